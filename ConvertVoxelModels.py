@@ -0,0 +1,178 @@
+#Turns the voxel model headers in src/game/VoxelModels into the compact tables in src/game/VoxelModels/CompactVoxelModels.h
+#every block becomes an occupancy bit plus an index into a shared palette of UV sets, every path subtile an index into a palette of path tiles.
+#After writing the header it expands the tables again and compares them block by block against the original models,
+#run with --check to only verify that the checked in header is up to date (returns non-zero if it isn't, or if anything doesn't match).
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+MODEL_DIR = os.path.join(ROOT, "src", "game", "VoxelModels")
+OUTPUT = os.path.join(MODEL_DIR, "CompactVoxelModels.h")
+
+#same order as the Tile_ constants in ThempTileArrays.h
+MODELS = [
+	("Rock.h", 1),
+	("FullBlock.h", 1),
+	("GroundBlock.h", 1),
+	("LiquidBlock.h", 1),
+	("DungeonHeart.h", 10),
+	("Portal.h", 10),
+	("Library.h", 10),
+	("Barracks.h", 10),
+	("RoomWithPillars.h", 10),
+]
+BLOCKS_PER_MODEL = 3 * 3 * 8
+PATH_TILES_PER_MODEL = 3 * 3
+
+FLOAT2 = r"XMFLOAT2\(\s*(\d+)\s*,\s*(\d+)\s*\)"
+BLOCK_RE = re.compile(r"Block\(\s*(true|false)\s*,\s*" + FLOAT2 + r"\s*,\s*" + FLOAT2 + r"(?:\s*,\s*" + FLOAT2 + r")?\s*\)")
+PATH_RE = re.compile(r"PathFindTile\(\s*([0-9.]+)\s*,\s*(\d+)\s*,\s*(true|false)\s*\)")
+ENTRY_RE = re.compile(BLOCK_RE.pattern + "|" + PATH_RE.pattern)
+
+def parse_models(fileName, count):
+	with open(os.path.join(MODEL_DIR, fileName), "r") as f:
+		text = re.sub(r"//[^\n]*", "", f.read())
+	blocks = []
+	paths = []
+	for m in ENTRY_RE.finditer(text):
+		if m.group(0).startswith("Block"):
+			g = m.groups()[:7]
+			u = (int(g[1]), int(g[2]))
+			if g[5] is None:
+				#Block(active, side, top) uses the same side UV on both axii
+				uvs = u + u + (int(g[3]), int(g[4]))
+			else:
+				uvs = u + (int(g[3]), int(g[4])) + (int(g[5]), int(g[6]))
+			blocks.append((g[0] == "true", uvs))
+		else:
+			g = m.groups()[7:]
+			paths.append((g[0], int(g[1]), g[2] == "true"))
+	if len(blocks) != count * BLOCKS_PER_MODEL or len(paths) != count * PATH_TILES_PER_MODEL:
+		sys.exit("%s: expected %d models, found %d blocks and %d path tiles" % (fileName, count, len(blocks), len(paths)))
+	models = []
+	for i in range(count):
+		models.append((fileName[:-2] + (" %d" % i if count > 1 else ""),
+			blocks[i * BLOCKS_PER_MODEL:(i + 1) * BLOCKS_PER_MODEL],
+			paths[i * PATH_TILES_PER_MODEL:(i + 1) * PATH_TILES_PER_MODEL]))
+	return models
+
+def palette_index(palette, lookup, value):
+	if value not in lookup:
+		lookup[value] = len(palette)
+		palette.append(value)
+	return lookup[value]
+
+def compact(models):
+	uvSets, uvLookup = [], {}
+	pathTiles, pathLookup = [], {}
+	compacted = []
+	for name, blocks, paths in models:
+		occupancy = [0] * PATH_TILES_PER_MODEL
+		uvIndices = []
+		for i, (active, uvs) in enumerate(blocks):
+			if active:
+				occupancy[i // 8] |= 1 << (i % 8)
+			uvIndices.append(palette_index(uvSets, uvLookup, uvs))
+		pathIndices = [palette_index(pathTiles, pathLookup, p) for p in paths]
+		activeBlocks = sum(1 for active, uvs in blocks if active)
+		compacted.append((name, occupancy, uvIndices, pathIndices, activeBlocks))
+	if len(uvSets) > 256 or len(pathTiles) > 256:
+		sys.exit("palette doesn't fit in a byte index anymore (%d uv sets, %d path tiles)" % (len(uvSets), len(pathTiles)))
+	return uvSets, pathTiles, compacted
+
+def expand(uvSets, pathTiles, entry):
+	name, occupancy, uvIndices, pathIndices, activeBlocks = entry
+	blocks = [(bool(occupancy[i // 8] & (1 << (i % 8))), uvSets[uvIndices[i]]) for i in range(BLOCKS_PER_MODEL)]
+	paths = [pathTiles[i] for i in pathIndices]
+	return blocks, paths
+
+def float_literal(text):
+	return (text if "." in text else text + ".0") + "f"
+
+def write_header(uvSets, pathTiles, compacted):
+	out = []
+	out.append("//Generated by ConvertVoxelModels.py from the model headers in this folder, don't edit by hand, change the models and re-run the script instead")
+	out.append("#pragma once")
+	out.append("#include <cstdint>")
+	out.append("namespace Themp")
+	out.append("{")
+	out.append("\tnamespace CompactVoxelModels")
+	out.append("\t{")
+	out.append("\t\tconstexpr int NumModels = %d;" % len(compacted))
+	out.append("\t\tconstexpr int NumUVSets = %d;" % len(uvSets))
+	out.append("\t\tconstexpr int NumPathTiles = %d;" % len(pathTiles))
+	out.append("")
+	out.append("\t\t//atlas cells for the x side, y side and top")
+	out.append("\t\tconstexpr uint8_t UVSets[NumUVSets][6] =")
+	out.append("\t\t{")
+	for uvs in uvSets:
+		out.append("\t\t\t{ %s }," % ",".join(str(v) for v in uvs))
+	out.append("\t\t};")
+	out.append("")
+	out.append("\t\t//PathFindTile constructor arguments")
+	out.append("\t\tstruct PathTile")
+	out.append("\t\t{")
+	out.append("\t\t\tfloat cost;")
+	out.append("\t\t\tuint8_t height;")
+	out.append("\t\t\tbool walkable;")
+	out.append("\t\t};")
+	out.append("\t\tconstexpr PathTile PathTiles[NumPathTiles] =")
+	out.append("\t\t{")
+	for cost, height, walkable in pathTiles:
+		out.append("\t\t\t{ %s, %d, %s }," % (float_literal(cost), height, "true" if walkable else "false"))
+	out.append("\t\t};")
+	out.append("")
+	out.append("\t\t//a byte of occupancy per subtile column (bit z), a UV set per block and a path tile per subtile, in RenderTile order")
+	out.append("\t\tstruct Model")
+	out.append("\t\t{")
+	out.append("\t\t\tuint8_t occupancy[9];")
+	out.append("\t\t\tuint8_t uvSet[72];")
+	out.append("\t\t\tuint8_t pathTile[9];")
+	out.append("\t\t\tuint16_t activeBlocks;")
+	out.append("\t\t};")
+	out.append("\t\tconstexpr Model Models[NumModels] =")
+	out.append("\t\t{")
+	for index, (name, occupancy, uvIndices, pathIndices, activeBlocks) in enumerate(compacted):
+		out.append("\t\t\t//%s (%d)" % (name, index))
+		out.append("\t\t\t{")
+		out.append("\t\t\t\t{ %s }," % ",".join("0x%02X" % v for v in occupancy))
+		out.append("\t\t\t\t{")
+		for column in range(PATH_TILES_PER_MODEL):
+			out.append("\t\t\t\t\t%s," % ",".join(str(v) for v in uvIndices[column * 8:(column + 1) * 8]))
+		out.append("\t\t\t\t},")
+		out.append("\t\t\t\t{ %s }," % ",".join(str(v) for v in pathIndices))
+		out.append("\t\t\t\t%d," % activeBlocks)
+		out.append("\t\t\t},")
+	out.append("\t\t};")
+	out.append("\t}")
+	out.append("};")
+	return "\r\n".join(out) + "\r\n"
+
+def main():
+	models = []
+	for fileName, count in MODELS:
+		models += parse_models(fileName, count)
+	uvSets, pathTiles, compacted = compact(models)
+
+	#the tables have to give back exactly what the original headers described
+	for (name, blocks, paths), entry in zip(models, compacted):
+		expandedBlocks, expandedPaths = expand(uvSets, pathTiles, entry)
+		for i in range(BLOCKS_PER_MODEL):
+			if expandedBlocks[i] != blocks[i]:
+				sys.exit("%s: block %d expands to %s, expected %s" % (name, i, expandedBlocks[i], blocks[i]))
+		if expandedPaths != paths:
+			sys.exit("%s: path tiles don't match" % name)
+
+	header = write_header(uvSets, pathTiles, compacted)
+	if "--check" in sys.argv:
+		current = open(OUTPUT, "rb").read().decode("utf-8") if os.path.exists(OUTPUT) else ""
+		if current != header:
+			sys.exit("CompactVoxelModels.h is out of date, re-run ConvertVoxelModels.py")
+		print("CompactVoxelModels.h is up to date, %d models match" % len(compacted))
+		return
+	with open(OUTPUT, "wb") as f:
+		f.write(header.encode("utf-8"))
+	print("%d models, %d uv sets, %d path tiles, all blocks match" % (len(compacted), len(uvSets), len(pathTiles)))
+
+main()
@@ -0,0 +1,45 @@
+//Map lights, shared by the voxel vertex and pixel shaders (named MapLight so it doesn't clash with the deferred Light in structs.hlsl)
+struct MapLight
+{
+	uint range;
+	uint lightIntensity;
+	uint x;
+	uint y;
+	uint z;
+	uint lightIndex;
+};
+//lights reaching each tile (85x85 cells), offset/count into lightCellIndices
+struct LightCell
+{
+    uint offset;
+    uint count;
+};
+StructuredBuffer<MapLight> lights : register(t8);
+StructuredBuffer<LightCell> lightCells : register(t9);
+StructuredBuffer<uint> lightCellIndices : register(t10);
+
+//pos is the x/z position in subtiles
+float GetLightStrength(float2 pos, uint index)
+{
+	if(index == -1)
+    {
+        return 0.0f;
+    }
+
+    MapLight light = lights[index];
+    //float distance = sqrt(pow(light.x - xPos, 2) + pow(light.y - yPos, 2));
+    float dist = distance(float2(light.x, light.y), pos);
+    return 1.0 / ((dist * dist) / (light.lightIntensity / 3.0));
+}
+
+float GetLightIntensity(float2 pos)
+{
+    float intensity = 0.0;
+    int2 cellPos = clamp(int2(floor(pos / 3.0)), int2(0, 0), int2(84, 84));
+    LightCell cell = lightCells[cellPos.y * 85 + cellPos.x];
+    for (uint i = 0; i < cell.count; i++)
+    {
+        intensity += GetLightStrength(pos, lightCellIndices[cell.offset + i]);
+    }
+    return clamp(intensity, 0.3f, 1.0f);
+}
@@ -1,6 +1,7 @@
 #include "defines.hlsl"
 #include "functions.hlsl"
 #include "structs.hlsl"
+#include "voxel_lights.hlsl"
 
 //Texture2D shaderTexture[4];
 Texture2D TextureAtlas : register(t0);
@@ -15,8 +16,15 @@ struct VOXEL_OUTPUT
     float2 uv : UV;
     float visible : VISIBLE;
     float lightIntensity : LIGHTINTENSITY;
+    float3 worldPos : WORLDPOS;
+    nointerpolation float2 cell : CELL;
+    nointerpolation uint tiled : TILED;
 };
 
+//size of a block texture in the atlas (8x68 cells of 32 pixels, half a pixel left off to avoid bleeding)
+static const float2 cellSize = float2(1.0 / 8.0, 1.0 / 68.0);
+static const float2 texSize = float2(31.5 / 256.0, 31.5 / 2176.0);
+
 float4 PShader(VOXEL_OUTPUT input) : SV_TARGET
 {
    // if (input.normal.x < -0.5 || input.normal.x > 0.5)
@@ -39,6 +47,28 @@ float4 PShader(VOXEL_OUTPUT input) : SV_TARGET
    //     return face3;
    // }
 
+    if (input.tiled)
+    {
+        //merged face, repeat the block texture every subtile the same way the single block faces lay it out
+        //lighting is done here too as the corners of a big quad are too far apart to interpolate between
+        float2 local;
+        if (input.normal.y > 0.5)
+        {
+            local = float2(input.worldPos.x + 0.5, input.worldPos.z + 0.5);
+        }
+        else if (input.normal.x > 0.5)
+        {
+            local = float2(input.worldPos.z + 0.5, -(input.worldPos.y + 0.5));
+        }
+        else
+        {
+            local = float2(input.worldPos.x + 0.5, -(input.worldPos.y + 0.5));
+        }
+        float2 uv = input.cell * cellSize + frac(local) * texSize;
+        float4 tiledFace = float4(TextureAtlas.SampleGrad(diffSampler, uv, ddx(local) * texSize, ddy(local) * texSize).xyz, 1.0);
+        return float4(tiledFace.xyz * GetLightIntensity(input.worldPos.xz) * input.visible, 1.0);
+    }
+
     float4 face = float4(TextureAtlas.Sample(diffSampler, float2(input.uv.x, input.uv.y)).xyz, 1.0);
    // return float4(face.xyz * input.visible * input.lightIntensity, 1.0);
     return float4(face.xyz * input.lightIntensity * input.visible, 1.0);
@@ -1,4 +1,5 @@
 #include "defines.hlsl"
+#include "voxel_lights.hlsl"
 
 struct VS_OUTPUT
 {
@@ -7,15 +8,15 @@ struct VS_OUTPUT
 	float2 uv : UV;
 	float visible : VISIBLE;
     float lightIntensity : LIGHTINTENSITY;
+    float3 worldPos : WORLDPOS;
+    nointerpolation float2 cell : CELL;
+    nointerpolation uint tiled : TILED;
 };
+//PackedVoxelVertex, see ThempVoxelVertexPacking.h for the layout
 struct VS_INPUT
 {
-	float3 position : POSITION;
-	float3 normal : NORMAL;
-	float2 uv : UV;
-	float visible : VISIBLE;
-	uint doAnimate : ANIMATE;
-	uint4 lightIndices : LIGHTINDICES;
+	uint4 position : POSITION; //w holds the flags
+	uint2 uv : UV;
 };
 cbuffer ObjectBuffer : register(b0)
 {
@@ -38,55 +39,40 @@ cbuffer ConstantBuffer : register(b2)
 	float _time;
 };
 
-struct Light
-{
-	uint range;
-	uint lightIntensity;
-	uint x;
-	uint y;
-	uint z;
-	uint lightIndex;
-};
-StructuredBuffer<Light> lights : register(t8);
-
-float GetLightStrength(VS_INPUT input, uint index)
-{
-	if(index == -1)
-    {
-        return 0.0f;
-    }
-
-    Light light = lights[index];
-    float xPos = input.position.x;
-    float yPos = input.position.z;
-    //float distance = sqrt(pow(light.x - xPos, 2) + pow(light.y - yPos, 2));
-    float dist = distance(float2(light.x, light.y), float2(xPos, yPos));
-    return 1.0 / ((dist * dist) / (light.lightIntensity / 3.0));
-}
-
 VS_OUTPUT VShader(VS_INPUT input)
 {
 	VS_OUTPUT output;
-	float4 pos = float4(input.position, 1.0);
+	const float3 position = input.position.xyz / 16.0 - 1.0;
+	const uint axis = input.position.w & 3;
+	const float3 normal = float3(axis == 0, axis == 1, axis == 2);
+	const float visible = (input.position.w & 4) > 0;
+	const uint doAnimate = (input.position.w >> 3) & 15;
+	float2 uv = input.uv / float2(512.0, 4352.0);
+	float4 pos = float4(position, 1.0);
 
-	if (input.doAnimate > 0)
+	//bit 0: water/lava wave, bit 1: merged face that tiles its texture, bit 2: face flipping through its texture frames (liquid surfaces, water edges, gold, marked tiles),
+	//bit 3: only 4 of those frames instead of 8
+	if ((doAnimate & 1) > 0)
 	{
 		pos.y += sin(_time*2.0 + pos.x * 1.33) * 0.25;
 	}
+	if ((doAnimate & 4) > 0)
+	{
+		//the frames sit next to each other in one row of the atlas, 5 a second
+		const float frames = (doAnimate & 8) > 0 ? 4.0 : 8.0;
+		uv.x += fmod(floor(_time * 5.0), frames) / 8.0;
+	}
 
 	output.position = mul(pos, mul(_modelMatrix, mul(_viewMatrix, _projectionMatrix)));
-	output.uv = input.uv;
-	output.normal = input.normal;
-	output.visible = input.visible;
+	output.uv = uv;
+	output.normal = normal;
+	output.visible = visible;
 	
-    output.lightIntensity = 0.0;
-
-    output.lightIntensity += GetLightStrength(input,input.lightIndices.x);
-    output.lightIntensity += GetLightStrength(input,input.lightIndices.y);
-    output.lightIntensity += GetLightStrength(input,input.lightIndices.z);
-    output.lightIntensity += GetLightStrength(input,input.lightIndices.w);
-
-    output.lightIntensity = clamp(output.lightIntensity, 0.3f, 1.0f);
+    output.worldPos = position;
+    //only used by merged faces, their uv points at the middle of the atlas cell
+    output.cell = floor(uv * float2(8.0, 68.0));
+    output.tiled = (doAnimate & 2) > 0;
+    output.lightIntensity = GetLightIntensity(position.xz);
 	return output;
 }
 
@@ -365,6 +365,23 @@ namespace Themp
 		XMStoreFloat4x4(&MVP, XMMatrixInverse(nullptr,(XMMatrixMultiply(viewMatrix, projectionMatrix))));
 		return MVP;
 	}
+	XMFLOAT4X4 Camera::GetViewProjectionMatrix()
+	{
+		XMMATRIX projectionMatrix;
+		if (m_CamType == CameraType::Perspective)
+		{
+			projectionMatrix = XMMatrixPerspectiveFovLH(m_FoV, m_AspectRatio, m_Near, m_Far);
+		}
+		else
+		{
+			projectionMatrix = XMMatrixOrthographicLH(m_OrthoWidth, m_OrthoHeight, m_Near, m_Far);
+		}
+		XMMATRIX viewMatrix = XMMatrixLookToLH(XMLoadFloat3(&m_Position), XMLoadFloat3(&m_Forward), XMLoadFloat3(&m_Up));
+
+		XMFLOAT4X4 res;
+		XMStoreFloat4x4(&res, XMMatrixMultiply(viewMatrix, projectionMatrix));
+		return res;
+	}
 	XMFLOAT4X4 Camera::GetViewMatrix()
 	{
 		XMVECTOR pos = XMLoadFloat3(&m_Position), dir = XMLoadFloat3(&m_Forward), up = XMLoadFloat3(&m_Up);
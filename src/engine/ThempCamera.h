@@ -55,6 +55,8 @@ namespace Themp
 		void Update(float dt);
 		XMFLOAT4X4 GetMVPMatrix();
 		XMFLOAT4X4 GetInvMVPMatrix();
+		//built from the current position/projection settings, GetMVPMatrix only changes when UpdateMatrices runs
+		XMFLOAT4X4 GetViewProjectionMatrix();
 		XMFLOAT4X4 GetViewMatrix();
 		XMFLOAT4X4 GetOrthoProjectionMatrix(float nearPlane, float farPlane);
 		XMFLOAT4X4 GetPerspectiveProjectionMatrix();
@@ -0,0 +1,60 @@
+#include "ThempFrustum.h"
+#include <cmath>
+using namespace Themp;
+using namespace DirectX;
+
+Frustum::Frustum()
+{
+	//everything passes until it's set up
+	for (int i = 0; i < NumPlanes; i++)
+	{
+		m_Planes[i] = XMFLOAT4(0, 0, 0, 1);
+	}
+}
+Frustum::Frustum(const XMFLOAT4X4& viewProjection)
+{
+	SetFromViewProjection(viewProjection);
+}
+
+//clip = pos * M, so every clip coordinate is the dot of the position with a column of M.
+//inside means -w <= x <= w, -w <= y <= w and 0 <= z <= w, every inequality is one plane.
+void Frustum::SetFromViewProjection(const XMFLOAT4X4& m)
+{
+	const XMFLOAT4 colX(m._11, m._21, m._31, m._41);
+	const XMFLOAT4 colY(m._12, m._22, m._32, m._42);
+	const XMFLOAT4 colZ(m._13, m._23, m._33, m._43);
+	const XMFLOAT4 colW(m._14, m._24, m._34, m._44);
+	m_Planes[Left] = XMFLOAT4(colW.x + colX.x, colW.y + colX.y, colW.z + colX.z, colW.w + colX.w);
+	m_Planes[Right] = XMFLOAT4(colW.x - colX.x, colW.y - colX.y, colW.z - colX.z, colW.w - colX.w);
+	m_Planes[Bottom] = XMFLOAT4(colW.x + colY.x, colW.y + colY.y, colW.z + colY.z, colW.w + colY.w);
+	m_Planes[Top] = XMFLOAT4(colW.x - colY.x, colW.y - colY.y, colW.z - colY.z, colW.w - colY.w);
+	m_Planes[Near] = colZ;
+	m_Planes[Far] = XMFLOAT4(colW.x - colZ.x, colW.y - colZ.y, colW.z - colZ.z, colW.w - colZ.w);
+	for (int i = 0; i < NumPlanes; i++)
+	{
+		XMFLOAT4& p = m_Planes[i];
+		const float length = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+		if (length > 0.0f)
+		{
+			p = XMFLOAT4(p.x / length, p.y / length, p.z / length, p.w / length);
+		}
+	}
+}
+
+bool Frustum::IntersectsBox(const XMFLOAT3& boxMin, const XMFLOAT3& boxMax) const
+{
+	for (int i = 0; i < NumPlanes; i++)
+	{
+		const XMFLOAT4& p = m_Planes[i];
+		//the corner furthest along the plane normal, if even that one is behind the plane the whole box is
+		const float x = p.x >= 0.0f ? boxMax.x : boxMin.x;
+		const float y = p.y >= 0.0f ? boxMax.y : boxMin.y;
+		const float z = p.z >= 0.0f ? boxMax.z : boxMin.z;
+		if (p.x * x + p.y * y + p.z * z + p.w < 0.0f) return false;
+	}
+	return true;
+}
+bool Frustum::ContainsPoint(const XMFLOAT3& point) const
+{
+	return IntersectsBox(point, point);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <DirectXMath.h>
+namespace Themp
+{
+	//The 6 planes of a view-projection matrix (D3D style, row vectors and 0..1 depth), works the same for perspective and orthographic cameras.
+	//Planes point inwards, a box is only thrown out when it's completely behind one of them so it can give false positives near the corners but never false negatives.
+	class Frustum
+	{
+	public:
+		Frustum();
+		Frustum(const DirectX::XMFLOAT4X4& viewProjection);
+		void SetFromViewProjection(const DirectX::XMFLOAT4X4& viewProjection);
+		bool IntersectsBox(const DirectX::XMFLOAT3& boxMin, const DirectX::XMFLOAT3& boxMax) const;
+		bool ContainsPoint(const DirectX::XMFLOAT3& point) const;
+
+		enum Plane { Left, Right, Bottom, Top, Near, Far, NumPlanes };
+		DirectX::XMFLOAT4 m_Planes[NumPlanes];
+	};
+};
@@ -16,8 +16,15 @@ namespace Themp
 		float nx, ny, nz;
 		float u, v, visible = 1.0f;
 		uint32_t doAnimate = 0;
-		uint32_t lightIndices[4] = { UINT32_MAX,UINT32_MAX,UINT32_MAX,UINT32_MAX };
 	};
+	//what VoxelVertex gets packed into before it's uploaded, see VoxelVertexPacking
+	struct PackedVoxelVertex
+	{
+		uint16_t x, y, z;
+		uint16_t flags;
+		uint16_t u, v;
+	};
+	static_assert(sizeof(PackedVoxelVertex) == 12, "voxel_vs.hlsl expects a 12 byte vertex");
 	class Material;
 	class Mesh
 	{
@@ -19,6 +19,12 @@ namespace Themp
 		ForceBufferUpdate();
 		Resources::TRes->m_3DObjects.push_back(this);
 	}
+	Object3D::Object3D(HeadlessTag)
+	{
+		m_Position = XMFLOAT3(0, 0, 0);
+		m_Scale = XMFLOAT3(1, 1, 1);
+		m_Rotation = XMFLOAT3(0, 0, 0);
+	}
 	Object3D::~Object3D()
 	{
 		if (m_ConstantBuffer)
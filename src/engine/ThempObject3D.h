@@ -15,7 +15,10 @@ namespace Themp
 			XMFLOAT4X4 worldMatrix;
 			uint32_t misc0, misc1, misc2, misc3;
 		};
+		enum HeadlessTag { Headless };
 		Object3D();
+		//just the transform, no constant buffer and not in the resources' object list, for objects that never get drawn (running the game code headless)
+		Object3D(HeadlessTag);
 		~Object3D();
 		void Update(float dt);
 		void SetMaterial(Material* m, int MeshIndex = 0);
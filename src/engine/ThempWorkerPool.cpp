@@ -0,0 +1,85 @@
+#include "ThempWorkerPool.h"
+using namespace Themp;
+
+WorkerPool::WorkerPool(int numThreads)
+{
+	m_NextJob = 0;
+	m_JobsLeft = 0;
+	for (int i = 0; i < numThreads; i++)
+	{
+		m_Threads.push_back(std::thread(&WorkerPool::WorkerLoop, this));
+	}
+}
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Quit = true;
+	}
+	m_WakeUp.notify_all();
+	for (size_t i = 0; i < m_Threads.size(); i++)
+	{
+		m_Threads[i].join();
+	}
+}
+
+void WorkerPool::Run(JobFunc func, void* context, int numJobs)
+{
+	if (numJobs <= 0) return;
+	uint32_t batch;
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		//a worker still on its way out of the last batch has to be gone before the counters change under it
+		m_Done.wait(lock, [this] { return m_BusyWorkers == 0; });
+		m_Func = func;
+		m_Context = context;
+		m_NumJobs = numJobs;
+		m_JobsLeft = numJobs;
+		batch = ++m_Batch;
+		m_NextJob = (uint64_t)batch << 32;
+	}
+	m_WakeUp.notify_all();
+
+	DoJobs(func, context, numJobs, batch);
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Done.wait(lock, [this] { return m_JobsLeft == 0 && m_BusyWorkers == 0; });
+}
+
+void WorkerPool::DoJobs(JobFunc func, void* context, int numJobs, uint32_t batch)
+{
+	uint64_t next = m_NextJob;
+	while ((uint32_t)(next >> 32) == batch && (int)(uint32_t)next < numJobs)
+	{
+		if (!m_NextJob.compare_exchange_weak(next, next + 1)) continue;
+		func(context, (int)(uint32_t)next);
+		m_JobsLeft--;
+		next = m_NextJob;
+	}
+}
+
+void WorkerPool::WorkerLoop()
+{
+	uint32_t lastBatch = 0;
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (true)
+	{
+		m_WakeUp.wait(lock, [this, lastBatch] { return m_Quit || m_Batch != lastBatch; });
+		if (m_Quit) return;
+		lastBatch = m_Batch;
+		const JobFunc func = m_Func;
+		void* const context = m_Context;
+		const int numJobs = m_NumJobs;
+		m_BusyWorkers++;
+		lock.unlock();
+
+		DoJobs(func, context, numJobs, lastBatch);
+
+		lock.lock();
+		m_BusyWorkers--;
+		if (m_BusyWorkers == 0 && m_JobsLeft == 0)
+		{
+			m_Done.notify_all();
+		}
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+namespace Themp
+{
+	//A handful of threads that sit idle until Run hands them a batch of jobs.
+	//Run blocks until every job in the batch is done, the calling thread picks up jobs too so a pool of 0 threads just runs them in order.
+	class WorkerPool
+	{
+	public:
+		typedef void(*JobFunc)(void* context, int jobIndex);
+
+		WorkerPool(int numThreads);
+		~WorkerPool();
+		void Run(JobFunc func, void* context, int numJobs);
+		int GetNumThreads() const { return (int)m_Threads.size(); }
+
+	private:
+		void WorkerLoop();
+		void DoJobs(JobFunc func, void* context, int numJobs, uint32_t batch);
+
+		std::vector<std::thread> m_Threads;
+		std::mutex m_Mutex;
+		std::condition_variable m_WakeUp;
+		std::condition_variable m_Done;
+		JobFunc m_Func = nullptr;
+		void* m_Context = nullptr;
+		int m_NumJobs = 0;
+		//the batch in the top 32 bits and its next job in the bottom ones, a worker only claims a job when the batch is still the one it was woken for
+		std::atomic<uint64_t> m_NextJob;
+		std::atomic<int> m_JobsLeft;
+		//workers that are still looking at the current batch, Run can't start the next one until they've let go of it
+		int m_BusyWorkers = 0;
+		uint32_t m_Batch = 0;
+		bool m_Quit = false;
+	};
+};
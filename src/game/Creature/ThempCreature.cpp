@@ -17,13 +17,26 @@
 #include "ThempAudio.h"
 #include "ThempLevelConfig.h"
 #include "ThempLevelScript.h"
+#include "ThempFieldOfView.h"
+#include "ThempTileEvents.h"
 #include "Players/ThempPlayerBase.h"
 #include <DirectXMath.h>
 #include <unordered_map>
 #include <array>
+#include <algorithm>
 #include <imgui.h>
 using namespace Themp;
 
+uint32_t Creature::s_NumSuspended = 0;
+uint32_t Creature::s_NumReducedRate = 0;
+uint8_t Creature::s_NextSimulationSlot = 0;
+Frustum Creature::s_SimulationView;
+
+//creatures this many tiles outside of the camera's view still run at full rate, so they're up to date when they walk in
+#define SIMULATION_VIEW_MARGIN 2
+//reduced rate creatures catch up on sprite directions and exploration once every this many game turns, spread out by their m_SimulationSlot
+#define SIMULATION_CATCH_UP_TURNS 4
+
 //2 types (FP or World), 5 directions, 12 states
 const std::array<std::array<std::array<CreatureData::ImpAnimations, 12>, 5>, 2> ImpAnimState =
 {
@@ -742,11 +755,26 @@ const std::unordered_map<CreatureData::CreatureType, CreatureData::CreatureSprit
 
 Themp::Creature::~Creature()
 {
+	Wake(Wake_Any);
+	CreatureTaskManager::RemovePendingImp(this);
+	for (int i = 0; i < 10; i++)
+	{
+		TimerWheel::Cancel(m_PowerCooldownTimer[i]);
+	}
+	TimerWheel::Cancel(m_ImpSpecialTimer);
+	TimerWheel::Cancel(m_TaskSearchTimer);
+	TimerWheel::Cancel(m_HungerTimer);
+	TimerWheel::Cancel(m_HungerTickTimer);
 	if (m_CreatureCB)
 	{
 		m_CreatureCB->Release();
 		m_CreatureCB = nullptr;
 	}
+	//the resources clean up the renderables of the drawn creatures
+	if (m_Headless)
+	{
+		delete m_Renderable;
+	}
 }
 
 Themp::Creature::Creature(CreatureData::CreatureType creatureIndex)
@@ -770,6 +798,7 @@ Themp::Creature::Creature(CreatureData::CreatureType creatureIndex)
 	//const float creatureYSize = (float)m_CreatureData.SizeYZ / 256.0f;
 	//m_Renderable->m_Scale = XMFLOAT3(creatureYSize, creatureYSize, creatureYSize);
 	m_Direction = XMFLOAT3(1, 0, 0);
+	m_SimulationSlot = (s_NextSimulationSlot++) % SIMULATION_CATCH_UP_TURNS;
 
 	m_CreatureCBData._AnimIndex = 0;
 	m_CreatureCBData._NumAnim = (float)m_Sprite->numAnim;
@@ -804,12 +833,24 @@ Themp::Creature::Creature(CreatureData::CreatureType creatureIndex)
 	{
 		UpdateBuffer();
 	}
-	for (int i = 0; i < 10; i++)
-	{
-		m_PowerCooldownTimer[i] = 0.0f;
-	}
 	m_Renderable->m_Meshes[0]->m_ConstantBuffer = m_CreatureCB;
 }
+Themp::Creature::Creature(CreatureData::CreatureType type, const CreatureData& data)
+{
+	m_Headless = true;
+	m_CreatureID = type;
+	m_CreatureData = data;
+	m_CreatureSpriteIndex = TypeToSprite.find(type)->second;
+	m_AnimState = CreatureData::AnimationState::Walking;
+	m_Renderable = new Object3D(Object3D::Headless);
+	m_Speed = BASESPEED_TO_DELTA(m_CreatureData.BaseSpeed);
+	m_Direction = XMFLOAT3(1, 0, 0);
+	m_SimulationSlot = (s_NextSimulationSlot++) % SIMULATION_CATCH_UP_TURNS;
+
+	m_CreatureCBData = {};
+	m_CreatureCBData._NumAnim = (float)HeadlessAnimationFrames;
+	m_CurrentHealth = m_CreatureData.Health;
+}
 
 void Creature::UpdateBuffer()
 {
@@ -841,6 +882,7 @@ bool Creature::PickUp()
 	{
 		CreatureTaskManager::UnlistImpFromTask(this);
 	}
+	Wake(Wake_Any);
 	m_InHand = true;
 	m_Renderable->isVisible = false;
 	SetCombatState(nullptr);
@@ -863,12 +905,6 @@ void Creature::SetToFreshAnimation(CreatureData::AnimationState anim)
 }
 void Creature::Update(float delta)
 {
-	for (int i = 0; i < 10; i++)
-	{
-		if(m_PowerCooldownTimer[i] > 0.0f)
-			m_PowerCooldownTimer[i] -= delta;
-	}
-
 	m_AnimationTime += delta;
 	if (m_AnimationTime > 1.0f / 15.0f)
 	{
@@ -885,47 +921,70 @@ void Creature::Update(float delta)
 		m_AnimationIndex = m_AnimationIndex % (int)m_CreatureCBData._NumAnim;
 		m_CreatureCBData._AnimIndex = (float)m_AnimationIndex;
 	}
+	const bool canGetHungry = CanGetHungry();
+	if (canGetHungry != m_HungerRunning)
+	{
+		SetHungerRunning(canGetHungry);
+	}
 	if (m_InHand)
 	{
 		
 		return;
 	}
+
+	//gameplay always runs at full rate, only the work nobody can see (or that is fine once per turn) gets spread out
+	const uint64_t turn = TimerWheel::GetCurrentTurn();
+	const bool reducedRate = UseReducedRate();
+	bool catchUp = !reducedRate;
+	if (reducedRate)
+	{
+		s_NumReducedRate++;
+		if (turn != m_LastCatchUpTurn && (turn + m_SimulationSlot) % SIMULATION_CATCH_UP_TURNS == 0)
+		{
+			m_LastCatchUpTurn = turn;
+			catchUp = true;
+		}
+	}
+
+	//suspended creatures only keep their animation going, the rest resumes once one of their wake conditions fires
+	if (m_Suspend.suspended)
+	{
+		UpdateAnimationDirections(catchUp);
+		m_Renderable->isDirty = true;
+		return;
+	}
 	const XMINT2 tilePos = LevelData::WorldToTile(m_Renderable->m_Position);
 	const XMINT2 subTilePos = XMINT2((int)round(m_Renderable->m_Position.x), (int)round(m_Renderable->m_Position.z));
-	m_Renderable->m_Position.y = LevelData::m_Map.m_Tiles[tilePos.y][tilePos.x].pathSubTiles[subTilePos.y % 3][subTilePos.x % 3].height;
+	m_Renderable->m_Position.y = LevelData::s_Map.m_TileDetails[tilePos.y][tilePos.x].pathSubTiles[subTilePos.y % 3][subTilePos.x % 3].height;
 
-	if (!m_InCombat && m_CurrentHealth > 0)
+	//looking for enemies once per game turn is enough when out of sight
+	if (!m_InCombat && m_CurrentHealth > 0 && (!reducedRate || turn != m_LastPerceptionTurn))
 	{
+		m_LastPerceptionTurn = turn;
 		CheckCombat();
 	}
 
-	if (m_CreatureID == CreatureData::CREATURE_IMP)
+	if (m_InCombat)
 	{
-		if (m_InCombat)
-		{
-			CombatUpdate(delta);
-		}
-		else
-		{
-			ImpUpdate(delta);
-		}
-		DoAnimationDirectionsImp();
+		CombatUpdate(delta);
+	}
+	else if (m_CreatureID == CreatureData::CREATURE_IMP)
+	{
+		ImpUpdate(delta);
 	}
 	else
 	{
-		if (m_InCombat)
-		{
-			CombatUpdate(delta);
-		}
-		else
-		{
-			CreatureUpdate(delta);
-		}
-		DoAnimationDirections();
+		CreatureUpdate(delta);
 	}
+	UpdateAnimationDirections(catchUp || m_InCombat);
 	m_Renderable->isDirty = true;
 
-	CheckVisibility();
+	//revealing tiles is gameplay too, off screen it still happens every turn, just not every frame
+	if (!reducedRate || turn != m_LastVisibilityTurn)
+	{
+		m_LastVisibilityTurn = turn;
+		CheckVisibility();
+	}
 	//DebugDraw::Line(m_Renderable->m_Position, m_Renderable->m_Position + m_Direction * 3);
 }
 bool Creature::IsAttackable()
@@ -962,13 +1021,19 @@ void Creature::CheckCombat()
 				Creature* c = player->m_Creatures[j];
 				if (c->GetAreaCode() == areaCode && c->IsAttackable())
 				{
-					if (Distance(m_Renderable->m_Position, c->m_Renderable->m_Position) < m_CreatureData.VisualRange)
+					const float distance = Distance(m_Renderable->m_Position, c->m_Renderable->m_Position);
+					//a suspended hostile isn't scanning, let it know we're close enough for it to see us
+					if (c->m_Suspend.suspended && distance < c->m_CreatureData.VisualRange)
+					{
+						c->Wake(Wake_EnemyInRange);
+					}
+					if (distance < m_CreatureData.VisualRange)
 					{
 						XMINT3 subTilePos = LevelData::WorldToSubtile(m_Renderable->m_Position);
 						XMINT3 targetSubTilePos = LevelData::WorldToSubtile(c->m_Renderable->m_Position);
 						float PathCost = 0.0f;
 						micropather::MPVector<void*> path;
-						int pathingResult = System::tSys->m_Game->m_CurrentLevel->PathFind(XMINT2(subTilePos.x, subTilePos.z), XMINT2(targetSubTilePos.x, targetSubTilePos.z), path, PathCost, true);
+						int pathingResult = Level::s_CurrentLevel->PathFind(XMINT2(subTilePos.x, subTilePos.z), XMINT2(targetSubTilePos.x, targetSubTilePos.z), path, PathCost, true);
 						if (pathingResult == micropather::MicroPather::SOLVED || pathingResult == micropather::MicroPather::START_END_SAME)
 						{
 							if (PathCost < m_CreatureData.VisualRange)
@@ -1033,7 +1098,7 @@ void Creature::CombatUpdate(float delta)
 		if(distance < 1.5f || pathResult)
 		{
 			//select a skill to use (current only use melee)
-			if (m_PowerCooldownTimer[0] <= 0.0f)
+			if (!TimerWheel::IsPending(m_PowerCooldownTimer[0]))
 			{
 				if (m_CreatureID == CreatureData::CreatureType::CREATURE_IMP)
 				{
@@ -1049,7 +1114,7 @@ void Creature::CombatUpdate(float delta)
 				}
 
 				const InstanceData& attackInstance = LevelConfig::instanceData[m_CreatureData.Power[0]];
-				m_PowerCooldownTimer[0] = GAME_TURNS_TO_SECOND(attackInstance.Time + attackInstance.ActionTime + attackInstance.ResetTime);
+				m_PowerCooldownTimer[0] = TimerWheel::Schedule(attackInstance.Time + attackInstance.ActionTime + attackInstance.ResetTime);
 			}
 		}
 	}
@@ -1076,32 +1141,18 @@ void Creature::GetTask()
 		if (m_Order.valid) return;
 	}
 
-	m_Order = CreatureTaskManager::GetSoloMiningTask(this, areaCode);
-	if (m_Order.valid)return;
-
-	m_Order = CreatureTaskManager::GetMiningTask(this, areaCode);
-	if (m_Order.valid) return;
-
-	m_Order = CreatureTaskManager::GetClaimingTask(this, areaCode);
-	if (m_Order.valid) return;
-
-	m_Order = CreatureTaskManager::GetReinforcingTask(this, areaCode);
-	if (m_Order.valid) return;
-
-	if (m_CurrentGoldHold > 0)
-	{
-		m_Order = CreatureTaskManager::GetAvailableTreasury(this, areaCode);
-		if (m_Order.valid) return;
-	}
-	m_Order = CreatureTaskManager::GetRandomMovementOrder(this, areaCode);
+	//Mining, claiming and reinforcing get handed out to all idle imps at once (closest first) at the end of the frame the next game turn starts in
+	//anyone left without a task will deliver what gold they have or wander around
+	CreatureTaskManager::RequestTask(this);
 }
 bool Creature::PathTo(float deltaTime, XMINT2 targetSubTile, bool ignoreWalls, bool dynamicTarget)
 {
 	int pathingResult = micropather::MicroPather::SOLVED;
-	if (LevelData::PathsInvalidated || m_Path.size() == 0 || m_JustSlapped || !(m_PathingTarget == targetSubTile))
+	if (m_RepathPending || m_Path.size() == 0 || m_JustSlapped || !(m_PathingTarget == targetSubTile))
 	{
 		m_PathingTarget = targetSubTile;
 		m_JustSlapped = false;
+		m_RepathPending = false;
 		const XMINT3 subTilePos = LevelData::WorldToSubtile(m_Renderable->m_Position);
 		float PathCost = 0;
 		if (!dynamicTarget)
@@ -1118,7 +1169,7 @@ bool Creature::PathTo(float deltaTime, XMINT2 targetSubTile, bool ignoreWalls, b
 		{
 			if (ignoreWalls)
 			{
-				pathingResult = System::tSys->m_Game->m_CurrentLevel->PathFindThroughWalls(XMINT2(subTilePos.x, subTilePos.z), targetSubTile, m_Path, PathCost, true);
+				pathingResult = Level::s_CurrentLevel->PathFindThroughWalls(XMINT2(subTilePos.x, subTilePos.z), targetSubTile, m_Path, PathCost, true);
 			}
 			else
 			{
@@ -1127,7 +1178,7 @@ bool Creature::PathTo(float deltaTime, XMINT2 targetSubTile, bool ignoreWalls, b
 		}
 		else
 		{
-			pathingResult = System::tSys->m_Game->m_CurrentLevel->PathFind(XMINT2(subTilePos.x, subTilePos.z), targetSubTile, m_Path, PathCost, true);
+			pathingResult = Level::s_CurrentLevel->PathFind(XMINT2(subTilePos.x, subTilePos.z), targetSubTile, m_Path, PathCost, true);
 		}
 
 		if (dynamicTarget)
@@ -1151,7 +1202,8 @@ bool Creature::PathTo(float deltaTime, XMINT2 targetSubTile, bool ignoreWalls, b
 		if (pathingResult != micropather::MicroPather::SOLVED && pathingResult != micropather::MicroPather::START_END_SAME)
 		{
 			taskString = "Invalid Path!";
-			LevelData::PathsInvalidated = true;
+			//the pather's cache might be what's wrong, nobody else's path is
+			Level::s_CurrentLevel->m_Pather->Reset();
 			if (m_CreatureID == CreatureData::CREATURE_IMP)
 			{
 				System::Print("Imp could not find path, resetting world pathing");
@@ -1231,9 +1283,10 @@ bool Creature::PathTo(float deltaTime, XMINT2 targetSubTile, bool ignoreWalls, b
 bool Creature::TunnelPathTo(float deltaTime, XMINT2 targetSubTile, bool ignoreWalls)
 {
 	int pathingResult = micropather::MicroPather::SOLVED;
-	if (LevelData::PathsInvalidated || m_Path.size() == 0 || m_JustSlapped)
+	if (m_RepathPending || m_Path.size() == 0 || m_JustSlapped)
 	{
 		m_JustSlapped = false;
+		m_RepathPending = false;
 		const XMINT3 subTilePos = LevelData::WorldToSubtile(m_Renderable->m_Position);
 		float PathCost = 0;
 		m_CurrentPathIndex = 0;
@@ -1248,7 +1301,7 @@ bool Creature::TunnelPathTo(float deltaTime, XMINT2 targetSubTile, bool ignoreWa
 		{
 			if (ignoreWalls)
 			{
-				pathingResult = System::tSys->m_Game->m_CurrentLevel->PathFindThroughWalls(XMINT2(subTilePos.x, subTilePos.z), targetSubTile, m_Path, PathCost, true);
+				pathingResult = Level::s_CurrentLevel->PathFindThroughWalls(XMINT2(subTilePos.x, subTilePos.z), targetSubTile, m_Path, PathCost, true);
 			}
 			else
 			{
@@ -1257,13 +1310,14 @@ bool Creature::TunnelPathTo(float deltaTime, XMINT2 targetSubTile, bool ignoreWa
 		}
 		else
 		{
-			pathingResult = System::tSys->m_Game->m_CurrentLevel->PathFind(XMINT2(subTilePos.x, subTilePos.z), targetSubTile, m_Path, PathCost, true);
+			pathingResult = Level::s_CurrentLevel->PathFind(XMINT2(subTilePos.x, subTilePos.z), targetSubTile, m_Path, PathCost, true);
 		}
 
 		if (pathingResult != micropather::MicroPather::SOLVED && pathingResult != micropather::MicroPather::START_END_SAME)
 		{
 			taskString = "Invalid Path!";
-			LevelData::PathsInvalidated = true;
+			//the pather's cache might be what's wrong, nobody else's path is
+			Level::s_CurrentLevel->m_Pather->Reset();
 			if (m_CreatureID == CreatureData::CREATURE_IMP)
 			{
 				System::Print("Imp could not find path, resetting world pathing");
@@ -1308,19 +1362,19 @@ bool Creature::TunnelPathTo(float deltaTime, XMINT2 targetSubTile, bool ignoreWa
 			{
 				m_PathLerpTime = 0.0f;
 				m_AnimState = CreatureData::AnimationState::Attacking;
-				if (m_ImpSpecialTimer <= 0.0f)
+				if (!TimerWheel::IsPending(m_ImpSpecialTimer))
 				{
 					const InstanceData& digInstance = LevelConfig::instanceData[INSTANCE_DIG];
-					m_ImpSpecialTimer = GAME_TURNS_TO_SECOND(digInstance.Time + digInstance.ActionTime + digInstance.ResetTime);
+					m_ImpSpecialTimer = TimerWheel::Schedule(digInstance.Time + digInstance.ActionTime + digInstance.ResetTime);
 					if (Level::s_CurrentLevel->m_LevelData->MineTile(targetTilePos.y, targetTilePos.x))
 					{
-						Level::s_CurrentLevel->m_LevelData->m_UnexploredTiles[targetTile] = targetTilePos;
+						Level::s_CurrentLevel->m_LevelData->AddUnexploredTile(targetTilePos);
 						TileNeighbourTiles n = Level::s_CurrentLevel->m_LevelData->GetNeighbourTiles(targetTilePos.y, targetTilePos.x);
 						for (int i = 0; i < 4; i++)
 						{
 							if (!n.Axii[i]->visible)
 							{
-								Level::s_CurrentLevel->m_LevelData->m_UnexploredTiles[n.Axii[i]] = targetTilePos + AxiiDirections[i];
+								Level::s_CurrentLevel->m_LevelData->AddUnexploredTile(targetTilePos + AxiiDirections[i]);
 							}
 						}
 					}
@@ -1377,11 +1431,6 @@ void Creature::ImpUpdate(float delta)
 #endif
 		return;
 	}
-	if (m_ImpSpecialTimer > 0.0f)
-	{
-		m_ImpSpecialTimer -= delta;
-	}
-
 	//Check if current task is still completeable or reachable
 	//for example, if an enemy imp has not taken over a neighbouring tile, so that claiming his currently tasked tile would be impossible (or reinforcing a wall)
 	//if so, set current order on invalid and RemoveTask();
@@ -1397,14 +1446,13 @@ void Creature::ImpUpdate(float delta)
 	taskString = "No Task";
 	if (!m_Order.valid)
 	{
-		m_TaskSearchTimer -= delta;
-		if (m_TaskSearchTimer <= 0.0f)
+		if (!TimerWheel::IsPending(m_TaskSearchTimer))
 		{
 			GetTask();
 			if (!m_Order.valid)
 			{
-				//random timer from 1 to 2 seconds
-				m_TaskSearchTimer = 1.0f + ((float)(rand() % 10)) / 10.0f;
+				SetTaskSearchTimer();
+				Suspend(Wake_Timer | Wake_TaskAvailable | Wake_EnemyInRange);
 			}
 		}
 	}
@@ -1423,10 +1471,10 @@ void Creature::ImpUpdate(float delta)
 			{
 				taskString = "Executing task: Mining!";
 				m_ImpAnimState = CreatureData::ImpAnimationState::IMP_Attacking;
-				if (m_ImpSpecialTimer <= 0.0f)
+				if (!TimerWheel::IsPending(m_ImpSpecialTimer))
 				{
 					const InstanceData& digInstance = LevelConfig::instanceData[INSTANCE_DIG];
-					m_ImpSpecialTimer = GAME_TURNS_TO_SECOND(digInstance.Time + digInstance.ActionTime + digInstance.ResetTime);
+					m_ImpSpecialTimer = TimerWheel::Schedule(digInstance.Time + digInstance.ActionTime + digInstance.ResetTime);
 					uint16_t miningType = Level::s_CurrentLevel->m_LevelData->GetTileType(m_Order.targetTilePos.y, m_Order.targetTilePos.x);
 					if (miningType == Type_Gold || miningType == Type_Gem)
 					{
@@ -1454,7 +1502,7 @@ void Creature::ImpUpdate(float delta)
 								{
 									if (!n.Axii[i]->visible)
 									{
-										Level::s_CurrentLevel->m_LevelData->m_UnexploredTiles[n.Axii[i]] = m_Order.targetTilePos + AxiiDirections[i];
+										Level::s_CurrentLevel->m_LevelData->AddUnexploredTile(m_Order.targetTilePos + AxiiDirections[i]);
 									}
 								}
 							}
@@ -1472,10 +1520,10 @@ void Creature::ImpUpdate(float delta)
 			{
 				taskString = "Executing task: Claiming!";
 				m_ImpAnimState = CreatureData::ImpAnimationState::IMP_Claiming;
-				if (m_ImpSpecialTimer <= 0.0f)
+				if (!TimerWheel::IsPending(m_ImpSpecialTimer))
 				{
 					const InstanceData& prettyPathInstance = LevelConfig::instanceData[INSTANCE_PRETTY_PATH];
-					m_ImpSpecialTimer = GAME_TURNS_TO_SECOND(prettyPathInstance.Time + prettyPathInstance.ActionTime + prettyPathInstance.ResetTime);
+					m_ImpSpecialTimer = TimerWheel::Schedule(prettyPathInstance.Time + prettyPathInstance.ActionTime + prettyPathInstance.ResetTime);
 					if (Level::s_CurrentLevel->m_LevelData->ReinforceTile(m_Owner, m_Order.targetTilePos.y, m_Order.targetTilePos.x))
 					{
 						Level::s_CurrentLevel->m_LevelData->ClaimTile(m_Owner, m_Order.targetTilePos.y, m_Order.targetTilePos.x);
@@ -1489,10 +1537,10 @@ void Creature::ImpUpdate(float delta)
 			{
 				taskString = "Executing task: Reinforcing!";
 				m_ImpAnimState = CreatureData::ImpAnimationState::IMP_Claiming;
-				if (m_ImpSpecialTimer <= 0.0f)
+				if (!TimerWheel::IsPending(m_ImpSpecialTimer))
 				{
 					const InstanceData& reinforceInstance = LevelConfig::instanceData[INSTANCE_REINFORCE];
-					m_ImpSpecialTimer = GAME_TURNS_TO_SECOND(reinforceInstance.Time + reinforceInstance.ActionTime + reinforceInstance.ResetTime);
+					m_ImpSpecialTimer = TimerWheel::Schedule(reinforceInstance.Time + reinforceInstance.ActionTime + reinforceInstance.ResetTime);
 					if (Level::s_CurrentLevel->m_LevelData->ReinforceTile(m_Owner, m_Order.targetTilePos.y, m_Order.targetTilePos.x))
 					{
 						Level::s_CurrentLevel->m_LevelData->ClaimTile(m_Owner, m_Order.targetTilePos.y, m_Order.targetTilePos.x);
@@ -1506,21 +1554,27 @@ void Creature::ImpUpdate(float delta)
 			{
 
 				taskString = "Executing task: Delivering Gold!";
-				auto& room = Level::s_CurrentLevel->m_LevelData->m_Rooms[m_Owner][m_Order.tile->roomID];
-				room.roomFillAmount += m_CurrentGoldHold;
-				auto&& t = room.tiles.find(m_Order.tile);
-				t->second.tileValue += m_CurrentGoldHold;
-				Level::s_CurrentLevel->m_LevelData->AdjustRoomTile(room, t->second);
-				LevelScript::GameValues[m_Owner]["MONEY"] += m_CurrentGoldHold;
-				m_CurrentGoldHold = 0;
+				LevelData* levelData = Level::s_CurrentLevel->m_LevelData;
+				//the treasury might've been sold or claimed while we were walking there
+				if (m_Order.tile->GetType() == Type_Treasure_Room && m_Order.tile->owner == m_Owner)
+				{
+					auto& room = levelData->m_Rooms[m_Owner][m_Order.tile->roomID];
+					LevelData::Room::RoomTile& t = levelData->GetRoomTile(room, m_Order.targetTilePos.y, m_Order.targetTilePos.x);
+					room.AddToTile(t, m_CurrentGoldHold);
+					levelData->AdjustRoomTile(room, t);
+					LevelScript::GameValues[m_Owner]["MONEY"] += m_CurrentGoldHold;
+					m_CurrentGoldHold = 0;
+				}
 				StopOrder();
 				GetTask();
 				//	System::Print("Creature.cpp || Unimplemented task: %i Deliver Gold!", m_Order.orderType);
 			}
 			else if (m_Order.orderType == CreatureTaskManager::Order_IdleMovement)
 			{
-				m_TaskSearchTimer = 1.0f + ((float)(rand() % 10)) / 10.0f;
+				SetTaskSearchTimer();
 				StopOrder();
+				m_ImpAnimState = CreatureData::ImpAnimationState::IMP_Idling;
+				Suspend(Wake_Timer | Wake_TaskAvailable | Wake_EnemyInRange);
 			}
 			else
 			{
@@ -1585,7 +1639,7 @@ void Creature::AnimationDoneEvent()
 	}
 	else if (m_CurrentState == CreatureState::SLEEPING)
 	{
-		if (m_TaskSearchTimer <= 0.0f)
+		if (!TimerWheel::IsPending(m_TaskSearchTimer))
 		{
 			StopActivity();
 			GetActivity();
@@ -1594,6 +1648,7 @@ void Creature::AnimationDoneEvent()
 }
 void Creature::SetCombatState(Creature* c)
 {
+	Wake(Wake_Any);
 	if (c == nullptr)
 	{
 		m_InCombat = false;
@@ -1748,7 +1803,7 @@ void Creature::PlayDieSound()
 	}
 	if (soundToPlay.size() > 0)
 	{
-		System::tSys->m_Audio->PlayOneShot(FileManager::GetSound(soundToPlay));
+		FileManager::PlayOneShot(soundToPlay);
 	}
 }
 void Creature::PlayHitSound()
@@ -1800,7 +1855,7 @@ void Creature::PlayHitSound()
 	}
 	if (soundToPlay.size() > 0)
 	{
-		System::tSys->m_Audio->PlayOneShot(FileManager::GetSound(soundToPlay));
+		FileManager::PlayOneShot(soundToPlay);
 	}
 }
 void Creature::Die()
@@ -1845,42 +1900,20 @@ void Creature::CreatureUpdate(float delta)
 		return;
 	}
 
-	if (m_CreatureData.HungerRate && m_Owner != Owner_PlayerWhite && m_Owner != Owner_PlayerNone)
-	{
-		const float hungerPerDelta = (float)m_CreatureData.HungerRate / 100.0f;
-		m_HungerTimer += delta;
-		if (m_HungerTimer > GAME_TURNS_TO_SECOND(hungerPerDelta))
-		{
-			m_HungerTickTimer = 0;
-			m_HungerTimer -= GAME_TURNS_TO_SECOND(hungerPerDelta);
-			if(m_CurrentHungerLevel > 0)
-				m_CurrentHungerLevel--;
-		}
-		if (m_CurrentHungerLevel <= 0)
-		{
-			m_HungerTickTimer += delta;
-			if (SECOND_TO_GAME_TURNS(m_HungerTickTimer) > m_TurnsTillHungerTick)
-			{
-				m_HungerTickTimer = 0;
-				if (TakeDamage(10))
-				{
-					return;
-				}
-			}
-		}
-	}
-	m_TaskSearchTimer -= delta;
 	if (!m_Activity.valid && m_HeroLeader == nullptr)
 	{
-		if (m_TaskSearchTimer <= 0.0f)
+		if (!TimerWheel::IsPending(m_TaskSearchTimer))
 		{
 			GetActivity();
 			if (!m_Activity.valid)
 			{
-				//random timer from 1 to 2 seconds
-				m_TaskSearchTimer = 1.0f + ((float)(rand() % 10)) / 10.0f;
+				SetTaskSearchTimer();
 			}
 		}
+		if (!m_Activity.valid)
+		{
+			Suspend(Wake_Timer | Wake_EnemyInRange);
+		}
 	}
 	
 	if (m_Activity.valid)
@@ -1888,7 +1921,6 @@ void Creature::CreatureUpdate(float delta)
 		bool result = false;
 		if (m_Activity.activityType == CreatureTaskManager::ActivityType::Activity_Tunnel)
 		{
-			m_ImpSpecialTimer -= delta;
 			result = TunnelPathTo(delta, m_Activity.subTilePos, true);
 		}
 		else
@@ -1901,11 +1933,11 @@ void Creature::CreatureUpdate(float delta)
 			{
 				taskString = "Doing Activity: Dungeon Heart!";
 
-				System::tSys->m_Audio->PlayOneShot(FileManager::GetSound("STARS3.WAV"));
+				FileManager::PlayOneShot("STARS3.WAV");
 				m_CurrentState = CreatureState::CREATE_LAIR;
 				m_AnimState = CreatureData::AnimationState::Walking;
 				StopActivity();
-				m_TaskSearchTimer = 0.0f;
+				TimerWheel::Cancel(m_TaskSearchTimer);
 			}
 			else if (m_Activity.activityType == CreatureTaskManager::ActivityType::Activity_CreateLair)
 			{
@@ -1914,7 +1946,7 @@ void Creature::CreatureUpdate(float delta)
 				m_AnimState = CreatureData::AnimationState::Dropping; //its a still frame
 				CreateLair();
 				StopActivity();
-				m_TaskSearchTimer = 0.0f;
+				TimerWheel::Cancel(m_TaskSearchTimer);
 			}
 			else if (m_Activity.activityType == CreatureTaskManager::ActivityType::Activity_GoToBed)
 			{
@@ -1939,7 +1971,8 @@ void Creature::CreatureUpdate(float delta)
 			{
 				taskString = "Doing Activity: Sleeping!"; 
 				m_CurrentState = CreatureState::SLEEPING;
-				//we wait for the animation events to finish
+				//we wait for the animation events to finish, those keep running while suspended
+				Suspend(Wake_Timer | Wake_EnemyInRange);
 			}
 			else if (m_Activity.activityType == CreatureTaskManager::ActivityType::Activity_Explore)
 			{
@@ -1990,12 +2023,231 @@ void Creature::StopOrder()
 }
 void Creature::StopActivity()
 {
-	m_TaskSearchTimer = 1.0f + ((float)(rand() % 10)) / 10.0f;
+	SetTaskSearchTimer();
 	m_Activity.valid = false;
 	m_Path.clear();
 	m_CurrentPathIndex = 0;
 	m_PathLerpTime = 0;
 }
+void Creature::SetTaskSearchTimer()
+{
+	//random timer from 1 to 2 seconds
+	TimerWheel::Reschedule(m_TaskSearchTimer, (uint32_t)SECOND_TO_GAME_TURNS(1.0f + ((float)(rand() % 10)) / 10.0f), Creature::OnTimer, this, Timer_TaskSearch);
+}
+void Creature::Suspend(uint8_t wakeConditions)
+{
+	//the task search timer is the fallback for anything we don't get told about, without it nothing would wake us up again
+	if (!TimerWheel::IsPending(m_TaskSearchTimer) || !m_Suspend.Suspend(wakeConditions)) return;
+	if (m_Suspend.wakeConditions & Wake_TaskAvailable)
+	{
+		CreatureTaskManager::AddWaitingImp(this);
+	}
+	s_NumSuspended++;
+}
+void Creature::Wake(uint8_t reason)
+{
+	const uint8_t wakeConditions = m_Suspend.wakeConditions;
+	if (!m_Suspend.Wake(reason)) return;
+	if (wakeConditions & Wake_TaskAvailable)
+	{
+		CreatureTaskManager::RemoveWaitingImp(this);
+	}
+	//a new task showed up, go look for it right away instead of waiting out the search timer
+	if (reason == Wake_TaskAvailable)
+	{
+		TimerWheel::Cancel(m_TaskSearchTimer);
+	}
+	s_NumSuspended--;
+}
+bool Creature::SuspendState::Suspend(uint8_t conditions)
+{
+	if (suspended) return false;
+	suspended = true;
+	wakeConditions = conditions | Wake_Timer;
+	return true;
+}
+bool Creature::SuspendState::Wake(uint8_t reason)
+{
+	if (!WaitsOn(reason)) return false;
+	suspended = false;
+	wakeConditions = 0;
+	return true;
+}
+void Creature::WakeNearTileChanges(const TileChange* changes, size_t count)
+{
+	if (s_NumSuspended == 0) return;
+	for (int i = 0; i < 5; i++)
+	{
+		PlayerBase* player = Level::s_CurrentLevel->m_Players[i];
+		if (player == nullptr)continue;
+		for (int j = 0; j < player->m_Creatures.size(); j++)
+		{
+			Creature* c = player->m_Creatures[j];
+			if (!c->m_Suspend.WaitsOn(Wake_EnemyInRange)) continue;
+			for (size_t k = 0; k < count; k++)
+			{
+				if (!(changes[k].fields & TileChange::Field_Walkable)) continue;
+				XMFLOAT3 tilePos = LevelData::TileToWorld(XMINT2(changes[k].x, changes[k].y));
+				tilePos.y = c->m_Renderable->m_Position.y;
+				if (Distance(c->m_Renderable->m_Position, tilePos) < c->m_CreatureData.VisualRange)
+				{
+					c->Wake(Wake_EnemyInRange);
+					break;
+				}
+			}
+		}
+	}
+}
+//stamped on the changed tiles and their neighbours, a path node on a tile with the current stamp is close enough to need a new path
+static uint32_t RepathMarks[MAP_SIZE_TILES][MAP_SIZE_TILES];
+static uint32_t RepathStamp = 0;
+void Creature::RepathNearTiles(const std::vector<XMINT2>& tiles)
+{
+	if (tiles.size() == 0) return;
+	RepathStamp++;
+	for (size_t i = 0; i < tiles.size(); i++)
+	{
+		for (int y = std::max(tiles[i].y - 1, 0); y <= std::min(tiles[i].y + 1, MAP_SIZE_TILES - 1); y++)
+		{
+			for (int x = std::max(tiles[i].x - 1, 0); x <= std::min(tiles[i].x + 1, MAP_SIZE_TILES - 1); x++)
+			{
+				RepathMarks[y][x] = RepathStamp;
+			}
+		}
+	}
+	for (int i = 0; i < 5; i++)
+	{
+		PlayerBase* player = Level::s_CurrentLevel->m_Players[i];
+		if (player == nullptr)continue;
+		for (int j = 0; j < player->m_Creatures.size(); j++)
+		{
+			Creature* c = player->m_Creatures[j];
+			if (c->m_RepathPending) continue;
+			//the path ends on its target, and the node it's walking away from counts too, it's still standing between the two
+			for (int k = std::max((int)c->m_CurrentPathIndex - 1, 0); k < (int)c->m_Path.size() && !c->m_RepathPending; k++)
+			{
+				const int pathX = (int)(((uint64_t)c->m_Path[k]) & 0xFFFFFFFF);
+				const int pathY = (int)((((uint64_t)c->m_Path[k]) >> 32) & 0xFFFFFFFF);
+				c->m_RepathPending = RepathMarks[pathY / 3][pathX / 3] == RepathStamp;
+			}
+		}
+	}
+}
+bool Creature::CanGetHungry()
+{
+	if (!m_CreatureData.HungerRate || m_Owner == Owner_PlayerWhite || m_Owner == Owner_PlayerNone) return false;
+	return m_CurrentHealth > 0 && !m_InHand && !m_InCombat && m_CreatureID != CreatureData::CREATURE_IMP;
+}
+uint32_t Creature::AdvanceHunger(uint32_t hungerRate, uint32_t& progress, uint64_t turns)
+{
+	progress += (uint32_t)(turns * 100);
+	const uint32_t steps = progress / hungerRate;
+	progress -= steps * hungerRate;
+	return steps;
+}
+void Creature::SetHungerRunning(bool running)
+{
+	const uint64_t turn = TimerWheel::GetCurrentTurn();
+	m_HungerRunning = running;
+	if (running)
+	{
+		m_HungerCountedTurn = turn;
+		ScheduleHungerStep();
+		if (m_HungerTickTurnsLeft)
+		{
+			m_HungerTickTimer = TimerWheel::Schedule(m_HungerTickTurnsLeft, Creature::OnTimer, this, Timer_HungerTick);
+			m_HungerTickTurnsLeft = 0;
+		}
+	}
+	else
+	{
+		//hold on to the turns counted so far, both timers carry on where they were once we're back
+		ApplyHungerSteps(AdvanceHunger(m_CreatureData.HungerRate, m_HungerProgress, turn - m_HungerCountedTurn));
+		m_HungerCountedTurn = turn;
+		m_HungerTickTurnsLeft = TimerWheel::TurnsRemaining(m_HungerTickTimer);
+		TimerWheel::Cancel(m_HungerTimer);
+		TimerWheel::Cancel(m_HungerTickTimer);
+	}
+}
+void Creature::ScheduleHungerStep()
+{
+	const uint32_t hundredthsLeft = m_HungerProgress < (uint32_t)m_CreatureData.HungerRate ? m_CreatureData.HungerRate - m_HungerProgress : 1;
+	TimerWheel::Reschedule(m_HungerTimer, (hundredthsLeft + 99) / 100, Creature::OnTimer, this, Timer_Hunger);
+}
+void Creature::ApplyHungerSteps(uint32_t steps)
+{
+	if (!steps) return;
+	m_CurrentHungerLevel = m_CurrentHungerLevel > (int)steps ? m_CurrentHungerLevel - (int)steps : 0;
+	//every step restarts the count towards the next hunger tick
+	if (m_CurrentHungerLevel <= 0)
+	{
+		TimerWheel::Reschedule(m_HungerTickTimer, m_TurnsTillHungerTick, Creature::OnTimer, this, Timer_HungerTick);
+	}
+	else
+	{
+		TimerWheel::Cancel(m_HungerTickTimer);
+	}
+}
+void Creature::OnTimer(void* owner, uint32_t eventCode)
+{
+	Creature* c = static_cast<Creature*>(owner);
+	if (c->m_CurrentHealth <= 0) return;
+
+	//both hunger timers only exist while hunger is running, see SetHungerRunning
+	switch (eventCode)
+	{
+	case Timer_Hunger:
+	{
+		const uint64_t turn = TimerWheel::GetCurrentTurn();
+		const uint32_t steps = AdvanceHunger(c->m_CreatureData.HungerRate, c->m_HungerProgress, turn - c->m_HungerCountedTurn);
+		c->m_HungerCountedTurn = turn;
+		c->ScheduleHungerStep();
+		c->ApplyHungerSteps(steps);
+		break;
+	}
+	case Timer_TaskSearch:
+		c->Wake(Wake_Timer);
+		break;
+	case Timer_HungerTick:
+		//ate in the meantime
+		if (c->m_CurrentHungerLevel > 0) return;
+		if (c->TakeDamage(10))
+		{
+			return;
+		}
+		c->m_HungerTickTimer = TimerWheel::Schedule(c->m_TurnsTillHungerTick, Creature::OnTimer, c, Timer_HungerTick);
+		break;
+	}
+}
+bool Creature::UseReducedRate()
+{
+	if (m_InCombat) return false;
+	return IsReducedRateTile(LevelData::WorldToTile(m_Renderable->m_Position));
+}
+bool Creature::IsReducedRateTile(XMINT2 tilePos)
+{
+	const float margin = SIMULATION_VIEW_MARGIN * 3.0f;
+	const XMFLOAT3 boxMin(tilePos.x * 3.0f - margin, 0.0f, tilePos.y * 3.0f - margin);
+	const XMFLOAT3 boxMax((tilePos.x + 1) * 3.0f + margin, (float)MAP_SIZE_HEIGHT, (tilePos.y + 1) * 3.0f + margin);
+	return !s_SimulationView.IntersectsBox(boxMin, boxMax);
+}
+void Creature::UpdateAnimationDirections(bool force)
+{
+	const int animState = m_CreatureID == CreatureData::CREATURE_IMP ? (int)m_ImpAnimState : (int)m_AnimState;
+	//the sprite decides how long an animation is (and with that when AnimationDoneEvent fires), so a changed animation is always applied right away
+	if (!force && animState == m_LastDirectionAnimState) return;
+	m_LastDirectionAnimState = animState;
+	//no sprites to pick from
+	if (m_Headless) return;
+	if (m_CreatureID == CreatureData::CREATURE_IMP)
+	{
+		DoAnimationDirectionsImp();
+	}
+	else
+	{
+		DoAnimationDirections();
+	}
+}
 void Creature::DoAnimationDirectionsImp()
 {
 	XMFLOAT3 camRight;
@@ -2070,7 +2322,7 @@ void Creature::CreateLair()
 	mapEntity->ResetScale();
 	mapEntity->SetVisibility(true);
 	mapEntity->m_Renderable->m_Position = LevelData::SubtileToWorld(XMINT3(m_Activity.subTilePos.x, 2, m_Activity.subTilePos.y));
-	m_Activity.tile->placedEntities[1][1] = mapEntity;
+	LevelData::s_Map.GetDetail(m_Activity.tile).placedEntities[1][1] = mapEntity;
 	m_LairLocation.x = m_Activity.targetTilePos.x;
 	m_LairLocation.y = m_Activity.targetTilePos.y;
 }
@@ -2087,6 +2339,18 @@ void Creature::SetVisibility(bool val)
 {
 	m_Renderable->isVisible = val;
 }
+//sight stops at anything solid at eye height (same as what the old raycasts hit), those tiles get revealed but can't be looked past
+static bool IsSightBlocked(void* context, int y, int x)
+{
+	const LevelData* ldata = static_cast<const LevelData*>(context);
+	return ldata->IsBlockActive(3, y * 3 + 1, x * 3 + 1);
+}
+static std::vector<XMINT2> RevealedTiles;
+static std::vector<XMINT2> NearbyUnexploredTiles;
+static void CollectRevealedTile(void* context, int y, int x)
+{
+	RevealedTiles.push_back(XMINT2(x, y));
+}
 void Creature::CheckVisibility()
 {
 	if (m_AreaNeedsDiscovering && m_Owner == Owner_PlayerRed)
@@ -2094,91 +2358,61 @@ void Creature::CheckVisibility()
 		//creatures can see 7 tiles in each direction
 		const int range = 7;
 		const XMINT2 tilePos = LevelData::WorldToTile(m_Renderable->m_Position);
-		const int areaCode = LevelData::m_Map.m_Tiles[tilePos.y][tilePos.x].areaCode;
-		const int minY = tilePos.y - range >= range ? tilePos.y - range : range;
-		const int minX = tilePos.x - range >= range ? tilePos.x - range : range;
-		const int maxY = tilePos.y + range < MAP_SIZE_TILES ? tilePos.y + range : MAP_SIZE_TILES - range - 1;
-		const int maxX = tilePos.x + range < MAP_SIZE_TILES ? tilePos.x + range : MAP_SIZE_TILES - range - 1;
+		const int areaCode = LevelData::s_Map.m_Tiles[tilePos.y][tilePos.x].areaCode;
 		LevelData* ldata = Level::s_CurrentLevel->m_LevelData;
 
-		for (auto c = ldata->m_UnexploredTiles.begin(); c != ldata->m_UnexploredTiles.end();)
+		//Tiles owned by us are always visible, they don't need to be in sight
+		NearbyUnexploredTiles.clear();
+		ldata->m_UnexploredTiles.GetInRange(tilePos, range, NearbyUnexploredTiles);
+		bool frontierInSight = false;
+		for (size_t i = 0; i < NearbyUnexploredTiles.size(); i++)
 		{
-			//Tile is already visible, shouldn't be in the list, remove it and continue
-			if (c->first->visible)
-			{
-				c = ldata->m_UnexploredTiles.erase(c);
-				continue;
-			}
+			const XMINT2 p = NearbyUnexploredTiles[i];
+			Tile& tile = LevelData::s_Map.m_Tiles[p.y][p.x];
+			if (tile.visible) continue;
 			//if we're not checking a wall (the area code != 0) and we're checking a tile from a different area
-			if ((c->first->areaCode != areaCode && c->first->areaCode != 0))
+			if (tile.areaCode != areaCode && tile.areaCode != 0) continue;
+			if (tile.owner != Owner_PlayerRed)
 			{
-				c++;
+				frontierInSight = true;
 				continue;
 			}
-			if (abs(c->second.x - tilePos.x) <= range && abs(c->second.y - tilePos.y) <= range)
-			{
-				int x = c->second.x;
-				int y = c->second.y;
-
-				//Tile is owned by us, they are always visible, mark it so and remove from the list 
-				if (c->first->owner == Owner_PlayerRed)
-				{
-					c->first->visible = true;
-					//we explored this tile, check if there are any other tiles next to this we gotta mark unexplored
-					ldata->AddExploredTileNeighboursVisibility(y, x, areaCode);
-
-					c = ldata->m_UnexploredTiles.erase(c);
-					continue;
-				}
 
-				//we raycast from our position to the target tile, if we hit it, mark it visible, if we hit another tile we mark that visible instead
-				XMFLOAT3 srcPos = LevelData::TileToWorld(LevelData::WorldToTile(m_Renderable->m_Position));
-				srcPos.y = 3;
-
-				XMFLOAT3 rayDir = XMFLOAT3((float)(x * 3 + 1), 3,(float)( y * 3 + 1)) - srcPos;
-				rayDir = Normalize(rayDir);
-				LevelData::HitData hit = ldata->Raycast(srcPos, rayDir, range * 3);
-				if (hit.hit)
-				{
-					//we hit something, now we check if thats our target tile or not
-					int tileX = hit.posX / 3;
-					int tileY = hit.posZ / 3;
-					Tile* hitTile = &LevelData::m_Map.m_Tiles[tileY][tileX];
-
-					if (tileX == x && tileY == y)
-					{
-						//DebugDraw::Line(XMFLOAT3(srcPos.x, 6, srcPos.z), XMFLOAT3(tileX * 3 + 1, 6, tileY * 3 + 1),0,XMFLOAT3(0,1,0));
-						//we hit our target tile
-						c->first->visible = true;
-						ldata->AddExploredTileNeighboursVisibility(y, x, areaCode);
-
-						if (!IsMineableForPlayer(hitTile->GetType(), hitTile->owner, Owner_PlayerRed))
-						{
-							hitTile->marked[Owner_PlayerRed] = false;
-						}
+			tile.visible = true;
+			ldata->m_TileEvents.MarkTile(p.y, p.x);
+			//we explored this tile, check if there are any other tiles next to this we gotta mark unexplored
+			ldata->AddExploredTileNeighboursVisibility(p.y, p.x, areaCode);
+			ldata->m_UnexploredTiles.Remove(p.y, p.x);
+		}
+		//nothing left to explore around here, most of the time
+		if (!frontierInSight) return;
+
+		//one shadowcasting pass finds everything in sight, only the unexplored frontier in there gets revealed like the old per tile raycasts did
+		//closest first, a frontier tile that's revealed puts the tiles behind it on the frontier in time for them to be looked at in the same pass
+		RevealedTiles.clear();
+		FieldOfView::Compute(tilePos, range, IsSightBlocked, CollectRevealedTile, ldata);
+		std::sort(RevealedTiles.begin(), RevealedTiles.end(), [tilePos](const XMINT2& a, const XMINT2& b)
+		{
+			const int da = (a.x - tilePos.x) * (a.x - tilePos.x) + (a.y - tilePos.y) * (a.y - tilePos.y);
+			const int db = (b.x - tilePos.x) * (b.x - tilePos.x) + (b.y - tilePos.y) * (b.y - tilePos.y);
+			return da != db ? da < db : (a.y != b.y ? a.y < b.y : a.x < b.x);
+		});
+		for (size_t i = 0; i < RevealedTiles.size(); i++)
+		{
+			const XMINT2 p = RevealedTiles[i];
+			Tile& tile = LevelData::s_Map.m_Tiles[p.y][p.x];
+			if (tile.visible || !ldata->m_UnexploredTiles.Contains(p.y, p.x)) continue;
+			//if we're not checking a wall (the area code != 0) and we're checking a tile from a different area
+			if (tile.areaCode != areaCode && tile.areaCode != 0) continue;
 
-						c = ldata->m_UnexploredTiles.erase(c);
-						continue;
-					}
-					else
-					{
-						//DebugDraw::Line(XMFLOAT3(srcPos.x, 6, srcPos.z), XMFLOAT3(tileX * 3 + 1, 6, tileY * 3 + 1), 0, XMFLOAT3(1, 0, 0));
-						//DebugDraw::Line(XMFLOAT3(srcPos.x, 6.2, srcPos.z), XMFLOAT3(x * 3 + 1, 6.2, y * 3 + 1), 0, XMFLOAT3(0, 0, 1));
-						//we hit a different tile, let's see if this is also in our unexplored tiles list, if so mark it visible and remove it
-						if (!hitTile->visible)
-						{
-							hitTile->visible = true;
-							ldata->AddExploredTileNeighboursVisibility(tileY, tileX, areaCode);
-							auto& newIt = ldata->m_UnexploredTiles.find(hitTile);
-							if (newIt != ldata->m_UnexploredTiles.end())
-							{
-								ldata->m_UnexploredTiles.erase(newIt);
-							}
-						}
-					}
-				}
+			tile.visible = true;
+			ldata->m_TileEvents.MarkTile(p.y, p.x);
+			ldata->AddExploredTileNeighboursVisibility(p.y, p.x, areaCode);
+			if (!IsMineableForPlayer(tile.GetType(), tile.owner, Owner_PlayerRed))
+			{
+				tile.marked[Owner_PlayerRed] = false;
 			}
-			c++;
+			ldata->m_UnexploredTiles.Remove(p.y, p.x);
 		}
 	}
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include "ThempCreatureParty.h"
 #include "ThempCreatureTaskManager.h"
 #include "ThempTileArrays.h"
+#include "ThempTimerWheel.h"
+#include "ThempFrustum.h"
 #include <micropather.h>
 //Number derived from imp traveling 20 tiles (96 base speed), which took ~6.5 seconds, since thats tiles/second and our world values are in subtiles, we have to multiply it by 3
 #define BASESPEED_TO_DELTA(x) (((float)(x)) / 10.645161f)
@@ -14,10 +16,26 @@ namespace Themp
 	class D3D;
 	class Object3D;
 	struct Sprite;
+	struct TileChange;
 	class Creature
 	{
 	public:
 		enum class CreatureState { JUST_ENTERED,CREATE_LAIR,UNCERTAIN, HUNGRY, ANNOYED, FIGHTING, EXPLORING, SLEEPING,RESEARCHING,TRAINING,DYING };
+		//event codes passed through the TimerWheel
+		enum TimerEvent { Timer_Hunger, Timer_HungerTick, Timer_TaskSearch };
+		//conditions a suspended creature waits on, anything else leaves it alone until one of these fires
+		enum WakeCondition { Wake_Timer = 1, Wake_TaskAvailable = 2, Wake_EnemyInRange = 4, Wake_Any = 0xFF };
+		//whether we're suspended and on what, Suspend and Wake do the rest (waiting lists, timers) around it
+		struct SuspendState
+		{
+			bool suspended = false;
+			uint8_t wakeConditions = 0;
+			//the timer always wakes us, returns false when we were suspended already
+			bool Suspend(uint8_t conditions);
+			//returns true when this woke us up
+			bool Wake(uint8_t reason);
+			bool WaitsOn(uint8_t reason) const { return suspended && (wakeConditions & reason); }
+		};
 		struct CreatureConstantBuffer
 		{
 			float _AnimIndex;
@@ -34,6 +52,8 @@ namespace Themp
 
 		//spriteIndex = CreatureData::Creature_X
 		Creature(CreatureData::CreatureType spriteIndex);
+		//a creature with the given stats and no sprite or D3D resources, every animation takes HeadlessAnimationFrames, for running the creature code headless (tests)
+		Creature(CreatureData::CreatureType type, const CreatureData& data);
 		void UpdateBuffer();
 		void SetPosition(int subTileX, int height, int subTileY);
 		void SetSprite(int SpriteID);
@@ -70,8 +90,32 @@ namespace Themp
 
 		void CheckVisibility();
 
+		static void OnTimer(void* owner, uint32_t eventCode);
+		//hunger only counts while the creature goes about its business (alive, not held, not fighting and not an imp)
+		bool CanGetHungry();
+		void SetHungerRunning(bool running);
+		void ScheduleHungerStep();
+		void ApplyHungerSteps(uint32_t steps);
+		//HungerRate is the amount of hundredths of a turn per hunger step, progress keeps the hundredths left over so odd rates don't drift, returns the amount of steps taken
+		static uint32_t AdvanceHunger(uint32_t hungerRate, uint32_t& progress, uint64_t turns);
+		void SetTaskSearchTimer();
+		void Suspend(uint8_t wakeConditions);
+		void Wake(uint8_t reason);
+		//a suspended creature doesn't scan for enemies, so map edits that open a path between two of them wake the ones that could see what changed
+		static void WakeNearTileChanges(const TileChange* changes, size_t count);
+		//creatures whose remaining path runs over or right next to one of these tiles re-path on their next step, everyone else keeps walking the path they have
+		static void RepathNearTiles(const std::vector<XMINT2>& tiles);
+
+		//Simulation level of detail, creatures away from the camera that aren't fighting refresh their sprite and exploration less often
+		bool UseReducedRate();
+		//a tile runs at full rate when it's (nearly) in view of the camera, s_SimulationView decides
+		static bool IsReducedRateTile(XMINT2 tilePos);
+		void UpdateAnimationDirections(bool force);
+
 		Object3D* m_Renderable = nullptr;
 		Sprite* m_Sprite = nullptr;
+		bool m_Headless = false;
+		static const int HeadlessAnimationFrames = 8;
 
 		 
 		// creature base data
@@ -80,6 +124,12 @@ namespace Themp
 		bool m_AreaNeedsDiscovering = true;
 		bool m_InCombat = false;
 		bool m_InHand = false;
+		SuspendState m_Suspend;
+		uint8_t m_SimulationSlot = 0;
+		int m_LastDirectionAnimState = -1;
+		uint64_t m_LastPerceptionTurn = UINT64_MAX;
+		uint64_t m_LastVisibilityTurn = UINT64_MAX;
+		uint64_t m_LastCatchUpTurn = UINT64_MAX;
 		int m_CurrentGoldHold = 0;
 		int m_CurrentHungerLevel = 100;
 		int m_CurrentHappiness = 100;
@@ -99,19 +149,26 @@ namespace Themp
 		DirectX::XMFLOAT3 m_Direction;
 		uint8_t m_Owner = Owner_PlayerRed;
 		bool m_JustSlapped = false;
+		bool m_RepathPending = false;
 		float m_Speed = 0;
 		float m_AnimationTime = 0;
 		float m_PathLerpTime = 0;
-		float m_HungerTimer = 0;
 		int m_TurnsTillHungerTick = 100;
-		float m_HungerTickTimer = 0;
+		TimerWheel::Handle m_HungerTimer;
+		TimerWheel::Handle m_HungerTickTimer;
+		bool m_HungerRunning = false;
+		uint32_t m_HungerProgress = 0;
+		uint64_t m_HungerCountedTurn = 0;
+		//what was left of the hunger tick when hunger got paused
+		uint32_t m_HungerTickTurnsLeft = 0;
 
 		int m_AnimationIndex = 0;
 		unsigned int m_CurrentPathIndex = 0;
 
-		float m_PowerCooldownTimer[10];
-		float m_ImpSpecialTimer = 0.0f; //Dig, Claim etc..
-		float m_TaskSearchTimer = 0.0f;
+		//all of these are considered "ready" once they're no longer pending on the TimerWheel
+		TimerWheel::Handle m_PowerCooldownTimer[10];
+		TimerWheel::Handle m_ImpSpecialTimer; //Dig, Claim etc..
+		TimerWheel::Handle m_TaskSearchTimer;
 
 
 		float m_Hero_TimeTillStrike = 0;
@@ -125,5 +182,11 @@ namespace Themp
 		micropather::MPVector<void*> m_Path;
 		CreatureConstantBuffer m_CreatureCBData;
 		ID3D11Buffer* m_CreatureCB = nullptr;
+
+		static uint32_t s_NumSuspended;
+		static uint32_t s_NumReducedRate;
+		static uint8_t s_NextSimulationSlot;
+		//the camera's frustum, set by the level every frame
+		static Frustum s_SimulationView;
 	};
 };
@@ -9,6 +9,7 @@
 #include "../Engine/ThempObject3D.h"
 #include "../Engine/ThempFunctions.h"
 #include <DirectXMath.h>
+#include <algorithm>
 
 using namespace Themp;
 
@@ -16,11 +17,76 @@ std::unordered_map<Tile*,CreatureTaskManager::Task> CreatureTaskManager::MiningT
 std::unordered_map<Tile*, CreatureTaskManager::Task> CreatureTaskManager::ClaimingTasks[4];
 std::unordered_map<Tile*, CreatureTaskManager::Task> CreatureTaskManager::ReinforcingTasks[4];
 std::unordered_map<Creature*,CreatureTaskManager::Task> CreatureTaskManager::TaskedImps[4];
+std::vector<Creature*> CreatureTaskManager::WaitingImps[4];
+std::vector<Creature*> CreatureTaskManager::PendingImps[4];
+CreatureTaskManager::AssignmentStats CreatureTaskManager::AssignStats;
+
+void CreatureTaskManager::Clear()
+{
+	for (int i = 0; i < 4; i++)
+	{
+		MiningTasks[i].clear();
+		ClaimingTasks[i].clear();
+		ReinforcingTasks[i].clear();
+		TaskedImps[i].clear();
+		WaitingImps[i].clear();
+		PendingImps[i].clear();
+	}
+	AssignStats = AssignmentStats();
+}
 
 
+//Runs once per game turn after the creatures updated, every imp that asked for a task since the last turn gets one here
+//this includes the imps that asked during this very frame, so a request waits at most until the frame the next turn starts in
 void CreatureTaskManager::Update(float delta)
 {
+	for (uint8_t player = 0; player < 4; player++)
+	{
+		if (PendingImps[player].size() == 0) continue;
+		Timer timer;
 
+		std::vector<IdleImp> imps;
+		imps.reserve(PendingImps[player].size());
+		for (size_t i = 0; i < PendingImps[player].size(); i++)
+		{
+			Creature* imp = PendingImps[player][i];
+			if (imp->m_Order.valid || imp->m_InCombat || !imp->IsAttackable()) continue;
+			IdleImp idle;
+			idle.imp = imp;
+			idle.tilePos = LevelData::WorldToTile(imp->m_Renderable->m_Position);
+			idle.areaCode = imp->GetAreaCode();
+			imps.push_back(idle);
+		}
+		PendingImps[player].clear();
+
+		//order of priority
+		AssignNearestTasks(Category_SoloMining, player, imps);
+		AssignNearestTasks(Category_Mining, player, imps);
+		AssignNearestTasks(Category_Claiming, player, imps);
+		AssignNearestTasks(Category_Reinforcing, player, imps);
+
+		for (size_t i = 0; i < imps.size(); i++)
+		{
+			Creature* imp = imps[i].imp;
+			if (imps[i].assigned)
+			{
+				imp->m_Order = imps[i].order;
+			}
+			else
+			{
+				if (imp->m_CurrentGoldHold > 0)
+				{
+					imp->m_Order = GetAvailableTreasury(imp, imps[i].areaCode);
+				}
+				if (!imp->m_Order.valid)
+				{
+					imp->m_Order = GetRandomMovementOrder(imp, imps[i].areaCode);
+				}
+			}
+			imp->Wake(Creature::Wake_Any);
+		}
+		AssignStats.microSeconds += timer.GetDeltaTimeMicro();
+	}
 }
 
 
@@ -92,6 +158,7 @@ void Themp::CreatureTaskManager::AddMiningTask(uint8_t player, XMINT2 tilePos, T
 	if (foundIt == MiningTasks[player].end())
 	{
 		MiningTasks[player][tile] = Task(tilePos, tile);
+		WakeWaitingImps(player);
 	}
 }
 void Themp::CreatureTaskManager::AddClaimingTask(uint8_t player, XMINT2 tilePos, Tile* tile)
@@ -100,6 +167,7 @@ void Themp::CreatureTaskManager::AddClaimingTask(uint8_t player, XMINT2 tilePos,
 	if (foundIt == ClaimingTasks[player].end())
 	{
 		ClaimingTasks[player][tile] = Task(tilePos, tile);
+		WakeWaitingImps(player);
 	}
 }
 
@@ -109,316 +177,282 @@ void Themp::CreatureTaskManager::AddReinforcingTask(uint8_t player, XMINT2 tileP
 	if (foundIt == ReinforcingTasks[player].end())
 	{
 		ReinforcingTasks[player][tile] = Task(tilePos, tile);
+		WakeWaitingImps(player);
 	}
 }
-
-CreatureTaskManager::Order Themp::CreatureTaskManager::GetMiningTask(Creature* requestee, int areaCode)
+void Themp::CreatureTaskManager::AddWaitingImp(Creature* imp)
+{
+	if (imp->m_Owner >= 4) return;
+	WaitingImps[imp->m_Owner].push_back(imp);
+}
+void Themp::CreatureTaskManager::RemoveWaitingImp(Creature* imp)
 {
-	uint8_t player = requestee->m_Owner;
-	const XMINT2 subTileOffsets[4] =
+	if (imp->m_Owner >= 4) return;
+	std::vector<Creature*>& waiting = WaitingImps[imp->m_Owner];
+	for (size_t i = 0; i < waiting.size(); i++)
 	{
-		XMINT2(0,3),
-		XMINT2(3,0),
-		XMINT2(0,-1),
-		XMINT2(-1,0),
-	};
-	const XMINT2 masks[4] =
+		if (waiting[i] == imp)
+		{
+			waiting[i] = waiting.back();
+			waiting.pop_back();
+			return;
+		}
+	}
+}
+void Themp::CreatureTaskManager::WakeWaitingImps(uint8_t player)
+{
+	if (WaitingImps[player].size() == 0) return;
+	//Wake removes the imp from the list, so work on a copy
+	std::vector<Creature*> waiting;
+	waiting.swap(WaitingImps[player]);
+	for (size_t i = 0; i < waiting.size(); i++)
 	{
-		XMINT2(1,0),
-		XMINT2(0,1),
-		XMINT2(1,0),
-		XMINT2(0,1),
-	};
+		waiting[i]->Wake(Creature::Wake_TaskAvailable);
+	}
+}
 
-	for (auto i = MiningTasks[player].begin(); i != MiningTasks[player].end(); i++)
+const XMINT2 subTileOffsets[4] =
+{
+	XMINT2(0,3),
+	XMINT2(3,0),
+	XMINT2(0,-1),
+	XMINT2(-1,0),
+};
+const XMINT2 subTileMasks[4] =
+{
+	XMINT2(1,0),
+	XMINT2(0,1),
+	XMINT2(1,0),
+	XMINT2(0,1),
+};
+
+//Finds a free spot at a task reachable from areaCode, returns the index into takenPositions (or -1) without claiming it
+int CreatureTaskManager::FindTaskSpot(TaskCategory category, const Task& task, uint8_t player, int areaCode, XMINT2& outSubTile)
+{
+	const XMINT2 taskSubTile = XMINT2(task.tilePosition.x * 3, task.tilePosition.y * 3);
+	switch (category)
 	{
-		Task& task = i->second;
-
-		Themp::TileNeighbours neighbours = System::tSys->m_Game->m_CurrentLevel->m_LevelData->CheckNeighbours(Type_Earth, task.tilePosition.y, task.tilePosition.x);
-		Themp::TileNeighbourTiles neighbourTiles = System::tSys->m_Game->m_CurrentLevel->m_LevelData->GetNeighbourTiles(task.tilePosition.y, task.tilePosition.x);
-
-		int Walkable[4] =
+	case Category_SoloMining:
+	case Category_Mining:
+	{
+		if (category == Category_SoloMining && task.assignedCreatures != 0)
+		{
+			return -1;
+		}
+		const TileNeighbours neighbours = LevelData::CheckNeighbours(Type_Earth, task.tilePosition.y, task.tilePosition.x);
+		const TileNeighbourTiles neighbourTiles = LevelData::GetNeighbourTiles(task.tilePosition.y, task.tilePosition.x);
+		const int walkable[4] =
 		{
 			(neighbours.North == N_WALKABLE || neighbours.North == N_WATER) && neighbourTiles.North->areaCode == areaCode,
 			(neighbours.East == N_WALKABLE || neighbours.East == N_WATER) && neighbourTiles.East->areaCode == areaCode,
 			(neighbours.South == N_WALKABLE || neighbours.South == N_WATER) && neighbourTiles.South->areaCode == areaCode,
 			(neighbours.West == N_WALKABLE || neighbours.West == N_WATER) && neighbourTiles.West->areaCode == areaCode,
 		};
-		if (task.assignedCreatures >= (Walkable[0] * 3 + Walkable[1] * 3 + Walkable[2] * 3 + Walkable[3] * 3))
+		if (task.assignedCreatures >= (walkable[0] * 3 + walkable[1] * 3 + walkable[2] * 3 + walkable[3] * 3))
 		{
-			continue;
+			return -1;
 		}
-		XMINT2 taskSubTile = XMINT2(task.tilePosition.x * 3, task.tilePosition.y * 3);
-		XMINT2 creatureSubtilePos;
-		int cameFrom = -1;
-		int creatureSpotIndex = -1;
 		for (int k = 0; k < 4; k++)
 		{
-			if (Walkable[k])
+			if (!walkable[k]) continue;
+			for (int j = 0; j < 3; j++)
 			{
-				for (int j = 0; j < 3; j++)
+				if (!task.takenPositions[k * 3 + j])
 				{
-					if (!task.takenPositions[k * 3 + j])
+					outSubTile = XMINT2(taskSubTile.x + subTileOffsets[k].x + j * subTileMasks[k].x, taskSubTile.y + subTileOffsets[k].y + j * subTileMasks[k].y);
+					if (LevelData::s_Map.m_Tiles[outSubTile.y / 3][outSubTile.x / 3].areaCode != areaCode)
 					{
-						creatureSubtilePos = XMINT2(taskSubTile.x + (subTileOffsets[k].x) + j * masks[k].x, taskSubTile.y + (subTileOffsets[k].y) + j * masks[k].y);
-						task.takenPositions[k * 3 + j] = requestee;
-						creatureSpotIndex = k * 3 + j;
-						cameFrom = k;
-						goto SPOTFOUND;
+						return -1;
 					}
+					return k * 3 + j;
 				}
 			}
 		}
-		if (cameFrom == -1)
-		{
-			continue;
-		}
-	SPOTFOUND:
-		XMINT2 creatureTilePos = XMINT2(creatureSubtilePos.x / 3, creatureSubtilePos.y / 3);
-		if (LevelData::m_Map.m_Tiles[creatureTilePos.y][creatureTilePos.x].areaCode != areaCode)
-		{
-			task.takenPositions[creatureSpotIndex] = nullptr;
-			continue;
-		}
-
-		i->second.assignedCreatures++;
-		TaskedImps[player][requestee] = task;
-		return Order(true, creatureSubtilePos, task.tilePosition, Order_Mine, task.tile);
+		return -1;
 	}
-	return Order(false, XMINT2(-1, -1), XMINT2(-1, -1), Order_None, nullptr);
-}
-CreatureTaskManager::Order Themp::CreatureTaskManager::GetSoloMiningTask(Creature* requestee, int areaCode)
-{
-	const uint8_t player = requestee->m_Owner;
-	const XMINT2 subTileOffsets[4] =
+	case Category_Claiming:
 	{
-		XMINT2(0,3),
-		XMINT2(3,0),
-		XMINT2(0,-1),
-		XMINT2(-1,0),
-	};
-	const XMINT2 masks[4] =
-	{
-		XMINT2(1,0),
-		XMINT2(0,1),
-		XMINT2(1,0),
-		XMINT2(0,1),
-	};
-
-	for (auto i = MiningTasks[player].begin(); i != MiningTasks[player].end(); i++)
-	{
-		Task& task = i->second;
-		if (task.assignedCreatures != 0)
+		if (task.assignedCreatures != 0 || LevelData::s_Map.m_Tiles[task.tilePosition.y][task.tilePosition.x].areaCode != areaCode)
 		{
-			continue;
+			return -1;
 		}
-		Themp::TileNeighbours neighbours = System::tSys->m_Game->m_CurrentLevel->m_LevelData->CheckNeighbours(Type_Earth, task.tilePosition.y, task.tilePosition.x);
-		Themp::TileNeighbourTiles neighbourTiles = System::tSys->m_Game->m_CurrentLevel->m_LevelData->GetNeighbourTiles(task.tilePosition.y, task.tilePosition.x);
-
-		int Walkable[4] =
+		const XMFLOAT3 creaturePos = LevelData::TileToWorld(task.tilePosition);
+		outSubTile = XMINT2((int)creaturePos.x, (int)creaturePos.z);
+		return 0;
+	}
+	case Category_Reinforcing:
+	{
+		const TileNeighbours neighbours = LevelData::CheckNeighbours(Type_Earth, task.tilePosition.y, task.tilePosition.x);
+		const TileNeighbourTiles neighbourTiles = LevelData::GetNeighbourTiles(task.tilePosition.y, task.tilePosition.x);
+		const int walkable[4] =
 		{
-			(neighbours.North == N_WALKABLE || neighbours.North == N_WATER) && neighbourTiles.North->areaCode == areaCode,
-			(neighbours.East == N_WALKABLE || neighbours.East == N_WATER) && neighbourTiles.East->areaCode == areaCode,
-			(neighbours.South == N_WALKABLE || neighbours.South == N_WATER) && neighbourTiles.South->areaCode == areaCode,
-			(neighbours.West == N_WALKABLE || neighbours.West == N_WATER) && neighbourTiles.West->areaCode == areaCode,
+			neighbours.North == N_WALKABLE && neighbourTiles.North->owner == player && neighbourTiles.North->areaCode == areaCode,
+			neighbours.East == N_WALKABLE && neighbourTiles.East->owner == player && neighbourTiles.East->areaCode == areaCode,
+			neighbours.South == N_WALKABLE && neighbourTiles.South->owner == player && neighbourTiles.South->areaCode == areaCode,
+			neighbours.West == N_WALKABLE && neighbourTiles.West->owner == player && neighbourTiles.West->areaCode == areaCode,
 		};
-		
-		const XMINT2 taskSubTile = XMINT2(task.tilePosition.x * 3, task.tilePosition.y * 3);
-		XMINT2 creatureSubtilePos;
-		int cameFrom = -1;
-		int creatureSpotIndex = -1;
-		for (int k = 0; k < 4; k++)
+		if (task.assignedCreatures >= (walkable[0] + walkable[1] + walkable[2] + walkable[3]))
+		{
+			return -1;
+		}
+		for (int j = 0; j < 4; j++)
 		{
-			if (Walkable[k])
+			if (walkable[j] && !task.takenPositions[j])
 			{
-				for (int j = 0; j < 3; j++)
+				outSubTile = XMINT2(taskSubTile.x + subTileOffsets[j].x, taskSubTile.y + subTileOffsets[j].y);
+				if (LevelData::s_Map.m_Tiles[outSubTile.y / 3][outSubTile.x / 3].areaCode != areaCode)
 				{
-					if (!task.takenPositions[k * 3 + j])
-					{
-						creatureSubtilePos = XMINT2(taskSubTile.x + (subTileOffsets[k].x) + j * masks[k].x, taskSubTile.y + (subTileOffsets[k].y) + j * masks[k].y);
-						task.takenPositions[k * 3 + j] = requestee;
-						creatureSpotIndex = k * 3 + j;
-						cameFrom = k;
-						goto SPOTFOUND;
-					}
+					return -1;
 				}
+				return j;
 			}
 		}
-		if (cameFrom == -1)
-		{
-			continue;
-		}
-	SPOTFOUND:
-		const XMINT2 creatureTilePos = XMINT2(creatureSubtilePos.x / 3, creatureSubtilePos.y / 3);
-		if (LevelData::m_Map.m_Tiles[creatureTilePos.y][creatureTilePos.x].areaCode != areaCode)
-		{
-			task.takenPositions[creatureSpotIndex] = nullptr;
-			continue;
-		}
-
-		i->second.assignedCreatures++;
-		TaskedImps[player][requestee] = task;
-		return Order(true, creatureSubtilePos, task.tilePosition, Order_Mine, task.tile);
+		return -1;
+	}
+	}
+	return -1;
+}
+CreatureTaskManager::Order CreatureTaskManager::TakeTaskSpot(TaskCategory category, Task& task, int spot, XMINT2 subTile, Creature* requestee, uint8_t player)
+{
+	const uint8_t orderTypes[4] = { Order_Mine, Order_Mine, Order_Claim, Order_Reinforce };
+	task.takenPositions[spot] = requestee;
+	task.assignedCreatures++;
+	TaskedImps[player][requestee] = task;
+	return Order(true, subTile, task.tilePosition, orderTypes[category], task.tile);
+}
+std::unordered_map<Tile*, CreatureTaskManager::Task>& CreatureTaskManager::GetTaskMap(TaskCategory category, uint8_t player)
+{
+	switch (category)
+	{
+	case Category_Claiming:
+		return ClaimingTasks[player];
+	case Category_Reinforcing:
+		return ReinforcingTasks[player];
+	default:
+		return MiningTasks[player];
 	}
-	return Order(false, XMINT2(-1, -1), XMINT2(-1, -1), Order_None, nullptr);
 }
 
-CreatureTaskManager::Order Themp::CreatureTaskManager::GetClaimingTask(Creature* requestee, int areaCode)
+void Themp::CreatureTaskManager::RequestTask(Creature* requestee)
 {
 	const uint8_t player = requestee->m_Owner;
-	for (auto i = ClaimingTasks[player].begin(); i != ClaimingTasks[player].end(); i++)
+	if (player >= 4)
 	{
-		Task& task = i->second;
-		if (task.assignedCreatures == 0)
-		{
-			XMFLOAT3 creaturePos = LevelData::TileToWorld(XMINT2(task.tilePosition.x, task.tilePosition.y));
-			if (LevelData::m_Map.m_Tiles[task.tilePosition.y][task.tilePosition.x].areaCode != areaCode)
-			{
-				continue;
-			}
-			task.takenPositions[0] = requestee;
-			i->second.assignedCreatures++;
-			TaskedImps[player][requestee] = task;
-			return Order(true, XMINT2((int)creaturePos.x,(int)creaturePos.z), task.tilePosition, Order_Claim, task.tile);
-		}
+		requestee->m_Order = GetRandomMovementOrder(requestee, requestee->GetAreaCode());
+		return;
 	}
-	return Order(false, XMINT2(-1, -1), XMINT2(-1, -1), Order_None, nullptr);
+	if (std::find(PendingImps[player].begin(), PendingImps[player].end(), requestee) == PendingImps[player].end())
+	{
+		PendingImps[player].push_back(requestee);
+	}
+}
+void Themp::CreatureTaskManager::RemovePendingImp(Creature* requestee)
+{
+	if (requestee->m_Owner >= 4) return;
+	std::vector<Creature*>& pending = PendingImps[requestee->m_Owner];
+	pending.erase(std::remove(pending.begin(), pending.end(), requestee), pending.end());
 }
 
-CreatureTaskManager::Order Themp::CreatureTaskManager::GetReinforcingTask(Creature* requestee, int areaCode)
+//Hands out tasks of a single category to every idle imp at once, closest imp/task pairs go first
+void Themp::CreatureTaskManager::AssignNearestTasks(TaskCategory category, uint8_t player, std::vector<IdleImp>& imps)
 {
-	const uint8_t player = requestee->m_Owner;
-	const XMINT2 subTileOffsets[4] =
+	struct Candidate
 	{
-		XMINT2(0,3),
-		XMINT2(3,0),
-		XMINT2(0,-1),
-		XMINT2(-1,0),
+		int distance;
+		int imp;
+		Task* task;
+		bool operator<(const Candidate& other) const { return distance < other.distance || (distance == other.distance && imp < other.imp); }
 	};
+	std::unordered_map<Tile*, Task>& tasks = GetTaskMap(category, player);
+	if (tasks.size() == 0) return;
 
-	for (auto i = ReinforcingTasks[player].begin(); i != ReinforcingTasks[player].end(); i++)
+	//imps generally share one or two area codes, so check every task per area instead of per imp
+	std::vector<int> areaCodes;
+	for (size_t i = 0; i < imps.size(); i++)
 	{
-		Task& task = i->second;
-		Themp::TileNeighbours neighbours = System::tSys->m_Game->m_CurrentLevel->m_LevelData->CheckNeighbours(Type_Earth, task.tilePosition.y, task.tilePosition.x);
-		Themp::TileNeighbourTiles neighbourTiles = System::tSys->m_Game->m_CurrentLevel->m_LevelData->GetNeighbourTiles(task.tilePosition.y, task.tilePosition.x);
-
-		int walkable[4] =
+		if (!imps[i].assigned && std::find(areaCodes.begin(), areaCodes.end(), imps[i].areaCode) == areaCodes.end())
 		{
-			neighbours.North == N_WALKABLE && neighbourTiles.North->owner == player && neighbourTiles.North->areaCode == areaCode,
-			neighbours.East == N_WALKABLE && neighbourTiles.East->owner == player && neighbourTiles.East->areaCode == areaCode,
-			neighbours.South == N_WALKABLE && neighbourTiles.South->owner == player && neighbourTiles.South->areaCode == areaCode,
-			neighbours.West == N_WALKABLE && neighbourTiles.West->owner == player && neighbourTiles.West->areaCode == areaCode,
-		};
-		
-		if (task.assignedCreatures >= (walkable[0] + walkable[1] + walkable[2] + walkable[3]))
-		{
-			continue;
+			areaCodes.push_back(imps[i].areaCode);
 		}
-		const XMINT2 taskSubTile = XMINT2(task.tilePosition.x * 3, task.tilePosition.y * 3);
-		XMINT2 creaturePos;
-		int cameFrom = -1;
-		for (int j = 0; j < 4; j++)
+	}
+	if (areaCodes.size() == 0) return;
+
+	std::vector<Candidate> candidates;
+	for (auto it = tasks.begin(); it != tasks.end(); it++)
+	{
+		Task& task = it->second;
+		for (size_t a = 0; a < areaCodes.size(); a++)
 		{
-			if (walkable[j] && !task.takenPositions[j])
+			XMINT2 subTile;
+			if (FindTaskSpot(category, task, player, areaCodes[a], subTile) < 0) continue;
+			for (size_t i = 0; i < imps.size(); i++)
 			{
-				creaturePos = XMINT2(taskSubTile.x + subTileOffsets[j].x, taskSubTile.y + subTileOffsets[j].y);
-				cameFrom = j;
-				break;
+				if (imps[i].assigned || imps[i].areaCode != areaCodes[a]) continue;
+				const int dx = imps[i].tilePos.x - task.tilePosition.x;
+				const int dy = imps[i].tilePos.y - task.tilePosition.y;
+				candidates.push_back({ dx * dx + dy * dy, (int)i, &task });
 			}
 		}
-		if (cameFrom == -1 || LevelData::m_Map.m_Tiles[creaturePos.y / 3][creaturePos.x / 3].areaCode != areaCode)
-		{
-			continue;
-		}
-		task.takenPositions[cameFrom] = requestee;
-		i->second.assignedCreatures++;
-		TaskedImps[player][requestee] = task;
-		return Order(true, creaturePos, task.tilePosition, Order_Reinforce, task.tile);
 	}
-	return Order(false, XMINT2(-1, -1), XMINT2(-1, -1), Order_None,nullptr);
+	std::sort(candidates.begin(), candidates.end());
+
+	for (size_t c = 0; c < candidates.size(); c++)
+	{
+		IdleImp& idle = imps[candidates[c].imp];
+		if (idle.assigned) continue;
+		//earlier assignments may have filled this task up
+		XMINT2 subTile;
+		const int spot = FindTaskSpot(category, *candidates[c].task, player, idle.areaCode, subTile);
+		if (spot < 0) continue;
+
+		idle.order = TakeTaskSpot(category, *candidates[c].task, spot, subTile, idle.imp, player);
+		idle.assigned = true;
+		AssignStats.assignedTasks++;
+		AssignStats.totalDistance += sqrtf((float)candidates[c].distance);
+	}
 }
 CreatureTaskManager::Order Themp::CreatureTaskManager::GetRandomMovementOrder(Creature* requestee, int areaCode)
 {
-	struct TileAndPos { Tile* t; XMINT2 p; };
-	//since there's no method for looking through a list of nearby walkable tiles we'll do it naively, this luckily isn't too much and isn't called that often.
-	std::vector<TileAndPos> walkableTiles;
-	walkableTiles.reserve(4 * 4);
-
-	const int range = 4;
+	LevelData* levelData = Level::s_CurrentLevel->m_LevelData;
 	const XMINT2 tilePos = LevelData::WorldToTile(requestee->m_Renderable->m_Position);
-	const int minY = tilePos.y - range >= range ? tilePos.y - range : range;
-	const int minX = tilePos.x - range >= range ? tilePos.x - range : range;
-	const int maxY = tilePos.y + range < MAP_SIZE_TILES ? tilePos.y + range : MAP_SIZE_TILES - range - 1;
-	const int maxX = tilePos.x + range < MAP_SIZE_TILES ? tilePos.x + range : MAP_SIZE_TILES - range - 1;
-
-	for (int y = minY; y < maxY; y++)
+	XMINT2 p;
+	//nothing walkable close by (shouldn't really happen), just go anywhere in our area instead
+	if (!levelData->GetRandomWalkableTileInRange(areaCode, tilePos, 4, p) && !levelData->GetRandomWalkableTile(areaCode, p))
 	{
-		for (int x = minX; x < maxX; x++)
-		{
-			Tile* t = &LevelData::m_Map.m_Tiles[y][x];
-			if (IsWalkable(t->GetType()) && t->areaCode == areaCode)
-			{
-				walkableTiles.push_back({ t,XMINT2(x,y) });
-			}
-		}
+		return Order(false, XMINT2(-1, -1), XMINT2(-1, -1), Order_None, nullptr);
 	}
-	int randomTile = rand() % walkableTiles.size();
-	TileAndPos& t = walkableTiles[randomTile];
+	Tile* t = &LevelData::s_Map.m_Tiles[p.y][p.x];
+	const TileDetail& detail = LevelData::s_Map.m_TileDetails[p.y][p.x];
 	//really subpar subtile selection but fuck it, its 9 subtiles, no tiles with more than 2 unwalkable subtiles, so the chances this will cause lagg is minimal.
 	while (true)
 	{
 		int randX = rand() % 3;
 		int randY = rand() % 3;
-		if (t.t->pathSubTiles[randY][randX].walkable)
+		if (detail.pathSubTiles[randY][randX].walkable)
 		{
-			return Order(true, LevelData::TileToSubtile(t.p) + XMINT2(randX-1, randY-1), t.p, Order_IdleMovement, t.t);
+			return Order(true, LevelData::TileToSubtile(p) + XMINT2(randX-1, randY-1), p, Order_IdleMovement, t);
 		}
 	}
 	return Order(false, XMINT2(-1, -1), XMINT2(-1, -1), Order_None, nullptr);
 }
 bool Themp::CreatureTaskManager::IsTreasuryAvailable(Creature* requestee, int areaCode)
 {
-	const uint8_t owner = requestee->m_Owner;
-	std::unordered_map<int, LevelData::Room>& rooms = Level::s_CurrentLevel->m_LevelData->m_Rooms[owner];
-	auto& it = rooms.begin();
-	while (it != rooms.end())
-	{
-		if (it->second.areaCode == areaCode && it->second.roomType == Type_Treasure_Room)
-		{
-			if (it->second.roomFillPercentage != 100)
-			{
-				return true;
-			}
-		}
-		it++;
-	}
-	return false;
+	return Level::s_CurrentLevel->m_LevelData->FindRoomWithSpace(requestee->m_Owner, Type_Treasure_Room, areaCode) != nullptr;
 }
 CreatureTaskManager::Order Themp::CreatureTaskManager::GetAvailableTreasury(Creature* requestee, int areaCode)
 {
-	const uint8_t owner = requestee->m_Owner;
-	std::unordered_map<int, LevelData::Room>& rooms = Level::s_CurrentLevel->m_LevelData->m_Rooms[owner];
-	auto& it = rooms.begin();
-	while (it != rooms.end())
+	LevelData::Room* room = Level::s_CurrentLevel->m_LevelData->FindRoomWithSpace(requestee->m_Owner, Type_Treasure_Room, areaCode);
+	if (room != nullptr)
 	{
-		if (it->second.areaCode == areaCode && it->second.roomType == Type_Treasure_Room)
+		//find a suitable tile, the room has at least one that isn't full
+		for (size_t i = 0; i < room->tiles.size(); i++)
 		{
-			if (it->second.roomFillPercentage != 100)
+			const LevelData::Room::RoomTile& tile = room->tiles[i];
+			if (tile.tileValue < room->tileCapacity)
 			{
-				const int roomMaxGoldPerTile = LevelConfig::gameSettings[GameSettings::GAME_GOLD_PILE_MAXIMUM].Value * it->second.roomEfficiency / 100;
-				//find a suitable tile
-				auto& tileIt = it->second.tiles.begin();
-				while (tileIt != it->second.tiles.end())
-				{
-					if (tileIt->second.tileValue < roomMaxGoldPerTile)
-					{
-						return Order(true, XMINT2(tileIt->second.x*3 + 1, tileIt->second.y* 3 + 1), XMINT2(tileIt->second.x, tileIt->second.y), Order_DeliverGold, tileIt->first);
-					}
-					tileIt++;
-				}
+				return Order(true, XMINT2(tile.x * 3 + 1, tile.y * 3 + 1), XMINT2(tile.x, tile.y), Order_DeliverGold, tile.tile);
 			}
 		}
-		it++;
 	}
 
 	return Order(false, XMINT2(-1, -1), XMINT2(-1, -1), Order_None, nullptr);
@@ -426,6 +460,7 @@ CreatureTaskManager::Order Themp::CreatureTaskManager::GetAvailableTreasury(Crea
 void Themp::CreatureTaskManager::UnlistImpFromTask(Creature * requestee)
 {
 	const uint8_t player = requestee->m_Owner;
+	RemovePendingImp(requestee);
 	auto it = TaskedImps[player].find(requestee);
 	if (it != TaskedImps[player].end())
 	{
@@ -480,47 +515,30 @@ void Themp::CreatureTaskManager::UnlistImpFromTask(Creature * requestee)
 CreatureTaskManager::Activity CreatureTaskManager::GetDungeonEnteredActivity(Creature* requestee, int areaCode)
 {
 	const uint8_t owner = requestee->m_Owner;
-	std::unordered_map<int, LevelData::Room>& rooms = Level::s_CurrentLevel->m_LevelData->m_Rooms[owner];
-	auto& it = rooms.begin();
-	while (it != rooms.end())
+	LevelData* levelData = Level::s_CurrentLevel->m_LevelData;
+	const std::vector<int32_t>& hearts = levelData->GetRooms(owner, Type_Dungeon_Heart);
+	for (size_t i = 0; i < hearts.size(); i++)
 	{
-		if (it->second.areaCode == areaCode && it->second.roomType == Type_Dungeon_Heart)
+		const LevelData::Room& room = levelData->m_Rooms[owner][hearts[i]];
+		if (room.areaCode != areaCode) continue;
+		for (auto& tile : room.tiles)
 		{
-			for (auto& tile : it->second.tiles)
+			//find the middle tile (naive method atm), though its only 9 tiles anyhow
+			if (tile.tile->type == (tile.tile->GetType() + (5 << 8)))
 			{
-				//find the middle tile (naive method atm), though its only 9 tiles anyhow
-				if (tile.first->type == (tile.first->GetType() + (5 << 8)))
-				{
-					return Activity(true, XMINT2(tile.second.x*3 +1, tile.second.y*3 +1), XMINT2(tile.second.x, tile.second.y), Activity_GoToHeart, tile.first);
-				}
+				return Activity(true, XMINT2(tile.x*3 +1, tile.y*3 +1), XMINT2(tile.x, tile.y), Activity_GoToHeart, tile.tile);
 			}
 		}
-		it++;
 	}
 	return Activity(false, XMINT2(-1, -1), XMINT2(-1, -1), Activity_None, nullptr);
 }
 CreatureTaskManager::Activity CreatureTaskManager::GetFoodActivity(Creature* requestee, int areaCode)
 {
-	const uint8_t owner = requestee->m_Owner;
-	std::unordered_map<int, LevelData::Room>& rooms = Level::s_CurrentLevel->m_LevelData->m_Rooms[owner];
-	auto& it = rooms.begin();
-	while (it != rooms.end())
+	//should target a random chicken inside the hatchery to feed upon, might do that when we are actually inside the hatchery though..
+	const LevelData::Room::RoomTile* tile = Level::s_CurrentLevel->m_LevelData->GetRandomRoomTile(requestee->m_Owner, Type_Hatchery, areaCode);
+	if (tile != nullptr)
 	{
-		if (it->second.areaCode == areaCode && it->second.roomType == Type_Hatchery)
-		{
-			//should target a random chicken inside the hatchery to feed upon, might do that when we are actually inside the hatchery though..
-
-			//Wow this is a shitty way to get a reference to a random tile..
-			auto& tileIt = it->second.tiles.begin();
-			int off = (rand() % it->second.tiles.size());
-			for (int i = 0; i < off; i++)
-			{
-				tileIt++;
-			}
-			LevelData::Room::RoomTile& tile = tileIt->second;
-			return Activity(true, XMINT2(tile.x * 3 + 1, tile.y * 3 + 1), XMINT2(tile.x, tile.y), Activity_GetFood, tile.tile);
-		}
-		it++;
+		return Activity(true, XMINT2(tile->x * 3 + 1, tile->y * 3 + 1), XMINT2(tile->x, tile->y), Activity_GetFood, tile->tile);
 	}
 	return Activity(false, XMINT2(-1, -1), XMINT2(-1, -1), Activity_None, nullptr);
 }
@@ -529,22 +547,17 @@ CreatureTaskManager::Activity CreatureTaskManager::GetCreateLairActivity(Creatur
 	const uint8_t owner = requestee->m_Owner;
 	if (requestee->m_LairLocation.x == -1 && requestee->m_LairLocation.y == -1)
 	{
-		std::unordered_map<int, LevelData::Room>& rooms = Level::s_CurrentLevel->m_LevelData->m_Rooms[owner];
-		auto& it = rooms.begin();
-		while (it != rooms.end())
+		LevelData::Room* room = Level::s_CurrentLevel->m_LevelData->FindRoomWithSpace(owner, Type_Lair, areaCode);
+		if (room != nullptr)
 		{
-			if (it->second.areaCode == areaCode && it->second.roomType == Type_Lair)
+			for (auto& tile : room->tiles)
 			{
-				for (auto& tile = it->second.tiles.begin(); tile != it->second.tiles.end(); tile++)
+				if (tile.tileValue == 0)
 				{
-					if (tile->second.tileValue == 0)
-					{
-						tile->second.tileValue = 1;
-						return Activity(true, XMINT2(tile->second.x * 3 + 1, tile->second.y * 3 + 1), XMINT2(tile->second.x, tile->second.y), Activity_CreateLair, tile->first);
-					}
+					room->AddToTile(tile, 1);
+					return Activity(true, XMINT2(tile.x * 3 + 1, tile.y * 3 + 1), XMINT2(tile.x, tile.y), Activity_CreateLair, tile.tile);
 				}
 			}
-			it++;
 		}
 	}
 	return Activity(false, XMINT2(-1, -1), XMINT2(-1, -1), Activity_None, nullptr);
@@ -560,42 +573,20 @@ CreatureTaskManager::Activity CreatureTaskManager::GetSleepActivity(Creature* re
 }
 CreatureTaskManager::Activity CreatureTaskManager::GetRandomMovementActivity(Creature* requestee, int areaCode)
 {
-	struct TileAndPos { Tile* t; XMINT2 p; };
-	//since there's no method for looking through a list of nearby walkable tiles we'll do it naively, this luckily isn't too much and isn't called that often.
-	std::vector<TileAndPos> walkableTiles;
-	walkableTiles.reserve(4 * 4);
-
-
-	const int range = 4;
 	const XMINT2 tilePos = LevelData::WorldToTile(requestee->m_Renderable->m_Position);
-	const int minY = tilePos.y - range >= range ? tilePos.y - range : range;
-	const int minX = tilePos.x - range >= range ? tilePos.x - range : range;
-	const int maxY = tilePos.y + range < MAP_SIZE_TILES ? tilePos.y + range : MAP_SIZE_TILES - range - 1;
-	const int maxX = tilePos.x + range < MAP_SIZE_TILES ? tilePos.x + range : MAP_SIZE_TILES - range - 1;
-
-	for (int y = minY; y < maxY; y++)
-	{
-		for (int x = minX; x < maxX; x++)
-		{
-			Tile* t = &LevelData::m_Map.m_Tiles[y][x];
-			if (IsWalkable(t->GetType()) && t->areaCode == areaCode)
-			{
-				walkableTiles.push_back({ t,XMINT2(x,y) });
-			}
-		}
-	}
-	if (walkableTiles.size() > 0)
+	XMINT2 p;
+	if (Level::s_CurrentLevel->m_LevelData->GetRandomWalkableTileInRange(areaCode, tilePos, 4, p))
 	{
-		int randomTile = rand() % walkableTiles.size();
-		TileAndPos& t = walkableTiles[randomTile];
+		Tile* t = &LevelData::s_Map.m_Tiles[p.y][p.x];
+		const TileDetail& detail = LevelData::s_Map.m_TileDetails[p.y][p.x];
 		//really subpar subtile selection but fuck it, its 9 subtiles, no tiles with more than 2 unwalkable subtiles, so the chances this will cause lagg is minimal.
 		while (true)
 		{
 			int randX = rand() % 3;
 			int randY = rand() % 3;
-			if (t.t->pathSubTiles[randY][randX].walkable)
+			if (detail.pathSubTiles[randY][randX].walkable)
 			{
-				return Activity(true, LevelData::TileToSubtile(t.p)+XMINT2(randX-1,randY-1), t.p, Activity_IdleMovement, t.t);
+				return Activity(true, LevelData::TileToSubtile(p)+XMINT2(randX-1,randY-1), p, Activity_IdleMovement, t);
 			}
 		}
 	}
@@ -627,18 +618,43 @@ CreatureTaskManager::Activity CreatureTaskManager::GetActivityByJob(Creature* re
 	return Activity(false, XMINT2(-1, -1), XMINT2(-1, -1), Activity_None, nullptr);
 }
 
+struct ExploreSearch
+{
+	LevelData* levelData;
+	int areaCode;
+	//tiles explored by something else in the mean time, they're taken out of the index once the search is done with it
+	std::vector<XMINT2>* stale;
+};
+static bool IsExplorable(void* context, int y, int x)
+{
+	ExploreSearch* search = static_cast<ExploreSearch*>(context);
+	if (LevelData::s_Map.m_Tiles[y][x].visible)
+	{
+		search->stale->push_back(XMINT2(x, y));
+		return false;
+	}
+	return search->levelData->HasWalkableNeighbour(y, x, search->areaCode);
+}
+static std::vector<XMINT2> StaleUnexploredTiles;
 CreatureTaskManager::Activity CreatureTaskManager::GetExploreActivity(Creature* requestee, int areaCode)
 {
 	LevelData* l = Level::s_CurrentLevel->m_LevelData;
-	if (l->m_UnexploredTiles.size() > 0)
+	if (l->m_UnexploredTiles.Size() > 0)
 	{
-		for (auto& it = l->m_UnexploredTiles.begin(); it != l->m_UnexploredTiles.end(); it++)
+		//go for the closest one on the edge of the creature's own area instead of whatever happened to be first in the list
+		const XMINT2 from = LevelData::WorldToTile(requestee->m_Renderable->m_Position);
+		StaleUnexploredTiles.clear();
+		ExploreSearch search = { l, areaCode, &StaleUnexploredTiles };
+		XMINT2 target;
+		const bool found = l->m_UnexploredTiles.FindNearest((uint32_t)areaCode, from, IsExplorable, &search, target);
+		for (size_t i = 0; i < StaleUnexploredTiles.size(); i++)
 		{
-			if (l->HasWalkableNeighbour(it->second.y, it->second.x,areaCode))
-			{
-				XMINT2 tile = l->GetWalkableNeighbour(it->second.y, it->second.x, areaCode);
-				return Activity(true, LevelData::TileToSubtile(tile), tile, Activity_Explore, it->first);
-			}
+			l->m_UnexploredTiles.Remove(StaleUnexploredTiles[i].y, StaleUnexploredTiles[i].x);
+		}
+		if (found)
+		{
+			XMINT2 tile = l->GetWalkableNeighbour(target.y, target.x, areaCode);
+			return Activity(true, LevelData::TileToSubtile(tile), tile, Activity_Explore, &LevelData::s_Map.m_Tiles[target.y][target.x]);
 		}
 	}
 	return Activity(false, XMINT2(-1, -1), XMINT2(-1, -1), Activity_None, nullptr);
@@ -78,7 +78,27 @@ namespace Themp
 			Tile* tile = nullptr;
 		};
 
+		//order of these is also the order of priority
+		enum TaskCategory { Category_SoloMining, Category_Mining, Category_Claiming, Category_Reinforcing };
+		struct IdleImp
+		{
+			Creature* imp = nullptr;
+			XMINT2 tilePos;
+			int areaCode = 0;
+			bool assigned = false;
+			//what it got handed, Update passes it on to the imp
+			Order order = Order(false, XMINT2(-1, -1), XMINT2(-1, -1), Order_None, nullptr);
+		};
+		struct AssignmentStats
+		{
+			uint32_t assignedTasks = 0;
+			float totalDistance = 0;
+			long long microSeconds = 0;
+		};
+
 		static void Update(float delta);
+		//drops every task and imp, for starting a level from nothing
+		static void Clear();
 		static Activity GetDungeonEnteredActivity(Creature* requestee, int areaCode);
 		static Activity GetFoodActivity(Creature* requestee, int areaCode);
 		static Activity GetCreateLairActivity(Creature* requestee, int areaCode);
@@ -92,18 +112,28 @@ namespace Themp
 		static void AddMiningTask(uint8_t player, XMINT2 tilePos, Tile* tile);
 		static void AddClaimingTask(uint8_t player, XMINT2 tilePos, Tile* tile);
 		static void AddReinforcingTask(uint8_t player, XMINT2 tilePos, Tile* tile);
-		static Order GetMiningTask(Creature * requestee, int areaCode);
-		static Order GetSoloMiningTask(Creature * requestee, int areaCode);
-		static Order GetClaimingTask(Creature* requestee, int areaCode);
-		static Order GetReinforcingTask(Creature* requestee, int areaCode);
 		static Order GetRandomMovementOrder(Creature * requestee, int areaCode);
+		static int FindTaskSpot(TaskCategory category, const Task& task, uint8_t player, int areaCode, XMINT2& outSubTile);
+		static Order TakeTaskSpot(TaskCategory category, Task& task, int spot, XMINT2 subTile, Creature* requestee, uint8_t player);
+		static std::unordered_map<Tile*, Task>& GetTaskMap(TaskCategory category, uint8_t player);
+		static void RequestTask(Creature* requestee);
+		static void RemovePendingImp(Creature* requestee);
+		static void AssignNearestTasks(TaskCategory category, uint8_t player, std::vector<IdleImp>& imps);
 		static bool IsTreasuryAvailable(Creature * requestee, int areaCode);
 		static Order GetAvailableTreasury(Creature * requestee, int areaCode);
 		static void UnlistImpFromTask(Creature* requestee);
+		static void AddWaitingImp(Creature* imp);
+		static void RemoveWaitingImp(Creature* imp);
+		static void WakeWaitingImps(uint8_t player);
 
 		static std::unordered_map<Tile*,Task> MiningTasks[4];
 		static std::unordered_map<Tile*, Task> ClaimingTasks[4];
 		static std::unordered_map<Tile*, Task> ReinforcingTasks[4];
 		static std::unordered_map<Creature*, Task> TaskedImps[4];
+		//suspended imps waiting for a new task to show up
+		static std::vector<Creature*> WaitingImps[4];
+		//imps that asked for a task, handed out together in Update at the end of the frame the next turn starts in
+		static std::vector<Creature*> PendingImps[4];
+		static AssignmentStats AssignStats;
 	};
 };
@@ -22,12 +22,6 @@ void Themp::CPUPlayer::Update(float delta)
 	for (int i = 0; i < m_Creatures.size(); i++)
 	{
 		m_Creatures[i]->Update(delta);
-		if (LevelData::PathsInvalidated)
-		{
-			//one of the creatures did an action that invalidated the paths, reset it again
-			Level::s_CurrentLevel->m_Pather->Reset();
-			LevelData::PathsInvalidated = false;
-		}
 	}
 	for (int i = 0; i < m_DeadCreatures.size(); i++)
 	{
@@ -165,7 +165,11 @@ void PlayerBase::AddCreature(uint8_t owner, Creature* c)
 	m_CreatureCount[c->m_CreatureID]++;
 	m_Creatures.push_back(c);
 	c->m_Owner = owner;
-	System::tSys->m_Game->AddCreature(c);
+	//headless creatures (tests) never get drawn
+	if (!c->m_Headless)
+	{
+		System::tSys->m_Game->AddCreature(c);
+	}
 }
 void PlayerBase::CreatureDied(Creature* c)
 {
@@ -179,11 +183,14 @@ void PlayerBase::CreatureDied(Creature* c)
 			LevelScript::GameValues[m_PlayerID][creatureTypeString]--;
 			m_CreatureCount[c->m_CreatureID]--;
 			m_Creatures.erase(m_Creatures.begin() + i);
-			Entity* e = Level::s_CurrentLevel->m_LevelData->GetMapEntity();
-			e->SetSprite(c->m_CreatureID == CreatureData::CreatureType::CREATURE_IMP ? c->m_CreatureSpriteIndex + 82 : c->m_CreatureSpriteIndex + 42);
-			e->m_Renderable->SetPosition(c->m_Renderable->m_Position);
-			e->ResetScale();
-			System::tSys->m_Game->RemoveCreature(c);
+			if (!c->m_Headless)
+			{
+				Entity* e = Level::s_CurrentLevel->m_LevelData->GetMapEntity();
+				e->SetSprite(c->m_CreatureID == CreatureData::CreatureType::CREATURE_IMP ? c->m_CreatureSpriteIndex + 82 : c->m_CreatureSpriteIndex + 42);
+				e->m_Renderable->SetPosition(c->m_Renderable->m_Position);
+				e->ResetScale();
+				System::tSys->m_Game->RemoveCreature(c);
+			}
 			m_DeadCreatures.push_back(c);
 
 			for (int j = 0; j < 5; j++)
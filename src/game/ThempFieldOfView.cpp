@@ -0,0 +1,80 @@
+#include "ThempFieldOfView.h"
+#include "ThempTileArrays.h"
+using namespace Themp;
+using namespace DirectX;
+
+namespace
+{
+	int FloorDiv(int a, int b)
+	{
+		const int q = a / b;
+		return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+	}
+}
+
+void FieldOfView::Compute(XMINT2 origin, int radius, IsOpaqueCallback isOpaque, RevealCallback reveal, void* context)
+{
+	reveal(context, origin.y, origin.x);
+	for (int quadrant = 0; quadrant < 4; quadrant++)
+	{
+		Scan scan = { origin, quadrant, radius, isOpaque, reveal, context };
+		Row first = { 1, { -1, 1 }, { 1, 1 } };
+		ScanRow(scan, first);
+	}
+}
+
+XMINT2 FieldOfView::Transform(const Scan& scan, int depth, int col)
+{
+	switch (scan.quadrant)
+	{
+	case 0: return XMINT2(scan.origin.x + col, scan.origin.y + depth);
+	case 1: return XMINT2(scan.origin.x + depth, scan.origin.y + col);
+	case 2: return XMINT2(scan.origin.x + col, scan.origin.y - depth);
+	default: return XMINT2(scan.origin.x - depth, scan.origin.y + col);
+	}
+}
+bool FieldOfView::IsOpaque(const Scan& scan, int depth, int col)
+{
+	const XMINT2 p = Transform(scan, depth, col);
+	if (p.x < 0 || p.y < 0 || p.x >= MAP_SIZE_TILES || p.y >= MAP_SIZE_TILES) return true;
+	return scan.isOpaque(scan.context, p.y, p.x);
+}
+
+void FieldOfView::ScanRow(const Scan& scan, Row row)
+{
+	if (row.depth > scan.radius) return;
+
+	//first and last column this row covers, depth * slope rounded with ties going outwards
+	const int minCol = FloorDiv(2 * row.depth * row.start.num + row.start.den, 2 * row.start.den);
+	const int maxCol = -FloorDiv(-2 * row.depth * row.end.num + row.end.den, 2 * row.end.den);
+
+	int prev = -1; //-1 nothing yet, 0 see-through, 1 opaque
+	for (int col = minCol; col <= maxCol; col++)
+	{
+		const XMINT2 p = Transform(scan, row.depth, col);
+		const bool inRange = row.depth * row.depth + col * col <= scan.radius * scan.radius
+			&& p.x >= 0 && p.y >= 0 && p.x < MAP_SIZE_TILES && p.y < MAP_SIZE_TILES;
+		const bool opaque = !inRange || IsOpaque(scan, row.depth, col);
+		//a floor tile is only seen if its centre is inside the row's slopes, that's what makes it symmetric
+		const bool symmetric = col * row.start.den >= row.depth * row.start.num && col * row.end.den <= row.depth * row.end.num;
+		if (inRange && (opaque || symmetric))
+		{
+			scan.reveal(scan.context, p.y, p.x);
+		}
+		if (prev == 1 && !opaque)
+		{
+			row.start = { 2 * col - 1, 2 * row.depth };
+		}
+		if (prev == 0 && opaque)
+		{
+			Row next = { row.depth + 1, row.start, { 2 * col - 1, 2 * row.depth } };
+			ScanRow(scan, next);
+		}
+		prev = opaque ? 1 : 0;
+	}
+	if (prev == 0)
+	{
+		Row next = { row.depth + 1, row.start, row.end };
+		ScanRow(scan, next);
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <DirectXMath.h>
+namespace Themp
+{
+	//Symmetric recursive shadowcasting over the tile grid.
+	//Every tile within 'radius' that can be seen from the origin tile gets passed to the reveal callback (opaque tiles on the edge of sight included, tiles on the diagonals can come by twice),
+	//each quadrant is scanned row by row so the cost only depends on the radius, not on what's being looked for.
+	class FieldOfView
+	{
+	public:
+		FieldOfView() = delete;
+		~FieldOfView() = delete;
+
+		typedef bool(*IsOpaqueCallback)(void* context, int y, int x);
+		typedef void(*RevealCallback)(void* context, int y, int x);
+
+		static void Compute(DirectX::XMINT2 origin, int radius, IsOpaqueCallback isOpaque, RevealCallback reveal, void* context);
+
+	private:
+		//slopes are kept as fractions so the rounding at tile edges is exact
+		struct Slope
+		{
+			int num, den;
+		};
+		struct Row
+		{
+			int depth;
+			Slope start;
+			Slope end;
+		};
+		struct Scan
+		{
+			DirectX::XMINT2 origin;
+			int quadrant;
+			int radius;
+			IsOpaqueCallback isOpaque;
+			RevealCallback reveal;
+			void* context;
+		};
+		static void ScanRow(const Scan& scan, Row row);
+		static DirectX::XMINT2 Transform(const Scan& scan, int depth, int col);
+		static bool IsOpaque(const Scan& scan, int depth, int col);
+	};
+};
@@ -516,6 +516,15 @@ Sound* Themp::FileManager::GetSound(std::string name)
 	}
 	return it->second;
 }
+void Themp::FileManager::PlayOneShot(const std::string& name)
+{
+	if (!System::tSys || !System::tSys->m_Audio) return;
+	Sound* sound = GetSound(name);
+	if (sound)
+	{
+		System::tSys->m_Audio->PlayOneShot(sound);
+	}
+}
 Sound* Themp::FileManager::GetAtlasGoodSound(int index)
 {
 	return AtlasGoodSounds[index % AtlasGoodSounds.size()];
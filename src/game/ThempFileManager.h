@@ -137,6 +137,8 @@ namespace Themp
 
 		static std::string GetText(int i);
 		static Sound* GetSound(std::string name);
+		//plays a loaded sound once, nothing plays without an audio device (the tests run the game code without one) or when the sound isn't loaded
+		static void PlayOneShot(const std::string& name);
 		static Sound * GetAtlasGoodSound(int index);
 		static Sound * GetAtlasBadSound(int index);
 		static std::vector<GUITexture>* GetFont(int source);
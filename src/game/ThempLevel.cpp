@@ -8,6 +8,7 @@
 #include "ThempFont.h"
 #include "ThempResources.h"
 #include "ThempVoxelObject.h"
+#include "ThempLiquidLayer.h"
 #include "ThempEntity.h"
 #include "ThempLevelScript.h"
 #include "../Library/imgui.h"
@@ -25,6 +26,7 @@
 #include "Creature/ThempCreature.h"
 #include "Creature/ThempCreatureParty.h"
 #include "ThempLevelUI.h"
+#include "ThempTimerWheel.h"
 #include <DirectXMath.h>
 using namespace Themp;
 
@@ -32,9 +34,11 @@ Level* Level::s_CurrentLevel = nullptr;
 
 Level::~Level()
 {
+	//the liquid layer and the map object unsubscribe from the level data's tile events
+	delete m_LiquidLayer;
+	delete m_MapObject;
 	delete m_LevelData;
 	delete m_LevelScript;
-	delete m_MapObject;
 	if (m_Pather)
 	{
 		delete m_Pather;
@@ -51,6 +55,10 @@ Level::~Level()
 		}
 	}
 	delete m_LevelUI;
+	if (s_CurrentLevel == this)
+	{
+		s_CurrentLevel = nullptr;
+	}
 }
 XMFLOAT2 cursorOffset = XMFLOAT2(0.03f, 0);
 
@@ -60,6 +68,7 @@ Object3D* tileIndicator = nullptr;
 Level::Level(int levelIndex)
 {
 	s_CurrentLevel = this;
+	TimerWheel::Reset();
 
 
 	//Red is the Human player, this always exists in single player levels
@@ -74,6 +83,8 @@ Level::Level(int levelIndex)
 	m_MapObject = new VoxelObject(m_LevelData);
 	m_MapObject->m_Obj3D->m_Meshes[0]->m_Material->SetTexture(FileManager::GetBlockTexture(m_LevelData->m_MapBlockTextureID));
 	Themp::System::tSys->m_Game->AddObject3D(m_MapObject->m_Obj3D);
+	m_LiquidLayer = new LiquidLayer(m_LevelData, m_MapObject->m_Obj3D->m_Meshes[0]->m_Material);
+	Themp::System::tSys->m_Game->AddObject3D(m_LiquidLayer->m_Obj3D);
 
 	m_LevelUI = new LevelUI();
 
@@ -104,6 +115,17 @@ Level::Level(int levelIndex)
 	m_PatherThroughWalls = new micropather::MicroPather(&m_LevelData->s_Map, 260, 8, false);
 	m_PatherThroughWalls->SetIgnoreWalls(true);
 
+	m_MinimapTiles.resize(MAP_SIZE_TILES * MAP_SIZE_TILES);
+	for (int y = 0; y < MAP_SIZE_TILES; y++)
+	{
+		for (int x = 0; x < MAP_SIZE_TILES; x++)
+		{
+			RefreshMinimapTile(y, x);
+		}
+	}
+	m_LevelData->m_TileEvents.Subscribe(OnPathingTileChanges, this);
+	m_LevelData->m_TileEvents.Subscribe(OnMinimapTileChanges, this);
+
 	System::tSys->m_Game->m_Camera->SetPosition(42 * 3, 12, 38 * 3);
 	System::tSys->m_Game->m_Camera->SetTarget(XMFLOAT3(42 * 3, 12, 38 * 3));
 
@@ -111,6 +133,21 @@ Level::Level(int levelIndex)
 	m_LevelScript->RunInitCommands();
 
 }
+Level::Level(LevelData* levelData)
+{
+	s_CurrentLevel = this;
+	TimerWheel::Reset();
+
+	m_Players[Owner_PlayerRed] = new Player(Owner_PlayerRed);
+	m_Players[Owner_PlayerWhite] = new GoodPlayer(Owner_PlayerWhite);
+	m_Players[Owner_PlayerNone] = new NeutralPlayer(Owner_PlayerNone);
+
+	m_LevelData = levelData;
+	m_Pather = new micropather::MicroPather(&m_LevelData->s_Map, 260, 8, false);
+	m_PatherThroughWalls = new micropather::MicroPather(&m_LevelData->s_Map, 260, 8, false);
+	m_PatherThroughWalls->SetIgnoreWalls(true);
+	m_LevelData->m_TileEvents.Subscribe(OnPathingTileChanges, this);
+}
 
 int SelectedTool = 0;
 int SelectedRoom = 0;
@@ -141,6 +178,7 @@ void Level::Update(float delta)
 
 	int camTilePosX = ((int)camPos.x) / 3;
 	int camTilePosY = ((int)camPos.z) / 3;
+	Creature::s_SimulationView.SetFromViewProjection(g->m_Camera->GetViewProjectionMatrix());
 
 	if (m_IsCompleted)
 	{
@@ -174,7 +212,7 @@ void Level::Update(float delta)
 	//Some level stuff
 	if(ImGui::Button("Explore Map"))
 	{
-		m_LevelData->m_UnexploredTiles.clear();
+		m_LevelData->m_UnexploredTiles.Clear();
 		for (int i = 0; i < 85; i++)
 		{
 			for (int j = 0; j < 85; j++)
@@ -182,6 +220,7 @@ void Level::Update(float delta)
 				m_LevelData->s_Map.m_Tiles[i][j].visible = true;
 			}
 		}
+		m_LevelData->m_TileEvents.MarkArea(0, MAP_SIZE_TILES - 1, 0, MAP_SIZE_TILES - 1);
 	}
 	if (ImGui::Button("Set Low Gold"))
 	{
@@ -192,6 +231,38 @@ void Level::Update(float delta)
 		LevelScript::GameValues[Owner_PlayerRed]["MONEY"] = 10000;
 	}
 	ImGui::Checkbox("Wireframe", &D3D::s_D3D->m_Wireframe);
+	ImGui::Checkbox("Greedy meshing", &VoxelObject::s_GreedyMeshing);
+	ImGui::SliderInt("Mesh threads", &VoxelObject::s_MeshThreads, 1, 16);
+	ImGui::Checkbox("Coarse far chunks", &VoxelObject::s_CoarseLod);
+	ImGui::SliderFloat("Coarse below screen size", &VoxelObject::s_LodScreenSize, 0.0f, 0.5f);
+#ifdef _DEBUG
+	const TimerWheel::Stats& timerStats = TimerWheel::GetLastTurnStats();
+	ImGui::Text("Game turn: %llu, active timers: %zu", TimerWheel::GetCurrentTurn(), TimerWheel::GetActiveTimers());
+	ImGui::Text("Timer work last turn: %u fired, %u cascaded, %u scheduled, %u cancelled", timerStats.fired, timerStats.cascaded, timerStats.scheduled, timerStats.cancelled);
+	const LevelData::AreaUpdateStats& areaStats = m_LevelData->m_AreaUpdateStats;
+	ImGui::Text("Last map flush: %u edits merged into %u updates, %u tiles (%u rebuilt)", areaStats.queuedLastFlush, areaStats.applied, areaStats.tiles, areaStats.rebuilt);
+	ImGui::Text("Block face masks: %u blocks changed, %u masks redone", areaStats.blocksChanged, areaStats.facesRefreshed);
+	const TileEvents::Stats& eventStats = m_LevelData->m_TileEvents.GetStats();
+	ImGui::Text("Tile events: %u changes out of %u tiles in the last batch, %u changes in %u batches", eventStats.changesLastBatch, eventStats.checkedLastBatch, eventStats.changes, eventStats.batches);
+	const LiquidLayer::Stats& liquidStats = m_LiquidLayer->m_Stats;
+	ImGui::Text("Liquid layer: %u quads on %u tiles, rebuilt %u times", liquidStats.quads, liquidStats.tiles, liquidStats.rebuilds);
+	const LightGrid::Stats& lightStats = LevelData::s_LightGrid.GetStats();
+	ImGui::Text("Lights: %zu, light cell entries: %u, most lights on a tile: %u", LevelData::s_LightGrid.GetNumLights(), lightStats.cellEntries, lightStats.mostLightsInCell);
+	ImGui::Text("Unexplored tiles: %zu", m_LevelData->m_UnexploredTiles.Size());
+	const VoxelObject::MeshStats& meshStats = m_MapObject->m_MeshStats;
+	ImGui::Text("Map mesh: %u vertices, %u indices built, %u vertices, %u indices uploaded", meshStats.vertices, meshStats.indices, meshStats.uploadedVertices, meshStats.uploadedIndices);
+	ImGui::Text("Map mesh built in %lld us on %d threads, %u of %d chunks in view (%u coarse)", meshStats.buildMicroseconds, VoxelObject::s_MeshThreads, meshStats.chunks, VoxelObject::NumMeshChunks * VoxelObject::NumMeshChunks, meshStats.coarseChunks);
+	ImGui::Text("Map vertex data: %zu KB packed (%zu KB unpacked)", meshStats.uploadedVertices * sizeof(PackedVoxelVertex) / 1024, meshStats.uploadedVertices * sizeof(VoxelVertex) / 1024);
+	if (VoxelObject::s_GreedyMeshing)
+	{
+		ImGui::Text("Greedy meshing: %u faces merged into %u quads", meshStats.mergedFaces, meshStats.mergedQuads);
+	}
+	const CreatureTaskManager::AssignmentStats& assignStats = CreatureTaskManager::AssignStats;
+	if (assignStats.assignedTasks > 0)
+	{
+		ImGui::Text("Imp tasks assigned: %u, %.2f us per task, %.2f tiles average travel", assignStats.assignedTasks, (float)assignStats.microSeconds / assignStats.assignedTasks, assignStats.totalDistance / assignStats.assignedTasks);
+	}
+#endif
 
 	ImGui::Text("Controls: WASD for forward/back/left/right, Q and E for up and down.");
 
@@ -384,7 +455,8 @@ void Level::Update(float delta)
 
 
 	//Update the map
-	m_MapObject->ConstructFromLevel(camPos.x,camPos.z);
+	m_MapObject->ConstructFromLevel(g->m_Camera->GetViewProjectionMatrix());
+	m_LiquidLayer->Update();
 
 	//minimap room color animation
 	UnOwnedRoomColorTimer += delta;
@@ -401,18 +473,26 @@ void Level::Update(float delta)
 		}
 	}
 	UpdateMinimap();
-	
-	//reset paths if need to
-	if (LevelData::PathsInvalidated)
-	{
-		m_Pather->Reset();
+
+	UpdateSimulation(delta);
+
+	for (int i = 0; i < m_LevelData->m_MapEntityUsed.size(); i++)
+	{ 
+		m_LevelData->m_MapEntityUsed[i]->Update(delta);
 	}
 
+	m_LevelScript->Update(delta);
+	
+}
+void Level::UpdateSimulation(float delta)
+{
 	m_CreatureGenerateTurnTimer += delta;
 	const float turnDelta = 1.0f / GAME_TURNS_PER_SECOND;
-	if (m_CreatureGenerateTurnTimer > turnDelta)
+	const bool turnStarted = m_CreatureGenerateTurnTimer > turnDelta;
+	if (turnStarted)
 	{
 		m_CreatureGenerateTurnTimer -= turnDelta;
+		TimerWheel::Advance();
 		m_CreatureGenerateTurns++;
 		int generateSpeed = LevelScript::GameValues[Owner_PlayerRed]["GENERATE_SPEED"];
 		if (m_CreatureGenerateTurns >= generateSpeed)
@@ -429,19 +509,23 @@ void Level::Update(float delta)
 		}
 	}
 
+	Creature::s_NumReducedRate = 0;
 	for (int player = 0; player < 6; player++)
 	{
 		if (m_Players[player] == nullptr) continue;
 		m_Players[player]->Update(delta);
 	}
-
-	for (int i = 0; i < m_LevelData->m_MapEntityUsed.size(); i++)
-	{ 
-		m_LevelData->m_MapEntityUsed[i]->Update(delta);
+#ifdef _DEBUG
+	//after the creatures updated, so these are this frame's numbers
+	ImGui::Text("Suspended creatures: %u, reduced rate creatures: %u", Creature::s_NumSuspended, Creature::s_NumReducedRate);
+#endif
+	//all map edits of this frame (digging, claiming, building) get applied here in one go
+	m_LevelData->FlushAreaUpdates();
+	//after the creatures and the map edits, so the imps that asked for a task this frame don't wait for another turn
+	if (turnStarted)
+	{
+		CreatureTaskManager::Update(turnDelta);
 	}
-
-	m_LevelScript->Update(delta);
-	
 }
 
 int Level::PathFind(XMINT2 A, XMINT2 B, micropather::MPVector<void*>& outPath, float& outCost, bool AllowDoors)
@@ -456,54 +540,138 @@ int Level::PathFindThroughWalls(XMINT2 A, XMINT2 B, micropather::MPVector<void*>
 	uint64_t BPos = ((((uint64_t)B.y) << 32) | (uint64_t)B.x);
 	return  m_PatherThroughWalls->Solve((void*)APos, (void*)BPos, &outPath, &outCost);
 }
-void Level::UpdateMinimap()
+//minimap texturing
+static const BYTE OwnerColorsPath[6][4] =
 {
-	BYTE* miniMapScratchData = m_LevelUI->m_MiniMapScratchData;
-	XMFLOAT3 camPos = System::tSys->m_Game->m_Camera->GetPosition();
-	camPos.z = MAP_SIZE_SUBTILES_RENDER - camPos.z;
-	//minimap texturing
-	const BYTE OwnerColorsPath[6][4] =
 	{
-		{
-			0x86,0x2C,0x00,0xFF, //red
-		},
-		{
-			0x8A,0x71,0x96,0xFF, //blue
-		},
-		{
-			0x34,0x5D,0x04,0xFF, //green
-		},
-		{
-			0xBE,0x9E,0x00,0xFF, //yellow
-		},
-		{
-			0xB6,0xA2,0x7D,0xFF, //white
-		},
-		{
-			0x34,0x24,0x04,0xFF, //none
-		},
-	};
-	const BYTE OwnerColorsRoom[6][4] =
+		0x86,0x2C,0x00,0xFF, //red
+	},
 	{
+		0x8A,0x71,0x96,0xFF, //blue
+	},
+	{
+		0x34,0x5D,0x04,0xFF, //green
+	},
+	{
+		0xBE,0x9E,0x00,0xFF, //yellow
+	},
+	{
+		0xB6,0xA2,0x7D,0xFF, //white
+	},
+	{
+		0x34,0x24,0x04,0xFF, //none
+	},
+};
+static const BYTE OwnerColorsRoom[6][4] =
+{
+	{
+		0x9E,0x30,0x00,0xFF, //red
+	},
+	{
+		0xA2,0x8A,0xB6,0xFF, //blue
+	},
+	{
+		0x38,0x71,0x0C,0xFF, //green
+	},
+	{
+		0xE7,0xD7,0x00,0xFF, //yellow
+	},
+	{
+		0xBE,0xAA,0x86,0xFF, //white
+	},
+	{
+		0x34,0x24,0x04,0xFF, //none
+	},
+};
+static const BYTE MinimapRock[4] = { 0x00,0x00,0x00,0xFF };
+static const BYTE MinimapLava[4] = { 0x38,0x1C,0x00,0xFF };
+static const BYTE MinimapWater[4] = { 0x65,0x4D,0x49,0xFF };
+static const BYTE MinimapWall[4] = { 0x5D,0x45,0x1C,0xFF };
+static const BYTE MinimapEarth[4] = { 0x30,0x20,0x04,0xFF };
+static const BYTE MinimapGold[4] = { 0x71,0x6D,0x18,0xFF };
+static const BYTE MinimapDoor[4] = { 0x92,0x9A,0x51,0xFF };
+static const BYTE MinimapLockedDoor[4] = { 0xF7,0x86,0x5D,0xFF };
+static const BYTE MinimapUnknown[4] = { 0xFF,0x00,0xFF,0xFF };
+static const BYTE MinimapUnexplored[4] = { 0x30,0x20,0x04,0xFF };
+static const BYTE MinimapMarkedGold[4] = { 0xE2,0xBC,0x6A,0xFF };
+static const BYTE MinimapMarked[4] = { 0x79,0x65,0x38,0xFF };
+static const BYTE MinimapCamera[4] = { 0xFF,0xFF,0xFF,0xFF };
+
+void Level::RefreshMinimapTile(int y, int x)
+{
+	const Tile& tile = m_LevelData->s_Map.m_Tiles[y][x];
+	MinimapTile& out = m_MinimapTiles[y * MAP_SIZE_TILES + x];
+	const uint16_t tileType = tile.type & 0xFF;
+	const BYTE* color = MinimapUnexplored;
+	out.unownedRoom = false;
+	if (tile.visible)
+	{
+		if (tileType == Type_Claimed_Land) color = OwnerColorsPath[tile.owner];
+		else if (tileType == Type_Unclaimed_Path) color = OwnerColorsPath[Owner_PlayerNone];
+		else if (tileType == Type_Rock) color = MinimapRock;
+		else if (tileType == Type_Lava) color = MinimapLava;
+		else if (tileType == Type_Water) color = MinimapWater;
+		else if (IsWall(tileType)) color = MinimapWall;
+		else if (tileType == Type_Earth || tileType == Type_Earth_Torch) color = MinimapEarth;
+		else if (tileType == Type_Gold) color = MinimapGold;
+		else if (tileType >= Type_Portal && tileType <= Type_Barracks)
 		{
-			0x9E,0x30,0x00,0xFF, //red
-		},
-		{
-			0xA2,0x8A,0xB6,0xFF, //blue
-		},
-		{
-			0x38,0x71,0x0C,0xFF, //green
-		},
-		{
-			0xE7,0xD7,0x00,0xFF, //yellow
-		},
+			out.unownedRoom = tile.owner == Owner_PlayerNone;
+			color = OwnerColorsRoom[tile.owner];
+		}
+		else if (tileType >= Type_Wooden_DoorH && tileType <= Type_Magic_DoorV) color = MinimapDoor;
+		else if (tileType >= Type_Wooden_DoorH_Locked && tileType <= Type_Magic_DoorV_Locked) color = MinimapLockedDoor;
+		else color = MinimapUnknown;
+	}
+	memcpy(out.color, color, 4);
+}
+void Level::OnMinimapTileChanges(void* context, const TileChange* changes, size_t count)
+{
+	Level* level = (Level*)context;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (changes[i].fields & (TileChange::Field_Type | TileChange::Field_Owner | TileChange::Field_Visible))
 		{
-			0xBE,0xAA,0x86,0xFF, //white
-		},
+			level->RefreshMinimapTile(changes[i].y, changes[i].x);
+		}
+	}
+}
+//The cached paths only go stale when walkable subtiles change, the pather that digs through walls also cares about tiles that stopped (or started) being mineable
+//only the creatures walking over or past those tiles need a new path
+static std::vector<XMINT2> PathingTileChanges;
+void Level::OnPathingTileChanges(void* context, const TileChange* changes, size_t count)
+{
+	Level* level = (Level*)context;
+	bool walkableChanged = false;
+	PathingTileChanges.clear();
+	for (size_t i = 0; i < count; i++)
+	{
+		const TileChange& change = changes[i];
+		const bool walkable = (change.fields & TileChange::Field_Walkable) != 0;
+		const bool mineable = (change.fields & TileChange::Field_Type) && IsMineable(change.before.type & 0xFF) != IsMineable(change.after.type & 0xFF);
+		walkableChanged |= walkable;
+		if (walkable || mineable)
 		{
-			0x34,0x24,0x04,0xFF, //none
-		},
-	};
+			PathingTileChanges.push_back(XMINT2(change.x, change.y));
+		}
+	}
+	if (walkableChanged)
+	{
+		Creature::WakeNearTileChanges(changes, count);
+		level->m_Pather->Reset();
+	}
+	if (PathingTileChanges.size())
+	{
+		level->m_PatherThroughWalls->Reset();
+		Creature::RepathNearTiles(PathingTileChanges);
+	}
+}
+
+void Level::UpdateMinimap()
+{
+	BYTE* miniMapScratchData = m_LevelUI->m_MiniMapScratchData;
+	XMFLOAT3 camPos = System::tSys->m_Game->m_Camera->GetPosition();
+	camPos.z = MAP_SIZE_SUBTILES_RENDER - camPos.z;
 	for (int y = 0; y < MAP_SIZE_SUBTILES_RENDER; y++)
 	{
 		const int yTile = 84 - (y / 3);
@@ -511,151 +679,29 @@ void Level::UpdateMinimap()
 		{
 			const int xTile = x / 3;
 			const Tile& tile = m_LevelData->s_Map.m_Tiles[yTile][xTile];
-			const unsigned int texPos = (x + y * MAP_SIZE_SUBTILES) * 4;
-			uint16_t tileType = tile.type & 0xFF;
-			if (tile.visible)
-			{
-				if (tileType == Type_Claimed_Land)
-				{
-					miniMapScratchData[texPos + 0] = OwnerColorsPath[tile.owner][0];
-					miniMapScratchData[texPos + 1] = OwnerColorsPath[tile.owner][1];
-					miniMapScratchData[texPos + 2] = OwnerColorsPath[tile.owner][2];
-					miniMapScratchData[texPos + 3] = OwnerColorsPath[tile.owner][3];
-				}
-				else if (tileType == Type_Unclaimed_Path)
-				{
-					miniMapScratchData[texPos + 0] = OwnerColorsPath[Owner_PlayerNone][0];
-					miniMapScratchData[texPos + 1] = OwnerColorsPath[Owner_PlayerNone][1];
-					miniMapScratchData[texPos + 2] = OwnerColorsPath[Owner_PlayerNone][2];
-					miniMapScratchData[texPos + 3] = OwnerColorsPath[Owner_PlayerNone][3];
-				}
-				else if (tileType == Type_Rock)
-				{
-					miniMapScratchData[texPos + 0] = 0x00;
-					miniMapScratchData[texPos + 1] = 0x00;
-					miniMapScratchData[texPos + 2] = 0x00;
-					miniMapScratchData[texPos + 3] = 0xFF;
-				}
-				else if (tileType == Type_Lava)
-				{
-					miniMapScratchData[texPos + 0] = 0x38;
-					miniMapScratchData[texPos + 1] = 0x1C;
-					miniMapScratchData[texPos + 2] = 0x00;
-					miniMapScratchData[texPos + 3] = 0xFF;
-				}
-				else if (tileType == Type_Water)
-				{
-					miniMapScratchData[texPos + 0] = 0x65;
-					miniMapScratchData[texPos + 1] = 0x4D;
-					miniMapScratchData[texPos + 2] = 0x49;
-					miniMapScratchData[texPos + 3] = 0xFF;
-				}
-				else if (IsWall(tileType))
-				{
-					miniMapScratchData[texPos + 0] = 0x5D;
-					miniMapScratchData[texPos + 1] = 0x45;
-					miniMapScratchData[texPos + 2] = 0x1C;
-					miniMapScratchData[texPos + 3] = 0xFF;
-				}
-				else if (tileType == Type_Earth || tileType == Type_Earth_Torch)
-				{
-					miniMapScratchData[texPos + 0] = 0x30;
-					miniMapScratchData[texPos + 1] = 0x20;
-					miniMapScratchData[texPos + 2] = 0x04;
-					miniMapScratchData[texPos + 3] = 0xFF;
-				}
-				else if (tileType == Type_Gold)
-				{
-					miniMapScratchData[texPos + 0] = 0x71;
-					miniMapScratchData[texPos + 1] = 0x6D;
-					miniMapScratchData[texPos + 2] = 0x18;
-					miniMapScratchData[texPos + 3] = 0xFF;
-				}
-				else if (tileType >= Type_Portal && tileType <= Type_Barracks)
-				{
-					if (tile.owner == Owner_PlayerNone)
-					{
-						miniMapScratchData[texPos + 0] = OwnerColorsRoom[UnownedRoomColorIndex][0];
-						miniMapScratchData[texPos + 1] = OwnerColorsRoom[UnownedRoomColorIndex][1];
-						miniMapScratchData[texPos + 2] = OwnerColorsRoom[UnownedRoomColorIndex][2];
-						miniMapScratchData[texPos + 3] = OwnerColorsRoom[UnownedRoomColorIndex][3];
-					}
-					else
-					{
-						miniMapScratchData[texPos + 0] = OwnerColorsRoom[tile.owner][0];
-						miniMapScratchData[texPos + 1] = OwnerColorsRoom[tile.owner][1];
-						miniMapScratchData[texPos + 2] = OwnerColorsRoom[tile.owner][2];
-						miniMapScratchData[texPos + 3] = OwnerColorsRoom[tile.owner][3];
-					}
-				}
-				else if (tileType >= Type_Wooden_DoorH && tileType <= Type_Magic_DoorV)
-				{
-					miniMapScratchData[texPos + 0] = 0x92;
-					miniMapScratchData[texPos + 1] = 0x9A;
-					miniMapScratchData[texPos + 2] = 0x51;
-					miniMapScratchData[texPos + 3] = 0xFF;
-				}
-				else if (tileType >= Type_Wooden_DoorH_Locked && tileType <= Type_Magic_DoorV_Locked)
-				{
-					miniMapScratchData[texPos + 0] = 0xF7;
-					miniMapScratchData[texPos + 1] = 0x86;
-					miniMapScratchData[texPos + 2] = 0x5D;
-					miniMapScratchData[texPos + 3] = 0xFF;
-				}
-				else
-				{
-					miniMapScratchData[texPos + 0] = 0xFF;
-					miniMapScratchData[texPos + 1] = 0x0;
-					miniMapScratchData[texPos + 2] = 0xFF;
-					miniMapScratchData[texPos + 3] = 0xFF;
-				}
-			}
-			else
-			{
-				miniMapScratchData[texPos + 0] = 0x30;
-				miniMapScratchData[texPos + 1] = 0x20;
-				miniMapScratchData[texPos + 2] = 0x04;
-				miniMapScratchData[texPos + 3] = 0xFF;
-			}
+			const MinimapTile& minimapTile = m_MinimapTiles[yTile * MAP_SIZE_TILES + xTile];
+			const BYTE* color = minimapTile.unownedRoom ? OwnerColorsRoom[UnownedRoomColorIndex] : minimapTile.color;
 			if (tile.marked[Owner_PlayerRed])
 			{
-				if (tileType == Type_Gold || tileType == Type_Gem)
-				{
-					miniMapScratchData[texPos + 0] = 0xE2;
-					miniMapScratchData[texPos + 1] = 0xBC;
-					miniMapScratchData[texPos + 2] = 0x6A;
-					miniMapScratchData[texPos + 3] = 0xFF;
-				}
-				else
-				{
-					miniMapScratchData[texPos + 0] = 0x79;
-					miniMapScratchData[texPos + 1] = 0x65;
-					miniMapScratchData[texPos + 2] = 0x38;
-					miniMapScratchData[texPos + 3] = 0xFF;
-				}
+				const uint16_t tileType = tile.type & 0xFF;
+				color = (tileType == Type_Gold || tileType == Type_Gem) ? MinimapMarkedGold : MinimapMarked;
 			}
 
-
 			if (x == (int)camPos.x - 24 || x == (int)camPos.x + 24)
 			{
 				if (y >= (int)camPos.z - 24 && y <= (int)camPos.z + 24)
 				{
-					miniMapScratchData[texPos + 0] = 0xFF;
-					miniMapScratchData[texPos + 1] = 0xFF;
-					miniMapScratchData[texPos + 2] = 0xFF;
-					miniMapScratchData[texPos + 3] = 0xFF;
+					color = MinimapCamera;
 				}
 			}
 			if (y == (int)camPos.z - 24 || y == (int)camPos.z + 24)
 			{
 				if (x >= (int)camPos.x - 24 && x <= (int)camPos.x + 24)
 				{
-					miniMapScratchData[texPos + 0] = 0xFF;
-					miniMapScratchData[texPos + 1] = 0xFF;
-					miniMapScratchData[texPos + 2] = 0xFF;
-					miniMapScratchData[texPos + 3] = 0xFF;
+					color = MinimapCamera;
 				}
 			}
+			memcpy(&miniMapScratchData[(x + y * MAP_SIZE_SUBTILES) * 4], color, 4);
 		}
 	}
 	//PATH DEBUG
@@ -707,22 +753,15 @@ void Level::UpdateMinimap()
 void Themp::Level::SpawnCreature(uint8_t player)
 {
 	
-	std::vector<LevelData::Room*> entrances;
-	for (auto& room : m_LevelData->m_Rooms[player])
-	{
-		if (room.second.roomType == Type_Portal)
-		{
-			entrances.push_back(&room.second);
-		}
-	}
+	const std::vector<int32_t>& entrances = m_LevelData->GetRooms(player, Type_Portal);
 	if (entrances.size() > 0)
 	{
 		int randRoom = rand() % entrances.size();
-		LevelData::Room* room = entrances[randRoom];
+		LevelData::Room* room = &m_LevelData->m_Rooms[player][entrances[randRoom]];
 		for (auto& tile : room->tiles)
 		{
 			//find the middle tile (naive method atm)
-			if (tile.first->type == (tile.first->GetType() + (5 << 8)))
+			if (tile.tile->type == (tile.tile->GetType() + (5 << 8)))
 			{
 				std::vector<int> available;
 				for (int i = 0; i < m_AvailableCreatures.size(); i++)
@@ -739,7 +778,7 @@ void Themp::Level::SpawnCreature(uint8_t player)
 				int selectedindex = rand() % available.size();
 				Creature* c = new Creature(m_AvailableCreatures[available[selectedindex]].type);
 				m_Players[player]->AddCreature(player,c);
-				c->m_Renderable->SetPosition(tile.second.x*3 + 1,tile.first->pathSubTiles[1][1].height+1,tile.second.y*3 + 1);
+				c->m_Renderable->SetPosition(tile.x*3 + 1,LevelData::s_Map.m_TileDetails[tile.y][tile.x].pathSubTiles[1][1].height+1,tile.y*3 + 1);
 				m_AvailableCreatures[available[selectedindex]].amount--;
 				break;
 			}
@@ -9,6 +9,7 @@ namespace Themp
 {
 	class D3D;
 	class VoxelObject;
+	class LiquidLayer;
 	class Object3D;
 	class Object2D;
 	class Creature;
@@ -17,6 +18,7 @@ namespace Themp
 	class LevelScript;
 	class PlayerBase;
 	class LevelUI;
+	struct TileChange;
 
 	struct AvailableCreatureInPool
 	{
@@ -30,13 +32,23 @@ namespace Themp
 		
 		~Level();
 		Level(int levelIndex);
+		//a level around the given (initialized) level data with only the players and the pathing, no map mesh, script, UI or camera, for running the creatures headless (tests)
+		//the level data is the level's to delete from then on
+		Level(LevelData* levelData);
 		void AvailableRoomsChanged();
 		void Update(float delta);
+		//the game turns, the creatures and the map edits they made, what's left of Update without the camera, input and drawing
+		void UpdateSimulation(float delta);
 		int PathFind(DirectX::XMINT2 A, DirectX::XMINT2 B, micropather::MPVector<void*>& outPath, float & outCost, bool AllowDoors);
 		int PathFindThroughWalls(DirectX::XMINT2 A, DirectX::XMINT2 B, micropather::MPVector<void*>& outPath, float & outCost, bool AllowDoors);
 		void UpdateMinimap();
+		void RefreshMinimapTile(int y, int x);
 		void SpawnCreature(uint8_t player);
 
+		//subscribers of the level data's tile events
+		static void OnPathingTileChanges(void* context, const TileChange* changes, size_t count);
+		static void OnMinimapTileChanges(void* context, const TileChange* changes, size_t count);
+
 
 		bool m_IsCompleted = false;
 		bool m_Ended = false;
@@ -57,7 +69,17 @@ namespace Themp
 		int m_CreatureGenerateTurns = 0;
 		int UnownedRoomColorIndex = 0;
 
+		//colour of every tile on the minimap, only redone for the tiles the tile events report
+		//unowned rooms flash through the owner colours, they get their colour when the minimap is drawn
+		struct MinimapTile
+		{
+			uint8_t color[4];
+			bool unownedRoom;
+		};
+		std::vector<MinimapTile> m_MinimapTiles;
+
 		VoxelObject* m_MapObject = nullptr;
+		LiquidLayer* m_LiquidLayer = nullptr;
 		LevelData* m_LevelData = nullptr;
 		LevelScript* m_LevelScript = nullptr;
 		LevelUI* m_LevelUI = nullptr;
@@ -9,6 +9,7 @@
 #include "Creature/ThempCreatureTaskManager.h"
 #include "ThempAudio.h"
 #include "ThempVoxelObject.h"
+#include "ThempVoxelModels.h"
 #include "ThempEntity.h"
 #include "../Library/imgui.h"
 #include "../Engine/ThempCamera.h"
@@ -23,17 +24,21 @@
 #include "ThempLevelConfig.h"
 #include "ThempLevelScript.h"
 #include <DirectXMath.h>
+#include <algorithm>
 using namespace Themp;
 using namespace DirectX;
 using XMFLOAT2 = DirectX::XMFLOAT2;
 
 TileMap LevelData::s_Map;
-std::unordered_map<uint32_t, Light> LevelData::s_Lights;
-std::array<uint32_t, MAP_SIZE_TILES*MAP_SIZE_TILES * MAX_LIGHTS_PER_TILE> LevelData::s_PerTileLights;
-bool LevelData::PathsInvalidated;
+LightGrid LevelData::s_LightGrid;
 uint32_t NextAreaCode = 0;
+
+//tiles of these types split up areas, everything else is part of one
+static bool IsAreaSeparator(uint16_t type)
+{
+	return type >= Type_Rock && type <= Type_Wall5 || type == Type_Lava || type == Type_Gem;
+}
 int32_t nextRoomID = 0;
-uint32_t currentLightIndex = 0;
 LevelData::~LevelData()
 {
 	for (int i = 0; i < m_MapEntityUsed.size(); i++)
@@ -51,13 +56,6 @@ LevelData::~LevelData()
 LevelData::LevelData(int levelIndex)
 {
 	m_CurrentLevelNr = levelIndex;
-	PathsInvalidated = true;
-	m_Rooms[0].reserve(24);
-	m_Rooms[1].reserve(24);
-	m_Rooms[2].reserve(24);
-	m_Rooms[3].reserve(24);
-	m_Rooms[4].reserve(24);
-	m_Rooms[5].reserve(24);
 	for (int i = 0; i < 128; i++)
 	{
 		Entity* e = new Entity(Entity::Entity_Gold0_FP);
@@ -65,25 +63,72 @@ LevelData::LevelData(int levelIndex)
 		e->SetVisibility(false);
 		m_MapEntityPool.push(e);
 	}
+	ResetTileData();
+
+	LoadLevelFileData();
+	m_TileEvents.Subscribe(OnTileChanges, this);
+	m_TileEvents.Subscribe(OnLightTileChanges, this);
+}
+LevelData::LevelData(const TileMap& map)
+{
+	m_CurrentLevelNr = -1;
+	ResetTileData();
+	s_Map = map;
+	m_OriginalMap = map;
+	m_TileEvents.Subscribe(OnTileChanges, this);
+	m_TileEvents.Subscribe(OnLightTileChanges, this);
+}
+void LevelData::ResetTileData()
+{
+	//every block starts out there, Init builds the whole map over it
+	memset(m_BlockOccupancy, 0xFF, sizeof(m_BlockOccupancy));
+	memset(m_AreaSearchMark, 0, sizeof(m_AreaSearchMark));
+	m_AreaSearchStamp = 0;
+	//room ids count up from the start for every level
+	nextRoomID = 0;
+	m_Rooms[0].reserve(24);
+	m_Rooms[1].reserve(24);
+	m_Rooms[2].reserve(24);
+	m_Rooms[3].reserve(24);
+	m_Rooms[4].reserve(24);
+	m_Rooms[5].reserve(24);
 
-	for (size_t i = 0; i < s_PerTileLights.size(); i++)
+	s_LightGrid.Clear();
+	for (int y = 0; y < MAP_SIZE_TILES; y++)
 	{
-		s_PerTileLights[i] = -1;
+		for (int x = 0; x < MAP_SIZE_TILES; x++)
+		{
+			m_WalkableTileArea[y][x] = 0;
+			m_WalkableTileIndex[y][x] = -1;
+			//the block map isn't filled in until Init, until then rays check every block
+			m_TileSolidHeight[y][x] = RaycastHeight;
+			m_TileRenderKeys[y][x].valid = false;
+			m_TileModels[y][x] = Tile_FULLBLOCK;
+			m_TorchLights[y][x] = NoTorchLight;
+		}
 	}
-	
-
-	LoadLevelFileData();
 }
 void LevelData::Init()
 {
 	UpdateArea(0, 84, 0, 84);
+	//the masks UpdateArea kept up to date don't know what the blocks looked like before the first build, so do them all once
+	UpdateAllBlockFaces();
+	//no events for the initial build, every tile gets its tasks once instead
+	for (int y = 0; y < MAP_SIZE_TILES; y++)
+	{
+		for (int x = 0; x < MAP_SIZE_TILES; x++)
+		{
+			RefreshTileTasks(y, x);
+			UpdateTorchLight(y, x);
+		}
+	}
 	NextAreaCode = 1;
 	for (int y = 1; y < 84; y++)
 	{
 		for (int x = 1; x < 84; x++)
 		{
 			uint16_t cType = s_Map.m_Tiles[y][x].type & 0xFF;
-			if (s_Map.m_Tiles[y][x].areaCode == 0 && !(cType >= Type_Rock && cType <= Type_Wall5 || cType == Type_Lava || cType == Type_Gem))
+			if (s_Map.m_Tiles[y][x].areaCode == 0 && !IsAreaSeparator(cType))
 			{
 				UpdateAreaCode(NextAreaCode, cType, y, x);
 				NextAreaCode++;
@@ -94,10 +139,11 @@ void LevelData::Init()
 	{
 		for (auto& it = m_Rooms[i].begin(); it != m_Rooms[i].end(); it++)
 		{
-			it->second.areaCode = it->second.tiles.begin()->first->areaCode;
+			it->second.areaCode = it->second.tiles[0].tile->areaCode;
 		}
 	}
-	
+	//from here on the tile events report against the map as it's been loaded
+	m_TileEvents.Reset(s_Map);
 }
 
 
@@ -194,7 +240,9 @@ LevelData::HitData LevelData::Raycast(XMFLOAT3 origin, XMFLOAT3 direction, float
 			yPos < 6 && yPos >= 0 &&
 			zPos < MAP_SIZE_SUBTILES_RENDER && zPos >= 0))
 		{
-			if (m_BlockMap[yPos][zPos][xPos].active || !s_Map.m_Tiles[zPos/3][xPos/3].visible)
+			//the height field is a cheap early out, anything at or above it in this tile is open air
+			const bool solid = yPos < m_TileSolidHeight[zPos / 3][xPos / 3] && IsBlockActive(yPos, zPos, xPos);
+			if (solid || !s_Map.m_Tiles[zPos/3][xPos/3].visible)
 			{
 				//HitData hitData;
 				hitData.hit = true;
@@ -243,25 +291,220 @@ LevelData::HitData LevelData::Raycast(XMFLOAT3 origin, XMFLOAT3 direction, float
 END:
 	return hitData;
 }
+void LevelData::RaycastBatch(const XMFLOAT3* origins, const XMFLOAT3* directions, size_t count, float range, HitData* outHits)
+{
+	for (size_t i = 0; i < count; i += RayPacketSize)
+	{
+		const int packetSize = count - i < RayPacketSize ? (int)(count - i) : RayPacketSize;
+		RaycastPacket(origins + i, directions + i, packetSize, range, outHits + i);
+	}
+}
+void LevelData::RaycastPacket(const XMFLOAT3* origins, const XMFLOAT3* directions, int count, float range, HitData* outHits)
+{
+	//set up a lane at a time the same way Raycast does, lanes past count copy the last ray and never count as active
+	//the block positions stay in plain ints per lane, they're only ever used for the lookups
+	int pos[3][RayPacketSize], step[3][RayPacketSize];
+	XMFLOAT4A tMax[3], tDelta[3];
+	float hitDistance[RayPacketSize];
+	float* lanes[6] = { &tMax[0].x, &tMax[1].x, &tMax[2].x, &tDelta[0].x, &tDelta[1].x, &tDelta[2].x };
+	for (int i = 0; i < RayPacketSize; i++)
+	{
+		const XMFLOAT3& origin = origins[i < count ? i : count - 1];
+		const XMFLOAT3& direction = directions[i < count ? i : count - 1];
+		const int stepX = signum(direction.x);
+		const int stepY = signum(direction.y);
+		const int stepZ = signum(direction.z);
+		const XMFLOAT3 delta((float)stepX / direction.x, (float)stepY / direction.y, (float)stepZ / direction.z);
+		const float values[6] = { intbound(origin.x, direction.x), intbound(origin.y, direction.y), intbound(origin.z, direction.z), delta.x, delta.y, delta.z };
+		for (int v = 0; v < 6; v++)
+		{
+			lanes[v][i] = values[v];
+		}
+		pos[0][i] = (int)floor(origin.x);
+		pos[1][i] = (int)floor(origin.y);
+		pos[2][i] = (int)floor(origin.z);
+		step[0][i] = stepX;
+		step[1][i] = stepY;
+		step[2][i] = stepZ;
+		hitDistance[i] = sqrt(delta.x + delta.y + delta.z);
+		if (i < count)
+		{
+			outHits[i].hit = false;
+			outHits[i].distance = 99999;
+			outHits[i].posX = 0;
+			outHits[i].posY = 0;
+			outHits[i].posZ = 0;
+		}
+	}
+	XMVECTOR tMaxX = XMLoadFloat4A(&tMax[0]), tMaxY = XMLoadFloat4A(&tMax[1]), tMaxZ = XMLoadFloat4A(&tMax[2]);
+	const XMVECTOR tDeltaX = XMLoadFloat4A(&tDelta[0]), tDeltaY = XMLoadFloat4A(&tDelta[1]), tDeltaZ = XMLoadFloat4A(&tDelta[2]);
+	const XMVECTOR rangeV = XMVectorReplicate(range);
+	const XMVECTOR zero = XMVectorZero();
+
+	//a lane is active until it hit something, left the map or ran out of range, it's entered once it's been inside the map (from then on only the range stops it)
+	uint32_t active = (1u << count) - 1;
+	uint32_t entered = 0;
+	while (active)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			const uint32_t bit = 1u << i;
+			if (!(active & bit)) continue;
+			const int xPos = pos[0][i];
+			const int yPos = pos[1][i];
+			const int zPos = pos[2][i];
+			if (xPos < MAP_SIZE_SUBTILES_RENDER && xPos >= 0 && yPos < 6 && yPos >= 0 && zPos < MAP_SIZE_SUBTILES_RENDER && zPos >= 0)
+			{
+				entered |= bit;
+				const bool solid = yPos < m_TileSolidHeight[zPos / 3][xPos / 3] && IsBlockActive(yPos, zPos, xPos);
+				if (solid || !s_Map.m_Tiles[zPos / 3][xPos / 3].visible)
+				{
+					outHits[i].hit = true;
+					outHits[i].distance = (int)round(hitDistance[i]);
+					outHits[i].posX = xPos;
+					outHits[i].posY = yPos;
+					outHits[i].posZ = zPos;
+					active &= ~bit;
+				}
+			}
+			else if (!(entered & bit))
+			{
+				//still on its way in, a ray heading away from the map never gets there
+				const int sx = step[0][i], sy = step[1][i], sz = step[2][i];
+				if ((sx < 0 && xPos < 0) || (sy < 0 && yPos < 0) || (sz < 0 && zPos < 0) ||
+					(xPos >= MAP_SIZE_SUBTILES_RENDER && sx > 0) || (yPos >= 6 && sy > 0) || (zPos >= MAP_SIZE_SUBTILES_RENDER && sz > 0))
+				{
+					active &= ~bit;
+				}
+			}
+		}
+		if (!active) break;
+
+		//every lane picks its axis like Raycast does, x if it's the smallest, y if it's smaller than z, z otherwise (ties included)
+		const XMVECTOR xLessY = XMVectorLess(tMaxX, tMaxY);
+		const XMVECTOR stepsX = XMVectorAndInt(xLessY, XMVectorLess(tMaxX, tMaxZ));
+		const XMVECTOR stepsY = XMVectorAndCInt(XMVectorLess(tMaxY, tMaxZ), xLessY);
+		const XMVECTOR stepsZ = XMVectorNorInt(stepsX, stepsY);
+		const XMVECTOR next = XMVectorSelect(XMVectorSelect(tMaxZ, tMaxY, stepsY), tMaxX, stepsX);
+
+		uint32_t axisX[4], axisY[4], outOfRange[4];
+		XMStoreInt4(axisX, stepsX);
+		XMStoreInt4(axisY, stepsY);
+		XMStoreInt4(outOfRange, XMVectorGreater(next, rangeV));
+		//lanes that stopped keep stepping along here, nothing looks at them anymore
+		tMaxX = XMVectorAdd(tMaxX, XMVectorSelect(zero, tDeltaX, stepsX));
+		tMaxY = XMVectorAdd(tMaxY, XMVectorSelect(zero, tDeltaY, stepsY));
+		tMaxZ = XMVectorAdd(tMaxZ, XMVectorSelect(zero, tDeltaZ, stepsZ));
+		for (int i = 0; i < count; i++)
+		{
+			//lanes that entered the map stop when the step they're about to take is out of range
+			if (outOfRange[i] && (entered & (1u << i))) active &= ~(1u << i);
+			const int axis = axisX[i] ? 0 : axisY[i] ? 1 : 2;
+			pos[axis][i] += step[axis][i];
+		}
+	}
+}
+
+void LevelData::UpdateTileSolidHeight(int y, int x)
+{
+	uint8_t height = 0;
+	for (int yy = 0; yy < 3; yy++)
+	{
+		for (int xx = 0; xx < 3; xx++)
+		{
+			for (int z = RaycastHeight - 1; z >= height; z--)
+			{
+				if (IsBlockActive(z, y * 3 + yy, x * 3 + xx))
+				{
+					height = (uint8_t)(z + 1);
+					break;
+				}
+			}
+		}
+	}
+	m_TileSolidHeight[y][x] = height;
+}
+
+//same edge rules the mesher has always used (including treating x/y 0 as open)
+uint8_t LevelData::GetExposedFaces(int z, int y, int x) const
+{
+	uint8_t faces = 0;
+	if (x + 1 >= MAP_SIZE_SUBTILES_RENDER || !IsBlockActive(z, y, x + 1)) faces |= Face_Right;
+	if (x - 1 <= 0 || !IsBlockActive(z, y, x - 1)) faces |= Face_Left;
+	if (y + 1 >= MAP_SIZE_SUBTILES_RENDER || !IsBlockActive(z, y + 1, x)) faces |= Face_Front;
+	if (y - 1 <= 0 || !IsBlockActive(z, y - 1, x)) faces |= Face_Back;
+	if (z + 1 >= MAP_SIZE_HEIGHT || !IsBlockActive(z + 1, y, x)) faces |= Face_Top;
+	if (z - 1 < 0 || !IsBlockActive(z - 1, y, x)) faces |= Face_Bottom;
+	return faces;
+}
+//Has to be called after anything switches blocks of a tile on or off.
+//Only the blocks that actually changed since the last call get their own and their neighbours' masks redone.
+void LevelData::UpdateTileBlockFaces(int y, int x)
+{
+	static const int Offsets[6][3] = { { 0, 0, 1 },{ 0, 0, -1 },{ 0, 1, 0 },{ 0, -1, 0 },{ 1, 0, 0 },{ -1, 0, 0 } };
+	for (int z = 0; z < MAP_SIZE_HEIGHT; z++)
+	{
+		for (int yy = y * 3; yy < y * 3 + 3; yy++)
+		{
+			for (int xx = x * 3; xx < x * 3 + 3; xx++)
+			{
+				uint8_t& faces = m_BlockFaces[z][yy][xx];
+				const bool active = IsBlockActive(z, yy, xx);
+				if (((faces & Face_Solid) != 0) == active) continue;
+
+				faces = (uint8_t)((active ? Face_Solid : 0) | GetExposedFaces(z, yy, xx));
+				m_AreaUpdateStats.blocksChanged++;
+				m_AreaUpdateStats.facesRefreshed++;
+				for (int i = 0; i < 6; i++)
+				{
+					const int nz = z + Offsets[i][0];
+					const int ny = yy + Offsets[i][1];
+					const int nx = xx + Offsets[i][2];
+					if (nz < 0 || ny < 0 || nx < 0 || nz >= MAP_SIZE_HEIGHT || ny >= MAP_SIZE_SUBTILES_RENDER || nx >= MAP_SIZE_SUBTILES_RENDER) continue;
+					//leave the neighbour's own solid bit alone, its tile might still have to be synced
+					uint8_t& neighbourFaces = m_BlockFaces[nz][ny][nx];
+					neighbourFaces = (uint8_t)((neighbourFaces & Face_Solid) | GetExposedFaces(nz, ny, nx));
+					m_AreaUpdateStats.facesRefreshed++;
+				}
+			}
+		}
+	}
+}
+void LevelData::UpdateAllBlockFaces()
+{
+	for (int z = 0; z < MAP_SIZE_HEIGHT; z++)
+	{
+		for (int y = 0; y < MAP_SIZE_SUBTILES_RENDER; y++)
+		{
+			for (int x = 0; x < MAP_SIZE_SUBTILES_RENDER; x++)
+			{
+				m_BlockFaces[z][y][x] = (uint8_t)((IsBlockActive(z, y, x) ? Face_Solid : 0) | GetExposedFaces(z, y, x));
+			}
+		}
+	}
+}
 
 
 //Selects a belonging RenderTile for the inputted tile (takes care of selecting the specific pieces of a room)
 int LevelData::CreateFromTile(const Tile& tile, RenderTile& out)
 {
-	int numSolidBlocks = 0;
+	//expanded straight from the compact tables instead of copying a full RenderTile around
+	return VoxelModels::Expand(GetTileModel(tile), out);
+}
+int LevelData::GetTileModel(const Tile& tile)
+{
 	uint8_t usingType = (tile.type >> 8);
 	if (usingType > 0)usingType--;
+	int model = Tile_LIQUID;
 	switch (tile.type & 0xFF)
 	{
 	case Type_Rock:
-		memcpy(&out, &RenderTileMap[Tile_ROCK], sizeof(RenderTile));
-		numSolidBlocks += RenderTileMap[Tile_ROCK].activeBlocks;
+		model = Tile_ROCK;
 		break;
 	case Type_Gold:
 	case Type_Earth:
 	case Type_Earth_Torch:
-		memcpy(&out, &RenderTileMap[Tile_FULLBLOCK], sizeof(RenderTile));
-		numSolidBlocks += RenderTileMap[Tile_FULLBLOCK].activeBlocks;
+		model = Tile_FULLBLOCK;
 		break;
 	case Type_Wall0:
 	case Type_Wall1:
@@ -269,55 +512,44 @@ int LevelData::CreateFromTile(const Tile& tile, RenderTile& out)
 	case Type_Wall3:
 	case Type_Wall4:
 	case Type_Wall5:
-		memcpy(&out, &RenderTileMap[Tile_FULLBLOCK], sizeof(RenderTile));
-		numSolidBlocks += RenderTileMap[Tile_FULLBLOCK].activeBlocks;
+		model = Tile_FULLBLOCK;
 		break;
 	case Type_Lair:
 	case Type_Unclaimed_Path:
 	case Type_Claimed_Land:
-		memcpy(&out, &RenderTileMap[Tile_GROUND], sizeof(RenderTile));
-		numSolidBlocks += RenderTileMap[Tile_GROUND].activeBlocks;
+		model = Tile_GROUND;
 		break;
 	case Type_Water:
 	case Type_Lava:
-		memcpy(&out, &RenderTileMap[Tile_LIQUID], sizeof(RenderTile));
-		numSolidBlocks += RenderTileMap[Tile_LIQUID].activeBlocks;
+		model = Tile_LIQUID;
 		break;
 	case Type_Portal:
-		memcpy(&out, &RenderTileMap[Tile_PORTAL + usingType], sizeof(RenderTile));
-		numSolidBlocks += RenderTileMap[Tile_PORTAL + usingType].activeBlocks;
+		model = Tile_PORTAL + usingType;
 		break;
 	case Type_Dungeon_Heart:
-		memcpy(&out, &RenderTileMap[Tile_DUNGEON_HEART + usingType], sizeof(RenderTile));
-		numSolidBlocks += RenderTileMap[Tile_DUNGEON_HEART + usingType].activeBlocks;
+		model = Tile_DUNGEON_HEART + usingType;
 		break;
 	case Type_Library:
-		memcpy(&out, &RenderTileMap[Tile_LIBRARY + usingType], sizeof(RenderTile));
-		numSolidBlocks += RenderTileMap[Tile_LIBRARY + usingType].activeBlocks;
+		model = Tile_LIBRARY + usingType;
 		break;
 	case Type_Barracks:
-		memcpy(&out, &RenderTileMap[Tile_BARRACKS + usingType], sizeof(RenderTile));
-		numSolidBlocks += RenderTileMap[Tile_BARRACKS + usingType].activeBlocks;
+		model = Tile_BARRACKS + usingType;
 		break;
 	case Type_Treasure_Room:
 	case Type_Training_Room:
 	case Type_Scavenger_Room:
 	case Type_Hatchery:
 	case Type_Workshop:
-		memcpy(&out, &RenderTileMap[Tile_PILLAR_ROOM + usingType], sizeof(RenderTile));
-		numSolidBlocks += RenderTileMap[Tile_PILLAR_ROOM + usingType].activeBlocks;
+		model = Tile_PILLAR_ROOM + usingType;
 		break;
 	//case Type_Hatchery:
-	//	memcpy(&out, &RenderTileMap[Tile_HATCHERY + usingType], sizeof(RenderTile));
-	//	numSolidBlocks += RenderTileMap[Tile_HATCHERY + usingType].activeBlocks;
+	//	model = Tile_HATCHERY + usingType;
 	//	break;
 	default:
-		memcpy(&out, &RenderTileMap[Tile_LIQUID], sizeof(RenderTile));
-		numSolidBlocks += RenderTileMap[Tile_LIQUID].activeBlocks;
+		model = Tile_LIQUID;
 		break;
 	}
-
-	return numSolidBlocks;
+	return model;
 }
 
 uint8_t LevelData::GetNeighbourInfo(uint16_t currentType, uint16_t nType)
@@ -452,49 +684,49 @@ NeighbourSubTiles LevelData::GetNeighbourSubTiles(int y, int x)
 	nInfo.NorthWest.owner = s_Map.m_Tiles[yPosPOne][xPosMOne].owner;
 	nInfo.NorthWest.type = s_Map.m_Tiles[yPosPOne][xPosMOne].type;
 	nInfo.NorthWest.areaCode = s_Map.m_Tiles[yPosPOne][xPosMOne].areaCode;
-	nInfo.NorthWest.height = s_Map.m_Tiles[yPosPOne][xPosMOne].pathSubTiles[ySubPOne][xSubMOne].height;
-	nInfo.NorthWest.cost = s_Map.m_Tiles[yPosPOne][xPosMOne].pathSubTiles[ySubPOne][xSubMOne].cost;
+	nInfo.NorthWest.height = s_Map.m_TileDetails[yPosPOne][xPosMOne].pathSubTiles[ySubPOne][xSubMOne].height;
+	nInfo.NorthWest.cost = s_Map.m_TileDetails[yPosPOne][xPosMOne].pathSubTiles[ySubPOne][xSubMOne].cost;
 	nInfo.North.owner = s_Map.m_Tiles[yPosPOne][xPos].owner;
 	nInfo.North.type = s_Map.m_Tiles[yPosPOne][xPos].type;
 	nInfo.North.areaCode = s_Map.m_Tiles[yPosPOne][xPos].areaCode;
-	nInfo.North.height = s_Map.m_Tiles[yPosPOne][xPos].pathSubTiles[ySubPOne][xSub].height;
-	nInfo.North.cost = s_Map.m_Tiles[yPosPOne][xPos].pathSubTiles[ySubPOne][xSub].cost;
+	nInfo.North.height = s_Map.m_TileDetails[yPosPOne][xPos].pathSubTiles[ySubPOne][xSub].height;
+	nInfo.North.cost = s_Map.m_TileDetails[yPosPOne][xPos].pathSubTiles[ySubPOne][xSub].cost;
 	nInfo.NorthEast.owner = s_Map.m_Tiles[yPosPOne][xPosPOne].owner;
 	nInfo.NorthEast.type = s_Map.m_Tiles[yPosPOne][xPosPOne].type;
 	nInfo.NorthEast.areaCode = s_Map.m_Tiles[yPosPOne][xPosPOne].areaCode;
-	nInfo.NorthEast.height = s_Map.m_Tiles[yPosPOne][xPosPOne].pathSubTiles[ySubPOne][xSubPOne].height;
-	nInfo.NorthEast.cost = s_Map.m_Tiles[yPosPOne][xPosPOne].pathSubTiles[ySubPOne][xSubPOne].cost;
+	nInfo.NorthEast.height = s_Map.m_TileDetails[yPosPOne][xPosPOne].pathSubTiles[ySubPOne][xSubPOne].height;
+	nInfo.NorthEast.cost = s_Map.m_TileDetails[yPosPOne][xPosPOne].pathSubTiles[ySubPOne][xSubPOne].cost;
 	nInfo.SouthWest.owner = s_Map.m_Tiles[yPosMOne][xPosMOne].owner;
 	nInfo.SouthWest.type = s_Map.m_Tiles[yPosMOne][xPosMOne].type;
 	nInfo.SouthWest.areaCode = s_Map.m_Tiles[yPosMOne][xPosMOne].areaCode;
-	nInfo.SouthWest.height = s_Map.m_Tiles[yPosMOne][xPosMOne].pathSubTiles[ySubMOne][xSubMOne].height;
-	nInfo.SouthWest.cost = s_Map.m_Tiles[yPosMOne][xPosMOne].pathSubTiles[ySubMOne][xSubMOne].cost;
+	nInfo.SouthWest.height = s_Map.m_TileDetails[yPosMOne][xPosMOne].pathSubTiles[ySubMOne][xSubMOne].height;
+	nInfo.SouthWest.cost = s_Map.m_TileDetails[yPosMOne][xPosMOne].pathSubTiles[ySubMOne][xSubMOne].cost;
 	nInfo.South.owner = s_Map.m_Tiles[yPosMOne][xPos].owner;
 	nInfo.South.type = s_Map.m_Tiles[yPosMOne][xPos].type;
 	nInfo.South.areaCode = s_Map.m_Tiles[yPosMOne][xPos].areaCode;
-	nInfo.South.height = s_Map.m_Tiles[yPosMOne][xPos].pathSubTiles[ySubMOne][xSub].height;
-	nInfo.South.cost = s_Map.m_Tiles[yPosMOne][xPos].pathSubTiles[ySubMOne][xSub].cost;
+	nInfo.South.height = s_Map.m_TileDetails[yPosMOne][xPos].pathSubTiles[ySubMOne][xSub].height;
+	nInfo.South.cost = s_Map.m_TileDetails[yPosMOne][xPos].pathSubTiles[ySubMOne][xSub].cost;
 	nInfo.SouthEast.owner = s_Map.m_Tiles[yPosMOne][xPosPOne].owner;
 	nInfo.SouthEast.type = s_Map.m_Tiles[yPosMOne][xPosPOne].type;
 	nInfo.SouthEast.areaCode = s_Map.m_Tiles[yPosMOne][xPosPOne].areaCode;
-	nInfo.SouthEast.height = s_Map.m_Tiles[yPosMOne][xPosPOne].pathSubTiles[ySubMOne][xSubPOne].height;
-	nInfo.SouthEast.cost = s_Map.m_Tiles[yPosMOne][xPosPOne].pathSubTiles[ySubMOne][xSubPOne].cost;
+	nInfo.SouthEast.height = s_Map.m_TileDetails[yPosMOne][xPosPOne].pathSubTiles[ySubMOne][xSubPOne].height;
+	nInfo.SouthEast.cost = s_Map.m_TileDetails[yPosMOne][xPosPOne].pathSubTiles[ySubMOne][xSubPOne].cost;
 	nInfo.East.owner = s_Map.m_Tiles[yPos][xPosPOne].owner;
 	nInfo.East.type = s_Map.m_Tiles[yPos][xPosPOne].type;
 	nInfo.East.areaCode = s_Map.m_Tiles[yPos][xPosPOne].areaCode;
-	nInfo.East.height = s_Map.m_Tiles[yPos][xPosPOne].pathSubTiles[ySub][xSubPOne].height;
-	nInfo.East.cost = s_Map.m_Tiles[yPos][xPosPOne].pathSubTiles[ySub][xSubPOne].cost;
+	nInfo.East.height = s_Map.m_TileDetails[yPos][xPosPOne].pathSubTiles[ySub][xSubPOne].height;
+	nInfo.East.cost = s_Map.m_TileDetails[yPos][xPosPOne].pathSubTiles[ySub][xSubPOne].cost;
 	nInfo.West.owner = s_Map.m_Tiles[yPos][xPosMOne].owner;
 	nInfo.West.type = s_Map.m_Tiles[yPos][xPosMOne].type;
 	nInfo.West.areaCode = s_Map.m_Tiles[yPos][xPosMOne].areaCode;
-	nInfo.West.height = s_Map.m_Tiles[yPos][xPosMOne].pathSubTiles[ySub][xSubMOne].height;
-	nInfo.West.cost = s_Map.m_Tiles[yPos][xPosMOne].pathSubTiles[ySub][xSubMOne].cost;
+	nInfo.West.height = s_Map.m_TileDetails[yPos][xPosMOne].pathSubTiles[ySub][xSubMOne].height;
+	nInfo.West.cost = s_Map.m_TileDetails[yPos][xPosMOne].pathSubTiles[ySub][xSubMOne].cost;
 	return nInfo;
 }
 
 uint8_t Themp::LevelData::GetSubtileHeight(int tileY, int tileX, int subTileY, int subTileX)
 {
-	return s_Map.m_Tiles[tileY][tileX].pathSubTiles[subTileY][subTileX].height;
+	return s_Map.m_TileDetails[tileY][tileX].pathSubTiles[subTileY][subTileX].height;
 }
 bool Is3By3Room(uint16_t type)
 {
@@ -513,16 +745,27 @@ void LevelData::AddExploredTileNeighboursVisibility(int y, int x, int areaCode)
 			{
 				if (s_Map.m_Tiles[y][x].areaCode != 0 && areaCode != 0)
 				{
-					m_UnexploredTiles[n.Axii[i]] = XMINT2(x, y) + AxiiDirections[i];
+					AddUnexploredTile(XMINT2(x, y) + AxiiDirections[i]);
 				}
 			}
 			else
 			{
-				m_UnexploredTiles[n.Axii[i]] = XMINT2(x, y) + AxiiDirections[i];
+				AddUnexploredTile(XMINT2(x, y) + AxiiDirections[i]);
 			}
 		}		
 	}
 }
+void LevelData::AddUnexploredTile(XMINT2 pos)
+{
+	//already in there means it's already on the frontier of everything around it, RefreshWalkableTile keeps that up
+	if (!m_UnexploredTiles.Add(pos)) return;
+	for (int i = 0; i < 4; i++)
+	{
+		const XMINT2 n = pos + AxiiDirections[i];
+		if (n.x < 0 || n.y < 0 || n.x >= MAP_SIZE_TILES || n.y >= MAP_SIZE_TILES) continue;
+		m_UnexploredTiles.AddToArea(m_WalkableTileArea[n.y][n.x], pos.y, pos.x);
+	}
+}
 
 
 bool IsNon3By3PillarRoom(uint16_t type)
@@ -715,7 +958,7 @@ bool Themp::LevelData::MineTile(int y, int x)
 			"DIG5.WAV",
 			"DIG6.WAV",
 		};
-		System::tSys->m_Audio->PlayOneShot(FileManager::GetSound(miningSounds[rand() % 6]));
+		FileManager::PlayOneShot(miningSounds[rand() % 6]);
 	}
 	return false;
 }
@@ -751,31 +994,10 @@ void LevelData::DestroyTile(int y, int x)
 			}
 		}
 
-		TileNeighbourTiles neighbours = GetNeighbourTiles(y, x);
-		uint32_t lowestAreaCode = NextAreaCode;
-		for (int i = 0; i < 4; i++)
-		{
-			if (neighbours.Axii[i]->areaCode > 0 && (neighbours.Axii[i]->type & 0xFF) != Type_Lava)
-			{
-				if (neighbours.Axii[i]->areaCode < lowestAreaCode)
-				{
-					lowestAreaCode = neighbours.Axii[i]->areaCode;
-				}
-			}
-			if (neighbours.Axii[i]->owner < Owner_PlayerWhite && neighbours.Axii[i]->GetType() == Type_Claimed_Land)
-			{
-				CreatureTaskManager::AddClaimingTask(neighbours.Axii[i]->owner, XMINT2(x, y), &s_Map.m_Tiles[y][x]);
-			}
-		}
-		if (lowestAreaCode == NextAreaCode)
-		{
-			lowestAreaCode = NextAreaCode;
-			NextAreaCode++;
-		}
-		UpdateAreaCode(lowestAreaCode, Type_Unclaimed_Path, y, x);
+		OpenTile(y, x);
 
-		//then update the area surrounding this
-		UpdateArea(y - 2, y + 2, x - 2, x + 2);
+		//then update the area surrounding this, the claiming tasks and new paths come from the tile events once it's flushed
+		QueueAreaUpdate(y - 2, y + 2, x - 2, x + 2);
 
 		const static std::string rockSounds[3] =
 		{
@@ -783,8 +1005,7 @@ void LevelData::DestroyTile(int y, int x)
 			"ROCKS2.WAV",
 			"ROCKS3.WAV",
 		};
-		System::tSys->m_Audio->PlayOneShot(FileManager::GetSound(rockSounds[rand() % 3]));
-		LevelData::PathsInvalidated = true;
+		FileManager::PlayOneShot(rockSounds[rand() % 3]);
 	}
 }
 
@@ -797,13 +1018,14 @@ bool LevelData::MarkTile(uint8_t player, int y, int x)
 		{
 			if (s_Map.m_Tiles[y][x].marked[player])return true;
 			s_Map.m_Tiles[y][x].marked[player] = true;
+			m_TileEvents.MarkTile(y, x);
 
 			TileNeighbours nb = CheckNeighbours(type, y, x);
 			if (nb.North == N_WALKABLE || nb.North == N_WATER || nb.East == N_WALKABLE || nb.East == N_WATER || nb.South == N_WALKABLE || nb.South == N_WATER || nb.West == N_WALKABLE || nb.West == N_WATER)
 			{
 				CreatureTaskManager::AddMiningTask(player, XMINT2(x, y),&s_Map.m_Tiles[y][x]);
 			}
-			System::tSys->m_Audio->PlayOneShot(FileManager::GetSound("DIGMARK.WAV"));
+			FileManager::PlayOneShot("DIGMARK.WAV");
 			return true;
 		}
 		else if(!s_Map.m_Tiles[y][x].visible)
@@ -813,7 +1035,8 @@ bool LevelData::MarkTile(uint8_t player, int y, int x)
 				return false;
 			}
 			LevelData::s_Map.m_Tiles[y][x].marked[player] = true;
-			System::tSys->m_Audio->PlayOneShot(FileManager::GetSound("DIGMARK.WAV"));
+			m_TileEvents.MarkTile(y, x);
+			FileManager::PlayOneShot("DIGMARK.WAV");
 			return true;
 		}
 	}
@@ -823,14 +1046,84 @@ void LevelData::UnMarkTile(uint8_t player, int y, int x)
 {
 	if (!s_Map.m_Tiles[y][x].marked[player]) return;
 	s_Map.m_Tiles[y][x].marked[player] = false;
+	m_TileEvents.MarkTile(y, x);
 	CreatureTaskManager::RemoveMiningTask(player, &s_Map.m_Tiles[y][x]);
-	System::tSys->m_Audio->PlayOneShot(FileManager::GetSound("DIGMARK.WAV"));
+	FileManager::PlayOneShot("DIGMARK.WAV");
+}
+
+//Map edits don't update the area straight away, they queue it up and everything queued during a frame gets applied at once in FlushAreaUpdates
+//this way ten imps claiming tiles next to each other cause one update instead of ten overlapping ones
+void LevelData::QueueAreaUpdate(int minY, int maxY, int minX, int maxX)
+{
+	AreaRect rect;
+	rect.minY = minY < 0 ? 0 : minY;
+	rect.maxY = maxY > MAP_SIZE_TILES - 1 ? MAP_SIZE_TILES - 1 : maxY;
+	rect.minX = minX < 0 ? 0 : minX;
+	rect.maxX = maxX > MAP_SIZE_TILES - 1 ? MAP_SIZE_TILES - 1 : maxX;
+	m_QueuedAreaUpdates.push_back(rect);
+	m_AreaUpdateStats.queued++;
+}
+void LevelData::FlushAreaUpdates()
+{
+	if (m_QueuedAreaUpdates.size() == 0)
+	{
+		//exploring doesn't queue area updates but still has events to send
+		m_TileEvents.Publish(s_Map);
+		return;
+	}
+
+	//merge rectangles as long as the merged one doesn't cover more tiles than the two did separately (overlapping or lined up next to each other)
+	std::vector<AreaRect>& rects = m_QueuedAreaUpdates;
+	bool merged = true;
+	while (merged)
+	{
+		merged = false;
+		for (size_t i = 0; i < rects.size() && !merged; i++)
+		{
+			for (size_t j = i + 1; j < rects.size(); j++)
+			{
+				const AreaRect& a = rects[i];
+				const AreaRect& b = rects[j];
+				AreaRect u;
+				u.minY = a.minY < b.minY ? a.minY : b.minY;
+				u.maxY = a.maxY > b.maxY ? a.maxY : b.maxY;
+				u.minX = a.minX < b.minX ? a.minX : b.minX;
+				u.maxX = a.maxX > b.maxX ? a.maxX : b.maxX;
+				if (u.Size() <= a.Size() + b.Size())
+				{
+					rects[i] = u;
+					rects[j] = rects.back();
+					rects.pop_back();
+					merged = true;
+					break;
+				}
+			}
+		}
+	}
+
+	m_AreaUpdateStats.applied = 0;
+	m_AreaUpdateStats.tiles = 0;
+	m_AreaUpdateStats.rebuilt = 0;
+	m_AreaUpdateStats.blocksChanged = 0;
+	m_AreaUpdateStats.facesRefreshed = 0;
+	for (size_t i = 0; i < rects.size(); i++)
+	{
+		m_TileEvents.MarkArea(rects[i].minY, rects[i].maxY, rects[i].minX, rects[i].maxX);
+		UpdateArea(rects[i].minY, rects[i].maxY, rects[i].minX, rects[i].maxX);
+		m_AreaUpdateStats.applied++;
+		m_AreaUpdateStats.tiles += rects[i].Size();
+	}
+	rects.clear();
+	m_AreaUpdateStats.queuedLastFlush = m_AreaUpdateStats.queued;
+	m_AreaUpdateStats.queued = 0;
+
+	//one batch for everything this flush changed (pathing, tasks, minimap, liquids all pick it up from there)
+	m_TileEvents.Publish(s_Map);
 }
 
 //in Tile Positions
 void LevelData::UpdateArea(int minY, int maxY, int minX, int maxX)
 {
-	RenderTile tileOut = {};
 	for (int y = minY; y <= maxY; y++)
 	{
 		for (int x = minX; x <= maxX; x++)
@@ -843,142 +1136,243 @@ void LevelData::UpdateArea(int minY, int maxY, int minX, int maxX)
 
 			}
 			s_Map.m_Tiles[y][x].type = type;
-			uint16_t numBlocks = CreateFromTile(s_Map.m_Tiles[y][x], tileOut);
-			s_Map.m_Tiles[y][x].numBlocks = numBlocks;
-
-
-			//Update area surrounding this
-			s_Map.m_Tiles[y][x].pathSubTiles = tileOut.pathSubTiles;
-			for (size_t yy = 0; yy < 3; yy++)
+			if (s_Map.m_Tiles[y][x].areaCode != 0 && IsAreaSeparator(type & 0xFF))
 			{
-				for (size_t xx = 0; xx < 3; xx++)
+				CloseTile(y, x);
+			}
+			uint16_t currentTileType = s_Map.m_Tiles[y][x].type & 0xFF;
+			//the blocks only have to be rebuilt if the tile or anything around it looks different from the last time
+			if (RefreshTileRenderKey(y, x))
+			{
+				//only whether the blocks are there is copied out of the model, GetTileUVs goes back to it for the uvs
+				const int model = GetTileModel(s_Map.m_Tiles[y][x]);
+				const RenderTile& tileOut = VoxelModels::Get(model);
+				m_TileModels[y][x] = (uint8_t)model;
+				s_Map.m_Tiles[y][x].numBlocks = tileOut.activeBlocks;
+
+				//Update area surrounding this
+				s_Map.m_TileDetails[y][x].pathSubTiles = tileOut.pathSubTiles;
+				for (size_t yy = 0; yy < 3; yy++)
 				{
-					assert(y * 3 + yy < 256 && y * 3 + yy >= 0);
-					assert(x * 3 + xx < 256 && x * 3 + xx >= 0);
-					for (size_t z = 0; z < MAP_SIZE_HEIGHT; z++)
+					for (size_t xx = 0; xx < 3; xx++)
 					{
-						Block& b = tileOut.subTile[yy][xx][z];
-						b.randValue = m_BlockMap[z][y * 3 + yy][x * 3 + xx].randValue;
-						m_BlockMap[z][y * 3 + yy][x * 3 + xx] = b;
+						assert(y * 3 + yy < 256 && y * 3 + yy >= 0);
+						assert(x * 3 + xx < 256 && x * 3 + xx >= 0);
+						for (size_t z = 0; z < MAP_SIZE_HEIGHT; z++)
+						{
+							SetBlockActive(z, y * 3 + yy, x * 3 + xx, tileOut.subTile[yy][xx][z].active);
+						}
 					}
 				}
+				if (currentTileType == Type_Hatchery)
+				{
+					DoHatcheryBlocks(CheckNeighbours(Type_Hatchery, y, x), x, y);
+				}
+				//the hatchery knocks blocks out, so this goes after it
+				UpdateTileSolidHeight(y, x);
+				UpdateTileBlockFaces(y, x);
+				m_AreaUpdateStats.rebuilt++;
 			}
-			uint16_t currentTileType = s_Map.m_Tiles[y][x].type & 0xFF;
-			DoUVs(currentTileType, y, x);
+			RefreshWalkableTile(y, x);
 
-			TileNeighbourTiles neighbourTiles = GetNeighbourTiles(y, x);
-			if (currentTileType == Type_Unclaimed_Path)
+			//the tasks that come with the new type are handed out by RefreshTileTasks once the tile events go out
+			Tile& tile = s_Map.m_Tiles[y][x];
+			if (tile.health <= 0.0f)
 			{
-				if (s_Map.m_Tiles[y][x].health <= 0.0f)
+				if (currentTileType == Type_Unclaimed_Path || currentTileType == Type_Earth || currentTileType == Type_Earth_Torch)
 				{
-					s_Map.m_Tiles[y][x].health = LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_ROCK].Value;
+					tile.health = LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_ROCK].Value;
 				}
-				for (int i = 0; i < 4; i++)
+				else if (currentTileType == Type_Claimed_Land)
 				{
-					uint16_t nType = (neighbourTiles.Axii[i]->type & 0xFF);
-					if(neighbourTiles.Axii[i]->owner != Owner_PlayerWhite && neighbourTiles.Axii[i]->owner != Owner_PlayerNone && (nType == Type_Claimed_Land || IsClaimableRoom(nType)))
-					{
-						CreatureTaskManager::AddClaimingTask(neighbourTiles.Axii[i]->owner, XMINT2(x, y), &s_Map.m_Tiles[y][x]);
-					}
+					tile.health = LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_PRETTY].Value;
 				}
-			}
-			else if (currentTileType == Type_Claimed_Land)
-			{
-				if (s_Map.m_Tiles[y][x].health <= 0.0f)
+				else if (IsClaimableRoom(currentTileType))
 				{
-					s_Map.m_Tiles[y][x].health = LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_PRETTY].Value;
+					tile.health = LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_ROOM].Value;
 				}
-				for (int i = 0; i < 4; i++)
+				else if (currentTileType == Type_Gold || currentTileType == Type_Gem)
 				{
-					uint16_t nType = (neighbourTiles.Axii[i]->type & 0xFF);
-					if (neighbourTiles.Axii[i]->owner != s_Map.m_Tiles[y][x].owner && neighbourTiles.Axii[i]->owner != Owner_PlayerWhite && neighbourTiles.Axii[i]->owner != Owner_PlayerNone && (nType == Type_Claimed_Land || IsClaimableRoom(nType)))
-					{
-						CreatureTaskManager::AddClaimingTask(neighbourTiles.Axii[i]->owner, XMINT2(x, y), &s_Map.m_Tiles[y][x]);
-					}
+					tile.health = LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_GOLD].Value;
 				}
 			}
-			else if (IsClaimableRoom(currentTileType))
+		}
+	}
+}
+
+//Every tile that changed type or owner gets its own tasks and the ones of the tiles next to it looked at again, the rest of the map can't have new ones.
+void LevelData::OnTileChanges(void* context, const TileChange* changes, size_t count)
+{
+	LevelData* level = (LevelData*)context;
+	std::bitset<MAP_SIZE_TILES * MAP_SIZE_TILES> refreshed;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (!(changes[i].fields & (TileChange::Field_Type | TileChange::Field_Owner))) continue;
+		for (int d = -1; d < 4; d++)
+		{
+			const int y = changes[i].y + (d < 0 ? 0 : AxiiDirections[d].y);
+			const int x = changes[i].x + (d < 0 ? 0 : AxiiDirections[d].x);
+			if (y < 0 || x < 0 || y >= MAP_SIZE_TILES || x >= MAP_SIZE_TILES || refreshed[y * MAP_SIZE_TILES + x]) continue;
+			refreshed[y * MAP_SIZE_TILES + x] = true;
+			level->RefreshTileTasks(y, x);
+		}
+	}
+}
+
+//Only a tile that changed type can have gained or lost its torch
+void LevelData::OnLightTileChanges(void* context, const TileChange* changes, size_t count)
+{
+	LevelData* level = (LevelData*)context;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (!(changes[i].fields & TileChange::Field_Type)) continue;
+		level->UpdateTorchLight(changes[i].y, changes[i].x);
+	}
+}
+
+//A torch lights up the middle of its tile, a bit above the floor
+void LevelData::UpdateTorchLight(int y, int x)
+{
+	const bool hasTorch = (s_Map.m_Tiles[y][x].type & 0xFF) == Type_Earth_Torch;
+	if (hasTorch == (m_TorchLights[y][x] != NoTorchLight)) return;
+	if (!hasTorch)
+	{
+		s_LightGrid.RemoveLight(m_TorchLights[y][x]);
+		m_TorchLights[y][x] = NoTorchLight;
+		return;
+	}
+	Light light;
+	light.range = 3 * 3;
+	light.lightIntensity = 12;
+	light.x = x * 3 + 1;
+	light.y = y * 3 + 1;
+	light.z = 4;
+	m_TorchLights[y][x] = s_LightGrid.AddLight(light);
+}
+
+//The claiming, reinforcing and mining tasks a tile hands out, the task manager ignores the ones it already has
+void LevelData::RefreshTileTasks(int y, int x)
+{
+	//the edge of the map is all rock
+	if (y < 1 || x < 1 || y >= MAP_SIZE_TILES - 1 || x >= MAP_SIZE_TILES - 1) return;
+	const uint16_t currentTileType = s_Map.m_Tiles[y][x].type & 0xFF;
+	TileNeighbourTiles neighbourTiles = GetNeighbourTiles(y, x);
+	if (currentTileType == Type_Unclaimed_Path || currentTileType == Type_Claimed_Land || IsClaimableRoom(currentTileType))
+	{
+		//marked tiles next to open ground can be dug out from here
+		for (int i = 0; i < 4; i++)
+		{
+			Tile* tile = &s_Map.m_Tiles[y + AxiiDirections[i].y][x + AxiiDirections[i].x];
+			for (int player = 0; player < 4; player++)
 			{
-				if (s_Map.m_Tiles[y][x].health <= 0.0f)
+				if (tile->marked[player] && IsMineableForPlayer(tile->GetType(), tile->owner, player))
 				{
-					s_Map.m_Tiles[y][x].health = LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_ROOM].Value;
-				}
-				for (int i = 0; i < 4; i++)
-				{
-					uint16_t nType = (neighbourTiles.Axii[i]->type & 0xFF);
-					if (neighbourTiles.Axii[i]->owner != s_Map.m_Tiles[y][x].owner && neighbourTiles.Axii[i]->owner != Owner_PlayerWhite && neighbourTiles.Axii[i]->owner != Owner_PlayerNone && (nType == Type_Claimed_Land || IsClaimableRoom(nType)))
-					{
-						CreatureTaskManager::AddClaimingTask(neighbourTiles.Axii[i]->owner, XMINT2(x, y), &s_Map.m_Tiles[y][x]);
-					}
+					CreatureTaskManager::AddMiningTask(player, XMINT2(x + AxiiDirections[i].x, y + AxiiDirections[i].y), tile);
 				}
 			}
-			else if (currentTileType == Type_Earth || currentTileType == Type_Earth_Torch)
+		}
+	}
+	if (currentTileType == Type_Unclaimed_Path)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			uint16_t nType = (neighbourTiles.Axii[i]->type & 0xFF);
+			if(neighbourTiles.Axii[i]->owner != Owner_PlayerWhite && neighbourTiles.Axii[i]->owner != Owner_PlayerNone && (nType == Type_Claimed_Land || IsClaimableRoom(nType)))
+			{
+				CreatureTaskManager::AddClaimingTask(neighbourTiles.Axii[i]->owner, XMINT2(x, y), &s_Map.m_Tiles[y][x]);
+			}
+		}
+	}
+	else if (currentTileType == Type_Claimed_Land || IsClaimableRoom(currentTileType))
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			uint16_t nType = (neighbourTiles.Axii[i]->type & 0xFF);
+			if (neighbourTiles.Axii[i]->owner != s_Map.m_Tiles[y][x].owner && neighbourTiles.Axii[i]->owner != Owner_PlayerWhite && neighbourTiles.Axii[i]->owner != Owner_PlayerNone && (nType == Type_Claimed_Land || IsClaimableRoom(nType)))
+			{
+				CreatureTaskManager::AddClaimingTask(neighbourTiles.Axii[i]->owner, XMINT2(x, y), &s_Map.m_Tiles[y][x]);
+			}
+		}
+	}
+	else if (currentTileType == Type_Earth || currentTileType == Type_Earth_Torch)
+	{
+		bool* markers = s_Map.m_Tiles[y][x].marked;
+		for (int player = 0; player < 4; player++)
+		{
+			for (int i = 0; i < 4; i++)
 			{
-				if (s_Map.m_Tiles[y][x].health <= 0.0f)
+				bool* bnMarkers = s_Map.m_Tiles[y + AxiiDirections[i].y][x + AxiiDirections[i].x].marked;
+				Tile* tile = &s_Map.m_Tiles[y + AxiiDirections[i].y][x + AxiiDirections[i].x];
+
+				uint16_t type = tile->GetType();
+				if (IsMineableForPlayer(type,tile->owner, player))
 				{
-					s_Map.m_Tiles[y][x].health = LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_ROCK].Value;
+					if (bnMarkers[player])
+					{
+						CreatureTaskManager::AddMiningTask(player, XMINT2(x + AxiiDirections[i].x, y + AxiiDirections[i].y), tile);
+					}
 				}
-				bool* markers = s_Map.m_Tiles[y][x].marked;
-				for (int player = 0; player < 4; player++)
+				if (!markers[player])
 				{
-					for (int i = 0; i < 4; i++)
+					uint16_t nType = (neighbourTiles.Axii[i]->type & 0xFF);
+					if (neighbourTiles.Axii[i]->owner == player && (nType == Type_Claimed_Land || IsClaimableRoom(nType)))
 					{
-						bool* bnMarkers = s_Map.m_Tiles[y + AxiiDirections[i].y][x + AxiiDirections[i].x].marked;
-						Tile* tile = &s_Map.m_Tiles[y + AxiiDirections[i].y][x + AxiiDirections[i].x];
-
-						uint16_t type = tile->GetType();
-						if (IsMineableForPlayer(type,tile->owner, player))
-						{
-							if (bnMarkers[player])
-							{
-								CreatureTaskManager::AddMiningTask(player, XMINT2(x + AxiiDirections[i].x, y + AxiiDirections[i].y), tile);
-							}
-							else
-							{
-								bnMarkers[player] = false;
-							}
-						}
-						if (!markers[player])
-						{
-							uint16_t nType = (neighbourTiles.Axii[i]->type & 0xFF);
-							if (neighbourTiles.Axii[i]->owner == player && (nType == Type_Claimed_Land || IsClaimableRoom(nType)))
-							{
-								CreatureTaskManager::AddReinforcingTask(player, XMINT2(x, y), &s_Map.m_Tiles[y][x]);
-							}
-						}
+						CreatureTaskManager::AddReinforcingTask(player, XMINT2(x, y), &s_Map.m_Tiles[y][x]);
 					}
 				}
 			}
-			else if (currentTileType == Type_Gold || currentTileType == Type_Gem)
+		}
+	}
+	else if (currentTileType == Type_Gold || currentTileType == Type_Gem)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			bool* markers = s_Map.m_Tiles[y + AxiiDirections[i].y][x + AxiiDirections[i].x].marked;
+			Tile* tile = &s_Map.m_Tiles[y + AxiiDirections[i].y][x + AxiiDirections[i].x];
+			uint16_t type = tile->GetType(); 
+			for (int player = 0; player < 4; player++)
 			{
-				if (s_Map.m_Tiles[y][x].health <= 0.0f)
+				if (markers[player])
 				{
-					s_Map.m_Tiles[y][x].health = LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_GOLD].Value;
-				}
-				for (int i = 0; i < 4; i++)
-				{
-					bool* markers = s_Map.m_Tiles[y + AxiiDirections[i].y][x + AxiiDirections[i].x].marked;
-					Tile* tile = &s_Map.m_Tiles[y + AxiiDirections[i].y][x + AxiiDirections[i].x];
-					uint16_t type = tile->GetType(); 
-					for (int player = 0; player < 4; player++)
+					if (IsMineableForPlayer(type, tile->owner, player))
 					{
-						if (markers[player])
-						{
-							if (IsMineableForPlayer(type, tile->owner, player))
-							{
-								CreatureTaskManager::AddMiningTask(player, XMINT2(x + AxiiDirections[i].x, y + AxiiDirections[i].y), tile);
-							}
-							else
-							{
-								markers[player] = false;
-							}
-						}
+						CreatureTaskManager::AddMiningTask(player, XMINT2(x + AxiiDirections[i].x, y + AxiiDirections[i].y), tile);
+					}
+					else
+					{
+						markers[player] = false;
 					}
 				}
 			}
 		}
 	}
 }
+//Builds the render key of a tile and stores it, returns whether it's different from the stored one.
+//Keyed on everything CreateFromTile/DoUVs read from the map: the full type (3x3 room piece included), the owner (floor/wall colours) and the full types of all 8 neighbours (wall textures come from the neighbouring room).
+//The per block random values are kept in the block map itself so they don't need to be part of it.
+bool LevelData::RefreshTileRenderKey(int y, int x)
+{
+	TileRenderKey key;
+	key.type = s_Map.m_Tiles[y][x].type;
+	key.owner = s_Map.m_Tiles[y][x].owner;
+	key.valid = true;
+	int n = 0;
+	for (int ny = y - 1; ny <= y + 1; ny++)
+	{
+		for (int nx = x - 1; nx <= x + 1; nx++)
+		{
+			if (ny == y && nx == x) continue;
+			key.neighbourTypes[n++] = (ny >= 0 && nx >= 0 && ny < MAP_SIZE_TILES && nx < MAP_SIZE_TILES) ? s_Map.m_Tiles[ny][nx].type : 0xFFFF;
+		}
+	}
+	TileRenderKey& stored = m_TileRenderKeys[y][x];
+	if (stored.valid && stored.type == key.type && stored.owner == key.owner && memcmp(stored.neighbourTypes, key.neighbourTypes, sizeof(key.neighbourTypes)) == 0)
+	{
+		return false;
+	}
+	stored = key;
+	return true;
+}
 uint16_t LevelData::GetTileType(int y, int x)
 {
 	return (s_Map.m_Tiles[y][x].type & 0xFF);
@@ -1022,35 +1416,25 @@ XMINT2 LevelData::GetWalkableNeighbour(int y, int x, int areaCode)
 
 void LevelData::SetRoomFloodID(int ID, int startID,uint16_t type, int y, int x)
 {
-	//if this tile is already the same code, return
-	if (s_Map.m_Tiles[y][x].roomID == ID) return;
+	std::vector<XMINT2> stack;
+	stack.push_back(XMINT2(x, y));
+	while (stack.size() > 0)
+	{
+		const XMINT2 p = stack.back();
+		stack.pop_back();
+		Tile& tile = s_Map.m_Tiles[p.y][p.x];
 
-	//tile is of a space seperating type, return
-	uint16_t nType = s_Map.m_Tiles[y][x].type & 0xFF;
-	if (nType != type) return;
-	
-	//if (DebugRoomIDs && ID != -1)
-	//{
-	//	Entity* e = nullptr;
-	//	if (m_Map.m_Tiles[y][x].placedEntities[0][0])
-	//	{
-	//		e = m_Map.m_Tiles[y][x].placedEntities[0][0];
-	//	}
-	//	else
-	//	{
-	//		e = GetMapEntity();
-	//		m_Map.m_Tiles[y][x].placedEntities[0][0] = e;
-	//	}
-	//	e->m_EntityID = (Entity::EntityType)(ID * 2);
-	//	e->SetSprite(ID *2);
-	//	e->m_Renderable->SetPosition(TileToWorld(XMINT2(x, y)));
-	//}
-	s_Map.m_Tiles[y][x].roomID = ID;
-
-	SetRoomFloodID(ID, startID,type, y - 1, x);
-	SetRoomFloodID(ID, startID,type, y + 1, x);
-	SetRoomFloodID(ID, startID,type, y, x - 1);
-	SetRoomFloodID(ID, startID,type, y, x + 1);
+		//if this tile is already the same code or of a space seperating type, skip it
+		if (tile.roomID == ID) continue;
+		if ((tile.type & 0xFF) != type) continue;
+
+		tile.roomID = ID;
+		m_TileEvents.MarkTile(p.y, p.x);
+		for (int i = 0; i < 4; i++)
+		{
+			stack.push_back(XMINT2(p.x + AxiiDirections[i].x, p.y + AxiiDirections[i].y));
+		}
+	}
 }
 
 void Themp::LevelData::UpdateSurroundingRoomsAdd(uint16_t cType, int y, int x)
@@ -1058,6 +1442,7 @@ void Themp::LevelData::UpdateSurroundingRoomsAdd(uint16_t cType, int y, int x)
 	uint16_t type = cType & 0xFF;
 	uint8_t owner = s_Map.m_Tiles[y][x].owner;
 	s_Map.m_Tiles[y][x].roomID = -1;
+	m_TileEvents.MarkTile(y, x);
 	TileNeighbourTiles n = GetNeighbourTiles(y, x);
 	//check if the same room exists in each direction, if so.. Get the lowest ID, remove those rooms from the Room Array, floodFill set to that ID, and add this room 
 
@@ -1074,7 +1459,7 @@ void Themp::LevelData::UpdateSurroundingRoomsAdd(uint16_t cType, int y, int x)
 				lowestID = t->roomID;
 			}
 			rooms[roomCount] = m_Rooms[owner][t->roomID];
-			m_Rooms[owner].erase(t->roomID);
+			UnregisterRoom(owner, t->roomID);
 			roomCount++;
 
 			SetRoomFloodID(-1, t->roomID,type, y + AxiiDirections[i].y, x + AxiiDirections[i].x);
@@ -1093,8 +1478,8 @@ void Themp::LevelData::UpdateSurroundingRoomsAdd(uint16_t cType, int y, int x)
 		r.roomID = nextRoomID;
 		r.roomType = type;
 		r.tilecount = 1;
-		m_Rooms[owner][nextRoomID] = r;
-		m_Rooms[owner][nextRoomID].tiles[&s_Map.m_Tiles[y][x]] = { 0,x,y, &s_Map.m_Tiles[y][x] };
+		r.AddTile(&s_Map.m_Tiles[y][x], x, y);
+		RegisterRoom(owner, r);
 	}
 	else
 	{
@@ -1105,13 +1490,12 @@ void Themp::LevelData::UpdateSurroundingRoomsAdd(uint16_t cType, int y, int x)
 		mergedRoom.roomID = lowestID;
 		mergedRoom.roomType = type;
 		mergedRoom.tilecount = 1;
-		mergedRoom.tiles[&s_Map.m_Tiles[y][x]] = { 0,x,y, &s_Map.m_Tiles[y][x] };
+		mergedRoom.AddTile(&s_Map.m_Tiles[y][x], x, y);
 		for (int i = 0; i < roomCount; i++)
 		{
 			mergedRoom += rooms[i];
 		}
-		mergedRoom.RecalcRoomData();
-		m_Rooms[owner][lowestID] = mergedRoom;
+		RegisterRoom(owner, mergedRoom);
 	}	
 	s_Map.m_Tiles[y][x].type = type;
 	SetRoomFloodID(lowestID, -1, type, y, x);
@@ -1121,8 +1505,8 @@ void Themp::LevelData::UpdateSurroundingRoomsAdd(uint16_t cType, int y, int x)
 		Room& r = m_Rooms[owner][lowestID];
 		for (auto&& t : r.tiles)
 		{
-			TileNeighbours neighbours = CheckNeighbours(Type_Hatchery, t.second.y, t.second.x);
-			DoRoomUVs(neighbours, Type_Hatchery, TypeToTexture(Type_Hatchery), t.second.x, t.second.y);
+			TileNeighbours neighbours = CheckNeighbours(Type_Hatchery, t.y, t.x);
+			DoHatcheryBlocks(neighbours, t.x, t.y);
 		}
 	}
 
@@ -1150,17 +1534,17 @@ void LevelData::AdjustRoomTile(const LevelData::Room& room, const LevelData::Roo
 	//create or adjust entity on this tile
 	if (room.roomType == Type_Treasure_Room)
 	{
-		if (roomTile.tile->placedEntities[1][1] == nullptr)
+		if (s_Map.m_TileDetails[roomTile.y][roomTile.x].placedEntities[1][1] == nullptr)
 		{
-			roomTile.tile->placedEntities[1][1] = GetMapEntity();
+			s_Map.m_TileDetails[roomTile.y][roomTile.x].placedEntities[1][1] = GetMapEntity();
 		}
 		//middle of the room
 		const int v = roomTile.tileValue;
 		//TODO: Use Game settings!
-		roomTile.tile->placedEntities[1][1]->m_EntityID = (v >= 1020 ? Entity::Entity_Gold4_FP : v > 750 ? Entity::Entity_Gold3_FP : v > 500 ? Entity::Entity_Gold2_FP : v >= 250 ? Entity::Entity_Gold1_FP : Entity::Entity_Gold0_FP);
+		s_Map.m_TileDetails[roomTile.y][roomTile.x].placedEntities[1][1]->m_EntityID = (v >= 1020 ? Entity::Entity_Gold4_FP : v > 750 ? Entity::Entity_Gold3_FP : v > 500 ? Entity::Entity_Gold2_FP : v >= 250 ? Entity::Entity_Gold1_FP : Entity::Entity_Gold0_FP);
 		XMFLOAT3 entityPos = TileToWorld(XMINT2(roomTile.x, roomTile.y));
 		entityPos.y = 2;
-		roomTile.tile->placedEntities[1][1]->m_Renderable->SetPosition(entityPos);
+		s_Map.m_TileDetails[roomTile.y][roomTile.x].placedEntities[1][1]->m_Renderable->SetPosition(entityPos);
 	}
 	else
 	{
@@ -1169,40 +1553,160 @@ void LevelData::AdjustRoomTile(const LevelData::Room& room, const LevelData::Roo
 }
 
 
-void LevelData::CreateRoomFromTile(Room& room,int ID, int startID, uint16_t type, int y, int x)
+void LevelData::Room::AddToTile(RoomTile& tile, int amount)
+{
+	const bool wasFull = tile.tileValue >= tileCapacity;
+	tile.tileValue += amount;
+	roomFillAmount += amount;
+	if (!wasFull && tile.tileValue >= tileCapacity) fullTiles++;
+	roomFillPercentage = capacity > 0 ? roomFillAmount * 100 / capacity : 100;
+}
+void LevelData::Room::RecalcRoomData()
+{
+	//recalc efficiency / fill amount
+	roomEfficiency = 100;
+	switch (roomType)
+	{
+	case Type_Treasure_Room:
+		tileCapacity = LevelConfig::gameSettings[GameSettings::GAME_GOLD_PILE_MAXIMUM].Value * roomEfficiency / 100;
+		break;
+	case Type_Lair:
+		tileCapacity = 1;
+		break;
+	default:
+		tileCapacity = 0;
+		break;
+	}
+	capacity = tileCapacity * tilecount;
+	roomFillAmount = 0;
+	fullTiles = 0;
+	int sumX = 0, sumY = 0;
+	for (size_t i = 0; i < tiles.size(); i++)
+	{
+		roomFillAmount += tiles[i].tileValue;
+		if (tiles[i].tileValue >= tileCapacity) fullTiles++;
+		sumX += tiles[i].x;
+		sumY += tiles[i].y;
+	}
+	roomFillPercentage = capacity > 0 ? roomFillAmount * 100 / capacity : 100;
+	center = tiles.size() > 0 ? XMINT2(sumX / (int)tiles.size(), sumY / (int)tiles.size()) : XMINT2(-1, -1);
+}
+
+//Every room that ends up in m_Rooms goes through here so the per type lists, tile index and cached data stay valid
+void LevelData::RegisterRoom(uint8_t owner, const Room& room)
+{
+	Room& r = m_Rooms[owner][room.roomID];
+	r = room;
+	r.RecalcRoomData();
+	for (size_t i = 0; i < r.tiles.size(); i++)
+	{
+		m_RoomTileIndex[r.tiles[i].y][r.tiles[i].x] = (int)i;
+	}
+	std::vector<int32_t>& typeRooms = m_RoomsByType[owner][r.roomType & 0x3F];
+	if (std::find(typeRooms.begin(), typeRooms.end(), r.roomID) == typeRooms.end())
+	{
+		typeRooms.push_back(r.roomID);
+	}
+}
+void LevelData::UnregisterRoom(uint8_t owner, int32_t roomID)
+{
+	auto it = m_Rooms[owner].find(roomID);
+	if (it == m_Rooms[owner].end()) return;
+	std::vector<int32_t>& typeRooms = m_RoomsByType[owner][it->second.roomType & 0x3F];
+	typeRooms.erase(std::remove(typeRooms.begin(), typeRooms.end(), roomID), typeRooms.end());
+	m_Rooms[owner].erase(it);
+}
+const std::vector<int32_t>& LevelData::GetRooms(uint8_t owner, uint16_t type)
+{
+	return m_RoomsByType[owner][type & 0x3F];
+}
+LevelData::Room::RoomTile& LevelData::GetRoomTile(Room& room, int y, int x)
+{
+	return room.tiles[m_RoomTileIndex[y][x]];
+}
+LevelData::Room* LevelData::FindRoomWithSpace(uint8_t owner, uint16_t type, int areaCode)
 {
-	//if this tile is already the same code, return
-	if (s_Map.m_Tiles[y][x].roomID == ID) return;
+	const std::vector<int32_t>& typeRooms = GetRooms(owner, type);
+	for (size_t i = 0; i < typeRooms.size(); i++)
+	{
+		Room& room = m_Rooms[owner][typeRooms[i]];
+		if (room.areaCode == areaCode && room.HasSpace())
+		{
+			return &room;
+		}
+	}
+	return nullptr;
+}
+//Any tile of any of these rooms in the area is as likely, so a room gets picked by how big it is
+LevelData::Room::RoomTile* LevelData::GetRandomRoomTile(uint8_t owner, uint16_t type, int areaCode)
+{
+	const std::vector<int32_t>& typeRooms = GetRooms(owner, type);
+	size_t totalTiles = 0;
+	for (size_t i = 0; i < typeRooms.size(); i++)
+	{
+		const Room& room = m_Rooms[owner][typeRooms[i]];
+		if (room.areaCode == areaCode)
+		{
+			totalTiles += room.tiles.size();
+		}
+	}
+	if (totalTiles == 0) return nullptr;
 
-	//tile is of a space seperating type, return
-	uint16_t nType = s_Map.m_Tiles[y][x].type & 0xFF;
-	if (nType != type) return;
+	size_t pick = rand() % totalTiles;
+	for (size_t i = 0; i < typeRooms.size(); i++)
+	{
+		Room& room = m_Rooms[owner][typeRooms[i]];
+		if (room.areaCode != areaCode) continue;
+		if (pick < room.tiles.size())
+		{
+			return &room.tiles[pick];
+		}
+		pick -= room.tiles.size();
+	}
+	return nullptr;
+}
 
-	room.tilecount++;
-	Room::RoomTile& rTile = room.tiles[&s_Map.m_Tiles[y][x]];
-	rTile.tile = &s_Map.m_Tiles[y][x];
-	rTile.tileValue = 0;
-	rTile.x = x;
-	rTile.y = y;
-	s_Map.m_Tiles[y][x].roomID = ID;
+void LevelData::CreateRoomFromTile(Room& room,int ID, int startID, uint16_t type, int y, int x, const Room* prevRoom)
+{
+	std::vector<XMINT2> stack;
+	stack.push_back(XMINT2(x, y));
+	while (stack.size() > 0)
+	{
+		const XMINT2 p = stack.back();
+		stack.pop_back();
+		Tile& tile = s_Map.m_Tiles[p.y][p.x];
+
+		//if this tile is already the same code or of a space seperating type, skip it
+		if (tile.roomID == ID) continue;
+		if ((tile.type & 0xFF) != type) continue;
 
-	CreateRoomFromTile(room, ID, startID, type, y - 1, x);
-	CreateRoomFromTile(room, ID, startID, type, y + 1, x);
-	CreateRoomFromTile(room, ID, startID, type, y, x - 1);
-	CreateRoomFromTile(room, ID, startID, type, y, x + 1);
+		room.tilecount++;
+		Room::RoomTile& rTile = room.AddTile(&tile, p.x, p.y);
+		if (prevRoom != nullptr)
+		{
+			//splitting up a room, keep whatever was stored on this tile
+			rTile.tileValue = prevRoom->tiles[m_RoomTileIndex[p.y][p.x]].tileValue;
+		}
+		tile.roomID = ID;
+		m_TileEvents.MarkTile(p.y, p.x);
+		for (int i = 0; i < 4; i++)
+		{
+			stack.push_back(XMINT2(p.x + AxiiDirections[i].x, p.y + AxiiDirections[i].y));
+		}
+	}
 }
-int LevelData::CreateRoomFromArea(uint16_t type, int initialRoomID, int y, int x)
+int LevelData::CreateRoomFromArea(uint16_t type, int initialRoomID, int y, int x, const Room* prevRoom)
 {
 	nextRoomID++;
 	Room newRoom = { 0 };
-	CreateRoomFromTile(newRoom, nextRoomID, initialRoomID, type, y, x);
+	CreateRoomFromTile(newRoom, nextRoomID, initialRoomID, type, y, x, prevRoom);
 
 	if (newRoom.tilecount > 0)
 	{
 		newRoom.roomID = nextRoomID;
 		newRoom.roomType = type;
 		newRoom.areaCode = s_Map.m_Tiles[y][x].areaCode;
-		m_Rooms[s_Map.m_Tiles[y][x].owner][nextRoomID] = newRoom;
+		RegisterRoom(s_Map.m_Tiles[y][x].owner, newRoom);
 		return nextRoomID;
 	}
 	return -1;
@@ -1219,9 +1723,10 @@ void LevelData::ClaimRoomFromEnemy(uint8_t newOwner,uint16_t type, int y, int x)
 	if (newOwner != prevOwner)
 	{
 		//copy the previous owner's room to the new owner
-		m_Rooms[newOwner][roomID] = m_Rooms[prevOwner][roomID];
+		const Room room = m_Rooms[prevOwner][roomID];
 		//remove it from the old owner;
-		m_Rooms[prevOwner].erase(roomID);
+		UnregisterRoom(prevOwner, roomID);
+		RegisterRoom(newOwner, room);
 		//remove their room tiles from the game data
 		//actually mark it claimed
 		ClaimRoom(newOwner, type, y, x);
@@ -1242,13 +1747,14 @@ void Themp::LevelData::UpdateSurroundingRoomsRemove(uint16_t type, int y, int x)
 	System::Print("Removing Room");
 
 
+	//the old tile array stays intact, m_RoomTileIndex keeps pointing into it until the split up rooms get registered
 	Room cRoom = m_Rooms[owner][s_Map.m_Tiles[y][x].roomID];
-	m_Rooms[owner].erase(s_Map.m_Tiles[y][x].roomID);
+	UnregisterRoom(owner, s_Map.m_Tiles[y][x].roomID);
 	s_Map.m_Tiles[y][x].type = Type_Claimed_Land;
 	cRoom.health -= LevelConfig::roomData[LevelConfig::TypeToRoom(type)].Health;
 	cRoom.tilecount--;
-	cRoom.tiles.erase(&s_Map.m_Tiles[y][x]);
 	s_Map.m_Tiles[y][x].roomID = INT32_MAX;
+	m_TileEvents.MarkTile(y, x);
 	if (cRoom.tilecount == 0)
 	{
 		System::Print("Removed Room, was a single tile!");
@@ -1278,7 +1784,7 @@ void Themp::LevelData::UpdateSurroundingRoomsRemove(uint16_t type, int y, int x)
 			//this is a tile that just got set to -1 (non room tiles have INT32_MAX)
 			if (t->roomID == -1)
 			{
-				int newRoomID = CreateRoomFromArea(type,-1, y + AxiiDirections[i].y, x + AxiiDirections[i].x);
+				int newRoomID = CreateRoomFromArea(type,-1, y + AxiiDirections[i].y, x + AxiiDirections[i].x, &cRoom);
 				if (newRoomID != -1)
 				{
 					newRooms[numRooms] = newRoomID;
@@ -1297,22 +1803,13 @@ void Themp::LevelData::UpdateSurroundingRoomsRemove(uint16_t type, int y, int x)
 		r.health = cRoom.health;
 		r.roomID = newRooms[i];
 		r.roomType = cRoom.roomType;
-		for (auto&& t : r.tiles)
-		{
-			auto&& prevT = cRoom.tiles.find(t.first);
-			if (prevT != cRoom.tiles.end())
-			{
-				t.second = prevT->second;
-			}
-		}
-
 		r.RecalcRoomData();
 		if (type == Type_Hatchery)
 		{
 			for (auto&& t : r.tiles)
 			{
-				TileNeighbours neighbours = CheckNeighbours(Type_Hatchery, t.second.y, t.second.x);
-				DoRoomUVs(neighbours, Type_Hatchery, TypeToTexture(Type_Hatchery), t.second.x, t.second.y);
+				TileNeighbours neighbours = CheckNeighbours(Type_Hatchery, t.y, t.x);
+				DoHatcheryBlocks(neighbours, t.x, t.y);
 			}
 		}
 	}
@@ -1320,19 +1817,197 @@ void Themp::LevelData::UpdateSurroundingRoomsRemove(uint16_t type, int y, int x)
 
 void LevelData::UpdateAreaCode(uint32_t newCode, uint16_t currentType, int ty, int tx)
 {
-	//if this tile is already the same code, return
-	if (newCode == s_Map.m_Tiles[ty][tx].areaCode) return;
+	std::vector<XMINT2> stack;
+	stack.push_back(XMINT2(tx, ty));
+	while (stack.size() > 0)
+	{
+		const XMINT2 p = stack.back();
+		stack.pop_back();
+		Tile& tile = s_Map.m_Tiles[p.y][p.x];
 
-	//tile is of a space seperating type, return
-	uint16_t nType = s_Map.m_Tiles[ty][tx].type & 0xFF;
-	if (nType >= Type_Rock && nType <= Type_Wall5 || nType == Type_Lava || nType == Type_Gem) return;
+		//if this tile is already the same code or of a space seperating type, skip it
+		if (newCode == tile.areaCode) continue;
+		if (IsAreaSeparator(tile.type & 0xFF)) continue;
 
-	s_Map.m_Tiles[ty][tx].areaCode = newCode;
+		tile.areaCode = newCode;
+		RefreshWalkableTile(p.y, p.x);
+		for (int i = 0; i < 4; i++)
+		{
+			stack.push_back(XMINT2(p.x + AxiiDirections[i].x, p.y + AxiiDirections[i].y));
+		}
+	}
+}
+//A tile just opened up, it joins (and connects) the areas around it
+//The biggest area keeps its code and the tiles of the smaller ones get moved over, so a tile is relabeled at most log(n) times over a whole game
+void LevelData::OpenTile(int y, int x)
+{
+	TileNeighbourTiles neighbours = GetNeighbourTiles(y, x);
+	uint32_t areas[4];
+	int numAreas = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		const uint32_t code = neighbours.Axii[i]->areaCode;
+		if (code == 0 || IsAreaSeparator(neighbours.Axii[i]->type & 0xFF)) continue;
+		bool known = false;
+		for (int j = 0; j < numAreas; j++)
+		{
+			known |= areas[j] == code;
+		}
+		if (!known)
+		{
+			areas[numAreas++] = code;
+		}
+	}
+	if (numAreas == 0)
+	{
+		//surrounded by walls, this is a brand new area
+		s_Map.m_Tiles[y][x].areaCode = NextAreaCode++;
+		RefreshWalkableTile(y, x);
+		return;
+	}
 
-	UpdateAreaCode(newCode, currentType, ty - 1, tx);
-	UpdateAreaCode(newCode, currentType, ty + 1, tx);
-	UpdateAreaCode(newCode, currentType, ty, tx - 1);
-	UpdateAreaCode(newCode, currentType, ty, tx + 1);
+	uint32_t biggest = areas[0];
+	for (int i = 1; i < numAreas; i++)
+	{
+		if (m_AreaWalkableTiles[areas[i]].size() > m_AreaWalkableTiles[biggest].size())
+		{
+			biggest = areas[i];
+		}
+	}
+	s_Map.m_Tiles[y][x].areaCode = biggest;
+	RefreshWalkableTile(y, x);
+	for (int i = 0; i < numAreas; i++)
+	{
+		if (areas[i] != biggest)
+		{
+			MergeAreas(areas[i], biggest);
+		}
+	}
+}
+void LevelData::MergeAreas(uint32_t from, uint32_t to)
+{
+	auto it = m_AreaWalkableTiles.find(from);
+	if (it != m_AreaWalkableTiles.end())
+	{
+		//the walkable list of an area holds every tile of it, so no flood fill needed
+		std::vector<XMINT2> tiles = std::move(it->second);
+		m_AreaWalkableTiles.erase(it);
+		std::vector<XMINT2>& target = m_AreaWalkableTiles[to];
+		target.reserve(target.size() + tiles.size());
+		for (size_t i = 0; i < tiles.size(); i++)
+		{
+			const XMINT2 p = tiles[i];
+			s_Map.m_Tiles[p.y][p.x].areaCode = to;
+			m_WalkableTileArea[p.y][p.x] = to;
+			m_WalkableTileIndex[p.y][p.x] = (int32_t)target.size();
+			target.push_back(p);
+		}
+	}
+	m_UnexploredTiles.MergeAreas(from, to);
+	for (int i = 0; i < 6; i++)
+	{
+		for (auto& room : m_Rooms[i])
+		{
+			if (room.second.areaCode == (int)from)
+			{
+				room.second.areaCode = to;
+			}
+		}
+	}
+}
+//A tile got closed off, which might have split its area in pieces
+//A search starts from every neighbour of the old area, taking turns a tile at a time. Searches that run into each other get joined (union-find),
+//once they're all joined nothing split and nothing gets relabeled. A group that runs out of tiles first is a cut off piece,
+//being the first to run out it's also the smaller side, so only that piece gets a new code
+void LevelData::CloseTile(int y, int x)
+{
+	const uint32_t oldCode = s_Map.m_Tiles[y][x].areaCode;
+	if (oldCode == 0) return;
+	s_Map.m_Tiles[y][x].areaCode = 0;
+	RefreshWalkableTile(y, x);
+
+	static std::vector<XMINT2> queues[4];
+	size_t heads[4] = { 0 };
+	int parent[4];
+	bool done[4] = { false };
+	XMINT2 starts[4];
+	int numSearches = 0;
+	m_AreaSearchStamp++;
+	for (int i = 0; i < 4; i++)
+	{
+		const int ny = y + AxiiDirections[i].y;
+		const int nx = x + AxiiDirections[i].x;
+		if (s_Map.m_Tiles[ny][nx].areaCode != oldCode || IsAreaSeparator(s_Map.m_Tiles[ny][nx].type & 0xFF)) continue;
+		queues[numSearches].clear();
+		queues[numSearches].push_back(XMINT2(nx, ny));
+		starts[numSearches] = XMINT2(nx, ny);
+		parent[numSearches] = numSearches;
+		m_AreaSearchMark[ny][nx] = m_AreaSearchStamp * 4 + numSearches;
+		numSearches++;
+	}
+	auto root = [&parent](int s)
+	{
+		while (parent[s] != s) s = parent[s];
+		return s;
+	};
+	//groups that are neither joined nor cut off yet, splitting needs at least two of them
+	int openGroups = numSearches;
+	while (openGroups > 1)
+	{
+		for (int s = 0; s < numSearches && openGroups > 1; s++)
+		{
+			if (done[root(s)] || heads[s] == queues[s].size()) continue;
+			const XMINT2 p = queues[s][heads[s]++];
+			for (int i = 0; i < 4; i++)
+			{
+				const int ny = p.y + AxiiDirections[i].y;
+				const int nx = p.x + AxiiDirections[i].x;
+				const Tile& n = s_Map.m_Tiles[ny][nx];
+				if (n.areaCode != oldCode || IsAreaSeparator(n.type & 0xFF)) continue;
+				const uint32_t mark = m_AreaSearchMark[ny][nx];
+				if (mark / 4 != m_AreaSearchStamp)
+				{
+					m_AreaSearchMark[ny][nx] = m_AreaSearchStamp * 4 + s;
+					queues[s].push_back(XMINT2(nx, ny));
+				}
+				else
+				{
+					const int a = root(s);
+					const int b = root(mark % 4);
+					if (a != b)
+					{
+						parent[b] = a;
+						openGroups--;
+					}
+				}
+			}
+		}
+		//a group whose searches all ran dry is a piece that got cut off
+		for (int s = 0; s < numSearches && openGroups > 1; s++)
+		{
+			const int r = root(s);
+			if (r != s || done[r]) continue;
+			bool exhausted = true;
+			for (int t = 0; t < numSearches; t++)
+			{
+				exhausted &= root(t) != r || heads[t] == queues[t].size();
+			}
+			if (!exhausted) continue;
+			done[r] = true;
+			openGroups--;
+			UpdateAreaCode(NextAreaCode++, Type_Unclaimed_Path, starts[s].y, starts[s].x);
+		}
+	}
+	for (int i = 0; i < 6; i++)
+	{
+		for (auto& room : m_Rooms[i])
+		{
+			if (room.second.areaCode == (int)oldCode && room.second.tiles.size() > 0)
+			{
+				room.second.areaCode = room.second.tiles[0].tile->areaCode;
+			}
+		}
+	}
 }
 bool LevelData::CollectiveClaimRoom(uint16_t type, int ty, int tx)
 {
@@ -1356,22 +2031,32 @@ bool LevelData::CollectiveClaimRoom(uint16_t type, int ty, int tx)
 }
 void LevelData::ClaimRoom(uint8_t newOwner, uint16_t type, int ty, int tx)
 {
-	//if this tile is already ours, return
-	if (newOwner == s_Map.m_Tiles[ty][tx].owner) return;
-
-	//tile is of a different type, return
-	uint16_t nType = s_Map.m_Tiles[ty][tx].GetType();
-	if (type != nType) return;
-
-	CreatureTaskManager::RemoveClaimingTask(newOwner, &s_Map.m_Tiles[ty][tx]);
-	s_Map.m_Tiles[ty][tx].owner = newOwner;
-	s_Map.m_Tiles[ty][tx].health = LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_ROOM].Value;
-	ClaimRoom(newOwner, type, ty - 1, tx);
-	ClaimRoom(newOwner, type, ty + 1, tx);
-	ClaimRoom(newOwner, type, ty, tx - 1);
-	ClaimRoom(newOwner, type, ty, tx + 1);
-
-	UpdateArea(ty - 1, ty + 1, tx - 1, tx + 1);
+	std::vector<XMINT2> stack;
+	std::vector<XMINT2> claimed;
+	stack.push_back(XMINT2(tx, ty));
+	while (stack.size() > 0)
+	{
+		const XMINT2 p = stack.back();
+		stack.pop_back();
+		Tile& tile = s_Map.m_Tiles[p.y][p.x];
+
+		//if this tile is already ours or of a different type, skip it
+		if (newOwner == tile.owner) continue;
+		if (type != tile.GetType()) continue;
+
+		CreatureTaskManager::RemoveClaimingTask(newOwner, &tile);
+		tile.owner = newOwner;
+		tile.health = LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_ROOM].Value;
+		claimed.push_back(p);
+		for (int i = 0; i < 4; i++)
+		{
+			stack.push_back(XMINT2(p.x + AxiiDirections[i].x, p.y + AxiiDirections[i].y));
+		}
+	}
+	for (size_t i = 0; i < claimed.size(); i++)
+	{
+		QueueAreaUpdate(claimed[i].y - 1, claimed[i].y + 1, claimed[i].x - 1, claimed[i].x + 1);
+	}
 }
 bool LevelData::IsClaimableCorner(int y, int x)
 {
@@ -1414,12 +2099,12 @@ void LevelData::ClaimTile(uint8_t player, int y, int x)
 			s_Map.m_Tiles[y][x].type = Type_Claimed_Land;
 			s_Map.m_Tiles[y][x].health = LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_PRETTY].Value;
 			s_Map.m_Tiles[y][x].owner = player;
-			UpdateArea(y - 1, y + 1, x - 1, x + 1);
+			QueueAreaUpdate(y - 1, y + 1, x - 1, x + 1);
 
 
 			//AddLight(x, y);
 
-			System::tSys->m_Audio->PlayOneShot(FileManager::GetSound("STARS3.WAV")); 
+			FileManager::PlayOneShot("STARS3.WAV"); 
 		}
 		else if (type == Type_Earth || type == Type_Earth_Torch)
 		{
@@ -1492,13 +2177,13 @@ void LevelData::ClaimTile(uint8_t player, int y, int x)
 			}
 			UpdateWalls(y, x);
 
-			UpdateArea(y - 1, y + 1, x - 1, x + 1);
+			QueueAreaUpdate(y - 1, y + 1, x - 1, x + 1);
 
-			System::tSys->m_Audio->PlayOneShot(FileManager::GetSound("STARS3.WAV"));
+			FileManager::PlayOneShot("STARS3.WAV");
 		}
 		else if (IsClaimableRoom(type))
 		{
-			System::tSys->m_Audio->PlayOneShot(FileManager::GetSound("TAKEOVER.WAV"));
+			FileManager::PlayOneShot("TAKEOVER.WAV");
 			ClaimRoomFromEnemy(player, type, y, x);
 		}
 	}
@@ -1509,21 +2194,21 @@ bool LevelData::BuildRoom(uint16_t type, uint8_t owner, int y, int x)
 	int roomCost = LevelConfig::roomData[LevelConfig::TypeToRoom(type)].Cost;
 	if (currentMoney < roomCost)
 	{
-		System::tSys->m_Audio->PlayOneShot(FileManager::GetSound("CANT.WAV"));
+		FileManager::PlayOneShot("CANT.WAV");
 		return false;
 	}
 	if (s_Map.m_Tiles[y][x].GetType() == Type_Claimed_Land && s_Map.m_Tiles[y][x].owner == owner)
 	{
 		UpdateSurroundingRoomsAdd(type, y, x);
-		UpdateArea(y - 1, y + 1, x - 1, x + 1);
+		QueueAreaUpdate(y - 1, y + 1, x - 1, x + 1);
 		LevelScript::GameValues[owner]["MONEY"] -= roomCost;
-		System::tSys->m_Audio->PlayOneShot(FileManager::GetSound("SLAB3.WAV"));
+		FileManager::PlayOneShot("SLAB3.WAV");
 		LevelScript::AddRoom(owner, type, 1);
 		return true;
 	}
 	else
 	{
-		System::tSys->m_Audio->PlayOneShot(FileManager::GetSound("CANT.WAV"));
+		FileManager::PlayOneShot("CANT.WAV");
 		return false;
 	}
 	return false;
@@ -1534,19 +2219,121 @@ bool LevelData::DeleteRoom(uint8_t owner, int y, int x)
 	if (IsClaimableRoom(type) && type != Type_Portal)
 	{
 		UpdateSurroundingRoomsRemove(type, y, x);
-		UpdateArea(y - 1, y + 1, x - 1, x + 1);
-		System::tSys->m_Audio->PlayOneShot(FileManager::GetSound("SUCK.WAV"));
+		QueueAreaUpdate(y - 1, y + 1, x - 1, x + 1);
+		FileManager::PlayOneShot("SUCK.WAV");
 		LevelScript::GameValues[owner]["MONEY"] += LevelConfig::roomData[LevelConfig::TypeToRoom(type)].Cost / 2;
 		LevelScript::AddRoom(owner, type, -1);
 	}
 	else
 	{
-		System::tSys->m_Audio->PlayOneShot(FileManager::GetSound("CANT.WAV"));
+		FileManager::PlayOneShot("CANT.WAV");
 		return false;
 	}
 	return false;
 }
 
+//Moves a tile between the per area walkable lists if its type or area code changed, lists are unordered so removal is a swap with the last entry
+void LevelData::RefreshWalkableTile(int y, int x)
+{
+	const Tile& tile = s_Map.m_Tiles[y][x];
+	const uint32_t area = IsWalkable(tile.GetType()) ? tile.areaCode : 0;
+	const uint32_t oldArea = m_WalkableTileArea[y][x];
+	if (area == oldArea) return;
+
+	if (oldArea != 0)
+	{
+		std::vector<XMINT2>& oldList = m_AreaWalkableTiles[oldArea];
+		const int32_t index = m_WalkableTileIndex[y][x];
+		const XMINT2 last = oldList.back();
+		oldList[index] = last;
+		m_WalkableTileIndex[last.y][last.x] = index;
+		oldList.pop_back();
+		m_WalkableTileIndex[y][x] = -1;
+	}
+	m_WalkableTileArea[y][x] = area;
+	if (area != 0)
+	{
+		std::vector<XMINT2>& newList = m_AreaWalkableTiles[area];
+		m_WalkableTileIndex[y][x] = (int32_t)newList.size();
+		newList.push_back(XMINT2(x, y));
+		//the unexplored tiles around it are on the edge of this area now
+		for (int i = 0; i < 4; i++)
+		{
+			const XMINT2 n = XMINT2(x, y) + AxiiDirections[i];
+			if (n.x < 0 || n.y < 0 || n.x >= MAP_SIZE_TILES || n.y >= MAP_SIZE_TILES) continue;
+			m_UnexploredTiles.AddToArea(area, n.y, n.x);
+		}
+	}
+}
+bool LevelData::GetRandomWalkableTile(int areaCode, XMINT2& outTile)
+{
+	auto it = m_AreaWalkableTiles.find(areaCode);
+	if (it == m_AreaWalkableTiles.end() || it->second.size() == 0) return false;
+	outTile = it->second[rand() % it->second.size()];
+	return true;
+}
+//Picks a random walkable tile of this area within [center - range, center + range)
+bool LevelData::GetRandomWalkableTileInRange(int areaCode, XMINT2 center, int range, XMINT2& outTile)
+{
+	auto it = m_AreaWalkableTiles.find(areaCode);
+	if (it == m_AreaWalkableTiles.end() || it->second.size() == 0) return false;
+	const std::vector<XMINT2>& walkable = it->second;
+
+	const int minY = center.y - range >= range ? center.y - range : range;
+	const int minX = center.x - range >= range ? center.x - range : range;
+	const int maxY = center.y + range < MAP_SIZE_TILES ? center.y + range : MAP_SIZE_TILES - range - 1;
+	const int maxX = center.x + range < MAP_SIZE_TILES ? center.x + range : MAP_SIZE_TILES - range - 1;
+	if (maxY <= minY || maxX <= minX) return false;
+
+	//small areas (a freshly dug out pocket, a room behind a door) have fewer tiles than the window, keep a random one of those inside it
+	if (walkable.size() <= (size_t)((maxY - minY) * (maxX - minX)))
+	{
+		int found = 0;
+		for (size_t i = 0; i < walkable.size(); i++)
+		{
+			const XMINT2& p = walkable[i];
+			if (p.y >= minY && p.y < maxY && p.x >= minX && p.x < maxX)
+			{
+				found++;
+				if (rand() % found == 0)
+				{
+					outTile = p;
+				}
+			}
+		}
+		return found > 0;
+	}
+
+	//m_WalkableTileArea tells which list a tile is in, most of the time a few random guesses inside the window are enough
+	for (int i = 0; i < 8; i++)
+	{
+		const int y = minY + rand() % (maxY - minY);
+		const int x = minX + rand() % (maxX - minX);
+		if (m_WalkableTileArea[y][x] == (uint32_t)areaCode)
+		{
+			outTile = XMINT2(x, y);
+			return true;
+		}
+	}
+	//mostly walls around us, go over the window once and keep a random one of the matching tiles
+	int found = 0;
+	for (int y = minY; y < maxY; y++)
+	{
+		for (int x = minX; x < maxX; x++)
+		{
+			if (m_WalkableTileArea[y][x] == (uint32_t)areaCode)
+			{
+				found++;
+				if (rand() % found == 0)
+				{
+					outTile = XMINT2(x, y);
+				}
+			}
+		}
+	}
+	return found > 0;
+}
+
 XMINT2 LevelData::WorldToTile(XMFLOAT3 pos)
 {
 	return XMINT2(((int)round(pos.x)) / 3, ((int)round(pos.z)) / 3);
@@ -1836,7 +2623,6 @@ void LevelData::LoadLevelFileData()
 		yIndex++;
 	}
 
-	uint16_t lightArrayPosition = 0;
 	bool PlayerHeartsPlaced[6] = { false,false,false,false,false,false };
 	for (int y = 0; y < MAP_SIZE_TILES; y++)
 	{
@@ -1847,8 +2633,6 @@ void LevelData::LoadLevelFileData()
 				adjustedMap[y][x].visible = true;
 			}
 			Tile& mapTile = adjustedMap[y][x];
-			mapTile.lightArrayIndex = lightArrayPosition;
-			lightArrayPosition += 4;
 			const uint16_t type = mapTile.type & 0xFF;
 			if (type == Type_Dungeon_Heart && !PlayerHeartsPlaced[mapTile.owner])
 			{
@@ -1866,7 +2650,7 @@ void LevelData::LoadLevelFileData()
 					//1x1,3x3,5x5 etc..
 					wPos.y = 5; //dungeon heart table is always on 5 high
 					e->m_Renderable->SetPosition(wPos);
-					adjustedMap[y][x].placedEntities[1][1] = e;
+					s_Map.m_TileDetails[y][x].placedEntities[1][1] = e;
 				}
 				else //even 
 				{
@@ -1875,7 +2659,7 @@ void LevelData::LoadLevelFileData()
 					wPos.z += 1.5f;
 					wPos.y = 5;
 					e->m_Renderable->SetPosition(wPos);
-					adjustedMap[y][x].placedEntities[2][2] = e;
+					s_Map.m_TileDetails[y][x].placedEntities[2][2] = e;
 				}
 				Level::s_CurrentLevel->m_Players[mapTile.owner]->m_DungeonHeartLocation = WorldToTile(wPos);
 				e->ResetScale();
@@ -2024,9 +2808,7 @@ void LevelData::LoadLevelFileData()
 			map_lgt.SkipBytes(1);
 			light.z = map_lgt.ReadUInt8();
 			map_lgt.SkipBytes(4);
-			s_Lights[i] = light;
-			light.lightIndex = currentLightIndex++;
-			AddLightToTiles(light);
+			s_LightGrid.AddLight(light);
 		}
 
 
@@ -2036,16 +2818,34 @@ void LevelData::LoadLevelFileData()
 		light.x = 128;
 		light.y = 125;
 		light.z = 2;
-		s_Lights[1] = light;
-		light.lightIndex = currentLightIndex++;
-		AddLightToTiles(light);
+		s_LightGrid.AddLight(light);
 	}
 
 
 }
 
 
-void LevelData::DoUVs(uint16_t type, int y, int x)
+void LevelData::GetTileUVs(int y, int x, TileUVs& out) const
+{
+	const RenderTile& model = VoxelModels::Get(m_TileModels[y][x]);
+	out.yP = y * 3;
+	out.xP = x * 3;
+	for (int z = 0; z < MAP_SIZE_HEIGHT; z++)
+	{
+		for (int sy = 0; sy < 3; sy++)
+		{
+			for (int sx = 0; sx < 3; sx++)
+			{
+				for (int i = 0; i < 3; i++)
+				{
+					out.blocks[z][sy][sx].uv[i] = model.subTile[sy][sx][z].uv[i];
+				}
+			}
+		}
+	}
+	DoUVs(s_Map.m_Tiles[y][x].type & 0xFF, y, x, out);
+}
+void LevelData::DoUVs(uint16_t type, int y, int x, TileUVs& out) const
 {
 	const int yP = y * 3;
 	const int xP = x * 3;
@@ -2058,7 +2858,7 @@ void LevelData::DoUVs(uint16_t type, int y, int x)
 			for (int sx = 0; sx < 3; sx++)
 			{
 				const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndex].top[0];
-				m_BlockMap[5][yP + sy][xP + sx].uv[2] = tex1[m_BlockMap[5][yP + sy][xP + sx].randValue % tex1.size()];
+				out.At(5, yP + sy, xP + sx).uv[2] = tex1[BlockSeed(5, yP + sy, xP + sx) % tex1.size()];
 			}
 	}
 	else if (type == Type_Unclaimed_Path)
@@ -2073,7 +2873,7 @@ void LevelData::DoUVs(uint16_t type, int y, int x)
 				for (int sy = 0; sy < 3; sy++)
 					for (int sx = 0; sx < 3; sx++)
 					{
-						m_BlockMap[1][yP + sy][xP + sx].uv[2] = tex0[m_BlockMap[1][yP + sy][xP + sx].randValue % tex0.size()];
+						out.At(1, yP + sy, xP + sx).uv[2] = tex0[BlockSeed(1, yP + sy, xP + sx) % tex0.size()];
 					}
 			}
 		}
@@ -2083,7 +2883,7 @@ void LevelData::DoUVs(uint16_t type, int y, int x)
 			for (int sy = 0; sy < 3; sy++)
 				for (int sx = 0; sx < 3; sx++)
 				{
-					m_BlockMap[1][yP + sy][xP + sx].uv[2] = tex0[m_BlockMap[1][yP + sy][xP + sx].randValue % tex0.size()];
+					out.At(1, yP + sy, xP + sx).uv[2] = tex0[BlockSeed(1, yP + sy, xP + sx) % tex0.size()];
 				}
 		}
 	}
@@ -2093,152 +2893,111 @@ void LevelData::DoUVs(uint16_t type, int y, int x)
 		const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndex].top[1];
 		if (neighbour.North == N_SAME)
 		{
-			m_BlockMap[1][yP + 2][xP + 1].uv[2] = tex1[m_BlockMap[1][yP + 2][xP + 1].randValue % tex1.size()];
+			out.At(1, yP + 2, xP + 1).uv[2] = tex1[BlockSeed(1, yP + 2, xP + 1) % tex1.size()];
 			if (neighbour.East == N_SAME)
 			{
-				m_BlockMap[1][yP + 2][xP + 2].uv[2] = tex1[m_BlockMap[1][yP + 2][xP + 2].randValue % tex1.size()];
+				out.At(1, yP + 2, xP + 2).uv[2] = tex1[BlockSeed(1, yP + 2, xP + 2) % tex1.size()];
 			}
 			else
 			{
-				m_BlockMap[1][yP + 2][xP + 2].uv[2] = tex0[5];
+				out.At(1, yP + 2, xP + 2).uv[2] = tex0[5];
 			}
 			if (neighbour.West == N_SAME)
 			{
-				m_BlockMap[1][yP + 2][xP].uv[2] = tex1[m_BlockMap[1][yP + 2][xP].randValue % tex1.size()];
+				out.At(1, yP + 2, xP).uv[2] = tex1[BlockSeed(1, yP + 2, xP) % tex1.size()];
 			}
 			else
 			{
-				m_BlockMap[1][yP + 2][xP].uv[2] = tex0[3];
+				out.At(1, yP + 2, xP).uv[2] = tex0[3];
 			}
 		}
 		else
 		{
-			m_BlockMap[1][yP + 2][xP + 1].uv[2] = tex0[7];
+			out.At(1, yP + 2, xP + 1).uv[2] = tex0[7];
 			if (neighbour.East == N_SAME)
 			{
-				m_BlockMap[1][yP + 2][xP + 2].uv[2] = tex0[7];
+				out.At(1, yP + 2, xP + 2).uv[2] = tex0[7];
 			}
 			else
 			{
-				m_BlockMap[1][yP + 2][xP + 2].uv[2] = tex0[8];
+				out.At(1, yP + 2, xP + 2).uv[2] = tex0[8];
 			}
 			if (neighbour.West == N_SAME)
 			{
-				m_BlockMap[1][yP + 2][xP].uv[2] = tex0[7];
+				out.At(1, yP + 2, xP).uv[2] = tex0[7];
 			}
 			else
 			{
-				m_BlockMap[1][yP + 2][xP].uv[2] = tex0[6];
+				out.At(1, yP + 2, xP).uv[2] = tex0[6];
 			}
 		}
 		if (neighbour.South == N_SAME)
 		{
-			m_BlockMap[1][yP][xP + 1].uv[2] = tex1[m_BlockMap[1][yP][xP + 1].randValue % tex1.size()];
+			out.At(1, yP, xP + 1).uv[2] = tex1[BlockSeed(1, yP, xP + 1) % tex1.size()];
 			if (neighbour.East == N_SAME)
 			{
-				m_BlockMap[1][yP][xP + 2].uv[2] = tex1[m_BlockMap[1][yP][xP + 2].randValue % tex1.size()];
+				out.At(1, yP, xP + 2).uv[2] = tex1[BlockSeed(1, yP, xP + 2) % tex1.size()];
 			}
 			else
 			{
-				m_BlockMap[1][yP][xP + 2].uv[2] = tex0[5];
+				out.At(1, yP, xP + 2).uv[2] = tex0[5];
 			}
 			if (neighbour.West == N_SAME)
 			{
-				m_BlockMap[1][yP][xP].uv[2] = tex1[m_BlockMap[1][yP][xP].randValue % tex1.size()];
+				out.At(1, yP, xP).uv[2] = tex1[BlockSeed(1, yP, xP) % tex1.size()];
 			}
 			else
 			{
-				m_BlockMap[1][yP][xP].uv[2] = tex0[3];
+				out.At(1, yP, xP).uv[2] = tex0[3];
 			}
 		}
 		else
 		{
-			m_BlockMap[1][yP][xP + 1].uv[2] = tex0[1];
+			out.At(1, yP, xP + 1).uv[2] = tex0[1];
 			if (neighbour.East == N_SAME)
 			{
-				m_BlockMap[1][yP][xP + 2].uv[2] = tex0[1];
+				out.At(1, yP, xP + 2).uv[2] = tex0[1];
 			}
 			else
 			{
-				m_BlockMap[1][yP][xP + 2].uv[2] = tex0[2];
+				out.At(1, yP, xP + 2).uv[2] = tex0[2];
 			}
 			if (neighbour.West == N_SAME)
 			{
-				m_BlockMap[1][yP][xP].uv[2] = tex0[1];
+				out.At(1, yP, xP).uv[2] = tex0[1];
 			}
 			else
 			{
-				m_BlockMap[1][yP][xP].uv[2] = tex0[0];
+				out.At(1, yP, xP).uv[2] = tex0[0];
 			}
 		}
 		if (neighbour.East == N_SAME)
 		{
-			m_BlockMap[1][yP + 1][xP + 2].uv[2] = tex1[m_BlockMap[1][yP + 1][xP + 2].randValue % tex1.size()];
+			out.At(1, yP + 1, xP + 2).uv[2] = tex1[BlockSeed(1, yP + 1, xP + 2) % tex1.size()];
 		}
 		else
 		{
-			m_BlockMap[1][yP + 1][xP + 2].uv[2] = tex0[5];
+			out.At(1, yP + 1, xP + 2).uv[2] = tex0[5];
 		}
 		if (neighbour.West == N_SAME)
 		{
-			m_BlockMap[1][yP + 1][xP].uv[2] = tex1[m_BlockMap[1][yP + 1][xP].randValue % tex1.size()];
+			out.At(1, yP + 1, xP).uv[2] = tex1[BlockSeed(1, yP + 1, xP) % tex1.size()];
 		}
 		else
 		{
-			m_BlockMap[1][yP + 1][xP].uv[2] = tex0[3];
+			out.At(1, yP + 1, xP).uv[2] = tex0[3];
 		}
-		m_BlockMap[1][yP + 1][xP + 1].uv[2] = t_FloorOwners[s_Map.m_Tiles[y][x].owner];
+		out.At(1, yP + 1, xP + 1).uv[2] = t_FloorOwners[s_Map.m_Tiles[y][x].owner];
 	} 
-	DoRoomUVs(neighbour, type, texIndex, x, y);
-	DoWallUVs(neighbour, type, texIndex, x, y);
+	DoRoomUVs(neighbour, type, texIndex, x, y, out);
+	DoWallUVs(neighbour, type, texIndex, x, y, out);
 
 	//debugging ownership
-	//m_BlockMap[1][yP + 1][xP + 1].uv[2] = t_FloorOwners[m_Map.m_Tiles[y][x].owner];
-	//m_BlockMap[5][yP + 1][xP + 1].uv[2] = t_FloorOwners[m_Map.m_Tiles[y][x].owner];
-}
-
-uint32_t LevelData::GetFreeLightIndex(uint16_t base)
-{
-	for (uint16_t i = 0; i < 4; i++)
-	{
-		if (s_PerTileLights[base + i] == -1)
-		{
-			return base + i;
-		}
-	}
-	return -1;
-}
-
-void LevelData::AddLightToTiles(const Light& light)
-{
-	const int lightRange = (int)ceil(ceil((float)light.range / 3.0f) / 2.0f);
-	XMINT2 tilePos = WorldToTile(XMFLOAT3(light.x , 0, light.y));
-	for (int y = -lightRange; y < lightRange; y++)
-	{
-		for (int x = -lightRange; x < lightRange; x++)
-		{
-			if (tilePos.x + x >= 0 && tilePos.y + y >= 0 && tilePos.x + x < MAP_SIZE_TILES && tilePos.y + y < MAP_SIZE_TILES)
-			{
-				Tile& tile = s_Map.m_Tiles[tilePos.y + y][tilePos.x + x];
-				//if (IsWalkable(tile.GetType()))
-				{
-					uint32_t freeIndex = GetFreeLightIndex(tile.lightArrayIndex);
-					if (freeIndex != -1)
-					{
-						s_PerTileLights[freeIndex] = light.lightIndex;
-					}
-					else
-					{
-						System::Print("Tile: (y: %i, x: %i) is influenced by more than 4 lights!", light.y + y, light.x + x);
-					}
-				}
-			}
-		}
-	}
+	//out.At(1, yP + 1, xP + 1).uv[2] = t_FloorOwners[m_Map.m_Tiles[y][x].owner];
+	//out.At(5, yP + 1, xP + 1).uv[2] = t_FloorOwners[m_Map.m_Tiles[y][x].owner];
 }
 
-
-void LevelData::DoRoomUVs(const TileNeighbours& neighbour, int type, int texIndex, int x, int y)
+void LevelData::DoRoomUVs(const TileNeighbours& neighbour, int type, int texIndex, int x, int y, TileUVs& out) const
 {
 	const int yP = y * 3;
 	const int xP = x * 3;
@@ -2247,25 +3006,25 @@ void LevelData::DoRoomUVs(const TileNeighbours& neighbour, int type, int texInde
 		const std::vector<XMFLOAT2>& tex0 = BlockTextures[texIndex].top[0];
 
 		//LU
-		m_BlockMap[1][yP + 2][xP].uv[2] = tex0[neighbour.North != N_SAME && neighbour.West != N_SAME ? 6 : neighbour.North != N_SAME ? 7 : neighbour.West != N_SAME ? 3 : 4];
+		out.At(1, yP + 2, xP).uv[2] = tex0[neighbour.North != N_SAME && neighbour.West != N_SAME ? 6 : neighbour.North != N_SAME ? 7 : neighbour.West != N_SAME ? 3 : 4];
 		//MU
-		m_BlockMap[1][yP + 2][xP + 1].uv[2] = tex0[neighbour.North != N_SAME ? 7 : 4];
+		out.At(1, yP + 2, xP + 1).uv[2] = tex0[neighbour.North != N_SAME ? 7 : 4];
 		//RU
-		m_BlockMap[1][yP + 2][xP + 2].uv[2] = tex0[neighbour.North != N_SAME && neighbour.East != N_SAME ? 8 : neighbour.North != N_SAME ? 7 : neighbour.East != N_SAME ? 5 : 4];
+		out.At(1, yP + 2, xP + 2).uv[2] = tex0[neighbour.North != N_SAME && neighbour.East != N_SAME ? 8 : neighbour.North != N_SAME ? 7 : neighbour.East != N_SAME ? 5 : 4];
 
 		//LM
-		m_BlockMap[1][yP + 1][xP].uv[2] = tex0[neighbour.West != N_SAME ? 3 : 4];
+		out.At(1, yP + 1, xP).uv[2] = tex0[neighbour.West != N_SAME ? 3 : 4];
 		//MM
-		m_BlockMap[1][yP + 1][xP + 1].uv[2] = tex0[4]; //middle tile is always the same
+		out.At(1, yP + 1, xP + 1).uv[2] = tex0[4]; //middle tile is always the same
 		//RM
-		m_BlockMap[1][yP + 1][xP + 2].uv[2] = tex0[neighbour.East != N_SAME ? 5 : 4];
+		out.At(1, yP + 1, xP + 2).uv[2] = tex0[neighbour.East != N_SAME ? 5 : 4];
 
 		//LD
-		m_BlockMap[1][yP][xP].uv[2] = tex0[neighbour.South != N_SAME && neighbour.West != N_SAME ? 0 : neighbour.South != N_SAME ? 1 : neighbour.West != N_SAME ? 3 : 4];
+		out.At(1, yP, xP).uv[2] = tex0[neighbour.South != N_SAME && neighbour.West != N_SAME ? 0 : neighbour.South != N_SAME ? 1 : neighbour.West != N_SAME ? 3 : 4];
 		//MD
-		m_BlockMap[1][yP][xP + 1].uv[2] = tex0[neighbour.South != N_SAME ? 1 : 4];
+		out.At(1, yP, xP + 1).uv[2] = tex0[neighbour.South != N_SAME ? 1 : 4];
 		//RD
-		m_BlockMap[1][yP][xP + 2].uv[2] = tex0[neighbour.South != N_SAME && neighbour.East != N_SAME ? 2 : neighbour.South != N_SAME ? 1 : neighbour.East != N_SAME ? 5 : 4];
+		out.At(1, yP, xP + 2).uv[2] = tex0[neighbour.South != N_SAME && neighbour.East != N_SAME ? 2 : neighbour.South != N_SAME ? 1 : neighbour.East != N_SAME ? 5 : 4];
 	}
 	else if (type == Type_Hatchery)
 	{
@@ -2275,94 +3034,118 @@ void LevelData::DoRoomUVs(const TileNeighbours& neighbour, int type, int texInde
 		{
 			for (int sx = 0; sx < 3; sx++)
 			{
-				m_BlockMap[0][yP + sy][xP + sx].uv[2] = tex0[0];
-				m_BlockMap[1][yP + sy][xP + sx].uv[2] = tex0[1];
-				m_BlockMap[1][yP + sy][xP + sx].uv[0] = tex1[3];
-				m_BlockMap[1][yP + sy][xP + sx].uv[1] = tex1[3];
-				m_BlockMap[1][yP + sy][xP + sx].active = false;
+				out.At(0, yP + sy, xP + sx).uv[2] = tex0[0];
+				out.At(1, yP + sy, xP + sx).uv[2] = tex0[1];
+				out.At(1, yP + sy, xP + sx).uv[0] = tex1[3];
+				out.At(1, yP + sy, xP + sx).uv[1] = tex1[3];
 			}
 		}
-
-		//LU
-		m_BlockMap[1][yP + 2][xP].active = !(neighbour.North == N_SAME && neighbour.West == N_SAME);
-		s_Map.m_Tiles[y][x].pathSubTiles[2][0].height = 1 + m_BlockMap[1][yP + 2][xP].active;
-		//MU	   
-		m_BlockMap[1][yP + 2][xP + 1].active = !(neighbour.North == N_SAME);
-		s_Map.m_Tiles[y][x].pathSubTiles[2][1].height = 1 + m_BlockMap[1][yP + 2][xP + 1].active;
-		//RU	   
-		m_BlockMap[1][yP + 2][xP + 2].active = !(neighbour.North == N_SAME && neighbour.East == N_SAME);
-		s_Map.m_Tiles[y][x].pathSubTiles[2][2].height = 1 + m_BlockMap[1][yP + 2][xP + 2].active;
-
-		//LM
-		m_BlockMap[1][yP + 1][xP].active = !(neighbour.West == N_SAME);
-		s_Map.m_Tiles[y][x].pathSubTiles[1][0].height = 1 + m_BlockMap[1][yP + 1][xP].active;
-		//MM	   
-		m_BlockMap[1][yP + 1][xP + 1].active = false; //middle tile is always the same
-		s_Map.m_Tiles[y][x].pathSubTiles[1][1].height = 1;
-		//RM	   
-		m_BlockMap[1][yP + 1][xP + 2].active = !(neighbour.East == N_SAME);
-		s_Map.m_Tiles[y][x].pathSubTiles[1][2].height = 1 + m_BlockMap[1][yP + 1][xP + 2].active;
-
-		//LD
-		m_BlockMap[1][yP][xP].active = !(neighbour.South == N_SAME && neighbour.West == N_SAME);
-		s_Map.m_Tiles[y][x].pathSubTiles[0][0].height = 1 + m_BlockMap[1][yP][xP].active;
-		//MD	   
-		m_BlockMap[1][yP][xP + 1].active = !(neighbour.South == N_SAME);
-		s_Map.m_Tiles[y][x].pathSubTiles[0][1].height = 1 + m_BlockMap[1][yP][xP + 1].active;
-		//RD	   
-		m_BlockMap[1][yP][xP + 2].active = !(neighbour.South == N_SAME && neighbour.East == N_SAME);
-		s_Map.m_Tiles[y][x].pathSubTiles[0][2].height = 1 + m_BlockMap[1][yP][xP + 2].active;
-
-		int pillarY = 0;
-		int pillarX = 0;
-		bool hasPillar = false;
-
-		//RU
-		if (neighbour.North != N_SAME && neighbour.East != N_SAME && neighbour.West == N_SAME && neighbour.South == N_SAME)
+		int pillarY, pillarX;
+		if (GetHatcheryPillar(neighbour, pillarY, pillarX))
 		{
-			hasPillar = true;
-			pillarX = 0;
-			pillarY = 0;
-		}
-		//LU
-		if (neighbour.North != N_SAME && neighbour.East == N_SAME && neighbour.West != N_SAME && neighbour.South == N_SAME)
-		{
-			hasPillar = true;
-			pillarX = 2;
-			pillarY = 0;
-		}
-		//RD
-		if (neighbour.North == N_SAME && neighbour.East != N_SAME && neighbour.West == N_SAME && neighbour.South != N_SAME)
-		{
-			hasPillar = true;
-			pillarX = 0;
-			pillarY = 2;
-		}
-		//LD
-		if (neighbour.North == N_SAME && neighbour.East == N_SAME && neighbour.West != N_SAME && neighbour.South != N_SAME)
-		{
-			hasPillar = true;
-			pillarX = 2;
-			pillarY = 2;
-		}
-
-
-		if (hasPillar)
-		{
-			s_Map.m_Tiles[y][x].pathSubTiles[pillarY][pillarX] = RenderTileMap[Tile_PILLAR_ROOM].pathSubTiles[2][2];
 			for (int i = 0; i < 2; i++)
 			{
-				const Block& src = RenderTileMap[Tile_PILLAR_ROOM].subTile[2][2][2+i];
-				Block& dst = m_BlockMap[1+i][yP + pillarY][xP + pillarX];
-				dst.uv[0] = src.uv[0];
-				dst.uv[1] = src.uv[1];
-				dst.uv[2] = src.uv[2];
-				dst.active = true;
+				const Block src = VoxelModels::GetBlock(Tile_PILLAR_ROOM, 2, 2, 2 + i);
+				for (int uv = 0; uv < 3; uv++)
+				{
+					out.At(1 + i, yP + pillarY, xP + pillarX).uv[uv] = src.uv[uv];
+				}
 			}
 		}
 	}
 }
-void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texIndex, int x, int y)
+//the pillar goes in the corner of a hatchery tile that has hatchery on two sides and not on the other two
+bool LevelData::GetHatcheryPillar(const TileNeighbours& neighbour, int& pillarY, int& pillarX)
+{
+	pillarY = 0;
+	pillarX = 0;
+	bool hasPillar = false;
+
+	//RU
+	if (neighbour.North != N_SAME && neighbour.East != N_SAME && neighbour.West == N_SAME && neighbour.South == N_SAME)
+	{
+		hasPillar = true;
+		pillarX = 0;
+		pillarY = 0;
+	}
+	//LU
+	if (neighbour.North != N_SAME && neighbour.East == N_SAME && neighbour.West != N_SAME && neighbour.South == N_SAME)
+	{
+		hasPillar = true;
+		pillarX = 2;
+		pillarY = 0;
+	}
+	//RD
+	if (neighbour.North == N_SAME && neighbour.East != N_SAME && neighbour.West == N_SAME && neighbour.South != N_SAME)
+	{
+		hasPillar = true;
+		pillarX = 0;
+		pillarY = 2;
+	}
+	//LD
+	if (neighbour.North == N_SAME && neighbour.East == N_SAME && neighbour.West != N_SAME && neighbour.South != N_SAME)
+	{
+		hasPillar = true;
+		pillarX = 2;
+		pillarY = 2;
+	}
+	return hasPillar;
+}
+void LevelData::DoHatcheryBlocks(const TileNeighbours& neighbour, int x, int y)
+{
+	const int yP = y * 3;
+	const int xP = x * 3;
+	for (int sy = 0; sy < 3; sy++)
+	{
+		for (int sx = 0; sx < 3; sx++)
+		{
+			SetBlockActive(1, yP + sy, xP + sx, false);
+		}
+	}
+
+	//LU
+	SetBlockActive(1, yP + 2, xP, !(neighbour.North == N_SAME && neighbour.West == N_SAME));
+	s_Map.m_TileDetails[y][x].pathSubTiles[2][0].height = 1 + IsBlockActive(1, yP + 2, xP);
+	//MU	   
+	SetBlockActive(1, yP + 2, xP + 1, !(neighbour.North == N_SAME));
+	s_Map.m_TileDetails[y][x].pathSubTiles[2][1].height = 1 + IsBlockActive(1, yP + 2, xP + 1);
+	//RU	   
+	SetBlockActive(1, yP + 2, xP + 2, !(neighbour.North == N_SAME && neighbour.East == N_SAME));
+	s_Map.m_TileDetails[y][x].pathSubTiles[2][2].height = 1 + IsBlockActive(1, yP + 2, xP + 2);
+
+	//LM
+	SetBlockActive(1, yP + 1, xP, !(neighbour.West == N_SAME));
+	s_Map.m_TileDetails[y][x].pathSubTiles[1][0].height = 1 + IsBlockActive(1, yP + 1, xP);
+	//MM	   
+	SetBlockActive(1, yP + 1, xP + 1, false); //middle tile is always the same
+	s_Map.m_TileDetails[y][x].pathSubTiles[1][1].height = 1;
+	//RM	   
+	SetBlockActive(1, yP + 1, xP + 2, !(neighbour.East == N_SAME));
+	s_Map.m_TileDetails[y][x].pathSubTiles[1][2].height = 1 + IsBlockActive(1, yP + 1, xP + 2);
+
+	//LD
+	SetBlockActive(1, yP, xP, !(neighbour.South == N_SAME && neighbour.West == N_SAME));
+	s_Map.m_TileDetails[y][x].pathSubTiles[0][0].height = 1 + IsBlockActive(1, yP, xP);
+	//MD	   
+	SetBlockActive(1, yP, xP + 1, !(neighbour.South == N_SAME));
+	s_Map.m_TileDetails[y][x].pathSubTiles[0][1].height = 1 + IsBlockActive(1, yP, xP + 1);
+	//RD	   
+	SetBlockActive(1, yP, xP + 2, !(neighbour.South == N_SAME && neighbour.East == N_SAME));
+	s_Map.m_TileDetails[y][x].pathSubTiles[0][2].height = 1 + IsBlockActive(1, yP, xP + 2);
+
+	int pillarY, pillarX;
+	if (GetHatcheryPillar(neighbour, pillarY, pillarX))
+	{
+		s_Map.m_TileDetails[y][x].pathSubTiles[pillarY][pillarX] = VoxelModels::GetPathTile(Tile_PILLAR_ROOM, 2, 2);
+		SetBlockActive(1, yP + pillarY, xP + pillarX, true);
+		SetBlockActive(2, yP + pillarY, xP + pillarX, true);
+	}
+	//hatcheries get re-done when the room changes, not just from UpdateArea
+	UpdateTileSolidHeight(y, x);
+	UpdateTileBlockFaces(y, x);
+}
+
+void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texIndex, int x, int y, TileUVs& out) const
 {
 	const int yP = y * 3;
 	const int xP = x * 3;
@@ -2373,38 +3156,38 @@ void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texInde
 		{
 			for (int sx = 0; sx < 3; sx++)
 			{
-				m_BlockMap[5][yP + sy][xP + sx].uv[2] = tex0[2];
+				out.At(5, yP + sy, xP + sx).uv[2] = tex0[2];
 			}
 		}
-		m_BlockMap[5][yP + 1][xP + 1].uv[2] = t_WallOwners[s_Map.m_Tiles[y][x].owner];
+		out.At(5, yP + 1, xP + 1).uv[2] = t_WallOwners[s_Map.m_Tiles[y][x].owner];
 		//for debugging
-		//m_BlockMap[5][yP + 1][xP + 1].uv[2] = t_WallOwners[Owner_PlayerWhite];
+		//out.At(5, yP + 1, xP + 1).uv[2] = t_WallOwners[Owner_PlayerWhite];
 		if (neighbour.North != N_SAME && neighbour.North != N_DIFF)
 		{
 			for (int sy = 0; sy < 3; sy++)
 			{
-				m_BlockMap[5][yP + 2][xP + sy].uv[2] = tex0[1];
+				out.At(5, yP + 2, xP + sy).uv[2] = tex0[1];
 			}
 		}
 		if (neighbour.South != N_SAME && neighbour.South != N_DIFF)
 		{
 			for (int sy = 0; sy < 3; sy++)
 			{
-				m_BlockMap[5][yP][xP + sy].uv[2] = tex0[1];
+				out.At(5, yP, xP + sy).uv[2] = tex0[1];
 			}
 		}
 		if (neighbour.East != N_SAME && neighbour.East != N_DIFF)
 		{
 			for (int sx = 0; sx < 3; sx++)
 			{
-				m_BlockMap[5][yP + sx][xP + 2].uv[2] = tex0[1];
+				out.At(5, yP + sx, xP + 2).uv[2] = tex0[1];
 			}
 		}
 		if (neighbour.West != N_SAME && neighbour.West != N_DIFF)
 		{
 			for (int sx = 0; sx < 3; sx++)
 			{
-				m_BlockMap[5][yP + sx][xP].uv[2] = tex0[1];
+				out.At(5, yP + sx, xP).uv[2] = tex0[1];
 			}
 		}
 
@@ -2418,52 +3201,52 @@ void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texInde
 		if (neighbour.West == N_WALKABLE || nWest == N_WATER)
 		{
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y][x - 1].type);
-			int randValue = m_BlockMap[7][yP][xP + 3].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP, xP + 3);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP + sx][xP].uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP + sx, xP).uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
 		if (neighbour.East == N_WALKABLE || nEast == N_WATER)
 		{
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y][x + 1].type);
-			int randValue = m_BlockMap[7][yP][xP - 3].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP, xP - 3);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP + sx][xP + 2].uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP + sx, xP + 2).uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
 		if (neighbour.North == N_WALKABLE || nNorth == N_WATER)
 		{
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y + 1][x].type);
-			int randValue = m_BlockMap[7][yP + 3][xP].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP + 3, xP);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP + 2][xP + sx].uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP + 2, xP + sx).uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
 		if (neighbour.South == N_WALKABLE || nSouth == N_WATER)
 		{
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y - 1][x].type);
-			int randValue = m_BlockMap[7][yP - 3][xP].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP - 3, xP);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP][xP + sx].uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP, xP + sx).uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
@@ -2480,19 +3263,19 @@ void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texInde
 		//corner pieces
 		if (northWalkable && eastWalkable || !northWalkable && !eastWalkable && northEastWalkable)
 		{
-			m_BlockMap[5][yP + 2][xP + 2].uv[2] = tex0[0];
+			out.At(5, yP + 2, xP + 2).uv[2] = tex0[0];
 		}
 		if (northWalkable && westWalkable || !northWalkable && !westWalkable && northWestWalkable)
 		{
-			m_BlockMap[5][yP + 2][xP].uv[2] = tex0[0];
+			out.At(5, yP + 2, xP).uv[2] = tex0[0];
 		}
 		if (southWalkable && eastWalkable || !southWalkable && !eastWalkable && southEastWalkable)
 		{
-			m_BlockMap[5][yP][xP + 2].uv[2] = tex0[0];
+			out.At(5, yP, xP + 2).uv[2] = tex0[0];
 		}
 		if (southWalkable && westWalkable || !southWalkable && !westWalkable && southWestWalkable)
 		{
-			m_BlockMap[5][yP][xP].uv[2] = tex0[0];
+			out.At(5, yP, xP).uv[2] = tex0[0];
 		}
 
 	}
@@ -2502,12 +3285,12 @@ void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texInde
 		for (int sy = 0; sy < 3; sy++)
 			for (int sx = 0; sx < 3; sx++)
 			{
-				m_BlockMap[5][yP + sy][xP + sx].uv[2] = tex0[2];
+				out.At(5, yP + sy, xP + sx).uv[2] = tex0[2];
 			}
 
-		m_BlockMap[5][yP + 1][xP + 1].uv[2] = t_WallOwners[s_Map.m_Tiles[y][x].owner];
+		out.At(5, yP + 1, xP + 1).uv[2] = t_WallOwners[s_Map.m_Tiles[y][x].owner];
 		//for debugging
-		//m_BlockMap[5][yP + 1][xP + 1].uv[2] = t_WallOwners[Owner_PlayerBlue];
+		//out.At(5, yP + 1, xP + 1).uv[2] = t_WallOwners[Owner_PlayerBlue];
 		bool northWall = s_Map.m_Tiles[y + 1][x].type == Type_Wall0;// && m_Map.m_Tiles[y + 1][x].type <= Type_Wall5;
 		bool southWall = s_Map.m_Tiles[y - 1][x].type == Type_Wall0;// && m_Map.m_Tiles[y - 1][x].type <= Type_Wall5;
 		bool eastWall = s_Map.m_Tiles[y][x + 1].type == Type_Wall0;//&& m_Map.m_Tiles[y][x + 1].type <= Type_Wall5;
@@ -2515,19 +3298,19 @@ void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texInde
 
 		if (northWall && eastWall)
 		{
-			m_BlockMap[5][yP + 2][xP + 2].uv[2] = tex0[0];
+			out.At(5, yP + 2, xP + 2).uv[2] = tex0[0];
 		}
 		if (northWall && westWall)
 		{
-			m_BlockMap[5][yP + 2][xP].uv[2] = tex0[0];
+			out.At(5, yP + 2, xP).uv[2] = tex0[0];
 		}
 		if (southWall && eastWall)
 		{
-			m_BlockMap[5][yP][xP + 2].uv[2] = tex0[0];
+			out.At(5, yP, xP + 2).uv[2] = tex0[0];
 		}
 		if (southWall && westWall)
 		{
-			m_BlockMap[5][yP][xP].uv[2] = tex0[0];
+			out.At(5, yP, xP).uv[2] = tex0[0];
 		}
 
 		uint8_t northInfo = neighbour.North;
@@ -2543,16 +3326,16 @@ void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texInde
 		{
 			for (int sy = 0; sy < 3; sy++)
 			{
-				m_BlockMap[5][yP + 2][xP + sy].uv[2] = tex0[1];
+				out.At(5, yP + 2, xP + sy).uv[2] = tex0[1];
 			}
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y + 1][x].GetType());
-			int randValue = m_BlockMap[7][yP + 3][xP].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP + 3, xP);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP + 2][xP + sx].uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP + 2, xP + sx).uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
@@ -2560,16 +3343,16 @@ void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texInde
 		{
 			for (int sy = 0; sy < 3; sy++)
 			{
-				m_BlockMap[5][yP][xP + sy].uv[2] = tex0[1];
+				out.At(5, yP, xP + sy).uv[2] = tex0[1];
 			}
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y - 1][x].GetType());
-			int randValue = m_BlockMap[7][yP - 3][xP].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP - 3, xP);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP][xP + sx].uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP, xP + sx).uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
@@ -2577,16 +3360,16 @@ void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texInde
 		{
 			for (int sx = 0; sx < 3; sx++)
 			{
-				m_BlockMap[5][yP + sx][xP + 2].uv[2] = tex0[1];
+				out.At(5, yP + sx, xP + 2).uv[2] = tex0[1];
 			}
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y][x + 1].GetType());
-			int randValue = m_BlockMap[7][yP][xP - 3].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP, xP - 3);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP + sx][xP + 2].uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP + sx, xP + 2).uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
@@ -2594,16 +3377,16 @@ void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texInde
 		{
 			for (int sx = 0; sx < 3; sx++)
 			{
-				m_BlockMap[5][yP + sx][xP].uv[2] = tex0[1];
+				out.At(5, yP + sx, xP).uv[2] = tex0[1];
 			}
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y][x - 1].GetType());
-			int randValue = m_BlockMap[7][yP][xP + 3].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP, xP + 3);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP + sx][xP].uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP + sx, xP).uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
@@ -2618,71 +3401,71 @@ void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texInde
 		if (neighbour.West == N_WALKABLE || nWest == N_WATER)
 		{
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y][x - 1].GetType());
-			int randValue = m_BlockMap[7][yP][xP + 3].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP, xP + 3);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP + sx][xP].uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP + sx, xP).uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
 		if (neighbour.East == N_WALKABLE || nEast == N_WATER)
 		{
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y][x + 1].GetType());
-			int randValue = m_BlockMap[7][yP][xP - 3].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP, xP - 3);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP + sx][xP + 2].uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP + sx, xP + 2).uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
 		if (neighbour.North == N_WALKABLE ||nNorth == N_WATER)
 		{
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y + 1][x].GetType());
-			int randValue = m_BlockMap[7][yP + 3][xP].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP + 3, xP);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP + 2][xP + sx].uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP + 2, xP + sx).uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
 		if (neighbour.South == N_WALKABLE || nSouth == N_WATER)
 		{
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y - 1][x].GetType());
-			int randValue = m_BlockMap[7][yP - 3][xP].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP - 3, xP);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP][xP + sx].uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP, xP + sx).uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
 
 		if ((neighbour.NorthEast != N_SAME && neighbour.NorthEast != N_DIFF) && ((northWalkable && eastWalkable) || (northInfo == N_SAME && eastInfo == N_SAME)))
 		{
-			m_BlockMap[5][yP + 2][xP + 2].uv[2] = tex0[0];
+			out.At(5, yP + 2, xP + 2).uv[2] = tex0[0];
 		}
 		if (neighbour.NorthWest != N_SAME && neighbour.NorthWest != N_DIFF && ((northWalkable && westWalkable) || (northInfo == N_SAME && westInfo == N_SAME)))
 		{
-			m_BlockMap[5][yP + 2][xP].uv[2] = tex0[0];
+			out.At(5, yP + 2, xP).uv[2] = tex0[0];
 		}
 		if (neighbour.SouthEast != N_SAME && neighbour.SouthEast != N_DIFF && ((southWalkable && eastWalkable) || (southInfo == N_SAME && eastInfo == N_SAME)))
 		{
-			m_BlockMap[5][yP][xP + 2].uv[2] = tex0[0];
+			out.At(5, yP, xP + 2).uv[2] = tex0[0];
 		}
 		if (neighbour.SouthWest != N_SAME && neighbour.SouthWest != N_DIFF && ((southWalkable && westWalkable) || (southInfo == N_SAME && westInfo == N_SAME)))
 		{
-			m_BlockMap[5][yP][xP].uv[2] = tex0[0];
+			out.At(5, yP, xP).uv[2] = tex0[0];
 		}
 	}
 	else if (type == Type_Wall3) //corner
@@ -2691,11 +3474,11 @@ void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texInde
 		for (int sy = 0; sy < 3; sy++)
 			for (int sx = 0; sx < 3; sx++)
 			{
-				m_BlockMap[5][yP + sy][xP + sx].uv[2] = tex0[2];
+				out.At(5, yP + sy, xP + sx).uv[2] = tex0[2];
 			}
-		m_BlockMap[5][yP + 1][xP + 1].uv[2] = t_WallOwners[s_Map.m_Tiles[y][x].owner];
+		out.At(5, yP + 1, xP + 1).uv[2] = t_WallOwners[s_Map.m_Tiles[y][x].owner];
 		//for debugging
-		//m_BlockMap[5][yP + 1][xP + 1].uv[2] = t_WallOwners[Owner_PlayerRed];
+		//out.At(5, yP + 1, xP + 1).uv[2] = t_WallOwners[Owner_PlayerRed];
 		bool northWall = neighbour.North == N_SAME;
 		bool southWall = neighbour.South == N_SAME;
 		bool eastWall = neighbour.East == N_SAME;
@@ -2706,22 +3489,22 @@ void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texInde
 		{
 			if (eastWall && neighbour.NorthEast == N_WALKABLE)
 			{
-				m_BlockMap[5][yP + 2][xP + 2].uv[2] = tex0[0];
+				out.At(5, yP + 2, xP + 2).uv[2] = tex0[0];
 			}
 			if (westWall && neighbour.NorthWest == N_WALKABLE)
 			{
-				m_BlockMap[5][yP + 2][xP].uv[2] = tex0[0];
+				out.At(5, yP + 2, xP).uv[2] = tex0[0];
 			}
 		}
 		if (southWall)
 		{
 			if (eastWall && neighbour.SouthEast == N_WALKABLE)
 			{
-				m_BlockMap[5][yP][xP + 2].uv[2] = tex0[0];
+				out.At(5, yP, xP + 2).uv[2] = tex0[0];
 			}
 			if (westWall && neighbour.SouthWest == N_WALKABLE)
 			{
-				m_BlockMap[5][yP][xP].uv[2] = tex0[0];
+				out.At(5, yP, xP).uv[2] = tex0[0];
 			}
 		}
 
@@ -2730,28 +3513,28 @@ void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texInde
 		{
 			for (int sy = 0; sy < 3; sy++)
 			{
-				m_BlockMap[5][yP + 2][xP + sy].uv[2] = tex0[1];
+				out.At(5, yP + 2, xP + sy).uv[2] = tex0[1];
 			}
 		}
 		if (neighbour.South != N_SAME && neighbour.South != N_DIFF)
 		{
 			for (int sy = 0; sy < 3; sy++)
 			{
-				m_BlockMap[5][yP][xP + sy].uv[2] = tex0[1];
+				out.At(5, yP, xP + sy).uv[2] = tex0[1];
 			}
 		}
 		if (neighbour.East != N_SAME && neighbour.East != N_DIFF)
 		{
 			for (int sx = 0; sx < 3; sx++)
 			{
-				m_BlockMap[5][yP + sx][xP + 2].uv[2] = tex0[1];
+				out.At(5, yP + sx, xP + 2).uv[2] = tex0[1];
 			}
 		}
 		if (neighbour.West != N_SAME && neighbour.West != N_DIFF)
 		{
 			for (int sx = 0; sx < 3; sx++)
 			{
-				m_BlockMap[5][yP + sx][xP].uv[2] = tex0[1];
+				out.At(5, yP + sx, xP).uv[2] = tex0[1];
 			}
 		}
 
@@ -2766,53 +3549,53 @@ void LevelData::DoWallUVs(const TileNeighbours& neighbour, int type, int texInde
 		if (neighbour.West == N_WALKABLE || nWest == N_WATER)
 		{
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y][x - 1].GetType());
-			int randValue = m_BlockMap[7][yP][xP + 3].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP, xP + 3);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
 					//maps | sx + (3 * (3 - (z - 2))) |  to a value within 3*4 area, upper left being 0, lower right being 8
-					m_BlockMap[z][yP + sx][xP].uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP + sx, xP).uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
 		if (neighbour.East == N_WALKABLE || nEast == N_WATER)
 		{
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y][x + 1].GetType());
-			int randValue = m_BlockMap[7][yP][xP - 3].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP, xP - 3);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP + sx][xP + 2].uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP + sx, xP + 2).uv[0] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
 		if (neighbour.North == N_WALKABLE || nNorth == N_WATER)
 		{
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y + 1][x].GetType());
-			int randValue = m_BlockMap[7][yP + 3][xP].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP + 3, xP);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP + 2][xP + sx].uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP + 2, xP + sx).uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
 		if (neighbour.South == N_WALKABLE || nSouth == N_WATER)
 		{
 			uint16_t texIndexRoom = TypeToTexture(s_Map.m_Tiles[y - 1][x].GetType());
-			int randValue = m_BlockMap[7][yP - 3][xP].randValue;//we use the random value of one block as the entire side will need to match
+			int randValue = BlockSeed(7, yP - 3, xP);//we use the random value of one block as the entire side will need to match
 			const std::vector<XMFLOAT2>& tex1 = BlockTextures[texIndexRoom].wall[randValue % BlockTextures[texIndexRoom].wall.size()];
 			for (int sx = 0; sx < 3; sx++)
 			{
 				for (int z = 2; z < MAP_SIZE_HEIGHT - 2; z++)
 				{
-					m_BlockMap[z][yP][xP + sx].uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
+					out.At(z, yP, xP + sx).uv[1] = tex1[sx + (3 * (3 - (z - 2)))];
 				}
 			}
 		}
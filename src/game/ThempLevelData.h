@@ -3,6 +3,9 @@
 #include <stack>
 #include "ThempTileArrays.h"
 #include "ThempFileManager.h"
+#include "ThempLightGrid.h"
+#include "ThempUnexploredTileIndex.h"
+#include "ThempTileEvents.h"
 namespace Themp
 {
 	class LevelData
@@ -60,28 +63,37 @@ namespace Themp
 			int roomEfficiency;
 			int roomFillAmount;
 			int roomFillPercentage;
-			std::unordered_map<Tile*, RoomTile> tiles;
+			//cached by RecalcRoomData, which runs whenever a room gets built, split, merged or claimed
+			int tileCapacity; //how much a single tile can hold (gold for treasuries, a single lair for lairs)
+			int capacity;
+			int fullTiles;
+			XMINT2 center;
+			//flat array of the room tiles, LevelData::m_RoomTileIndex maps a tile position back into it
+			std::vector<RoomTile> tiles;
+			RoomTile& AddTile(Tile* tile, int x, int y)
+			{
+				RoomTile rTile;
+				rTile.tile = tile;
+				rTile.tileValue = 0;
+				rTile.x = x;
+				rTile.y = y;
+				tiles.push_back(rTile);
+				return tiles.back();
+			}
 			Room& operator+=(const Room& rhs)
 			{
 				health += rhs.health;
 				biggestSquare = biggestSquare >= rhs.biggestSquare ? biggestSquare : rhs.biggestSquare;
 				tilecount += rhs.tilecount;
 				roomFillAmount += rhs.roomFillAmount;
-				auto& it = rhs.tiles.begin();
-				while (it != rhs.tiles.end())
-				{
-					tiles[it->first] = it->second;
-					it++;
-				}
+				tiles.insert(tiles.end(), rhs.tiles.begin(), rhs.tiles.end());
 				assert(tilecount == tiles.size());
 				return *this;
 			}
-			void RecalcRoomData()
-			{
-				//recalc efficiency / fill amount
-				roomEfficiency = 100;
-				//roomFillPercentage = tilecount / roomFillAmount * 100;
-			}
+			bool HasSpace() const { return fullTiles < tilecount; }
+			//adds to a tiles value (gold, lair taken) while keeping the cached fill data in sync
+			void AddToTile(RoomTile& tile, int amount);
+			void RecalcRoomData();
 		};
 		struct clm_data
 		{
@@ -100,6 +112,40 @@ namespace Themp
 			// there are 8 cubes, each having a 2 byte entry. The first cube usually forms the floor, etc, up to the ceiling.
 			uint16_t cubes[8];
 		};
+		struct AreaRect
+		{
+			int minY, maxY, minX, maxX;
+			int Size() const { return (maxY - minY + 1) * (maxX - minX + 1); }
+		};
+		struct AreaUpdateStats
+		{
+			uint32_t queued = 0;
+			uint32_t queuedLastFlush = 0;
+			uint32_t applied = 0;
+			uint32_t tiles = 0;
+			uint32_t rebuilt = 0;
+			uint32_t blocksChanged = 0;
+			uint32_t facesRefreshed = 0;
+		};
+		//bits of m_BlockFaces, a face bit is set when there's no block on that side. Face_Solid is what the block itself was the last time its tile got synced
+		enum BlockFace : uint8_t
+		{
+			Face_Right = 1,		//+x
+			Face_Left = 2,		//-x
+			Face_Front = 4,		//+y
+			Face_Back = 8,		//-y
+			Face_Top = 16,		//+z
+			Face_Bottom = 32,	//-z
+			Face_Solid = 64,
+		};
+		//Everything the blocks of a tile depend on, see RefreshTileRenderKey
+		struct TileRenderKey
+		{
+			uint16_t type;
+			uint16_t neighbourTypes[8];
+			uint8_t owner;
+			bool valid;
+		};
 		struct HitData
 		{
 			bool hit;
@@ -108,21 +154,38 @@ namespace Themp
 			int posY;
 			int posZ;
 		};
+		//rays only look at the bottom 6 block layers
+		static const int RaycastHeight = 6;
 		~LevelData();
 		LevelData(int levelIndex);
+		//a level made from the given tiles instead of the level files, without the level file's entities and lights (torch tiles still get theirs), for running the map code headless (tests)
+		LevelData(const TileMap& map);
 		void Init();
 		LevelData::HitData Raycast(XMFLOAT3 origin, XMFLOAT3 direction, float range, bool tileMode = false);
-		uint8_t GetNeighbourInfo(uint16_t currentType, uint16_t nType);
-		TileNeighbours CheckNeighbours(uint16_t type, int y, int x);
-		TileNeighbourTiles GetNeighbourTiles(int y, int x);
+		//how many rays RaycastBatch steps together, one per SIMD lane
+		static const int RayPacketSize = 4;
+		//Raycast for a whole list of rays, RayPacketSize of them at a time: the DDA steps of a packet are done for all its lanes together, the block lookups one lane
+		//at a time (behind the height field like Raycast). Every hit is the same as Raycast's (without tileMode). Rays next to each other in the list that start
+		//close together and point the same way (a block of screen pixels, a creature's sight lines) finish around the same time and keep the lanes busy
+		void RaycastBatch(const XMFLOAT3* origins, const XMFLOAT3* directions, size_t count, float range, HitData* outHits);
+		void RaycastPacket(const XMFLOAT3* origins, const XMFLOAT3* directions, int count, float range, HitData* outHits);
+		static uint8_t GetNeighbourInfo(uint16_t currentType, uint16_t nType);
+		static TileNeighbours CheckNeighbours(uint16_t type, int y, int x);
+		static TileNeighbourTiles GetNeighbourTiles(int y, int x);
 		NeighbourSubTiles GetNeighbourSubTiles(int y, int x);
 		uint8_t GetSubtileHeight(int tileY, int tileX, int subTileY, int subTileX);
-		void DoUVs(uint16_t type, int x, int y);
-		uint32_t GetFreeLightIndex(uint16_t base);
-		void AddLightToTiles(const Light & light);
-		void DoRoomUVs(const TileNeighbours& neighbour, int type, int texIndex, int x, int y);
-		void DoWallUVs(const TileNeighbours& neighbour, int type, int texIndex, int x, int y);
+		//picks the uvs that depend on the neighbours (wall edges, room borders, path mud) over the ones the tile's model came with
+		void DoUVs(uint16_t type, int y, int x, TileUVs& out) const;
+		void DoRoomUVs(const TileNeighbours& neighbour, int type, int texIndex, int x, int y, TileUVs& out) const;
+		void DoWallUVs(const TileNeighbours& neighbour, int type, int texIndex, int x, int y, TileUVs& out) const;
+		//the hatchery floor sinks in between hatchery tiles and gets a pillar in inside corners, the blocks and walkable heights of that, the uvs are in DoRoomUVs
+		void DoHatcheryBlocks(const TileNeighbours& neighbour, int x, int y);
+		static bool GetHatcheryPillar(const TileNeighbours& neighbour, int& pillarY, int& pillarX);
+		//the face uvs of every block of the tile, from its model (m_TileModels) and DoUVs. The map doesn't keep them, they're only needed while meshing
+		void GetTileUVs(int y, int x, TileUVs& out) const;
 		void AddExploredTileNeighboursVisibility(int y, int x, int areaCode);
+		//puts a tile in m_UnexploredTiles and on the frontier of the walkable areas next to it
+		void AddUnexploredTile(XMINT2 pos);
 		uint16_t Handle3by3Rooms(int yPos, int xPos);
 		uint16_t HandleNon3by3RoomsPillars(int yPos, int xPos);
 		void UpdateWalls(int y, int x);
@@ -132,18 +195,40 @@ namespace Themp
 		bool MarkTile(uint8_t player, int y, int x);
 		void UnMarkTile(uint8_t player, int y, int x);
 		void UpdateArea(int minY, int maxY, int minX, int maxX);
+		void RefreshTileTasks(int y, int x);
+		//task subscriber of m_TileEvents
+		static void OnTileChanges(void* context, const TileChange* changes, size_t count);
+		void UpdateTorchLight(int y, int x);
+		//light subscriber of m_TileEvents, torch tiles bring their light along and take it with them when they're dug out
+		static void OnLightTileChanges(void* context, const TileChange* changes, size_t count);
+		void UpdateTileSolidHeight(int y, int x);
+		uint8_t GetExposedFaces(int z, int y, int x) const;
+		void UpdateTileBlockFaces(int y, int x);
+		void UpdateAllBlockFaces();
+		bool RefreshTileRenderKey(int y, int x);
+		void QueueAreaUpdate(int minY, int maxY, int minX, int maxX);
+		void FlushAreaUpdates();
 		uint16_t GetTileType(int y, int x);
 		bool HasWalkableNeighbour(int y, int x, int areaCode);
 		XMINT2 GetWalkableNeighbour(int y, int x, int areaCode);
 		void SetRoomFloodID(int ID, int startID, uint16_t type, int y, int x);
-		void CreateRoomFromTile(Room & room, int ID, int startID, uint16_t type, int y, int x);
-		int CreateRoomFromArea(uint16_t type, int initialRoomID, int y, int x);
+		void CreateRoomFromTile(Room & room, int ID, int startID, uint16_t type, int y, int x, const Room* prevRoom = nullptr);
+		int CreateRoomFromArea(uint16_t type, int initialRoomID, int y, int x, const Room* prevRoom = nullptr);
 		void ClaimRoomFromEnemy(uint8_t newOwner, uint16_t type, int y, int x);
 		void UpdateSurroundingRoomsAdd(uint16_t type, int y, int x);
 		void UpdateSurroundingRoomsRemove(uint16_t type, int y, int x);
 		Entity * GetMapEntity();
 		void AdjustRoomTile(const LevelData::Room & room, const LevelData::Room::RoomTile & roomTile);
+		void RegisterRoom(uint8_t owner, const Room& room);
+		void UnregisterRoom(uint8_t owner, int32_t roomID);
+		const std::vector<int32_t>& GetRooms(uint8_t owner, uint16_t type);
+		Room::RoomTile& GetRoomTile(Room& room, int y, int x);
+		Room* FindRoomWithSpace(uint8_t owner, uint16_t type, int areaCode);
+		Room::RoomTile* GetRandomRoomTile(uint8_t owner, uint16_t type, int areaCode);
 		void UpdateAreaCode(uint32_t newCode, uint16_t currentType, int ty, int tx);
+		void OpenTile(int y, int x);
+		void CloseTile(int y, int x);
+		void MergeAreas(uint32_t from, uint32_t to);
 		bool CollectiveClaimRoom(uint16_t type, int ty, int tx);
 		void ClaimRoom(uint8_t newOwner, uint16_t type, int ty, int tx);
 		bool IsClaimableCorner(int y, int x);
@@ -151,6 +236,9 @@ namespace Themp
 		void ClaimTile(uint8_t player, int y, int x);
 		bool BuildRoom(uint16_t type, uint8_t owner, int y, int x);
 		bool DeleteRoom(uint8_t owner, int y, int x);
+		void RefreshWalkableTile(int y, int x);
+		bool GetRandomWalkableTile(int areaCode, XMINT2& outTile);
+		bool GetRandomWalkableTileInRange(int areaCode, XMINT2 center, int range, XMINT2& outTile);
 		static XMINT2 WorldToTile(XMFLOAT3 pos);
 		static XMFLOAT3 TileToWorld(XMINT2 tPos);
 		static XMFLOAT3 WorldToSubtileFloat(XMFLOAT3 pos);
@@ -161,7 +249,11 @@ namespace Themp
 		static std::wstring LevelIDtoString(int levelID);
 
 		void LoadLevelFileData();
+		//what both constructors start from, before the tiles are filled in
+		void ResetTileData();
 		int CreateFromTile(const Tile & tile, RenderTile & out);
+		//the VoxelModels model (Tile_ constant) a tile's blocks are built from
+		static int GetTileModel(const Tile& tile);
 		uint8_t m_MapBlockTextureID = 0;
 		int m_CurrentLevelNr = 0;
 
@@ -172,16 +264,64 @@ namespace Themp
 
 		//Map which the current changes to it (mined/dug out blocks, rooms etc..)
 		static TileMap s_Map;
-		static bool PathsInvalidated;
-		static std::unordered_map<uint32_t, Light> s_Lights;
-		static std::array<uint32_t, MAP_SIZE_TILES*MAP_SIZE_TILES * MAX_LIGHTS_PER_TILE> s_PerTileLights;
-		//Map in subtile format, used for pathfinding/picking
-		Block m_BlockMap[MAP_SIZE_HEIGHT][MAP_SIZE_SUBTILES_RENDER][MAP_SIZE_SUBTILES_RENDER];
+		static LightGrid s_LightGrid;
+		//Map in subtile format, used for pathfinding/picking/meshing: a bit per block that's there, a row of subtiles is 4 words.
+		//What the blocks look like isn't kept, GetTileUVs puts it together from the model in m_TileModels, BlockSeed and the neighbours (m_TileRenderKeys says they're what the tile was built from)
+		static const int OccupancyWords = (MAP_SIZE_SUBTILES_RENDER + 63) / 64;
+		uint64_t m_BlockOccupancy[MAP_SIZE_HEIGHT][MAP_SIZE_SUBTILES_RENDER][OccupancyWords];
+		bool IsBlockActive(int z, int y, int x) const
+		{
+			return (m_BlockOccupancy[z][y][x >> 6] >> (x & 63)) & 1;
+		}
+		void SetBlockActive(int z, int y, int x, bool active)
+		{
+			const uint64_t bit = 1ull << (x & 63);
+			if (active) m_BlockOccupancy[z][y][x >> 6] |= bit;
+			else m_BlockOccupancy[z][y][x >> 6] &= ~bit;
+		}
+		//per tile, the model its blocks came from
+		uint8_t m_TileModels[MAP_SIZE_TILES][MAP_SIZE_TILES];
+		//picked from the position instead of rand() so a map always looks the same, the mesh golden hashes depend on it
+		static uint16_t BlockSeed(uint32_t z, uint32_t y, uint32_t x)
+		{
+			uint32_t h = (x * 73856093u) ^ (y * 19349663u) ^ (z * 83492791u);
+			h ^= h >> 13;
+			h *= 0x5bd1e995u;
+			h ^= h >> 15;
+			return (uint16_t)h;
+		}
+		//per tile, one above the highest solid block a ray can hit, rays passing above it don't have to touch m_BlockOccupancy
+		uint8_t m_TileSolidHeight[MAP_SIZE_TILES][MAP_SIZE_TILES];
+		//per block, which of its faces are out in the open (see BlockFace) so the mesher doesn't have to look at the neighbours every frame
+		uint8_t m_BlockFaces[MAP_SIZE_HEIGHT][MAP_SIZE_SUBTILES_RENDER][MAP_SIZE_SUBTILES_RENDER];
+		//what each tile's blocks were last built from, UpdateArea skips tiles where nothing changed
+		TileRenderKey m_TileRenderKeys[MAP_SIZE_TILES][MAP_SIZE_TILES];
+		//s_LightGrid slot of the torch on each tile, NoTorchLight where there isn't one
+		static const uint16_t NoTorchLight = UINT16_MAX;
+		uint16_t m_TorchLights[MAP_SIZE_TILES][MAP_SIZE_TILES];
 		std::vector<ActionPoint> m_ActionPoints;
 		std::vector<Thing> m_HeroGates;
 		std::vector<Thing> m_LevelThings;
 		std::unordered_map<int32_t,Room> m_Rooms[6];
+		//room IDs per player and room type (low byte of the tile type), kept in sync by RegisterRoom/UnregisterRoom
+		std::vector<int32_t> m_RoomsByType[6][64];
+		//index of a room tile in its room's tile array
+		int m_RoomTileIndex[MAP_SIZE_TILES][MAP_SIZE_TILES];
+
+		UnexploredTileIndex m_UnexploredTiles;
+
+		std::vector<AreaRect> m_QueuedAreaUpdates;
+		AreaUpdateStats m_AreaUpdateStats;
+		//what changed on the map per flush, tiles edited outside of an area update (exploring) have to be marked in here themselves
+		TileEvents m_TileEvents;
 
-		std::unordered_map<Tile*,XMINT2> m_UnexploredTiles;
+		//Walkable tiles per area code, kept up to date by UpdateArea and UpdateAreaCode
+		//m_WalkableTileArea holds the area a tile is listed under (0 for none) and m_WalkableTileIndex its position in that list
+		std::unordered_map<uint32_t, std::vector<XMINT2>> m_AreaWalkableTiles;
+		uint32_t m_WalkableTileArea[MAP_SIZE_TILES][MAP_SIZE_TILES];
+		int32_t m_WalkableTileIndex[MAP_SIZE_TILES][MAP_SIZE_TILES];
+		//which of CloseTile's searches reached a tile (stamp * 4 + search), the stamp goes up every call so it never needs clearing
+		uint32_t m_AreaSearchMark[MAP_SIZE_TILES][MAP_SIZE_TILES];
+		uint32_t m_AreaSearchStamp = 0;
 	};
 };
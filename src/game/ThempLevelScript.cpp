@@ -9,6 +9,7 @@
 #include "Creature/ThempCreature.h"
 #include "Creature/ThempCreatureParty.h"
 #include "ThempLevelUI.h"
+#include "ThempTimerWheel.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
@@ -111,13 +112,72 @@ std::unordered_map<std::string, uint16_t> StringToRoomType
 	{"ENTRANCE",Type_Portal},
 };
 
+//script timers only remember the turn they were started on, their value is derived from the TimerWheel
+//the value in GameValues gets written when the script reads it and when the wheel fires on a turn that changes what an IF on it says
 struct GameTurnTimer
 {
-	int turns = 0;
+	uint64_t startTurn = 0;
 	bool started = false;
+	uint8_t player = 0;
+	std::string name;
+	LevelScript* script = nullptr;
+	TimerWheel::Handle handle;
 };
 std::array<std::unordered_map<std::string, GameTurnTimer>, 6> turnTimers;
 
+//brings GAME_TURN or a running timer in GameValues up to date, anything else is kept up to date by whatever changes it
+void RefreshTurnValue(uint8_t player, const std::string& var)
+{
+	if (var == "GAME_TURN")
+	{
+		LevelScript::GameValues[player][var] = (int)TimerWheel::GetCurrentTurn();
+		return;
+	}
+	auto it = turnTimers[player].find(var);
+	if (it != turnTimers[player].end() && it->second.started)
+	{
+		LevelScript::GameValues[player][var] = (int)(TimerWheel::GetCurrentTurn() - it->second.startTurn);
+	}
+}
+//the first timer value after elapsed at which one of the script's IFs on this timer changes its outcome, 0 when there's none
+uint64_t NextTimerThreshold(const std::vector<LevelScript::IfStatement*>& ifStatements, const GameTurnTimer& timer, uint64_t elapsed)
+{
+	typedef LevelScript::IfStatement::Evaluator Evaluator;
+	uint64_t next = 0;
+	for (size_t i = 0; i < ifStatements.size(); i++)
+	{
+		for (const LevelScript::IfStatement* node = ifStatements[i]; node != nullptr; node = node->child)
+		{
+			if (node->owner != timer.player || node->var != timer.name || node->number < 0) continue;
+			//< and >= flip on the number itself, <= and > one later, == and != on both
+			const uint64_t number = (uint64_t)node->number;
+			const bool flipsOnNumber = node->eval != Evaluator::SMALLEROREQUALTO && node->eval != Evaluator::BIGGERTHAN;
+			const bool flipsAfterNumber = node->eval != Evaluator::SMALLERTHAN && node->eval != Evaluator::BIGGEROREQUALTO;
+			if (flipsOnNumber && number > elapsed && (next == 0 || number < next)) next = number;
+			if (flipsAfterNumber && number + 1 > elapsed && (next == 0 || number + 1 < next)) next = number + 1;
+		}
+	}
+	return next;
+}
+void ScheduleTurnTimer(GameTurnTimer& timer);
+void OnTurnTimer(void* owner, uint32_t eventCode)
+{
+	GameTurnTimer* timer = static_cast<GameTurnTimer*>(owner);
+	RefreshTurnValue(timer->player, timer->name);
+	ScheduleTurnTimer(*timer);
+}
+void ScheduleTurnTimer(GameTurnTimer& timer)
+{
+	const uint64_t elapsed = TimerWheel::GetCurrentTurn() - timer.startTurn;
+	const uint64_t next = NextTimerThreshold(timer.script->m_IfStatements, timer, elapsed);
+	if (next == 0)
+	{
+		TimerWheel::Cancel(timer.handle);
+		return;
+	}
+	TimerWheel::Reschedule(timer.handle, (uint32_t)(next - elapsed), OnTurnTimer, &timer);
+}
+
 std::array<std::unordered_map<std::string,int>,6> LevelScript::GameValues;
 
 std::array<std::unordered_map<CreatureData::CreatureType, AvailableObject>, 6> LevelScript::AvailableCreatures;
@@ -128,6 +188,14 @@ std::array<std::unordered_map<Doors, AvailableObject>, 6> LevelScript::Available
 
 LevelScript::~LevelScript()
 {
+	for (int i = 0; i < 6; i++)
+	{
+		for (auto&& timer : turnTimers[i])
+		{
+			TimerWheel::Cancel(timer.second.handle);
+		}
+		turnTimers[i].clear();
+	}
 	for (int i = 0; i < m_IfStatements.size(); i++)
 	{
 		std::vector<IfStatement*> ifsToFree;
@@ -149,6 +217,11 @@ LevelScript::LevelScript(std::wstring file)
 
 	for (int i = 0; i < 6; i++)
 	{
+		for (auto&& timer : turnTimers[i])
+		{
+			TimerWheel::Cancel(timer.second.handle);
+		}
+		turnTimers[i].clear();
 		GameValues[i]["GAME_TURN"] = 0;
 
 		GameValues[i]["TREASURE"] = 0;
@@ -678,9 +751,15 @@ void LevelScript::ExecuteCommand(Command* c)
 		break;
 	case Command::ScriptFunctions::SET_TIMER:
 		{
-			GameTurnTimer& timer = turnTimers[PlayerTagToNumber(c->argsStrings[0])][c->argsStrings[1]];
+			const uint8_t player = PlayerTagToNumber(c->argsStrings[0]);
+			GameTurnTimer& timer = turnTimers[player][c->argsStrings[1]];
 			timer.started = true;
-			timer.turns = 0;
+			timer.startTurn = TimerWheel::GetCurrentTurn();
+			timer.player = player;
+			timer.name = c->argsStrings[1];
+			timer.script = this;
+			GameValues[player][timer.name] = 0;
+			ScheduleTurnTimer(timer);
 		}
 		break;
 	case Command::ScriptFunctions::BONUS_LEVEL_TIME:
@@ -767,6 +846,7 @@ void LevelScript::ExecuteCommand(Command* c)
 }
 bool LevelScript::EvaluateIfStatement(IfStatement* ifs)
 {
+	RefreshTurnValue(ifs->owner, ifs->var);
 	switch (ifs->eval)
 	{
 	case IfStatement::Evaluator::SMALLERTHAN:
@@ -869,32 +949,8 @@ void LevelScript::RunInitCommands()
 	}
 }
 
-float TurnTimer = 0;
 void LevelScript::Update(float dt)
 {
-	TurnTimer += dt;
-	const float turnDelta = 1.0f / GAME_TURNS_PER_SECOND;
-	if (TurnTimer > turnDelta)
-	{
-		TurnTimer -= turnDelta;
-		for (int i = 0; i < 6; i++)
-		{
-			GameValues[i]["GAME_TURN"]++;
-			for (auto&& timer : turnTimers[i])
-			{
-				if(timer.second.started)
-				{
-					timer.second.turns++;
-					GameValues[i][timer.first] = timer.second.turns;
-				}
-			}
-		}
-		if (TurnTimer > turnDelta * 2)
-		{
-			TurnTimer = turnDelta * 2;
-		}
-	}
-
 	for (int i = m_IfStatements.size()-1; i >= 0; i--)
 	{
 		IfStatement* node = m_IfStatements[i];
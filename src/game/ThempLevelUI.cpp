@@ -184,7 +184,7 @@ bool LevelUI::Update(float delta)
 								Level::s_CurrentLevel->m_SelectedBuilding = buttonRooms[i];
 							}
 							Level::s_CurrentLevel->m_BuildMode = true;
-							Themp::System::tSys->m_Audio->PlayOneShot(FileManager::GetSound("BUTTON1.WAV"));
+							FileManager::PlayOneShot("BUTTON1.WAV");
 						}
 						else
 						{
@@ -338,13 +338,9 @@ std::unordered_map<uint16_t, int> RoomCounts;
 void LevelUI::UpdateRoomIcons()
 {
 	BuildingPanel& bp = m_BuildingPanel;
-	for (auto& c : RoomCounts)
-	{
-		c.second = 0;
-	}
-	for (auto& room : Level::s_CurrentLevel->m_LevelData->m_Rooms[Owner_PlayerRed])
+	for (int i = 0; i < 14; i++)
 	{
-		RoomCounts[room.second.roomType]++;
+		RoomCounts[buttonRooms[i]] = (int)Level::s_CurrentLevel->m_LevelData->GetRooms(Owner_PlayerRed, buttonRooms[i]).size();
 	}
 	uint16_t selectedBuilding = Level::s_CurrentLevel->m_SelectedBuilding;
 	if (Level::s_CurrentLevel->m_BuildMode && selectedBuilding > 0)
@@ -0,0 +1,157 @@
+#include "ThempLightGrid.h"
+#include <cmath>
+#include <algorithm>
+using namespace Themp;
+
+LightGrid::LightGrid()
+{
+	Clear();
+}
+void LightGrid::Clear()
+{
+	m_Lights.clear();
+	m_SlotUsed.clear();
+	m_FreeSlots.clear();
+	for (int y = 0; y < MAP_SIZE_TILES; y++)
+	{
+		for (int x = 0; x < MAP_SIZE_TILES; x++)
+		{
+			m_Cells[y][x].clear();
+		}
+	}
+	m_DirtyMin = UINT16_MAX;
+	m_DirtyMax = 0;
+	m_CellsDirty = true;
+}
+
+uint16_t LightGrid::AddLight(const Light& light)
+{
+	uint16_t slot;
+	if (m_FreeSlots.size() > 0)
+	{
+		slot = m_FreeSlots.back();
+		m_FreeSlots.pop_back();
+		m_Lights[slot] = light;
+		m_SlotUsed[slot] = true;
+	}
+	else
+	{
+		slot = (uint16_t)m_Lights.size();
+		m_Lights.push_back(light);
+		m_SlotUsed.push_back(true);
+	}
+	m_Lights[slot].lightIndex = slot;
+	InsertIntoCells(slot);
+	MarkDirty(slot);
+	return slot;
+}
+void LightGrid::MoveLight(uint16_t slot, uint8_t x, uint8_t y, uint8_t z)
+{
+	if (slot >= m_Lights.size() || !m_SlotUsed[slot]) return;
+	Light& light = m_Lights[slot];
+	int oldMinY, oldMaxY, oldMinX, oldMaxX;
+	GetCellBounds(light, oldMinY, oldMaxY, oldMinX, oldMaxX);
+	Light moved = light;
+	moved.x = x;
+	moved.y = y;
+	moved.z = z;
+	int newMinY, newMaxY, newMinX, newMaxX;
+	GetCellBounds(moved, newMinY, newMaxY, newMinX, newMaxX);
+
+	//moving around within the same tile doesn't change which cells it reaches
+	if (oldMinY != newMinY || oldMaxY != newMaxY || oldMinX != newMinX || oldMaxX != newMaxX)
+	{
+		RemoveFromCells(slot);
+		light = moved;
+		InsertIntoCells(slot);
+	}
+	else
+	{
+		light = moved;
+	}
+	MarkDirty(slot);
+}
+void LightGrid::RemoveLight(uint16_t slot)
+{
+	if (slot >= m_Lights.size() || !m_SlotUsed[slot]) return;
+	RemoveFromCells(slot);
+	m_SlotUsed[slot] = false;
+	m_FreeSlots.push_back(slot);
+	//the GPU only reads slots listed in a cell, so a freed slot doesn't need uploading
+}
+
+void LightGrid::ClearDirty()
+{
+	m_DirtyMin = UINT16_MAX;
+	m_DirtyMax = 0;
+	m_CellsDirty = false;
+}
+
+void LightGrid::BuildCellData(std::vector<CellRange>& ranges, std::vector<uint32_t>& indices)
+{
+	ranges.resize(MAP_SIZE_TILES * MAP_SIZE_TILES);
+	indices.clear();
+	m_Stats.mostLightsInCell = 0;
+	for (int y = 0; y < MAP_SIZE_TILES; y++)
+	{
+		for (int x = 0; x < MAP_SIZE_TILES; x++)
+		{
+			const std::vector<uint16_t>& cell = m_Cells[y][x];
+			CellRange& range = ranges[y * MAP_SIZE_TILES + x];
+			range.offset = (uint32_t)indices.size();
+			range.count = (uint32_t)cell.size();
+			indices.insert(indices.end(), cell.begin(), cell.end());
+			if (range.count > m_Stats.mostLightsInCell) m_Stats.mostLightsInCell = range.count;
+		}
+	}
+	m_Stats.cellEntries = (uint32_t)indices.size();
+}
+
+//same reach as the old per tile light lists: [tile - range, tile + range) with range = ceil(range in tiles / 2), the bounds returned are inclusive
+void LightGrid::GetCellBounds(const Light& light, int& minY, int& maxY, int& minX, int& maxX) const
+{
+	const int lightRange = (int)ceil(ceil((float)light.range / 3.0f) / 2.0f);
+	const int tileX = light.x / 3;
+	const int tileY = light.y / 3;
+	minY = std::max(tileY - lightRange, 0);
+	maxY = std::min(tileY + lightRange - 1, MAP_SIZE_TILES - 1);
+	minX = std::max(tileX - lightRange, 0);
+	maxX = std::min(tileX + lightRange - 1, MAP_SIZE_TILES - 1);
+}
+void LightGrid::InsertIntoCells(uint16_t slot)
+{
+	int minY, maxY, minX, maxX;
+	GetCellBounds(m_Lights[slot], minY, maxY, minX, maxX);
+	for (int y = minY; y <= maxY; y++)
+	{
+		for (int x = minX; x <= maxX; x++)
+		{
+			m_Cells[y][x].push_back(slot);
+		}
+	}
+	m_CellsDirty = true;
+}
+void LightGrid::RemoveFromCells(uint16_t slot)
+{
+	int minY, maxY, minX, maxX;
+	GetCellBounds(m_Lights[slot], minY, maxY, minX, maxX);
+	for (int y = minY; y <= maxY; y++)
+	{
+		for (int x = minX; x <= maxX; x++)
+		{
+			std::vector<uint16_t>& cell = m_Cells[y][x];
+			auto it = std::find(cell.begin(), cell.end(), slot);
+			if (it != cell.end())
+			{
+				*it = cell.back();
+				cell.pop_back();
+			}
+		}
+	}
+	m_CellsDirty = true;
+}
+void LightGrid::MarkDirty(uint16_t slot)
+{
+	if (slot < m_DirtyMin) m_DirtyMin = slot;
+	if (slot > m_DirtyMax) m_DirtyMax = slot;
+}
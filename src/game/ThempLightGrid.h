@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "ThempTileArrays.h"
+namespace Themp
+{
+	//2D grid with a cell per tile, every cell lists the lights that reach it (no limit on how many)
+	//A light keeps its slot for as long as it exists, that slot is also its index in the GPU light buffer.
+	//Adding/moving/removing a light only touches the cells within its range and marks its slot dirty so only changed lights get uploaded.
+	class LightGrid
+	{
+	public:
+		struct CellRange
+		{
+			uint32_t offset;
+			uint32_t count;
+		};
+		struct Stats
+		{
+			uint32_t cellEntries = 0;
+			uint32_t mostLightsInCell = 0;
+		};
+
+		LightGrid();
+		void Clear();
+
+		uint16_t AddLight(const Light& light);
+		void MoveLight(uint16_t slot, uint8_t x, uint8_t y, uint8_t z);
+		void RemoveLight(uint16_t slot);
+
+		const Light& GetLight(uint16_t slot) const { return m_Lights[slot]; }
+		const std::vector<uint16_t>& GetCell(int y, int x) const { return m_Cells[y][x]; }
+		size_t GetNumLights() const { return m_Lights.size() - m_FreeSlots.size(); }
+		size_t GetNumSlots() const { return m_Lights.size(); }
+
+		//dirty slot range (inclusive), empty when min > max
+		bool HasDirtyLights() const { return m_DirtyMin <= m_DirtyMax; }
+		uint16_t GetDirtyMin() const { return m_DirtyMin; }
+		uint16_t GetDirtyMax() const { return m_DirtyMax; }
+		bool CellsDirty() const { return m_CellsDirty; }
+		void ClearDirty();
+
+		//flattens the cell lists into one offset/count per cell (row major, MAP_SIZE_TILES wide) and a single index array
+		void BuildCellData(std::vector<CellRange>& ranges, std::vector<uint32_t>& indices);
+		const Stats& GetStats() const { return m_Stats; }
+
+	private:
+		void GetCellBounds(const Light& light, int& minY, int& maxY, int& minX, int& maxX) const;
+		void InsertIntoCells(uint16_t slot);
+		void RemoveFromCells(uint16_t slot);
+		void MarkDirty(uint16_t slot);
+
+		std::vector<Light> m_Lights;
+		std::vector<bool> m_SlotUsed;
+		std::vector<uint16_t> m_FreeSlots;
+		std::vector<uint16_t> m_Cells[MAP_SIZE_TILES][MAP_SIZE_TILES];
+		uint16_t m_DirtyMin = UINT16_MAX;
+		uint16_t m_DirtyMax = 0;
+		bool m_CellsDirty = false;
+		Stats m_Stats;
+	};
+};
@@ -0,0 +1,278 @@
+#include "ThempSystem.h"
+#include "ThempLiquidLayer.h"
+#include "ThempVoxelVertexPacking.h"
+#include "ThempLevelData.h"
+#include "ThempVoxelObject.h"
+#include "ThempResources.h"
+#include "../Engine/ThempObject3D.h"
+#include "../Engine/ThempMesh.h"
+#include "../Engine/ThempMaterial.h"
+#include "../Engine/ThempD3D.h"
+
+using namespace Themp;
+
+static const float pixelSizeX = (1.0f / 256.0f) * 31.5f;
+static const float pixelSizeY = (1.0f / 2176.0f) * 31.5f;
+
+LiquidLayer::LiquidLayer(LevelData* level, Material* material)
+{
+	m_Level = level;
+	m_Obj3D = new Object3D();
+	m_Obj3D->SetPosition(0, 0, 0);
+	//nothing to draw until the first build
+	m_Obj3D->isVisible = false;
+
+	Mesh* m = new Mesh();
+	Themp::Resources::TRes->m_Meshes.push_back(m);
+	m_Obj3D->m_Meshes.push_back(m);
+	m->m_NumIndices = 0;
+	m->m_NumVertices = 0;
+	m->m_Vertices = nullptr;
+	m->m_Indices = nullptr;
+	m->m_VertexBuffer = nullptr;
+	m->m_IndexBuffer = nullptr;
+	m->m_VertexSize = sizeof(PackedVoxelVertex);
+	//same shader and block texture as the map
+	m->m_Material = material;
+
+	m_Level->m_TileEvents.Subscribe(OnTileChanges, this);
+}
+LiquidLayer::LiquidLayer(LevelData* level)
+{
+	m_Level = level;
+	m_Level->m_TileEvents.Subscribe(OnTileChanges, this);
+}
+LiquidLayer::~LiquidLayer()
+{
+	m_Level->m_TileEvents.Unsubscribe(OnTileChanges, this);
+	CLEAN(m_IndexBuffer.buf);
+	CLEAN(m_VertexBuffer.buf);
+}
+
+void LiquidLayer::Update()
+{
+	if (m_Dirty)
+	{
+		Build();
+	}
+}
+static bool IsLiquid(uint16_t type)
+{
+	return (type & 0xFF) == Type_Water || (type & 0xFF) == Type_Lava;
+}
+//A surface depends on its own tile (type, explored) and on the 8 around it (the shore), so any change on or next to a liquid tile means a rebuild
+void LiquidLayer::OnTileChanges(void* context, const TileChange* changes, size_t count)
+{
+	LiquidLayer* layer = (LiquidLayer*)context;
+	if (layer->m_Dirty) return;
+	for (size_t i = 0; i < count; i++)
+	{
+		const TileChange& change = changes[i];
+		if (!(change.fields & (TileChange::Field_Type | TileChange::Field_Visible))) continue;
+		if (IsLiquid(change.before.type) || IsLiquid(change.after.type))
+		{
+			layer->m_Dirty = true;
+			return;
+		}
+		for (int y = change.y - 1; y <= change.y + 1; y++)
+		{
+			for (int x = change.x - 1; x <= change.x + 1; x++)
+			{
+				if (y < 0 || x < 0 || y >= MAP_SIZE_TILES || x >= MAP_SIZE_TILES) continue;
+				if (IsLiquid(LevelData::s_Map.m_Tiles[y][x].type))
+				{
+					layer->m_Dirty = true;
+					return;
+				}
+			}
+		}
+	}
+}
+
+void LiquidLayer::Build()
+{
+	m_Vertices.clear();
+	m_Indices.clear();
+	m_Stats.tiles = 0;
+
+	//the map mesh never builds the last row and column of tiles either
+	for (int yP = 0; yP < MAP_SIZE_TILES - 1; yP++)
+	{
+		for (int xP = 0; xP < MAP_SIZE_TILES - 1; xP++)
+		{
+			const Tile& tile = m_Level->s_Map.m_Tiles[yP][xP];
+			const int tileType = tile.GetType();
+			if (tileType != Type_Water && tileType != Type_Lava) continue;
+			//unexplored tiles are drawn as solid blocks by the map mesh
+			if (!tile.visible) continue;
+			m_Stats.tiles++;
+			for (int y = yP * 3; y < yP * 3 + 3; y++)
+			{
+				for (int x = xP * 3; x < xP * 3 + 3; x++)
+				{
+					if (!m_Level->IsBlockActive(0, y, x)) continue;
+					if (!(m_Level->m_BlockFaces[0][y][x] & LevelData::Face_Top)) continue;
+					AddSurface(y, x, yP, xP, tileType);
+				}
+			}
+		}
+	}
+	m_Stats.quads = (uint32_t)(m_Indices.size() / 6);
+	m_Stats.rebuilds++;
+	m_Dirty = false;
+	if (m_Obj3D)
+	{
+		UploadBuffers();
+	}
+}
+
+//the top of one z 0 liquid block, always the first frame, the vertex shader moves it along to the current one
+void LiquidLayer::AddSurface(int y, int x, int yP, int xP, int tileType)
+{
+	const std::vector<XMFLOAT2>& tex0 = BlockTextures[TypeToTexture(tileType)].top[0];
+	assert(tex0.size() == NumFrames);
+	XMFLOAT2 uv = tex0[0];
+	uv.x = uv.x / 8.0f;
+	uv.y = uv.y / 68.0f;
+
+	//the wave stays off along the shore so the surface doesn't come loose from the walls around it
+	bool cornerQuad = false;
+	uint32_t useAnimNorth = 1;
+	uint32_t useAnimWest = 1;
+	uint32_t useAnimSouth = 1;
+	uint32_t useAnimEast = 1;
+	const int xMod = x % 3;
+	const int yMod = y % 3;
+	TileNeighbours neighbour = m_Level->CheckNeighbours(tileType, yP, xP);
+	if (neighbour.North != N_SAME && yMod == 2)
+	{
+		useAnimNorth = 0;
+	}
+	else if (neighbour.South != N_SAME && yMod == 0)
+	{
+		useAnimSouth = 0;
+	}
+	if (neighbour.East != N_SAME && xMod == 2)
+	{
+		useAnimEast = 0;
+	}
+	else if (neighbour.West != N_SAME && xMod == 0)
+	{
+		useAnimWest = 0;
+	}
+	if (xMod == 0 && yMod == 2 && neighbour.North == N_SAME && neighbour.West == N_SAME)
+	{
+		if (neighbour.NorthWest != N_SAME)
+		{
+			useAnimNorth = 0;
+			useAnimWest = 0;
+			cornerQuad = true;
+		}
+	}
+	else if (xMod == 2 && yMod == 2 && neighbour.North == N_SAME && neighbour.East == N_SAME)
+	{
+		if (neighbour.NorthEast != N_SAME)
+		{
+			useAnimNorth = 0;
+			useAnimEast = 0;
+			cornerQuad = true;
+		}
+	}
+	else if (xMod == 0 && yMod == 0 && neighbour.South == N_SAME && neighbour.West == N_SAME)
+	{
+		if (neighbour.SouthWest != N_SAME)
+		{
+			useAnimSouth = 0;
+			useAnimWest = 0;
+			cornerQuad = true;
+		}
+	}
+	else if (xMod == 2 && yMod == 0 && neighbour.South == N_SAME && neighbour.East == N_SAME)
+	{
+		if (neighbour.SouthEast != N_SAME)
+		{
+			useAnimSouth = 0;
+			useAnimEast = 0;
+			cornerQuad = true;
+		}
+	}
+
+	uint32_t waveSE, waveNE, waveNW, waveSW;
+	if (cornerQuad)
+	{
+		waveSE = useAnimEast || useAnimSouth;
+		waveNE = useAnimEast || useAnimNorth;
+		waveNW = useAnimWest || useAnimNorth;
+		waveSW = useAnimWest || useAnimSouth;
+	}
+	else
+	{
+		waveSE = useAnimEast && useAnimSouth;
+		waveNE = useAnimEast && useAnimNorth;
+		waveNW = useAnimWest && useAnimNorth;
+		waveSW = useAnimWest && useAnimSouth;
+	}
+
+	const uint32_t vIndex = (uint32_t)m_Vertices.size();
+	m_Indices.push_back(vIndex + 2);
+	m_Indices.push_back(vIndex + 1);
+	m_Indices.push_back(vIndex + 0);
+	m_Indices.push_back(vIndex + 3);
+	m_Indices.push_back(vIndex + 2);
+	m_Indices.push_back(vIndex + 0);
+
+	m_Vertices.push_back({ x + 0.5f, 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y				, 1, VoxelObject::AnimateFrames | waveSE });
+	m_Vertices.push_back({ x + 0.5f, 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, VoxelObject::AnimateFrames | waveNE });
+	m_Vertices.push_back({ x - 0.5f, 0.5f ,  y + 0.5f , 0,1,0, uv.x				,uv.y + pixelSizeY	, 1, VoxelObject::AnimateFrames | waveNW });
+	m_Vertices.push_back({ x - 0.5f, 0.5f ,  y - 0.5f , 0,1,0, uv.x				,uv.y				, 1, VoxelObject::AnimateFrames | waveSW });
+}
+
+bool LiquidLayer::ReserveBuffer(Resources::Buffer& buf, size_t numElements, size_t elementSize, UINT bindFlags)
+{
+	if (buf.buf && buf.numElements >= numElements) return true;
+	//grow to the next power of two so digging out a bit more next to the water doesn't recreate it every time
+	size_t capacity = 256;
+	while (capacity < numElements) capacity *= 2;
+
+	D3D11_BUFFER_DESC bd;
+	ZeroMemory(&bd, sizeof(D3D11_BUFFER_DESC));
+	bd.Usage = D3D11_USAGE_DYNAMIC;
+	bd.ByteWidth = (UINT)(elementSize * capacity);
+	bd.BindFlags = bindFlags;
+	bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	ID3D11Buffer* newBuffer;
+	if (D3D::s_D3D->m_Device->CreateBuffer(&bd, NULL, &newBuffer) != S_OK)
+	{
+		System::Print("Could not create liquid layer buffer!");
+		return false;
+	}
+	CLEAN(buf.buf);
+	buf.buf = newBuffer;
+	buf.numElements = capacity;
+	return true;
+}
+bool LiquidLayer::UploadBuffers()
+{
+	Mesh* m = m_Obj3D->m_Meshes[0];
+	m_Obj3D->isVisible = m_Indices.size() > 0;
+	m->m_NumVertices = (uint32_t)m_Vertices.size();
+	m->m_NumIndices = (uint32_t)m_Indices.size();
+	if (m_Indices.size() == 0) return true;
+
+	if (!ReserveBuffer(m_VertexBuffer, m_Vertices.size(), sizeof(PackedVoxelVertex), D3D11_BIND_VERTEX_BUFFER)) return false;
+	if (!ReserveBuffer(m_IndexBuffer, m_Indices.size(), sizeof(uint32_t), D3D11_BIND_INDEX_BUFFER)) return false;
+
+	ID3D11DeviceContext* devCon = D3D::s_D3D->m_DevCon;
+	D3D11_MAPPED_SUBRESOURCE ms;
+	ZeroMemory(&ms, sizeof(D3D11_MAPPED_SUBRESOURCE));
+	if (devCon->Map(m_VertexBuffer.buf, NULL, D3D11_MAP_WRITE_DISCARD, NULL, &ms) != S_OK) return false;
+	VoxelVertexPacking::Pack(m_Vertices.data(), (PackedVoxelVertex*)ms.pData, m_Vertices.size());
+	devCon->Unmap(m_VertexBuffer.buf, NULL);
+	if (devCon->Map(m_IndexBuffer.buf, NULL, D3D11_MAP_WRITE_DISCARD, NULL, &ms) != S_OK) return false;
+	memcpy(ms.pData, m_Indices.data(), sizeof(uint32_t) * m_Indices.size());
+	devCon->Unmap(m_IndexBuffer.buf, NULL);
+
+	m->m_VertexBuffer = m_VertexBuffer.buf;
+	m->m_IndexBuffer = m_IndexBuffer.buf;
+	return true;
+}
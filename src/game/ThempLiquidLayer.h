@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <d3d11.h>
+#include "ThempTileArrays.h"
+#include "ThempTileEvents.h"
+#include "ThempResources.h"
+namespace Themp
+{
+	class Object3D;
+	class Material;
+	class LevelData;
+	struct VoxelVertex;
+	//The water and lava surfaces, kept out of the map mesh so that one doesn't change when the liquid animates.
+	//It's only rebuilt when the tile events report a change on or next to a liquid tile (dug out, explored), the wave and the texture frames (VoxelObject::AnimateFrames) run in voxel_vs.hlsl off the time in the constant buffer.
+	class LiquidLayer
+	{
+	public:
+		//frames per liquid, next to each other in one row of the block atlas
+		static const size_t NumFrames = 8;
+
+		LiquidLayer(LevelData* level, Material* material);
+		//without an Object3D or buffers, only builds the surfaces (tests)
+		LiquidLayer(LevelData* level);
+		~LiquidLayer();
+		void Update();
+		void Build();
+		static void OnTileChanges(void* context, const TileChange* changes, size_t count);
+
+		Object3D* m_Obj3D = nullptr;
+		struct Stats
+		{
+			uint32_t rebuilds = 0;
+			uint32_t tiles = 0;
+			uint32_t quads = 0;
+		} m_Stats;
+
+	private:
+		void AddSurface(int y, int x, int yP, int xP, int tileType);
+		bool ReserveBuffer(Resources::Buffer& buf, size_t numElements, size_t elementSize, UINT bindFlags);
+		bool UploadBuffers();
+
+		LevelData* m_Level = nullptr;
+		//set until the first build and by OnTileChanges
+		bool m_Dirty = true;
+		std::vector<VoxelVertex> m_Vertices;
+		std::vector<uint32_t> m_Indices;
+		Resources::Buffer m_VertexBuffer;
+		Resources::Buffer m_IndexBuffer;
+	};
+};
@@ -259,7 +259,7 @@ void Themp::MainMenu::Update(double dt)
 								break;
 							}
 
-							Themp::System::tSys->m_Audio->PlayOneShot(FileManager::GetSound("BUTTON1.WAV"));
+							FileManager::PlayOneShot("BUTTON1.WAV");
 						}
 						else
 						{
@@ -13,7 +13,6 @@ using namespace DirectX;
 #define SUBTILESX 3
 #define SUBTILESY 3
 #define SUBTILESZ 8
-#define MAX_LIGHTS_PER_TILE 4
 
 #define L8(x) ((x)&0xFF)
 
@@ -178,11 +177,21 @@ namespace Themp
 {
 	class Entity;
 
+	//Atlas cell of a block face, the block texture atlas is 8 by 68 cells so a byte per axis is plenty
+	//converts to/from XMFLOAT2 so the UV tables can stay as they are
+	struct BlockUV
+	{
+		BlockUV() : x(0), y(0) {}
+		BlockUV(const XMFLOAT2& v) : x((uint8_t)v.x), y((uint8_t)v.y) {}
+		operator XMFLOAT2() const { return XMFLOAT2(x, y); }
+		uint8_t x, y;
+	};
+
+	//A block of a tile model (RenderTile), the map only keeps whether it's there (LevelData::m_BlockOccupancy), the uvs come from the model when the tile gets meshed
 	struct Block
 	{
 		Block()
 		{
-			randValue = 0;
 		}
 		Block(bool a, XMFLOAT2 u, XMFLOAT2 v)
 		{
@@ -190,7 +199,6 @@ namespace Themp
 			uv[0] = u; //X (side)
 			uv[1] = u; //Y (side)
 			uv[2] = v; //Z (top)
-			randValue = 0;
 		}
 		Block(bool a, XMFLOAT2 u,XMFLOAT2 v,XMFLOAT2 w)
 		{
@@ -198,11 +206,29 @@ namespace Themp
 			uv[0] = u; //X (side)
 			uv[1] = v; //Y (side)
 			uv[2] = w; //Z (top)
-			randValue = 0;
 		}
+		BlockUV uv[3];
 		bool active = false;
-		int randValue;
-		XMFLOAT2 uv[3];
+	};
+	//The face uvs of a block, X side, Y side and top
+	struct BlockUVs
+	{
+		BlockUV uv[3];
+	};
+	//The face uvs of all the blocks of one tile, LevelData::GetTileUVs puts them together from the tile's model and its neighbours whenever the mesher needs them.
+	//Looked up with map subtile coordinates, so the code picking them doesn't have to care that it's only got the one tile
+	struct TileUVs
+	{
+		BlockUVs blocks[MAP_SIZE_HEIGHT][SUBTILESY][SUBTILESX];
+		int yP = 0, xP = 0;
+		BlockUVs& At(int z, int y, int x)
+		{
+			return blocks[z][y - yP][x - xP];
+		}
+		const BlockUVs& At(int z, int y, int x) const
+		{
+			return blocks[z][y - yP][x - xP];
+		}
 	};
 	struct PathFindTile
 	{
@@ -268,6 +294,8 @@ namespace Themp
 		uint16_t lightIndex = 0;
 	};
 
+	//Only the fields that get swept over the whole map (type, owner, visibility, area/room etc) live in here, packed into 24 bytes
+	//the per subtile data is in TileDetail, see TileMap::m_TileDetails
 	struct Tile
 	{
 		Tile()
@@ -282,9 +310,28 @@ namespace Themp
 			marked[3] = false;
 			health = 1024;
 			areaCode = 0;
-			lightArrayIndex = 0;
 			roomID = INT32_MAX;
+		}
 
+		uint16_t GetType() const
+		{
+			return (type & 0xFF);
+		}
+
+		uint32_t areaCode;
+		int32_t roomID;
+		int32_t health;
+		uint16_t type;
+		uint16_t numBlocks;
+		uint8_t owner;
+		bool visible;
+		bool marked[4];
+	};
+	//Per subtile data of a tile, only touched when pathing/placing things on a specific tile
+	struct TileDetail
+	{
+		TileDetail()
+		{
 			for (size_t i = 0; i < SUBTILESY; i++)
 			{
 				for (size_t j = 0; j < SUBTILESX; j++)
@@ -294,24 +341,8 @@ namespace Themp
 				}
 			}
 		}
-
-		uint16_t GetType() const
-		{
-			return (type & 0xFF);
-		}
-
-		bool visible;
-		uint8_t owner;
-		uint16_t type;
-		uint32_t areaCode;
-		int32_t roomID;
-		uint16_t lightArrayIndex;
 		std::array<std::array<PathFindTile, SUBTILESY>, SUBTILESX> pathSubTiles;
 		std::array<std::array<Entity*, SUBTILESY>, SUBTILESX> placedEntities;
-
-		uint16_t numBlocks;
-		int32_t health;
-		bool marked[4];
 	};
 	struct NeighbourSubTiles
 	{
@@ -349,6 +380,14 @@ namespace Themp
 	{
 	public:
 		Tile m_Tiles[MAP_SIZE_TILES][MAP_SIZE_TILES];
+		TileDetail m_TileDetails[MAP_SIZE_TILES][MAP_SIZE_TILES];
+
+		//for when all we have is a pointer into m_Tiles
+		TileDetail& GetDetail(const Tile* tile)
+		{
+			const size_t index = tile - &m_Tiles[0][0];
+			return m_TileDetails[index / MAP_SIZE_TILES][index % MAP_SIZE_TILES];
+		}
 
 		/**
 		Return the least possible cost between 2 states. For example, if your pathfinding
@@ -423,18 +462,7 @@ namespace Themp
 	constexpr int Tile_LIBRARY = 24;
 	constexpr int Tile_BARRACKS = 34;
 	constexpr int Tile_PILLAR_ROOM = 44;
-	const RenderTile RenderTileMap[] =
-	{
-		#include "Rock.h" //0
-		#include "FullBlock.h" //1
-		#include "GroundBlock.h" //2
-		#include "LiquidBlock.h" //3
-		#include "DungeonHeart.h"//4 - 13
-		#include "Portal.h" //14 - 23
-		#include "Library.h"//24 - 33
-		#include "Barracks.h"//34 - 43
-		#include "RoomWithPillars.h"//44 - 53
-	};
+	//the models themselves live in ThempVoxelModels (compact tables generated from the VoxelModels headers)
 
 	struct TileTextures
 	{
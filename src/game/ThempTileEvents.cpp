@@ -0,0 +1,125 @@
+#include "ThempTileEvents.h"
+#include <algorithm>
+#include <cstring>
+using namespace Themp;
+
+TileEvents::TileEvents()
+{
+	memset(m_Published, 0, sizeof(m_Published));
+}
+void TileEvents::Subscribe(Subscriber subscriber, void* context)
+{
+	m_Subscribers.push_back({ subscriber, context });
+}
+void TileEvents::Unsubscribe(Subscriber subscriber, void* context)
+{
+	for (size_t i = 0; i < m_Subscribers.size(); i++)
+	{
+		if (m_Subscribers[i].callback == subscriber && m_Subscribers[i].context == context)
+		{
+			m_Subscribers.erase(m_Subscribers.begin() + i);
+			return;
+		}
+	}
+}
+
+void TileEvents::Reset(const TileMap& map)
+{
+	for (int y = 0; y < MAP_SIZE_TILES; y++)
+	{
+		for (int x = 0; x < MAP_SIZE_TILES; x++)
+		{
+			m_Published[y][x] = Capture(map, y, x);
+		}
+	}
+	m_Marked.reset();
+	m_MarkedTiles.clear();
+}
+
+void TileEvents::MarkTile(int y, int x)
+{
+	if (y < 0 || x < 0 || y >= MAP_SIZE_TILES || x >= MAP_SIZE_TILES) return;
+	const int index = y * MAP_SIZE_TILES + x;
+	if (m_Marked[index]) return;
+	m_Marked[index] = true;
+	m_MarkedTiles.push_back((uint16_t)index);
+}
+void TileEvents::MarkArea(int minY, int maxY, int minX, int maxX)
+{
+	for (int y = minY; y <= maxY; y++)
+	{
+		for (int x = minX; x <= maxX; x++)
+		{
+			MarkTile(y, x);
+		}
+	}
+}
+
+void TileEvents::Publish(const TileMap& map)
+{
+	if (m_MarkedTiles.size() == 0) return;
+	std::sort(m_MarkedTiles.begin(), m_MarkedTiles.end());
+
+	m_Changes.clear();
+	for (size_t i = 0; i < m_MarkedTiles.size(); i++)
+	{
+		const int y = m_MarkedTiles[i] / MAP_SIZE_TILES;
+		const int x = m_MarkedTiles[i] % MAP_SIZE_TILES;
+		m_Marked[m_MarkedTiles[i]] = false;
+
+		TileState& before = m_Published[y][x];
+		const TileState after = Capture(map, y, x);
+		uint8_t fields = 0;
+		if (before.type != after.type) fields |= TileChange::Field_Type;
+		if (before.owner != after.owner) fields |= TileChange::Field_Owner;
+		if (before.walkableSubTiles != after.walkableSubTiles) fields |= TileChange::Field_Walkable;
+		if (before.visible != after.visible) fields |= TileChange::Field_Visible;
+		if (before.roomID != after.roomID) fields |= TileChange::Field_Room;
+		if (before.marked != after.marked) fields |= TileChange::Field_Marked;
+		if (fields == 0) continue;
+
+		m_Changes.push_back({ y, x, fields, before, after });
+		before = after;
+	}
+	m_Stats.batches++;
+	m_Stats.checkedLastBatch = (uint32_t)m_MarkedTiles.size();
+	m_Stats.changesLastBatch = (uint32_t)m_Changes.size();
+	m_Stats.changes += (uint32_t)m_Changes.size();
+	//anything a subscriber marks goes into the next batch
+	m_MarkedTiles.clear();
+
+	if (m_Changes.size() == 0) return;
+	for (size_t i = 0; i < m_Subscribers.size(); i++)
+	{
+		m_Subscribers[i].callback(m_Subscribers[i].context, m_Changes.data(), m_Changes.size());
+	}
+}
+
+TileState TileEvents::Capture(const TileMap& map, int y, int x)
+{
+	const Tile& tile = map.m_Tiles[y][x];
+	TileState state;
+	state.type = tile.type;
+	state.owner = tile.owner;
+	state.visible = tile.visible;
+	state.roomID = tile.roomID;
+	state.marked = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		state.marked |= tile.marked[i] ? 1 << i : 0;
+	}
+	state.walkableSubTiles = 0;
+	const TileDetail& detail = map.m_TileDetails[y][x];
+	for (int sy = 0; sy < SUBTILESY; sy++)
+	{
+		for (int sx = 0; sx < SUBTILESX; sx++)
+		{
+			//same test TileMap::AdjacentCost does
+			if (detail.pathSubTiles[sy][sx].cost < 1000.0f)
+			{
+				state.walkableSubTiles |= 1 << (sy * SUBTILESX + sx);
+			}
+		}
+	}
+	return state;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <bitset>
+#include <cstdint>
+#include "ThempTileArrays.h"
+namespace Themp
+{
+	//The parts of a tile the rest of the game reacts to
+	struct TileState
+	{
+		uint16_t type;
+		uint8_t owner;
+		bool visible;
+		//bit (subtile y * 3 + subtile x) for every subtile the pather can walk over
+		uint16_t walkableSubTiles;
+		int32_t roomID;
+		//bit per player that marked the tile for digging
+		uint8_t marked;
+	};
+	struct TileChange
+	{
+		enum Field : uint8_t
+		{
+			Field_Type = 1,
+			Field_Owner = 2,
+			Field_Walkable = 4,
+			Field_Visible = 8,
+			Field_Room = 16,
+			Field_Marked = 32,
+		};
+		int y, x;
+		//Field bits for what's different between before and after
+		uint8_t fields;
+		TileState before;
+		TileState after;
+	};
+
+	//Map edits mark the tiles they touch, Publish compares those with what was published last time and hands the ones that really changed to every subscriber in one go.
+	//LevelData publishes at the end of FlushAreaUpdates, so everything edited in a frame comes out as one batch with a single entry per tile (in row order).
+	class TileEvents
+	{
+	public:
+		typedef void(*Subscriber)(void* context, const TileChange* changes, size_t count);
+		struct Stats
+		{
+			uint32_t batches = 0;
+			uint32_t checkedLastBatch = 0;
+			uint32_t changesLastBatch = 0;
+			uint32_t changes = 0;
+		};
+
+		TileEvents();
+		void Subscribe(Subscriber subscriber, void* context);
+		void Unsubscribe(Subscriber subscriber, void* context);
+		//takes the map as it is now as the published state, without telling anyone (level load)
+		void Reset(const TileMap& map);
+		void MarkTile(int y, int x);
+		void MarkArea(int minY, int maxY, int minX, int maxX);
+		void Publish(const TileMap& map);
+		const Stats& GetStats() const { return m_Stats; }
+
+		static TileState Capture(const TileMap& map, int y, int x);
+
+	private:
+		struct SubscriberEntry
+		{
+			Subscriber callback;
+			void* context;
+		};
+		std::vector<SubscriberEntry> m_Subscribers;
+		TileState m_Published[MAP_SIZE_TILES][MAP_SIZE_TILES];
+		std::bitset<MAP_SIZE_TILES * MAP_SIZE_TILES> m_Marked;
+		std::vector<uint16_t> m_MarkedTiles;
+		std::vector<TileChange> m_Changes;
+		Stats m_Stats;
+	};
+};
@@ -0,0 +1,260 @@
+#include "ThempSystem.h"
+#include "ThempTimerWheel.h"
+
+using namespace Themp;
+
+#define WHEEL_LEVEL0_BITS 8
+#define WHEEL_LEVELN_BITS 6
+#define WHEEL_LEVEL0_SIZE (1 << WHEEL_LEVEL0_BITS)
+#define WHEEL_LEVELN_SIZE (1 << WHEEL_LEVELN_BITS)
+#define WHEEL_LEVEL_SHIFT(level) (WHEEL_LEVEL0_BITS + ((level) - 1) * WHEEL_LEVELN_BITS)
+//about 38 days worth of game turns, anything further away gets clamped
+#define WHEEL_MAX_DELTA ((1ull << WHEEL_LEVEL_SHIFT(4)) - 1)
+#define WHEEL_NONE UINT32_MAX
+
+std::vector<TimerWheel::Node> TimerWheel::s_Nodes;
+uint32_t TimerWheel::s_FreeList = WHEEL_NONE;
+uint32_t TimerWheel::s_Level0[256] = {};
+uint32_t TimerWheel::s_Levels[3][64] = {};
+uint64_t TimerWheel::s_CurrentTurn = 0;
+size_t TimerWheel::s_ActiveTimers = 0;
+TimerWheel::Stats TimerWheel::s_CurrentStats;
+TimerWheel::Stats TimerWheel::s_LastTurnStats;
+TimerWheel::Stats TimerWheel::s_TotalStats;
+
+//the static arrays above are zero initialized, but 0 is a valid node index, the wheel has to start out with empty slots
+struct TimerWheelInitializer
+{
+	TimerWheelInitializer()
+	{
+		TimerWheel::Reset();
+	}
+} s_TimerWheelInitializer;
+
+uint32_t& TimerWheel::SlotHead(int level, int slot)
+{
+	if (level == 0)
+	{
+		return s_Level0[slot];
+	}
+	return s_Levels[level - 1][slot];
+}
+uint32_t TimerWheel::AllocNode()
+{
+	uint32_t index = s_FreeList;
+	if (index != WHEEL_NONE)
+	{
+		s_FreeList = s_Nodes[index].next;
+	}
+	else
+	{
+		index = (uint32_t)s_Nodes.size();
+		s_Nodes.push_back(Node());
+	}
+	Node& n = s_Nodes[index];
+	n.prev = WHEEL_NONE;
+	n.next = WHEEL_NONE;
+	n.active = true;
+	s_ActiveTimers++;
+	return index;
+}
+void TimerWheel::FreeNode(uint32_t index)
+{
+	Node& n = s_Nodes[index];
+	n.active = false;
+	n.generation++;
+	n.callback = nullptr;
+	n.owner = nullptr;
+	n.prev = WHEEL_NONE;
+	n.next = s_FreeList;
+	s_FreeList = index;
+	s_ActiveTimers--;
+}
+void TimerWheel::Insert(uint32_t index)
+{
+	Node& n = s_Nodes[index];
+	if (n.expires < s_CurrentTurn)
+	{
+		n.expires = s_CurrentTurn;
+	}
+	uint64_t delta = n.expires - s_CurrentTurn;
+	if (delta < WHEEL_LEVEL0_SIZE)
+	{
+		n.level = 0;
+		n.slot = (uint8_t)(n.expires & (WHEEL_LEVEL0_SIZE - 1));
+	}
+	else
+	{
+		if (delta > WHEEL_MAX_DELTA)
+		{
+			n.expires = s_CurrentTurn + WHEEL_MAX_DELTA;
+			delta = WHEEL_MAX_DELTA;
+		}
+		int level = 1;
+		while (level < 3 && delta >= (1ull << WHEEL_LEVEL_SHIFT(level + 1)))
+		{
+			level++;
+		}
+		n.level = (uint8_t)level;
+		n.slot = (uint8_t)((n.expires >> WHEEL_LEVEL_SHIFT(level)) & (WHEEL_LEVELN_SIZE - 1));
+	}
+	uint32_t& head = SlotHead(n.level, n.slot);
+	n.prev = WHEEL_NONE;
+	n.next = head;
+	if (head != WHEEL_NONE)
+	{
+		s_Nodes[head].prev = index;
+	}
+	head = index;
+}
+void TimerWheel::Unlink(uint32_t index)
+{
+	Node& n = s_Nodes[index];
+	if (n.prev != WHEEL_NONE)
+	{
+		s_Nodes[n.prev].next = n.next;
+	}
+	else
+	{
+		SlotHead(n.level, n.slot) = n.next;
+	}
+	if (n.next != WHEEL_NONE)
+	{
+		s_Nodes[n.next].prev = n.prev;
+	}
+	n.prev = WHEEL_NONE;
+	n.next = WHEEL_NONE;
+}
+void TimerWheel::Cascade(int level, int slot)
+{
+	uint32_t& head = SlotHead(level, slot);
+	uint32_t index = head;
+	head = WHEEL_NONE;
+	while (index != WHEEL_NONE)
+	{
+		const uint32_t next = s_Nodes[index].next;
+		Insert(index);
+		s_CurrentStats.cascaded++;
+		index = next;
+	}
+}
+
+TimerWheel::Handle TimerWheel::Schedule(uint32_t turns, TimerCallback callback, void* owner, uint32_t eventCode)
+{
+	const uint32_t index = AllocNode();
+	Node& n = s_Nodes[index];
+	n.expires = s_CurrentTurn + (turns > 0 ? turns : 1);
+	n.callback = callback;
+	n.owner = owner;
+	n.eventCode = eventCode;
+	Insert(index);
+	s_CurrentStats.scheduled++;
+
+	Handle handle;
+	handle.index = index;
+	handle.generation = n.generation;
+	return handle;
+}
+void TimerWheel::Reschedule(Handle& handle, uint32_t turns, TimerCallback callback, void* owner, uint32_t eventCode)
+{
+	Cancel(handle);
+	handle = Schedule(turns, callback, owner, eventCode);
+}
+void TimerWheel::Cancel(Handle& handle)
+{
+	if (IsPending(handle))
+	{
+		Unlink(handle.index);
+		FreeNode(handle.index);
+		s_CurrentStats.cancelled++;
+	}
+	handle = Handle();
+}
+bool TimerWheel::IsPending(const Handle& handle)
+{
+	if (handle.index >= s_Nodes.size()) return false;
+	const Node& n = s_Nodes[handle.index];
+	return n.active && n.generation == handle.generation;
+}
+uint32_t TimerWheel::TurnsRemaining(const Handle& handle)
+{
+	if (!IsPending(handle)) return 0;
+	return (uint32_t)(s_Nodes[handle.index].expires - s_CurrentTurn);
+}
+
+void TimerWheel::Advance()
+{
+	s_CurrentTurn++;
+
+	//every time a level wraps around, pull the next slot of the level above it down
+	const int slot0 = (int)(s_CurrentTurn & (WHEEL_LEVEL0_SIZE - 1));
+	if (slot0 == 0)
+	{
+		for (int level = 1; level <= 3; level++)
+		{
+			const int slot = (int)((s_CurrentTurn >> WHEEL_LEVEL_SHIFT(level)) & (WHEEL_LEVELN_SIZE - 1));
+			Cascade(level, slot);
+			if (slot != 0) break;
+		}
+	}
+
+	//callbacks are free to schedule/cancel timers, so no references into s_Nodes are kept around while calling them
+	uint32_t& head = s_Level0[slot0];
+	while (head != WHEEL_NONE)
+	{
+		const uint32_t index = head;
+		Unlink(index);
+		const Node& n = s_Nodes[index];
+		TimerCallback callback = n.callback;
+		void* owner = n.owner;
+		const uint32_t eventCode = n.eventCode;
+		FreeNode(index);
+		s_CurrentStats.fired++;
+		if (callback)
+		{
+			callback(owner, eventCode);
+		}
+	}
+
+	s_LastTurnStats = s_CurrentStats;
+	s_TotalStats.scheduled += s_CurrentStats.scheduled;
+	s_TotalStats.cancelled += s_CurrentStats.cancelled;
+	s_TotalStats.fired += s_CurrentStats.fired;
+	s_TotalStats.cascaded += s_CurrentStats.cascaded;
+	s_CurrentStats = Stats();
+}
+void TimerWheel::Reset()
+{
+	//nodes are kept (and their generation bumped) so handles from before the reset can never match a new timer
+	s_FreeList = WHEEL_NONE;
+	for (int i = (int)s_Nodes.size() - 1; i >= 0; i--)
+	{
+		Node& n = s_Nodes[i];
+		if (n.active)
+		{
+			n.active = false;
+			n.generation++;
+		}
+		n.callback = nullptr;
+		n.owner = nullptr;
+		n.prev = WHEEL_NONE;
+		n.next = s_FreeList;
+		s_FreeList = i;
+	}
+	for (int i = 0; i < WHEEL_LEVEL0_SIZE; i++)
+	{
+		s_Level0[i] = WHEEL_NONE;
+	}
+	for (int level = 0; level < 3; level++)
+	{
+		for (int i = 0; i < WHEEL_LEVELN_SIZE; i++)
+		{
+			s_Levels[level][i] = WHEEL_NONE;
+		}
+	}
+	s_CurrentTurn = 0;
+	s_ActiveTimers = 0;
+	s_CurrentStats = Stats();
+	s_LastTurnStats = Stats();
+	s_TotalStats = Stats();
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+namespace Themp
+{
+	//Hierarchical timer wheel keyed in game turns.
+	//Owners schedule a deadline and (optionally) a callback + event code, nothing is paid per turn until the slot holding the timer comes around.
+	//Level 0 resolves single turns (256 slots), the upper levels hold 64 slots each of increasingly coarse turn ranges and get cascaded down as time passes.
+	class TimerWheel
+	{
+	public:
+		TimerWheel() = delete;
+		~TimerWheel() = delete;
+
+		typedef void(*TimerCallback)(void* owner, uint32_t eventCode);
+
+		//generation guards against stale handles, a handle whose timer fired or got cancelled is simply "not pending"
+		struct Handle
+		{
+			uint32_t index = UINT32_MAX;
+			uint32_t generation = 0;
+		};
+
+		struct Stats
+		{
+			uint32_t scheduled = 0;
+			uint32_t cancelled = 0;
+			uint32_t fired = 0;
+			uint32_t cascaded = 0;
+		};
+
+		//schedules a timer that fires after 'turns' game turns (minimum of 1), callback may be nullptr for timers that are only queried with IsPending
+		static Handle Schedule(uint32_t turns, TimerCallback callback = nullptr, void* owner = nullptr, uint32_t eventCode = 0);
+		//cancels the old timer of this handle (if any) and schedules a new one in its place
+		static void Reschedule(Handle& handle, uint32_t turns, TimerCallback callback = nullptr, void* owner = nullptr, uint32_t eventCode = 0);
+		static void Cancel(Handle& handle);
+		static bool IsPending(const Handle& handle);
+		static uint32_t TurnsRemaining(const Handle& handle);
+
+		//Advances the wheel by a single game turn, firing everything that expired
+		static void Advance();
+		//Drops every timer, used when a level gets (un)loaded
+		static void Reset();
+
+		static uint64_t GetCurrentTurn() { return s_CurrentTurn; }
+		static size_t GetActiveTimers() { return s_ActiveTimers; }
+		static const Stats& GetLastTurnStats() { return s_LastTurnStats; }
+		static const Stats& GetTotalStats() { return s_TotalStats; }
+
+	private:
+		struct Node
+		{
+			uint64_t expires = 0;
+			TimerCallback callback = nullptr;
+			void* owner = nullptr;
+			uint32_t eventCode = 0;
+			uint32_t generation = 0;
+			uint32_t prev = UINT32_MAX;
+			uint32_t next = UINT32_MAX;
+			uint8_t level = 0;
+			uint8_t slot = 0;
+			bool active = false;
+		};
+
+		static void Insert(uint32_t index);
+		static void Unlink(uint32_t index);
+		static void Cascade(int level, int slot);
+		static uint32_t AllocNode();
+		static void FreeNode(uint32_t index);
+		static uint32_t& SlotHead(int level, int slot);
+
+		static std::vector<Node> s_Nodes;
+		static uint32_t s_FreeList;
+		static uint32_t s_Level0[256];
+		static uint32_t s_Levels[3][64];
+		static uint64_t s_CurrentTurn;
+		static size_t s_ActiveTimers;
+		static Stats s_CurrentStats;
+		static Stats s_LastTurnStats;
+		static Stats s_TotalStats;
+	};
+};
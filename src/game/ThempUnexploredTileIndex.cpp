@@ -0,0 +1,133 @@
+#include "ThempUnexploredTileIndex.h"
+#include <algorithm>
+using namespace Themp;
+
+UnexploredTileIndex::UnexploredTileIndex()
+{
+	Clear();
+}
+void UnexploredTileIndex::Clear()
+{
+	m_Bits.reset();
+	for (int y = 0; y < NumCells; y++)
+	{
+		for (int x = 0; x < NumCells; x++)
+		{
+			m_CellCounts[y][x] = 0;
+		}
+	}
+	m_Count = 0;
+	m_AreaFrontier.clear();
+	for (int y = 0; y < MAP_SIZE_TILES; y++)
+	{
+		for (int x = 0; x < MAP_SIZE_TILES; x++)
+		{
+			m_SeenStamp[y][x] = 0;
+		}
+	}
+	m_Stamp = 0;
+}
+bool UnexploredTileIndex::Add(int y, int x)
+{
+	const int index = y * MAP_SIZE_TILES + x;
+	if (m_Bits[index]) return false;
+	m_Bits[index] = true;
+	m_CellCounts[y / CellSize][x / CellSize]++;
+	m_Count++;
+	return true;
+}
+void UnexploredTileIndex::Remove(int y, int x)
+{
+	const int index = y * MAP_SIZE_TILES + x;
+	if (!m_Bits[index]) return;
+	m_Bits[index] = false;
+	m_CellCounts[y / CellSize][x / CellSize]--;
+	m_Count--;
+}
+
+void UnexploredTileIndex::GetInRange(XMINT2 center, int radius, std::vector<XMINT2>& out) const
+{
+	const int minY = center.y - radius > 0 ? center.y - radius : 0;
+	const int minX = center.x - radius > 0 ? center.x - radius : 0;
+	const int maxY = center.y + radius < MAP_SIZE_TILES ? center.y + radius : MAP_SIZE_TILES - 1;
+	const int maxX = center.x + radius < MAP_SIZE_TILES ? center.x + radius : MAP_SIZE_TILES - 1;
+	for (int cy = minY / CellSize; cy <= maxY / CellSize; cy++)
+	{
+		for (int cx = minX / CellSize; cx <= maxX / CellSize; cx++)
+		{
+			if (m_CellCounts[cy][cx] == 0) continue;
+			const int startY = cy * CellSize > minY ? cy * CellSize : minY;
+			const int startX = cx * CellSize > minX ? cx * CellSize : minX;
+			const int endY = (cy + 1) * CellSize - 1 < maxY ? (cy + 1) * CellSize - 1 : maxY;
+			const int endX = (cx + 1) * CellSize - 1 < maxX ? (cx + 1) * CellSize - 1 : maxX;
+			for (int y = startY; y <= endY; y++)
+			{
+				for (int x = startX; x <= endX; x++)
+				{
+					if (m_Bits[y * MAP_SIZE_TILES + x])
+					{
+						out.push_back(XMINT2(x, y));
+					}
+				}
+			}
+		}
+	}
+}
+
+void UnexploredTileIndex::AddToArea(uint32_t areaCode, int y, int x)
+{
+	if (areaCode == 0 || !Contains(y, x)) return;
+	m_AreaFrontier[areaCode].push_back(XMINT2(x, y));
+}
+void UnexploredTileIndex::MergeAreas(uint32_t from, uint32_t to)
+{
+	auto it = m_AreaFrontier.find(from);
+	if (it == m_AreaFrontier.end()) return;
+	std::vector<XMINT2> tiles = std::move(it->second);
+	m_AreaFrontier.erase(it);
+	std::vector<XMINT2>& target = m_AreaFrontier[to];
+	target.insert(target.end(), tiles.begin(), tiles.end());
+}
+size_t UnexploredTileIndex::AreaSize(uint32_t areaCode) const
+{
+	auto it = m_AreaFrontier.find(areaCode);
+	return it != m_AreaFrontier.end() ? it->second.size() : 0;
+}
+
+bool UnexploredTileIndex::FindNearest(uint32_t areaCode, XMINT2 from, TilePredicate predicate, void* context, XMINT2& out)
+{
+	auto it = m_AreaFrontier.find(areaCode);
+	if (it == m_AreaFrontier.end()) return false;
+	std::vector<XMINT2>& frontier = it->second;
+	m_Stamp++;
+	m_Candidates.clear();
+	for (size_t i = 0; i < frontier.size();)
+	{
+		const XMINT2 p = frontier[i];
+		if (!Contains(p.y, p.x) || m_SeenStamp[p.y][p.x] == m_Stamp)
+		{
+			//explored or listed twice, the list is unordered so it's a swap with the last one
+			frontier[i] = frontier.back();
+			frontier.pop_back();
+			continue;
+		}
+		m_SeenStamp[p.y][p.x] = m_Stamp;
+		m_Candidates.push_back(std::make_pair((p.y - from.y) * (p.y - from.y) + (p.x - from.x) * (p.x - from.x), p));
+		i++;
+	}
+	//ties go to the lowest row and column so the order the list ended up in doesn't matter
+	std::sort(m_Candidates.begin(), m_Candidates.end(), [](const std::pair<int, XMINT2>& a, const std::pair<int, XMINT2>& b)
+	{
+		if (a.first != b.first) return a.first < b.first;
+		return a.second.y != b.second.y ? a.second.y < b.second.y : a.second.x < b.second.x;
+	});
+	for (size_t i = 0; i < m_Candidates.size(); i++)
+	{
+		if (predicate(context, m_Candidates[i].second.y, m_Candidates[i].second.x))
+		{
+			out = m_Candidates[i].second;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include <bitset>
+#include <cstdint>
+#include <unordered_map>
+#include "ThempTileArrays.h"
+namespace Themp
+{
+	//The tiles on the edge of what's been explored, a bit per tile plus a count per 8x8 tile cell
+	//so area queries can skip over the (mostly empty) parts of the map instead of walking everything.
+	//On top of that every area code has a frontier list of the tiles it borders, so looking for the closest tile
+	//a creature can reach only goes over its own area's edge and never over the frontier of areas it can't get to.
+	class UnexploredTileIndex
+	{
+	public:
+		static const int CellSize = 8;
+		static const int NumCells = (MAP_SIZE_TILES + CellSize - 1) / CellSize;
+
+		typedef bool(*TilePredicate)(void* context, int y, int x);
+
+		UnexploredTileIndex();
+		void Clear();
+		//true if the tile wasn't in the index yet
+		bool Add(int y, int x);
+		bool Add(XMINT2 pos) { return Add(pos.y, pos.x); }
+		void Remove(int y, int x);
+		bool Contains(int y, int x) const { return m_Bits[y * MAP_SIZE_TILES + x]; }
+		size_t Size() const { return m_Count; }
+
+		//all unexplored tiles within 'radius' tiles (square) of center
+		void GetInRange(XMINT2 center, int radius, std::vector<XMINT2>& out) const;
+		//lists a tile on the frontier of an area, LevelData does this for every walkable area next to a tile when it's added
+		//and when a tile next to one becomes walkable
+		void AddToArea(uint32_t areaCode, int y, int x);
+		//the areas got joined, everything on the edge of 'from' is on the edge of 'to' now
+		void MergeAreas(uint32_t from, uint32_t to);
+		//closest tile on the frontier of the area to 'from' that passes the predicate, the predicate is only asked about that area's tiles
+		//and in order of distance. Tiles that left the index (and doubles) are dropped from the list on the way
+		bool FindNearest(uint32_t areaCode, XMINT2 from, TilePredicate predicate, void* context, XMINT2& out);
+		size_t AreaSize(uint32_t areaCode) const;
+
+	private:
+		std::bitset<MAP_SIZE_TILES * MAP_SIZE_TILES> m_Bits;
+		uint16_t m_CellCounts[NumCells][NumCells];
+		size_t m_Count = 0;
+
+		//a tile stays listed under an area when the neighbour it got listed for changes area, the predicate sorts those out
+		std::unordered_map<uint32_t, std::vector<XMINT2>> m_AreaFrontier;
+		//which FindNearest saw a tile last, the stamp goes up every call so it never needs clearing
+		uint32_t m_SeenStamp[MAP_SIZE_TILES][MAP_SIZE_TILES];
+		uint32_t m_Stamp = 0;
+		//distance and tile of the frontier tiles FindNearest goes through
+		std::vector<std::pair<int, XMINT2>> m_Candidates;
+	};
+};
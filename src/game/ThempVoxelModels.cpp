@@ -0,0 +1,94 @@
+#include "ThempVoxelModels.h"
+#include "VoxelModels/CompactVoxelModels.h"
+#include <cassert>
+#include <vector>
+using namespace Themp;
+
+static_assert(sizeof(CompactVoxelModels::Model::occupancy) == SUBTILESY * SUBTILESX, "One occupancy byte per subtile column");
+static_assert(SUBTILESZ <= 8, "Occupancy needs a bit per block in a column");
+static_assert(sizeof(CompactVoxelModels::Model::uvSet) == SUBTILESY * SUBTILESX * SUBTILESZ, "One UV set per block");
+static_assert(sizeof(CompactVoxelModels::Model::pathTile) == SUBTILESY * SUBTILESX, "One path tile per subtile");
+static_assert(CompactVoxelModels::NumModels == Tile_PILLAR_ROOM + 10, "The compact models are out of line with the Tile_ constants, re-run ConvertVoxelModels.py");
+
+const int VoxelModels::NumModels = CompactVoxelModels::NumModels;
+
+namespace
+{
+	Block ExpandBlock(const CompactVoxelModels::Model& model, int column, int z)
+	{
+		const uint8_t* uvs = CompactVoxelModels::UVSets[model.uvSet[column * SUBTILESZ + z]];
+		Block b;
+		b.active = (model.occupancy[column] >> z) & 1;
+		for (int i = 0; i < 3; i++)
+		{
+			b.uv[i].x = uvs[i * 2];
+			b.uv[i].y = uvs[i * 2 + 1];
+		}
+		return b;
+	}
+	PathFindTile ExpandPathTile(const CompactVoxelModels::Model& model, int column)
+	{
+		const CompactVoxelModels::PathTile& p = CompactVoxelModels::PathTiles[model.pathTile[column]];
+		return PathFindTile(p.cost, p.height, p.walkable);
+	}
+	RenderTile ExpandModel(int model)
+	{
+		const CompactVoxelModels::Model& m = CompactVoxelModels::Models[model];
+		RenderTile out;
+		for (int y = 0; y < SUBTILESY; y++)
+		{
+			for (int x = 0; x < SUBTILESX; x++)
+			{
+				const int column = y * SUBTILESX + x;
+				for (int z = 0; z < SUBTILESZ; z++)
+				{
+					out.subTile[y][x][z] = ExpandBlock(m, column, z);
+				}
+				out.pathSubTiles[y][x] = ExpandPathTile(m, column);
+			}
+		}
+		out.activeBlocks = m.activeBlocks;
+		return out;
+	}
+	//every model expanded once, the first time one is asked for. Expanding costs a couple of microseconds a tile, copying the result a fraction of that
+	const std::vector<RenderTile>& GetExpandedModels()
+	{
+		static const std::vector<RenderTile> models = []()
+		{
+			std::vector<RenderTile> result;
+			for (int i = 0; i < CompactVoxelModels::NumModels; i++)
+			{
+				result.push_back(ExpandModel(i));
+			}
+			return result;
+		}();
+		return models;
+	}
+}
+
+uint16_t VoxelModels::Expand(int model, RenderTile& out)
+{
+	assert(model >= 0 && model < NumModels);
+	out = GetExpandedModels()[model];
+	return out.activeBlocks;
+}
+const RenderTile& VoxelModels::Get(int model)
+{
+	assert(model >= 0 && model < NumModels);
+	return GetExpandedModels()[model];
+}
+uint16_t VoxelModels::GetActiveBlocks(int model)
+{
+	assert(model >= 0 && model < NumModels);
+	return CompactVoxelModels::Models[model].activeBlocks;
+}
+Block VoxelModels::GetBlock(int model, int y, int x, int z)
+{
+	assert(model >= 0 && model < NumModels);
+	return GetExpandedModels()[model].subTile[y][x][z];
+}
+PathFindTile VoxelModels::GetPathTile(int model, int y, int x)
+{
+	assert(model >= 0 && model < NumModels);
+	return GetExpandedModels()[model].pathSubTiles[y][x];
+}
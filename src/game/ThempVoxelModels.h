@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include "ThempTileArrays.h"
+namespace Themp
+{
+	//The block/room models from the VoxelModels headers,
+	//stored as occupancy bits plus indices into small UV set and path tile palettes (CompactVoxelModels.h, generated by ConvertVoxelModels.py).
+	//Models are indexed with the Tile_ constants, they're expanded into Blocks once on first use and copied out from there when a tile gets (re)built.
+	class VoxelModels
+	{
+	public:
+		VoxelModels() = delete;
+		~VoxelModels() = delete;
+
+		static const int NumModels;
+
+		//fills in the whole RenderTile, returns the amount of active blocks
+		static uint16_t Expand(int model, RenderTile& out);
+		//the expanded model itself, for reading a few of its blocks without copying it
+		static const RenderTile& Get(int model);
+		static uint16_t GetActiveBlocks(int model);
+		static Block GetBlock(int model, int y, int x, int z);
+		static PathFindTile GetPathTile(int model, int y, int x);
+	};
+};
@@ -1,6 +1,8 @@
 #include "ThempSystem.h"
 #include "ThempVoxelObject.h"
+#include "ThempVoxelVertexPacking.h"
 #include "ThempLevelData.h"
+#include "ThempTileEvents.h"
 #include "ThempFileManager.h"
 #include "ThempResources.h"
 #include "../Library/imgui.h"
@@ -9,31 +11,40 @@
 #include "../Engine/ThempMaterial.h"
 #include "../Engine/ThempD3D.h"
 #include "../Engine/ThempFunctions.h"
+#include "../Engine/ThempWorkerPool.h"
+#include "../Engine/ThempFrustum.h"
+#include <algorithm>
+#include <cfloat>
 
 D3D11_INPUT_ELEMENT_DESC VoxelInputLayoutDesc[] =
 {
-	{ "POSITION" , 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "NORMAL" , 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "UV", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "VISIBLE", 0 ,DXGI_FORMAT_R32_FLOAT,0,32,D3D11_INPUT_PER_VERTEX_DATA,0},
-	{ "ANIMATE", 0 ,DXGI_FORMAT_R32_UINT,0,36,D3D11_INPUT_PER_VERTEX_DATA,0},
-	{ "LIGHTINDICES", 0 ,DXGI_FORMAT_R32G32B32A32_UINT,0,40,D3D11_INPUT_PER_VERTEX_DATA,0},
+	{ "POSITION" , 0, DXGI_FORMAT_R16G16B16A16_UINT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "UV", 0, DXGI_FORMAT_R16G16_UINT, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 };
 
 using namespace Themp;
 VoxelObject::~VoxelObject()
 {
+	m_Level->m_TileEvents.Unsubscribe(OnTileChanges, this);
 	if(m_Vertices)
 		delete[] m_Vertices;
 	if (m_Indices)
 		delete[] m_Indices;
-	if (m_Lights)
-		delete[] m_Lights;
+	for (size_t i = 0; i < m_MeshJobs.size(); i++)
+	{
+		delete[] m_MeshJobs[i].vertices;
+		delete[] m_MeshJobs[i].indices;
+	}
+	delete m_MeshPool;
 
 	CLEAN(m_IndexBuffer.buf);
 	CLEAN(m_VertexBuffer.buf);
 	CLEAN(m_LightBuffer.buf);
 	CLEAN(m_LightBuffer.srv);
+	CLEAN(m_LightCellBuffer.buf);
+	CLEAN(m_LightCellBuffer.srv);
+	CLEAN(m_LightIndexBuffer.buf);
+	CLEAN(m_LightIndexBuffer.srv);
 	
 }
 
@@ -55,158 +66,182 @@ VoxelObject::VoxelObject(LevelData* leveldata)
 
 	m_Vertices = new VoxelVertex[4]; 
 	m_Indices = new uint32_t[6];
-	m_Lights = new Light[UINT16_MAX];
 	m->m_Vertices = nullptr;
 	m->m_Indices = nullptr;
 
 	CreateVertexBuffer(m_Vertices, 4);
 	CreateIndexBuffer(m_Indices, 6);
-	CreateLightBuffer(LevelData::s_Lights);
+	CreateLightBuffers();
+	UploadLights();
 
 	m->m_VertexBuffer = m_VertexBuffer.buf;
 	m->m_IndexBuffer = m_IndexBuffer.buf;
-	m->m_VertexSize = sizeof(VoxelVertex);
-
-	m->m_Material = Resources::TRes->GetUniqueMaterial("", "voxel", VoxelInputLayoutDesc,6);
-
-	D3D::s_D3D->m_DevCon->VSSetShaderResources(8, 1, &m_LightBuffer.srv);
-	D3D::s_D3D->m_DevCon->PSSetShaderResources(8, 1, &m_LightBuffer.srv);
-
-	for (size_t z = 0; z < MAP_SIZE_HEIGHT; z++)
-	for (size_t y = 0; y < MAP_SIZE_SUBTILES_RENDER; y++)
-		for (size_t x = 0; x < MAP_SIZE_SUBTILES_RENDER; x++)
-		{
-			m_Level->m_BlockMap[z][y][x].active = true;
-			m_Level->m_BlockMap[z][y][x].randValue = rand();
-		}
+	m->m_VertexSize = sizeof(PackedVoxelVertex);
 
+	m->m_Material = Resources::TRes->GetUniqueMaterial("", "voxel", VoxelInputLayoutDesc,2);
+	m_MeshOutput = UploadMesh;
+	m_MeshOutputContext = this;
+	m_Level->m_TileEvents.Subscribe(OnTileChanges, this);
+}
+VoxelObject::VoxelObject(LevelData* leveldata, MeshOutputCallback output, void* outputContext)
+{
+	m_Level = leveldata;
+	m_MeshOutput = output;
+	m_MeshOutputContext = outputContext;
+	m_Level->m_TileEvents.Subscribe(OnTileChanges, this);
+}
+//everything the mesher looks at (types, owners, explored, dig marks) comes with a tile event, and a change can reach into the neighbouring chunks, so any of them means a new mesh
+void VoxelObject::OnTileChanges(void* context, const TileChange* changes, size_t count)
+{
+	((VoxelObject*)context)->m_MeshDirty = true;
 }
 void VoxelObject::Update(float dt)
 {
-	m_AnimationTime += dt;
-	if (m_AnimationTime >= 1.0f / 5.0f)
-	{
-		if (m_AnimationTime > (1.0f / 2.5f)) m_AnimationTime = 1.0f / 2.5f;
-		m_AnimationTime -= 1.0f / 5.0f;
-		m_AnimationIndex++;
-	}
+	//the animated faces run in the shader, the mesh only changes with the map
+	UploadLights();
 }
 
+bool VoxelObject::s_GreedyMeshing = false;
+bool VoxelObject::s_CoarseLod = true;
+float VoxelObject::s_LodScreenSize = 0.08f;
+int VoxelObject::s_MeshThreads = std::max(1, std::min((int)std::thread::hardware_concurrency(), 8));
+
 const float pixelSizeX = (1.0f / 256.0f) * 31.5f;
 const float pixelSizeY = (1.0f / 2176.0f) * 31.5f;
 
+//doAnimate for a face showing the first of these frames
+static uint32_t AnimatedFrames(const std::vector<XMFLOAT2>& frames)
+{
+	assert(frames.size() == 1 || frames.size() == 4 || frames.size() == 8);
+	if (frames.size() == 1) return 0;
+	return frames.size() == 4 ? VoxelObject::AnimateFrames | VoxelObject::AnimateFourFrames : VoxelObject::AnimateFrames;
+}
+
 //Z = 1
-void VoxelObject::DoVoxelBlockVisibleEdge(int y, int x,int yP, int xP, uint32_t& currentIndex, uint32_t& vIndex)
+void VoxelObject::DoVoxelBlockVisibleEdge(int y, int x,int yP, int xP, const BlockUVs& block, VoxelVertex* vertices, uint32_t* indices, uint32_t& currentIndex, uint32_t& vIndex)
 {
 	const Tile& tile = m_Level->s_Map.m_Tiles[yP][xP];
 	const int tileType = tile.GetType();
-	const uint32_t lights[4] = { m_Level->s_PerTileLights[tile.lightArrayIndex] , m_Level->s_PerTileLights[tile.lightArrayIndex + 1], m_Level->s_PerTileLights[tile.lightArrayIndex + 2], m_Level->s_PerTileLights[tile.lightArrayIndex + 3] };
+	const uint8_t faces = m_Level->m_BlockFaces[1][y][x];
 
 	if (tileType == Type_Earth || IsWall(tileType))
 	{
 		TileNeighbours neighbour = m_Level->CheckNeighbours(tileType, yP, xP);
 		uint16_t texIndex = TypeToTexture(tileType);
 		const std::vector<XMFLOAT2>& tex0 = BlockTextures[texIndex].edge[2];
-		int animIndex = m_AnimationIndex % tex0.size();
+		//the water running down the side is the first frame, the vertex shader flips through the rest
+		const uint32_t waterFrames = AnimatedFrames(tex0);
+		uint32_t anim0 = 0;
+		uint32_t anim1 = 0;
+		//the water and lava along the sides only go into the mesh, the tile's uvs keep what the level gave the block
+		XMFLOAT2 sideUV[2] = { block.uv[0], block.uv[1] };
 		if (neighbour.North == N_WATER)
 		{
-			m_Level->m_BlockMap[1][y][x].uv[1] = tex0[animIndex];
+			sideUV[1] = tex0[0];
+			anim1 = waterFrames;
 		}
 		else if (neighbour.North == N_LAVA)
 		{
-			m_Level->m_BlockMap[1][y][x].uv[1] = tex0[m_Level->m_BlockMap[1][y][x].randValue & 1];
+			sideUV[1] = tex0[LevelData::BlockSeed(1, y, x) & 1];
+			anim1 = 0;
 		}
 		if (neighbour.South == N_WATER)
 		{
-			m_Level->m_BlockMap[1][y][x].uv[1] = tex0[animIndex];
+			sideUV[1] = tex0[0];
+			anim1 = waterFrames;
 		}
 		else if (neighbour.South == N_LAVA)
 		{
-			m_Level->m_BlockMap[1][y][x].uv[1] = tex0[m_Level->m_BlockMap[1][y][x].randValue & 1];
+			sideUV[1] = tex0[LevelData::BlockSeed(1, y, x) & 1];
+			anim1 = 0;
 		}
 		if (neighbour.East == N_WATER)
 		{
-			m_Level->m_BlockMap[1][y][x].uv[0] = tex0[animIndex];
+			sideUV[0] = tex0[0];
+			anim0 = waterFrames;
 		}
 		else if (neighbour.East == N_LAVA)
 		{
-			m_Level->m_BlockMap[1][y][x].uv[1] = tex0[m_Level->m_BlockMap[1][y][x].randValue & 1];
+			sideUV[1] = tex0[LevelData::BlockSeed(1, y, x) & 1];
+			anim1 = 0;
 		}
 		if (neighbour.West == N_WATER)
 		{
-			m_Level->m_BlockMap[1][y][x].uv[0] = tex0[animIndex];
+			sideUV[0] = tex0[0];
+			anim0 = waterFrames;
 		}
 		else if (neighbour.West == N_LAVA)
 		{
-			m_Level->m_BlockMap[1][y][x].uv[1] = tex0[m_Level->m_BlockMap[1][y][x].randValue & 1];
+			sideUV[1] = tex0[LevelData::BlockSeed(1, y, x) & 1];
+			anim1 = 0;
 		}
 
-		XMFLOAT2 uv = m_Level->m_BlockMap[1][y][x].uv[0];
+		XMFLOAT2 uv = sideUV[0];
 		uv.x = uv.x / 8.0f;
 		uv.y = uv.y / 68.0f;
-		if (!m_Level->m_BlockMap[1][y][x + 1].active) // right
+		if (faces & LevelData::Face_Right) // right
 		{
-			m_Indices[currentIndex + 0] = vIndex + 2;
-			m_Indices[currentIndex + 1] = vIndex + 1;
-			m_Indices[currentIndex + 2] = vIndex + 0;
-			m_Indices[currentIndex + 3] = vIndex + 3;
-			m_Indices[currentIndex + 4] = vIndex + 2;
-			m_Indices[currentIndex + 5] = vIndex + 0;
+			indices[currentIndex + 0] = vIndex + 2;
+			indices[currentIndex + 1] = vIndex + 1;
+			indices[currentIndex + 2] = vIndex + 0;
+			indices[currentIndex + 3] = vIndex + 3;
+			indices[currentIndex + 4] = vIndex + 2;
+			indices[currentIndex + 5] = vIndex + 0;
 			currentIndex += 6;
 
-			m_Vertices[vIndex++] = { x + 0.5f, 1.0f + 0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y				,  1,0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x + 0.5f, 1.0f - 0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y + pixelSizeY	,  1,0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x + 0.5f, 1.0f - 0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	,  1,0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x + 0.5f, 1.0f + 0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y				,  1,0 ,lights[0],lights[1],lights[2],lights[3] };
+			vertices[vIndex++] = { x + 0.5f, 1.0f + 0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y				,  1,anim0 };
+			vertices[vIndex++] = { x + 0.5f, 1.0f - 0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y + pixelSizeY	,  1,anim0 };
+			vertices[vIndex++] = { x + 0.5f, 1.0f - 0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	,  1,anim0 };
+			vertices[vIndex++] = { x + 0.5f, 1.0f + 0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y				,  1,anim0 };
 
 		}
-		if (!m_Level->m_BlockMap[1][y][x - 1].active) // left
+		if (faces & LevelData::Face_Left) // left
 		{
-			m_Indices[currentIndex + 0] = vIndex + 2;
-			m_Indices[currentIndex + 1] = vIndex + 1;
-			m_Indices[currentIndex + 2] = vIndex + 0;
-			m_Indices[currentIndex + 3] = vIndex + 3;
-			m_Indices[currentIndex + 4] = vIndex + 2;
-			m_Indices[currentIndex + 5] = vIndex + 0;
+			indices[currentIndex + 0] = vIndex + 2;
+			indices[currentIndex + 1] = vIndex + 1;
+			indices[currentIndex + 2] = vIndex + 0;
+			indices[currentIndex + 3] = vIndex + 3;
+			indices[currentIndex + 4] = vIndex + 2;
+			indices[currentIndex + 5] = vIndex + 0;
 			currentIndex += 6;
 
-			m_Vertices[vIndex++] = { x - 0.5f, 1.0f + 0.5f, y - 0.5f  , 1,0,0, uv.x					,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f, 1.0f + 0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f, 1.0f - 0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f, 1.0f - 0.5f, y - 0.5f  , 1,0,0, uv.x					,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
+			vertices[vIndex++] = { x - 0.5f, 1.0f + 0.5f, y - 0.5f  , 1,0,0, uv.x					,uv.y				, 1, anim0 };
+			vertices[vIndex++] = { x - 0.5f, 1.0f + 0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y				, 1, anim0 };
+			vertices[vIndex++] = { x - 0.5f, 1.0f - 0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, anim0 };
+			vertices[vIndex++] = { x - 0.5f, 1.0f - 0.5f, y - 0.5f  , 1,0,0, uv.x					,uv.y + pixelSizeY	, 1, anim0 };
 		}
-		uv = m_Level->m_BlockMap[1][y][x].uv[1];
+		uv = sideUV[1];
 		uv.x = uv.x / 8.0f;
 		uv.y = uv.y / 68.0f;
-		if (!m_Level->m_BlockMap[1][y - 1][x].active) // back
+		if (faces & LevelData::Face_Back) // back
 		{
-			m_Indices[currentIndex + 0] = vIndex + 2;
-			m_Indices[currentIndex + 1] = vIndex + 1;
-			m_Indices[currentIndex + 2] = vIndex + 0;
-			m_Indices[currentIndex + 3] = vIndex + 3;
-			m_Indices[currentIndex + 4] = vIndex + 2;
-			m_Indices[currentIndex + 5] = vIndex + 0;
+			indices[currentIndex + 0] = vIndex + 2;
+			indices[currentIndex + 1] = vIndex + 1;
+			indices[currentIndex + 2] = vIndex + 0;
+			indices[currentIndex + 3] = vIndex + 3;
+			indices[currentIndex + 4] = vIndex + 2;
+			indices[currentIndex + 5] = vIndex + 0;
 			currentIndex += 6;
 
-			m_Vertices[vIndex++] = { x + 0.5f ,  1.0f - 0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x + 0.5f ,  1.0f + 0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f ,  1.0f + 0.5f  , y - 0.5f , 0,0,1, uv.x				,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f ,  1.0f - 0.5f  , y - 0.5f , 0,0,1, uv.x				,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
+			vertices[vIndex++] = { x + 0.5f ,  1.0f - 0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, anim1 };
+			vertices[vIndex++] = { x + 0.5f ,  1.0f + 0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				, 1, anim1 };
+			vertices[vIndex++] = { x - 0.5f ,  1.0f + 0.5f  , y - 0.5f , 0,0,1, uv.x				,uv.y				, 1, anim1 };
+			vertices[vIndex++] = { x - 0.5f ,  1.0f - 0.5f  , y - 0.5f , 0,0,1, uv.x				,uv.y + pixelSizeY	, 1, anim1 };
 		}
-		if (!m_Level->m_BlockMap[1][y + 1][x].active) // front
+		if (faces & LevelData::Face_Front) // front
 		{
-			m_Indices[currentIndex + 0] = vIndex + 0;
-			m_Indices[currentIndex + 1] = vIndex + 1;
-			m_Indices[currentIndex + 2] = vIndex + 2;
-			m_Indices[currentIndex + 3] = vIndex + 0;
-			m_Indices[currentIndex + 4] = vIndex + 2;
-			m_Indices[currentIndex + 5] = vIndex + 3;
+			indices[currentIndex + 0] = vIndex + 0;
+			indices[currentIndex + 1] = vIndex + 1;
+			indices[currentIndex + 2] = vIndex + 2;
+			indices[currentIndex + 3] = vIndex + 0;
+			indices[currentIndex + 4] = vIndex + 2;
+			indices[currentIndex + 5] = vIndex + 3;
 			currentIndex += 6;
 
-			m_Vertices[vIndex++] = { x + 0.5f  , 1.0f - 0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x + 0.5f  , 1.0f + 0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f  , 1.0f + 0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f  , 1.0f - 0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
+			vertices[vIndex++] = { x + 0.5f  , 1.0f - 0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, anim1 };
+			vertices[vIndex++] = { x + 0.5f  , 1.0f + 0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				, 1, anim1 };
+			vertices[vIndex++] = { x - 0.5f  , 1.0f + 0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y				, 1, anim1 };
+			vertices[vIndex++] = { x - 0.5f  , 1.0f - 0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y + pixelSizeY	, 1, anim1 };
 		}
 	}
 	else
@@ -215,418 +250,340 @@ void VoxelObject::DoVoxelBlockVisibleEdge(int y, int x,int yP, int xP, uint32_t&
 		assert(y <= 254);
 		assert(x >= 0);
 		assert(y >= 0);
-		if (m_Level->m_BlockMap[1][y][x].active)
+		if (m_Level->IsBlockActive(1, y, x))
 		{
-			XMFLOAT2 uv = m_Level->m_BlockMap[1][y][x].uv[0];
+			XMFLOAT2 uv = block.uv[0];
 			uv.x = uv.x / 8.0;
 			uv.y = uv.y / 68.0;
-			if (x + 1 >= MAP_SIZE_SUBTILES_RENDER || !m_Level->m_BlockMap[1][y][x + 1].active) // right
+			if (faces & LevelData::Face_Right) // right
 			{
-				m_Indices[currentIndex + 0] = vIndex + 2;
-				m_Indices[currentIndex + 1] = vIndex + 1;
-				m_Indices[currentIndex + 2] = vIndex + 0;
-				m_Indices[currentIndex + 3] = vIndex + 3;
-				m_Indices[currentIndex + 4] = vIndex + 2;
-				m_Indices[currentIndex + 5] = vIndex + 0;
+				indices[currentIndex + 0] = vIndex + 2;
+				indices[currentIndex + 1] = vIndex + 1;
+				indices[currentIndex + 2] = vIndex + 0;
+				indices[currentIndex + 3] = vIndex + 3;
+				indices[currentIndex + 4] = vIndex + 2;
+				indices[currentIndex + 5] = vIndex + 0;
 				currentIndex += 6;
 
-				m_Vertices[vIndex++] = { x + 0.5f, 1 + 0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x + 0.5f, 1 - 0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x + 0.5f, 1 - 0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x + 0.5f, 1 + 0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
+				vertices[vIndex++] = { x + 0.5f, 1 + 0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y				, 1, 0 };
+				vertices[vIndex++] = { x + 0.5f, 1 - 0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y + pixelSizeY	, 1, 0 };
+				vertices[vIndex++] = { x + 0.5f, 1 - 0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 };
+				vertices[vIndex++] = { x + 0.5f, 1 + 0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y				, 1, 0 };
 
 			}
-			if (x - 1 <= 0 || !m_Level->m_BlockMap[1][y][x - 1].active) // left
+			if (faces & LevelData::Face_Left) // left
 			{
-				m_Indices[currentIndex + 0] = vIndex + 2;
-				m_Indices[currentIndex + 1] = vIndex + 1;
-				m_Indices[currentIndex + 2] = vIndex + 0;
-				m_Indices[currentIndex + 3] = vIndex + 3;
-				m_Indices[currentIndex + 4] = vIndex + 2;
-				m_Indices[currentIndex + 5] = vIndex + 0;
+				indices[currentIndex + 0] = vIndex + 2;
+				indices[currentIndex + 1] = vIndex + 1;
+				indices[currentIndex + 2] = vIndex + 0;
+				indices[currentIndex + 3] = vIndex + 3;
+				indices[currentIndex + 4] = vIndex + 2;
+				indices[currentIndex + 5] = vIndex + 0;
 				currentIndex += 6;
 
-				m_Vertices[vIndex++] = { x - 0.5f, 1 + 0.5f, y - 0.5f  , 1,0,0, uv.x				,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f, 1 + 0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f, 1 - 0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f, 1 - 0.5f, y - 0.5f  , 1,0,0, uv.x				,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
+				vertices[vIndex++] = { x - 0.5f, 1 + 0.5f, y - 0.5f  , 1,0,0, uv.x				,uv.y				, 1, 0 };
+				vertices[vIndex++] = { x - 0.5f, 1 + 0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y				, 1, 0 };
+				vertices[vIndex++] = { x - 0.5f, 1 - 0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 };
+				vertices[vIndex++] = { x - 0.5f, 1 - 0.5f, y - 0.5f  , 1,0,0, uv.x				,uv.y + pixelSizeY	, 1, 0 };
 			}
-			uv = m_Level->m_BlockMap[1][y][x].uv[1];
+			uv = block.uv[1];
 			uv.x = uv.x / 8.0f;
 			uv.y = uv.y / 68.0f;
-			if (y - 1 <= 0 || !m_Level->m_BlockMap[1][y - 1][x].active) // back
+			if (faces & LevelData::Face_Back) // back
 			{
-				m_Indices[currentIndex + 0] = vIndex + 2;
-				m_Indices[currentIndex + 1] = vIndex + 1;
-				m_Indices[currentIndex + 2] = vIndex + 0;
-				m_Indices[currentIndex + 3] = vIndex + 3;
-				m_Indices[currentIndex + 4] = vIndex + 2;
-				m_Indices[currentIndex + 5] = vIndex + 0;
+				indices[currentIndex + 0] = vIndex + 2;
+				indices[currentIndex + 1] = vIndex + 1;
+				indices[currentIndex + 2] = vIndex + 0;
+				indices[currentIndex + 3] = vIndex + 3;
+				indices[currentIndex + 4] = vIndex + 2;
+				indices[currentIndex + 5] = vIndex + 0;
 				currentIndex += 6;
 
-				m_Vertices[vIndex++] = { x + 0.5f ,  1 - 0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1,0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x + 0.5f ,  1 + 0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				, 1,0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f ,  1 + 0.5f  , y - 0.5f , 0,0,1, uv.x					,uv.y				, 1,0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f ,  1 - 0.5f  , y - 0.5f , 0,0,1, uv.x					,uv.y + pixelSizeY	, 1,0 ,lights[0],lights[1],lights[2],lights[3] };
+				vertices[vIndex++] = { x + 0.5f ,  1 - 0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1,0 };
+				vertices[vIndex++] = { x + 0.5f ,  1 + 0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				, 1,0 };
+				vertices[vIndex++] = { x - 0.5f ,  1 + 0.5f  , y - 0.5f , 0,0,1, uv.x					,uv.y				, 1,0 };
+				vertices[vIndex++] = { x - 0.5f ,  1 - 0.5f  , y - 0.5f , 0,0,1, uv.x					,uv.y + pixelSizeY	, 1,0 };
 			}
-			if (y + 1 >= MAP_SIZE_SUBTILES_RENDER || !m_Level->m_BlockMap[1][y + 1][x].active) // front
+			if (faces & LevelData::Face_Front) // front
 			{
-				m_Indices[currentIndex + 0] = vIndex + 0;
-				m_Indices[currentIndex + 1] = vIndex + 1;
-				m_Indices[currentIndex + 2] = vIndex + 2;
-				m_Indices[currentIndex + 3] = vIndex + 0;
-				m_Indices[currentIndex + 4] = vIndex + 2;
-				m_Indices[currentIndex + 5] = vIndex + 3;
+				indices[currentIndex + 0] = vIndex + 0;
+				indices[currentIndex + 1] = vIndex + 1;
+				indices[currentIndex + 2] = vIndex + 2;
+				indices[currentIndex + 3] = vIndex + 0;
+				indices[currentIndex + 4] = vIndex + 2;
+				indices[currentIndex + 5] = vIndex + 3;
 				currentIndex += 6;
 
-				m_Vertices[vIndex++] = { x + 0.5f  , 1 - 0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x + 0.5f  , 1 + 0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f  , 1 + 0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f  , 1 - 0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
+				vertices[vIndex++] = { x + 0.5f  , 1 - 0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 };
+				vertices[vIndex++] = { x + 0.5f  , 1 + 0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				, 1, 0 };
+				vertices[vIndex++] = { x - 0.5f  , 1 + 0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y				, 1, 0 };
+				vertices[vIndex++] = { x - 0.5f  , 1 - 0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y + pixelSizeY	, 1, 0 };
 			}
-			uv = m_Level->m_BlockMap[1][y][x].uv[2];
+			uv = block.uv[2];
 			uv.x = uv.x / 8.0f;
 			uv.y = uv.y / 68.0f;
-			if (!m_Level->m_BlockMap[0][y][x].active) // bottom
+			if (faces & LevelData::Face_Bottom) // bottom
 			{
-				m_Indices[currentIndex + 0] = vIndex + 2;
-				m_Indices[currentIndex + 1] = vIndex + 1;
-				m_Indices[currentIndex + 2] = vIndex + 0;
-				m_Indices[currentIndex + 3] = vIndex + 3;
-				m_Indices[currentIndex + 4] = vIndex + 2;
-				m_Indices[currentIndex + 5] = vIndex + 0;
+				indices[currentIndex + 0] = vIndex + 2;
+				indices[currentIndex + 1] = vIndex + 1;
+				indices[currentIndex + 2] = vIndex + 0;
+				indices[currentIndex + 3] = vIndex + 3;
+				indices[currentIndex + 4] = vIndex + 2;
+				indices[currentIndex + 5] = vIndex + 0;
 				currentIndex += 6;
 
-				m_Vertices[vIndex++] = { x - 0.5f , 1 - 0.5f ,  y + 0.5f  , 0,1,0, uv.x					,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x + 0.5f , 1 - 0.5f ,  y + 0.5f  , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x + 0.5f , 1 - 0.5f ,  y - 0.5f  , 0,1,0, uv.x + pixelSizeX	,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f , 1 - 0.5f ,  y - 0.5f  , 0,1,0, uv.x					,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
+				vertices[vIndex++] = { x - 0.5f , 1 - 0.5f ,  y + 0.5f  , 0,1,0, uv.x					,uv.y + pixelSizeY	, 1, 0 };
+				vertices[vIndex++] = { x + 0.5f , 1 - 0.5f ,  y + 0.5f  , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 };
+				vertices[vIndex++] = { x + 0.5f , 1 - 0.5f ,  y - 0.5f  , 0,1,0, uv.x + pixelSizeX	,uv.y				, 1, 0 };
+				vertices[vIndex++] = { x - 0.5f , 1 - 0.5f ,  y - 0.5f  , 0,1,0, uv.x					,uv.y				, 1, 0 };
 			}
-			if (!m_Level->m_BlockMap[2][y][x].active) // top
+			if (faces & LevelData::Face_Top) // top
 			{
-				m_Indices[currentIndex + 0] = vIndex + 2;
-				m_Indices[currentIndex + 1] = vIndex + 1;
-				m_Indices[currentIndex + 2] = vIndex + 0;
-				m_Indices[currentIndex + 3] = vIndex + 3;
-				m_Indices[currentIndex + 4] = vIndex + 2;
-				m_Indices[currentIndex + 5] = vIndex + 0;
+				indices[currentIndex + 0] = vIndex + 2;
+				indices[currentIndex + 1] = vIndex + 1;
+				indices[currentIndex + 2] = vIndex + 0;
+				indices[currentIndex + 3] = vIndex + 3;
+				indices[currentIndex + 4] = vIndex + 2;
+				indices[currentIndex + 5] = vIndex + 0;
 				currentIndex += 6;
 
-				m_Vertices[vIndex++] = { x + 0.5f, 1 + 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,	uv.y				,  1,0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x + 0.5f, 1 + 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX		,uv.y + pixelSizeY	,  1,0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f, 1 + 0.5f ,  y + 0.5f , 0,1,0, uv.x					,uv.y + pixelSizeY	,  1,0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f, 1 + 0.5f ,  y - 0.5f , 0,1,0, uv.x					,uv.y				,  1,0 ,lights[0],lights[1],lights[2],lights[3] };
+				vertices[vIndex++] = { x + 0.5f, 1 + 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,	uv.y				,  1,0 };
+				vertices[vIndex++] = { x + 0.5f, 1 + 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX		,uv.y + pixelSizeY	,  1,0 };
+				vertices[vIndex++] = { x - 0.5f, 1 + 0.5f ,  y + 0.5f , 0,1,0, uv.x					,uv.y + pixelSizeY	,  1,0 };
+				vertices[vIndex++] = { x - 0.5f, 1 + 0.5f ,  y - 0.5f , 0,1,0, uv.x					,uv.y				,  1,0 };
 			}
 		}
 	}
 }
 //Z = 0
-void VoxelObject::DoVoxelBlockVisibleAnimated(int y, int x,uint32_t& currentIndex, uint32_t& vIndex)
+void VoxelObject::DoVoxelBlockVisibleAnimated(int y, int x, const BlockUVs& block, VoxelVertex* vertices, uint32_t* indices, uint32_t& currentIndex, uint32_t& vIndex)
 {
 	const int yP = (int)floor((float)y / 3.0f);
 	const int xP = (int)floor((float)x / 3.0f);
 	const Tile& tile = m_Level->s_Map.m_Tiles[yP][xP];
 	const int tileType = tile.GetType();
-	const uint32_t lights[4] = { m_Level->s_PerTileLights[tile.lightArrayIndex] , m_Level->s_PerTileLights[tile.lightArrayIndex + 1], m_Level->s_PerTileLights[tile.lightArrayIndex + 2], m_Level->s_PerTileLights[tile.lightArrayIndex + 3] };
+	const uint8_t faces = m_Level->m_BlockFaces[0][y][x];
 
-	XMFLOAT2 uv = m_Level->m_BlockMap[0][y][x].uv[0];
+	XMFLOAT2 uv = block.uv[0];
 	uv.x = uv.x / 8.0;
 	uv.y = uv.y / 68.0;
-	if (x + 1 >= MAP_SIZE_SUBTILES_RENDER || !m_Level->m_BlockMap[0][y][x + 1].active) // right
+	if (faces & LevelData::Face_Right) // right
 	{
-		m_Indices[currentIndex + 0] = vIndex + 2;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 0;
-		m_Indices[currentIndex + 3] = vIndex + 3;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 0;
+		indices[currentIndex + 0] = vIndex + 2;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 0;
+		indices[currentIndex + 3] = vIndex + 3;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 0;
 		currentIndex += 6;
 
-		m_Vertices[vIndex++] = { x + 0.5f,+0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f,-0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f,-0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f,+0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
+		vertices[vIndex++] = { x + 0.5f,+0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y				, 1, 0 };
+		vertices[vIndex++] = { x + 0.5f,-0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y + pixelSizeY	, 1, 0 };
+		vertices[vIndex++] = { x + 0.5f,-0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 };
+		vertices[vIndex++] = { x + 0.5f,+0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y				, 1, 0 };
 
 	}
-	if (x - 1 <= 0 || !m_Level->m_BlockMap[0][y][x - 1].active) // left
+	if (faces & LevelData::Face_Left) // left
 	{
-		m_Indices[currentIndex + 0] = vIndex + 2;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 0;
-		m_Indices[currentIndex + 3] = vIndex + 3;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 0;
+		indices[currentIndex + 0] = vIndex + 2;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 0;
+		indices[currentIndex + 3] = vIndex + 3;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 0;
 		currentIndex += 6;
 
-		m_Vertices[vIndex++] = { x - 0.5f,+0.5f, y - 0.5f  , 1,0,0, uv.x				,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f,+0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f,-0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f,-0.5f, y - 0.5f  , 1,0,0, uv.x				,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
+		vertices[vIndex++] = { x - 0.5f,+0.5f, y - 0.5f  , 1,0,0, uv.x				,uv.y				, 1, 0 };
+		vertices[vIndex++] = { x - 0.5f,+0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y				, 1, 0 };
+		vertices[vIndex++] = { x - 0.5f,-0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 };
+		vertices[vIndex++] = { x - 0.5f,-0.5f, y - 0.5f  , 1,0,0, uv.x				,uv.y + pixelSizeY	, 1, 0 };
 	}
-	uv = m_Level->m_BlockMap[0][y][x].uv[1];
+	uv = block.uv[1];
 	uv.x = uv.x / 8.0;
 	uv.y = uv.y / 68.0;
-	if (y - 1 <= 0 || !m_Level->m_BlockMap[0][y - 1][x].active) // back
+	if (faces & LevelData::Face_Back) // back
 	{
-		m_Indices[currentIndex + 0] = vIndex + 2;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 0;
-		m_Indices[currentIndex + 3] = vIndex + 3;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 0;
+		indices[currentIndex + 0] = vIndex + 2;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 0;
+		indices[currentIndex + 3] = vIndex + 3;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 0;
 		currentIndex += 6;
 
-		m_Vertices[vIndex++] = { x + 0.5f ,-0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f ,+0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f ,+0.5f  , y - 0.5f , 0,0,1, uv.x				,uv.y				, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f ,-0.5f  , y - 0.5f , 0,0,1, uv.x				,uv.y + pixelSizeY	, 1, 0 ,lights[0],lights[1],lights[2],lights[3] };
+		vertices[vIndex++] = { x + 0.5f ,-0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, 0 };
+		vertices[vIndex++] = { x + 0.5f ,+0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				, 1, 0 };
+		vertices[vIndex++] = { x - 0.5f ,+0.5f  , y - 0.5f , 0,0,1, uv.x				,uv.y				, 1, 0 };
+		vertices[vIndex++] = { x - 0.5f ,-0.5f  , y - 0.5f , 0,0,1, uv.x				,uv.y + pixelSizeY	, 1, 0 };
 	}
-	if (y + 1 >= MAP_SIZE_SUBTILES_RENDER || !m_Level->m_BlockMap[0][y + 1][x].active) // front
+	if (faces & LevelData::Face_Front) // front
 	{
-		m_Indices[currentIndex + 0] = vIndex + 0;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 2;
-		m_Indices[currentIndex + 3] = vIndex + 0;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 3;
+		indices[currentIndex + 0] = vIndex + 0;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 2;
+		indices[currentIndex + 3] = vIndex + 0;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 3;
 		currentIndex += 6;
 
-		m_Vertices[vIndex++] = { x + 0.5f  ,-0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	,  1,0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f  ,+0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				,  1,0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f  ,+0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y				,  1,0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f  ,-0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y + pixelSizeY	,  1,0 ,lights[0],lights[1],lights[2],lights[3] };
+		vertices[vIndex++] = { x + 0.5f  ,-0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	,  1,0 };
+		vertices[vIndex++] = { x + 0.5f  ,+0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				,  1,0 };
+		vertices[vIndex++] = { x - 0.5f  ,+0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y				,  1,0 };
+		vertices[vIndex++] = { x - 0.5f  ,-0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y + pixelSizeY	,  1,0 };
 	}
-	uv = m_Level->m_BlockMap[0][y][x].uv[2];
+	uv = block.uv[2];
 	uv.x = uv.x / 8.0;
 	uv.y = uv.y / 68.0;
-	if (!m_Level->m_BlockMap[1][y][x].active) // top
+	//water and lava surfaces are in the LiquidLayer, they're animated there without touching this mesh
+	if ((faces & LevelData::Face_Top) && tileType != Type_Water && tileType != Type_Lava) // top
 	{
-		m_Indices[currentIndex + 0] = vIndex + 2;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 0;
-		m_Indices[currentIndex + 3] = vIndex + 3;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 0;
+		indices[currentIndex + 0] = vIndex + 2;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 0;
+		indices[currentIndex + 3] = vIndex + 3;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 0;
 		currentIndex += 6;
 
-
-
-		if (tileType == Type_Water || tileType == Type_Lava)
-		{
-			uint16_t texIndex = TypeToTexture(tileType);
-			const std::vector<XMFLOAT2>& tex0 = BlockTextures[texIndex].top[0];
-			int animIndex = m_AnimationIndex % tex0.size();
-			uv = tex0[animIndex];
-			uv.x = uv.x / 8.0;
-			uv.y = uv.y / 68.0;
-
-			bool cornerQuad = false;
-			uint32_t useAnimNorth = 1;
-			uint32_t useAnimWest = 1;
-			uint32_t useAnimSouth = 1;
-			uint32_t useAnimEast = 1;
-			const int xMod = x % 3;
-			const int yMod = y % 3;
-			TileNeighbours neighbour = m_Level->CheckNeighbours(tileType, yP, xP);
-			if (neighbour.North != N_SAME && yMod == 2)
-			{
-				useAnimNorth = 0;
-			}
-			else if (neighbour.South != N_SAME && yMod == 0)
-			{
-				useAnimSouth = 0;
-			}
-			if (neighbour.East != N_SAME && xMod == 2)
-			{
-				useAnimEast = 0;
-			}
-			else if (neighbour.West != N_SAME && xMod == 0)
-			{
-				useAnimWest = 0;
-			}
-			if (xMod == 0 && yMod == 2 && neighbour.North == N_SAME && neighbour.West == N_SAME)
-			{
-				if (neighbour.NorthWest != N_SAME)
-				{
-					useAnimNorth = 0;
-					useAnimWest = 0;
-					cornerQuad = true;
-				}
-			}
-			else if (xMod == 2 && yMod == 2 && neighbour.North == N_SAME && neighbour.East == N_SAME)
-			{
-				if (neighbour.NorthEast != N_SAME)
-				{
-					useAnimNorth = 0;
-					useAnimEast = 0;
-					cornerQuad = true;
-				}
-			}
-			else if (xMod == 0 && yMod == 0 && neighbour.South == N_SAME && neighbour.West == N_SAME)
-			{
-				if (neighbour.SouthWest != N_SAME)
-				{
-					useAnimSouth = 0;
-					useAnimWest = 0;
-					cornerQuad = true;
-				}
-			}
-			else if (xMod == 2 && yMod == 0 && neighbour.South == N_SAME && neighbour.East == N_SAME)
-			{
-				if (neighbour.SouthEast != N_SAME)
-				{
-					useAnimSouth = 0;
-					useAnimEast = 0;
-					cornerQuad = true;
-				}
-			}
-
-			if (cornerQuad)
-			{
-				m_Vertices[vIndex++] = { x + 0.5f, 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y				,  1,(useAnimEast || useAnimSouth) ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x + 0.5f, 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	,  1,(useAnimEast || useAnimNorth) ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f, 0.5f ,  y + 0.5f , 0,1,0, uv.x				,uv.y + pixelSizeY	,  1,(useAnimWest || useAnimNorth) ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f, 0.5f ,  y - 0.5f , 0,1,0, uv.x				,uv.y				,  1,(useAnimWest || useAnimSouth) ,lights[0],lights[1],lights[2],lights[3] };
-			}
-			else
-			{
-				m_Vertices[vIndex++] = { x + 0.5f, 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y				, 1, (useAnimEast && useAnimSouth) ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x + 0.5f, 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1, (useAnimEast && useAnimNorth) ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f, 0.5f ,  y + 0.5f , 0,1,0, uv.x				,uv.y + pixelSizeY	, 1, (useAnimWest && useAnimNorth) ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f, 0.5f ,  y - 0.5f , 0,1,0, uv.x				,uv.y				, 1, (useAnimWest && useAnimSouth) ,lights[0],lights[1],lights[2],lights[3] };
-			}
-		}
-		else
-		{
-			m_Vertices[vIndex++] = { x + 0.5f, 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX		,uv.y				,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x + 0.5f, 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX		,uv.y + pixelSizeY	,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f, 0.5f ,  y + 0.5f , 0,1,0, uv.x					,uv.y + pixelSizeY	,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f, 0.5f ,  y - 0.5f , 0,1,0, uv.x					,uv.y				,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		}
+		vertices[vIndex++] = { x + 0.5f, 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX		,uv.y				,  1, 0 };
+		vertices[vIndex++] = { x + 0.5f, 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX		,uv.y + pixelSizeY	,  1, 0 };
+		vertices[vIndex++] = { x - 0.5f, 0.5f ,  y + 0.5f , 0,1,0, uv.x					,uv.y + pixelSizeY	,  1, 0 };
+		vertices[vIndex++] = { x - 0.5f, 0.5f ,  y - 0.5f , 0,1,0, uv.x					,uv.y				,  1, 0 };
 	}
 }
-//Z = 2 to 8
-void VoxelObject::DoVoxelBlockVisible(int z, int y, int x, int yP, int xP, uint32_t& currentIndex, uint32_t& vIndex)
+//What a block at z 2 and up is drawn with. Gold and gems sparkle, they aren't in the tile's uvs and get their first frame here
+//instead, so the mesher never has to write into the level (the mesh threads and the coarse chunks read it at the same time).
+void VoxelObject::GetBlockUVs(const BlockUVs& block, int z, int y, int x, XMFLOAT2 uv[3], uint32_t anim[3]) const
 {
-	const Tile& tile = m_Level->s_Map.m_Tiles[yP][xP];
+	const Tile& tile = m_Level->s_Map.m_Tiles[y / 3][x / 3];
 	const int tileType = tile.GetType();
-	const uint32_t lights[4] = { m_Level->s_PerTileLights[tile.lightArrayIndex] , m_Level->s_PerTileLights[tile.lightArrayIndex + 1], m_Level->s_PerTileLights[tile.lightArrayIndex + 2], m_Level->s_PerTileLights[tile.lightArrayIndex + 3] };
+	for (int i = 0; i < 3; i++)
+	{
+		uv[i] = block.uv[i];
+		anim[i] = 0;
+	}
+	if (tileType != Type_Gold && tileType != Type_Gem) return;
 
-	if (tileType == Type_Gold || tileType == Type_Gem)
+	const uint16_t texIndex = TypeToTexture(tileType);
+	const std::vector<XMFLOAT2>& tex0 = BlockTextures[texIndex].top[LevelData::BlockSeed(z, y, x) % BlockTextures[texIndex].top.size()];
+	uv[0] = uv[1] = tex0[0];
+	anim[0] = anim[1] = AnimatedFrames(tex0);
+	if (z == 5)
 	{
-		uint16_t texIndex = TypeToTexture(tileType);
+		const std::vector<XMFLOAT2>& tex1 = tile.marked[Owner_PlayerRed] ? BlockTextures[7].top[1] : BlockTextures[texIndex].top[LevelData::BlockSeed(1, y, x) % BlockTextures[texIndex].top.size()];
+		uv[2] = tex1[0];
+		anim[2] = AnimatedFrames(tex1);
+	}
+}
 
-		const std::vector<XMFLOAT2>& tex0 = BlockTextures[texIndex].top[m_Level->m_BlockMap[z][y][x].randValue % BlockTextures[texIndex].top.size()];
-		m_Level->m_BlockMap[z][y][x].uv[0] = tex0[m_AnimationIndex % tex0.size()];
-		m_Level->m_BlockMap[z][y][x].uv[1] = tex0[m_AnimationIndex % tex0.size()];
+//Z = 2 to 8
+void VoxelObject::DoVoxelBlockVisible(int z, int y, int x, int yP, int xP, const BlockUVs& block, VoxelVertex* vertices, uint32_t* indices, uint32_t& currentIndex, uint32_t& vIndex)
+{
+	const Tile& tile = m_Level->s_Map.m_Tiles[yP][xP];
+	const int tileType = tile.GetType();
+	const uint8_t faces = m_Level->m_BlockFaces[z][y][x];
 
-		if (z == 5)
-		{
-			if (tile.marked[Owner_PlayerRed])
-			{
-				const std::vector<XMFLOAT2>& tex0 = BlockTextures[7].top[1];
-				m_Level->m_BlockMap[5][y][x].uv[2] = tex0[m_AnimationIndex % tex0.size()];
-			}
-			else
-			{
-				const std::vector<XMFLOAT2>& tex0 = BlockTextures[texIndex].top[m_Level->m_BlockMap[1][y][x].randValue % BlockTextures[texIndex].top.size()];
-				m_Level->m_BlockMap[5][y][x].uv[2] = tex0[m_AnimationIndex % tex0.size()];
-			}
-		}
-	}
+	//the sparkling gold and the dig marks are stored as their first frame, the vertex shader flips through the rest
+	XMFLOAT2 blockUV[3];
+	uint32_t anim[3];
+	GetBlockUVs(block, z, y, x, blockUV, anim);
+	const uint32_t anim0 = anim[0];
+	const uint32_t anim1 = anim[1];
+	uint32_t anim2 = anim[2];
 
-	XMFLOAT2 uv = m_Level->m_BlockMap[z][y][x].uv[0];
+	XMFLOAT2 uv = blockUV[0];
 	uv.x = uv.x / 8.0;
 	uv.y = uv.y / 68.0;
-	if (x + 1 >= MAP_SIZE_SUBTILES_RENDER || !m_Level->m_BlockMap[z][y][x + 1].active) // right
+	if (faces & LevelData::Face_Right) // right
 	{
-		m_Indices[currentIndex + 0] = vIndex + 2;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 0;
-		m_Indices[currentIndex + 3] = vIndex + 3;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 0;
+		indices[currentIndex + 0] = vIndex + 2;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 0;
+		indices[currentIndex + 3] = vIndex + 3;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 0;
 		currentIndex += 6;
 
-		m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y,					1, 0,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f, z - 0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y + pixelSizeY,		1, 0,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f, z - 0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY,		1, 0,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y,					1, 0,lights[0],lights[1],lights[2],lights[3] };
+		vertices[vIndex++] = { x + 0.5f, z + 0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y,					1, anim0 };
+		vertices[vIndex++] = { x + 0.5f, z - 0.5f  , y - 0.5f  , 1,0,0, uv.x				,uv.y + pixelSizeY,		1, anim0 };
+		vertices[vIndex++] = { x + 0.5f, z - 0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY,		1, anim0 };
+		vertices[vIndex++] = { x + 0.5f, z + 0.5f  , y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y,					1, anim0 };
 
 	}
-	if (x - 1 <= 0 || !m_Level->m_BlockMap[z][y][x - 1].active) // left
+	if (faces & LevelData::Face_Left) // left
 	{
-		m_Indices[currentIndex + 0] = vIndex + 2;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 0;
-		m_Indices[currentIndex + 3] = vIndex + 3;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 0;
+		indices[currentIndex + 0] = vIndex + 2;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 0;
+		indices[currentIndex + 3] = vIndex + 3;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 0;
 		currentIndex += 6;
 
-		m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f, y - 0.5f  , 1,0,0, uv.x				,uv.y				,  1, 0,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y				,  1, 0,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f, z - 0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	,  1, 0,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f, z - 0.5f, y - 0.5f  , 1,0,0, uv.x				,uv.y + pixelSizeY	,  1, 0,lights[0],lights[1],lights[2],lights[3] };
+		vertices[vIndex++] = { x - 0.5f, z + 0.5f, y - 0.5f  , 1,0,0, uv.x				,uv.y				,  1, anim0 };
+		vertices[vIndex++] = { x - 0.5f, z + 0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y				,  1, anim0 };
+		vertices[vIndex++] = { x - 0.5f, z - 0.5f, y + 0.5f  , 1,0,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	,  1, anim0 };
+		vertices[vIndex++] = { x - 0.5f, z - 0.5f, y - 0.5f  , 1,0,0, uv.x				,uv.y + pixelSizeY	,  1, anim0 };
 	}
-	uv = m_Level->m_BlockMap[z][y][x].uv[1];
+	uv = blockUV[1];
 	uv.x = uv.x / 8.0;
 	uv.y = uv.y / 68.0;
-	if (y - 1 <= 0 || !m_Level->m_BlockMap[z][y - 1][x].active) // back
+	if (faces & LevelData::Face_Back) // back
 	{
-		m_Indices[currentIndex + 0] = vIndex + 2;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 0;
-		m_Indices[currentIndex + 3] = vIndex + 3;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 0;
+		indices[currentIndex + 0] = vIndex + 2;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 0;
+		indices[currentIndex + 3] = vIndex + 3;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 0;
 		currentIndex += 6;
 
-		m_Vertices[vIndex++] = { x + 0.5f ,  z - 0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f ,  z + 0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f ,  z + 0.5f  , y - 0.5f , 0,0,1, uv.x					,uv.y				,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f ,  z - 0.5f  , y - 0.5f , 0,0,1, uv.x					,uv.y + pixelSizeY	,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
+		vertices[vIndex++] = { x + 0.5f ,  z - 0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	,  1, anim1 };
+		vertices[vIndex++] = { x + 0.5f ,  z + 0.5f  , y - 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				,  1, anim1 };
+		vertices[vIndex++] = { x - 0.5f ,  z + 0.5f  , y - 0.5f , 0,0,1, uv.x					,uv.y				,  1, anim1 };
+		vertices[vIndex++] = { x - 0.5f ,  z - 0.5f  , y - 0.5f , 0,0,1, uv.x					,uv.y + pixelSizeY	,  1, anim1 };
 	}
-	if (y + 1 >= MAP_SIZE_SUBTILES_RENDER || !m_Level->m_BlockMap[z][y + 1][x].active) // front
+	if (faces & LevelData::Face_Front) // front
 	{
-		m_Indices[currentIndex + 0] = vIndex + 0;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 2;
-		m_Indices[currentIndex + 3] = vIndex + 0;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 3;
+		indices[currentIndex + 0] = vIndex + 0;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 2;
+		indices[currentIndex + 3] = vIndex + 0;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 3;
 		currentIndex += 6;
 
-		m_Vertices[vIndex++] = { x + 0.5f  ,   z - 0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f  ,   z + 0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f  ,   z + 0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y				,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f  ,   z - 0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y + pixelSizeY	,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
+		vertices[vIndex++] = { x + 0.5f  ,   z - 0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y + pixelSizeY	,  1, anim1 };
+		vertices[vIndex++] = { x + 0.5f  ,   z + 0.5f,  y + 0.5f , 0,0,1, uv.x + pixelSizeX	,uv.y				,  1, anim1 };
+		vertices[vIndex++] = { x - 0.5f  ,   z + 0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y				,  1, anim1 };
+		vertices[vIndex++] = { x - 0.5f  ,   z - 0.5f,  y + 0.5f , 0,0,1, uv.x				,uv.y + pixelSizeY	,  1, anim1 };
 	}
 
-	uv = m_Level->m_BlockMap[z][y][x].uv[2];
+	uv = blockUV[2];
 	if (tileType != Type_Gold && tileType != Type_Gem && tile.marked[Owner_PlayerRed])
 	{
 		const std::vector<XMFLOAT2>& tex0 = BlockTextures[7].top[0];
-		uv = tex0[m_AnimationIndex % tex0.size()];
+		uv = tex0[0];
+		anim2 = AnimatedFrames(tex0);
 	}
 	uv.x = uv.x / 8.0;
 	uv.y = uv.y / 68.0;
-	if (!m_Level->m_BlockMap[z - 1][y][x].active) // bottom
+	if (faces & LevelData::Face_Bottom) // bottom
 	{
-		m_Indices[currentIndex + 0] = vIndex + 2;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 0;
-		m_Indices[currentIndex + 3] = vIndex + 3;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 0;
+		indices[currentIndex + 0] = vIndex + 2;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 0;
+		indices[currentIndex + 3] = vIndex + 3;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 0;
 		currentIndex += 6;
 
-		m_Vertices[vIndex++] = { x - 0.5f , z - 0.5f ,  y + 0.5f  , 0,1,0, uv.x				,uv.y + pixelSizeY	,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f , z - 0.5f ,  y + 0.5f  , 0,1,0, uv.x + pixelSizeX,uv.y + pixelSizeY	,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f , z - 0.5f ,  y - 0.5f  , 0,1,0, uv.x + pixelSizeX,uv.y				,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f , z - 0.5f ,  y - 0.5f  , 0,1,0, uv.x				,uv.y				,  1, 0 ,lights[0],lights[1],lights[2],lights[3] };
+		vertices[vIndex++] = { x - 0.5f , z - 0.5f ,  y + 0.5f  , 0,1,0, uv.x				,uv.y + pixelSizeY	,  1, anim2 };
+		vertices[vIndex++] = { x + 0.5f , z - 0.5f ,  y + 0.5f  , 0,1,0, uv.x + pixelSizeX,uv.y + pixelSizeY	,  1, anim2 };
+		vertices[vIndex++] = { x + 0.5f , z - 0.5f ,  y - 0.5f  , 0,1,0, uv.x + pixelSizeX,uv.y				,  1, anim2 };
+		vertices[vIndex++] = { x - 0.5f , z - 0.5f ,  y - 0.5f  , 0,1,0, uv.x				,uv.y				,  1, anim2 };
 	}
-	if (z + 1 >= MAP_SIZE_HEIGHT || !m_Level->m_BlockMap[z + 1][y][x].active) //top
+	if (faces & LevelData::Face_Top) //top
 	{
 		
 		bool visible[4] = {true,true,true,true};
@@ -698,278 +655,375 @@ void VoxelObject::DoVoxelBlockVisible(int z, int y, int x, int yP, int xP, uint3
 			}
 			if (isCorner)
 			{
-				m_Indices[currentIndex + 0] = vIndex + 2;
-				m_Indices[currentIndex + 1] = vIndex + 1;
-				m_Indices[currentIndex + 2] = vIndex + 0;
-				m_Indices[currentIndex + 3] = vIndex + 3;
-				m_Indices[currentIndex + 4] = vIndex + 2;
-				m_Indices[currentIndex + 5] = vIndex + 0;
+				indices[currentIndex + 0] = vIndex + 2;
+				indices[currentIndex + 1] = vIndex + 1;
+				indices[currentIndex + 2] = vIndex + 0;
+				indices[currentIndex + 3] = vIndex + 3;
+				indices[currentIndex + 4] = vIndex + 2;
+				indices[currentIndex + 5] = vIndex + 0;
 				currentIndex += 6;
 
-				m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y,				(float)(visible[3]) , 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY, (float)(visible[1]) , 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x				,uv.y + pixelSizeY, (float)(visible[0]) , 0 ,lights[0],lights[1],lights[2],lights[3] };
-				m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x				,uv.y,				(float)(visible[2]) , 0 ,lights[0],lights[1],lights[2],lights[3] };
+				vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y,				(float)(visible[3]) , anim2 };
+				vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY, (float)(visible[1]) , anim2 };
+				vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x				,uv.y + pixelSizeY, (float)(visible[0]) , anim2 };
+				vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x				,uv.y,				(float)(visible[2]) , anim2 };
 			}
 			else
 			{
 
 				if ((!visible[0] && !visible[2]) || (!visible[1] && !visible[3]))
 				{
-					m_Indices[currentIndex + 0] = vIndex + 0;
-					m_Indices[currentIndex + 1] = vIndex + 2;
-					m_Indices[currentIndex + 2] = vIndex + 1;
-					m_Indices[currentIndex + 3] = vIndex + 0;
-					m_Indices[currentIndex + 4] = vIndex + 3;
-					m_Indices[currentIndex + 5] = vIndex + 2;
+					indices[currentIndex + 0] = vIndex + 0;
+					indices[currentIndex + 1] = vIndex + 2;
+					indices[currentIndex + 2] = vIndex + 1;
+					indices[currentIndex + 3] = vIndex + 0;
+					indices[currentIndex + 4] = vIndex + 3;
+					indices[currentIndex + 5] = vIndex + 2;
 					currentIndex += 6;
-					m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x				,uv.y,				(float)(visible[1] && visible[3]) , 0 ,lights[0],lights[1],lights[2],lights[3] };
-					m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y,				(float)(visible[0] && visible[3]) , 0 ,lights[0],lights[1],lights[2],lights[3] };
-					m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY, (float)(visible[0] && visible[2]) , 0 ,lights[0],lights[1],lights[2],lights[3] };
-					m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x				,uv.y + pixelSizeY, (float)(visible[1] && visible[2]) , 0 ,lights[0],lights[1],lights[2],lights[3] };
+					vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x				,uv.y,				(float)(visible[1] && visible[3]) , anim2 };
+					vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y,				(float)(visible[0] && visible[3]) , anim2 };
+					vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY, (float)(visible[0] && visible[2]) , anim2 };
+					vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x				,uv.y + pixelSizeY, (float)(visible[1] && visible[2]) , anim2 };
 				}
 				else
 				{
-					m_Indices[currentIndex + 0] = vIndex + 2;
-					m_Indices[currentIndex + 1] = vIndex + 1;
-					m_Indices[currentIndex + 2] = vIndex + 0;
-					m_Indices[currentIndex + 3] = vIndex + 3;
-					m_Indices[currentIndex + 4] = vIndex + 2;
-					m_Indices[currentIndex + 5] = vIndex + 0;
+					indices[currentIndex + 0] = vIndex + 2;
+					indices[currentIndex + 1] = vIndex + 1;
+					indices[currentIndex + 2] = vIndex + 0;
+					indices[currentIndex + 3] = vIndex + 3;
+					indices[currentIndex + 4] = vIndex + 2;
+					indices[currentIndex + 5] = vIndex + 0;
 					currentIndex += 6;
-					m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y,				(float)(visible[0] && visible[3]) , 0 ,lights[0],lights[1],lights[2],lights[3] };
-					m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY, (float)(visible[0] && visible[2]) , 0 ,lights[0],lights[1],lights[2],lights[3] };
-					m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x				,uv.y + pixelSizeY, (float)(visible[1] && visible[2]) , 0 ,lights[0],lights[1],lights[2],lights[3] };
-					m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x				,uv.y,				(float)(visible[1] && visible[3]) , 0 ,lights[0],lights[1],lights[2],lights[3] };
+					vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y,				(float)(visible[0] && visible[3]) , anim2 };
+					vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY, (float)(visible[0] && visible[2]) , anim2 };
+					vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x				,uv.y + pixelSizeY, (float)(visible[1] && visible[2]) , anim2 };
+					vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x				,uv.y,				(float)(visible[1] && visible[3]) , anim2 };
 				}
 			}
 		}
 		else
 		{
-			m_Indices[currentIndex + 0] = vIndex + 2;
-			m_Indices[currentIndex + 1] = vIndex + 1;
-			m_Indices[currentIndex + 2] = vIndex + 0;
-			m_Indices[currentIndex + 3] = vIndex + 3;
-			m_Indices[currentIndex + 4] = vIndex + 2;
-			m_Indices[currentIndex + 5] = vIndex + 0;
+			indices[currentIndex + 0] = vIndex + 2;
+			indices[currentIndex + 1] = vIndex + 1;
+			indices[currentIndex + 2] = vIndex + 0;
+			indices[currentIndex + 3] = vIndex + 3;
+			indices[currentIndex + 4] = vIndex + 2;
+			indices[currentIndex + 5] = vIndex + 0;
 			currentIndex += 6;
 
-			m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y				, 1 , 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1 , 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x				,uv.y + pixelSizeY	, 1 , 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x				,uv.y				, 1 , 0 ,lights[0],lights[1],lights[2],lights[3] };
+			vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y				, 1 , anim2 };
+			vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1 , anim2 };
+			vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x				,uv.y + pixelSizeY	, 1 , anim2 };
+			vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x				,uv.y				, 1 , anim2 };
 		}
 	}
 	
 }
 //All Z's 
-void VoxelObject::DoVoxelBlockInvisible(int z, int y, int x, int yP,int xP, uint32_t& currentIndex, uint32_t& vIndex)
+void VoxelObject::DoVoxelBlockInvisible(int z, int y, int x, int yP,int xP, VoxelVertex* vertices, uint32_t* indices, uint32_t& currentIndex, uint32_t& vIndex)
 {
 	if (z + 1 > 6) return;
 
-	const Tile& tile = m_Level->s_Map.m_Tiles[yP][xP];
-	const uint32_t lights[4] = { m_Level->s_PerTileLights[tile.lightArrayIndex] , m_Level->s_PerTileLights[tile.lightArrayIndex + 1], m_Level->s_PerTileLights[tile.lightArrayIndex + 2], m_Level->s_PerTileLights[tile.lightArrayIndex + 3] };
-
 	const XMFLOAT2 uv = XMFLOAT2(0, 0);
 	if (((x+1) / 3) == (xP+1) && m_Level->s_Map.m_Tiles[yP][xP+1].visible) // right
 	{
-		m_Indices[currentIndex + 0] = vIndex + 2;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 0;
-		m_Indices[currentIndex + 3] = vIndex + 3;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 0;
+		indices[currentIndex + 0] = vIndex + 2;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 0;
+		indices[currentIndex + 3] = vIndex + 3;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 0;
 		currentIndex += 6;
 
-		m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f  , y - 0.5f  , 1,0,0, 0,0,0, 0,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f, z - 0.5f  , y - 0.5f  , 1,0,0, 0,0,0, 0,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f, z - 0.5f  , y + 0.5f  , 1,0,0, 0,0,0, 0,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f  , y + 0.5f  , 1,0,0, 0,0,0, 0,lights[0],lights[1],lights[2],lights[3] };
+		vertices[vIndex++] = { x + 0.5f, z + 0.5f  , y - 0.5f  , 1,0,0, 0,0,0, 0 };
+		vertices[vIndex++] = { x + 0.5f, z - 0.5f  , y - 0.5f  , 1,0,0, 0,0,0, 0 };
+		vertices[vIndex++] = { x + 0.5f, z - 0.5f  , y + 0.5f  , 1,0,0, 0,0,0, 0 };
+		vertices[vIndex++] = { x + 0.5f, z + 0.5f  , y + 0.5f  , 1,0,0, 0,0,0, 0 };
 
 	}
 	if (((x - 1) / 3) == (xP - 1) && m_Level->s_Map.m_Tiles[yP][xP - 1].visible) // left
 	{
-		m_Indices[currentIndex + 0] = vIndex + 2;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 0;
-		m_Indices[currentIndex + 3] = vIndex + 3;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 0;
+		indices[currentIndex + 0] = vIndex + 2;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 0;
+		indices[currentIndex + 3] = vIndex + 3;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 0;
 		currentIndex += 6;
 
-		m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f, y - 0.5f  , 1,0,0, 0,0,0, 0,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f, y + 0.5f  , 1,0,0, 0,0,0, 0,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f, z - 0.5f, y + 0.5f  , 1,0,0, 0,0,0, 0,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f, z - 0.5f, y - 0.5f  , 1,0,0, 0,0,0, 0,lights[0],lights[1],lights[2],lights[3] };
+		vertices[vIndex++] = { x - 0.5f, z + 0.5f, y - 0.5f  , 1,0,0, 0,0,0, 0 };
+		vertices[vIndex++] = { x - 0.5f, z + 0.5f, y + 0.5f  , 1,0,0, 0,0,0, 0 };
+		vertices[vIndex++] = { x - 0.5f, z - 0.5f, y + 0.5f  , 1,0,0, 0,0,0, 0 };
+		vertices[vIndex++] = { x - 0.5f, z - 0.5f, y - 0.5f  , 1,0,0, 0,0,0, 0 };
 	}
 	if (((y - 1) / 3) == (yP - 1) && m_Level->s_Map.m_Tiles[yP - 1][xP].visible) // back
 	{
-		m_Indices[currentIndex + 0] = vIndex + 2;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 0;
-		m_Indices[currentIndex + 3] = vIndex + 3;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 0;
+		indices[currentIndex + 0] = vIndex + 2;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 0;
+		indices[currentIndex + 3] = vIndex + 3;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 0;
 		currentIndex += 6;
 
-		m_Vertices[vIndex++] = { x + 0.5f ,  z - 0.5f  , y - 0.5f , 0,0,1, 0,0,0, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f ,  z + 0.5f  , y - 0.5f , 0,0,1, 0,0,0, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f ,  z + 0.5f  , y - 0.5f , 0,0,1, 0,0,0, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f ,  z - 0.5f  , y - 0.5f , 0,0,1, 0,0,0, 0 ,lights[0],lights[1],lights[2],lights[3] };
+		vertices[vIndex++] = { x + 0.5f ,  z - 0.5f  , y - 0.5f , 0,0,1, 0,0,0, 0 };
+		vertices[vIndex++] = { x + 0.5f ,  z + 0.5f  , y - 0.5f , 0,0,1, 0,0,0, 0 };
+		vertices[vIndex++] = { x - 0.5f ,  z + 0.5f  , y - 0.5f , 0,0,1, 0,0,0, 0 };
+		vertices[vIndex++] = { x - 0.5f ,  z - 0.5f  , y - 0.5f , 0,0,1, 0,0,0, 0 };
 	}
 	if (((y + 1) / 3) == (yP + 1) && m_Level->s_Map.m_Tiles[yP + 1][xP].visible) // front
 	{
-		m_Indices[currentIndex + 0] = vIndex + 0;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 2;
-		m_Indices[currentIndex + 3] = vIndex + 0;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 3;
+		indices[currentIndex + 0] = vIndex + 0;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 2;
+		indices[currentIndex + 3] = vIndex + 0;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 3;
 		currentIndex += 6;
 
-		m_Vertices[vIndex++] = { x + 0.5f  ,   z - 0.5f,  y + 0.5f , 0,0,1,  0,0,0, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x + 0.5f  ,   z + 0.5f,  y + 0.5f , 0,0,1,  0,0,0, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f  ,   z + 0.5f,  y + 0.5f , 0,0,1,  0,0,0, 0 ,lights[0],lights[1],lights[2],lights[3] };
-		m_Vertices[vIndex++] = { x - 0.5f  ,   z - 0.5f,  y + 0.5f , 0,0,1,  0,0,0, 0 ,lights[0],lights[1],lights[2],lights[3] };
+		vertices[vIndex++] = { x + 0.5f  ,   z - 0.5f,  y + 0.5f , 0,0,1,  0,0,0, 0 };
+		vertices[vIndex++] = { x + 0.5f  ,   z + 0.5f,  y + 0.5f , 0,0,1,  0,0,0, 0 };
+		vertices[vIndex++] = { x - 0.5f  ,   z + 0.5f,  y + 0.5f , 0,0,1,  0,0,0, 0 };
+		vertices[vIndex++] = { x - 0.5f  ,   z - 0.5f,  y + 0.5f , 0,0,1,  0,0,0, 0 };
 	}
 
 	if (z + 1 == 6) // top
 	{
-		m_Indices[currentIndex + 0] = vIndex + 2;
-		m_Indices[currentIndex + 1] = vIndex + 1;
-		m_Indices[currentIndex + 2] = vIndex + 0;
-		m_Indices[currentIndex + 3] = vIndex + 3;
-		m_Indices[currentIndex + 4] = vIndex + 2;
-		m_Indices[currentIndex + 5] = vIndex + 0;
+		indices[currentIndex + 0] = vIndex + 2;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 0;
+		indices[currentIndex + 3] = vIndex + 3;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 0;
 		currentIndex += 6;
 
 		if (m_Level->s_Map.m_Tiles[yP][xP].marked[Owner_PlayerRed])
 		{
 			const std::vector<XMFLOAT2>& tex0 = BlockTextures[7].top[0];
-			XMFLOAT2 uv = tex0[m_AnimationIndex % tex0.size()];
+			const uint32_t anim = AnimatedFrames(tex0);
+			XMFLOAT2 uv = tex0[0];
 			uv.x = uv.x / 8.0;
 			uv.y = uv.y / 68.0;
-			m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y				, 1 , 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1 , 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x				,uv.y + pixelSizeY	, 1 , 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x				,uv.y				, 1 , 0 ,lights[0],lights[1],lights[2],lights[3] };
+			vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y				, 1 , anim };
+			vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x + pixelSizeX	,uv.y + pixelSizeY	, 1 , anim };
+			vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, uv.x				,uv.y + pixelSizeY	, 1 , anim };
+			vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, uv.x				,uv.y				, 1 , anim };
 		}
 		else
 		{
-			m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, 0,0,0, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, 0,0,0, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, 0,0,0, 0 ,lights[0],lights[1],lights[2],lights[3] };
-			m_Vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, 0,0,0, 0 ,lights[0],lights[1],lights[2],lights[3] };
+			vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, 0,0,0, 0 };
+			vertices[vIndex++] = { x + 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, 0,0,0, 0 };
+			vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y + 0.5f , 0,1,0, 0,0,0, 0 };
+			vertices[vIndex++] = { x - 0.5f, z + 0.5f ,  y - 0.5f , 0,1,0, 0,0,0, 0 };
 		}
 	}
 }
 
-void VoxelObject::ConstructFromLevel(int camX,int camY)
+void VoxelObject::ConstructFromLevel(const XMFLOAT4X4& viewProjection)
 {
-	const int tileRadius = 10;
-	const int subTileRadius = tileRadius * 3;
+	uint32_t numVertices = 0;
+	uint32_t numIndices = 0;
+	if (BuildMesh(viewProjection, numVertices, numIndices))
+	{
+		m_MeshOutput(m_MeshOutputContext, m_Vertices, numVertices, m_Indices, numIndices);
+	}
+}
 
-	XMINT2 camTilePos = LevelData::WorldToTile(XMFLOAT3(camX, 2, camY));
+bool VoxelObject::BuildMesh(const XMFLOAT4X4& viewProjection, uint32_t& numVertices, uint32_t& numIndices)
+{
+	//Only the chunks the camera can see get meshed, every chunk is a job for the worker pool.
+	//The last row and column of tiles never gets built (the block functions look one subtile past the block they're doing), the chunks stop short of them.
+	const Frustum frustum(viewProjection);
+	size_t numJobs = 0;
+	uint32_t coarseChunks = 0;
+	for (int cy = 0; cy < NumMeshChunks; cy++)
+	{
+		for (int cx = 0; cx < NumMeshChunks; cx++)
+		{
+			//blocks are centered on their subtile, so give it some room
+			const XMFLOAT3 boxMin(cx * MeshChunkSubtiles - 1.0f, -1.0f, cy * MeshChunkSubtiles - 1.0f);
+			const XMFLOAT3 boxMax((cx + 1) * MeshChunkSubtiles, (float)MAP_SIZE_HEIGHT, (cy + 1) * MeshChunkSubtiles);
+			if (!frustum.IntersectsBox(boxMin, boxMax)) continue;
 
-	int camSubTilePosX = camTilePos.x * 3;
-	int camSubTilePosY = camTilePos.y * 3;
+			bool& coarse = m_ChunkCoarse[cy][cx];
+			if (!s_CoarseLod)
+			{
+				coarse = false;
+			}
+			else
+			{
+				const float screenSize = GetScreenSize(viewProjection, boxMin, boxMax);
+				coarse = coarse ? screenSize < s_LodScreenSize * 1.25f : screenSize < s_LodScreenSize;
+			}
+			if (coarse) coarseChunks++;
 
+			if (numJobs == m_MeshJobs.size())
+			{
+				m_MeshJobs.push_back(MeshJob());
+			}
+			MeshJob& job = m_MeshJobs[numJobs++];
+			job.yStart = cy * MeshChunkSubtiles;
+			job.yEnd = job.yStart + MeshChunkSubtiles;
+			job.xStart = cx * MeshChunkSubtiles;
+			job.xEnd = job.xStart + MeshChunkSubtiles;
+			job.coarse = coarse;
+		}
+	}
+	//jobs past this keep their arrays around for when more chunks come into view
+	m_NumMeshJobs = numJobs;
+	m_MeshStats.chunks = (uint32_t)numJobs;
+	m_MeshStats.coarseChunks = coarseChunks;
 
-	//make sure we're within bounds of a of the 85x85 map with a 16x16 tile area
-	//This is working in subtiles
-	if (camTilePos.x - tileRadius < 0)
+	bool sameChunks = m_BuiltChunks.size() == numJobs;
+	for (size_t i = 0; i < numJobs && sameChunks; i++)
 	{
-		camTilePos.x = tileRadius;
-		camSubTilePosX = subTileRadius;
+		const MeshJob& job = m_MeshJobs[i];
+		sameChunks = m_BuiltChunks[i] == (uint16_t)((job.yStart / MeshChunkSubtiles * NumMeshChunks + job.xStart / MeshChunkSubtiles) << 1 | job.coarse);
 	}
-	else if (camTilePos.x + tileRadius >= MAP_SIZE_TILES)
+	if (!m_MeshDirty && sameChunks && m_BuiltGreedy == s_GreedyMeshing)
 	{
-		camTilePos.x = MAP_SIZE_TILES - tileRadius - 1;
-		camSubTilePosX = MAP_SIZE_SUBTILES_RENDER - subTileRadius - 1;
+		return false;
 	}
-	if (camTilePos.y - tileRadius < 0)
+	m_MeshDirty = false;
+	m_BuiltGreedy = s_GreedyMeshing;
+	m_BuiltChunks.resize(numJobs);
+	for (size_t i = 0; i < numJobs; i++)
 	{
-		camTilePos.y = tileRadius;
-		camSubTilePosY = subTileRadius;
+		const MeshJob& job = m_MeshJobs[i];
+		m_BuiltChunks[i] = (uint16_t)((job.yStart / MeshChunkSubtiles * NumMeshChunks + job.xStart / MeshChunkSubtiles) << 1 | job.coarse);
 	}
-	else if (camTilePos.y + tileRadius >= MAP_SIZE_TILES)
+
+	if (s_MeshThreads < 1) s_MeshThreads = 1;
+	if (m_MeshPool == nullptr || m_MeshPool->GetNumThreads() != s_MeshThreads - 1)
 	{
-		camTilePos.y = MAP_SIZE_TILES - tileRadius - 1;
-		camSubTilePosY = MAP_SIZE_SUBTILES_RENDER - subTileRadius - 1;
+		delete m_MeshPool;
+		m_MeshPool = new WorkerPool(s_MeshThreads - 1);
 	}
-	size_t solidBlocks = 0;
+	Timer meshTimer;
+	m_MeshPool->Run(BuildMeshJob, this, (int)m_NumMeshJobs);
 
-	assert(camTilePos.x + tileRadius <= 84);
-	assert(camTilePos.y + tileRadius <= 84);
-	assert(camTilePos.y - tileRadius >= 0);
-	assert(camTilePos.x - tileRadius >= 0);
-	for (int y = camTilePos.y - tileRadius; y < camTilePos.y + tileRadius; y++)
+	size_t totalVertices = 0;
+	for (size_t i = 0; i < m_NumMeshJobs; i++)
 	{
-		for (int x = camTilePos.x - tileRadius; x < camTilePos.x+ tileRadius; x++)
-		{
-			solidBlocks += m_Level->s_Map.m_Tiles[y][x].numBlocks;
-		}
+		totalVertices += m_MeshJobs[i].numVertices;
 	}
 	//We'll check if we have to resize our buffers..
-	if (solidBlocks > m_NumBlocks)
+	if (totalVertices > m_NumBlocks * 6 * 4)
 	{
 		delete[] m_Vertices;
 		delete[] m_Indices;
 
-		m_NumBlocks = solidBlocks;
-		m_Vertices = new VoxelVertex[solidBlocks * 6 * 4]; //worse case scenario
-		m_Indices = new uint32_t[solidBlocks * 6 * 6];
+		m_NumBlocks = (totalVertices + 6 * 4 - 1) / (6 * 4);
+		m_Vertices = new VoxelVertex[m_NumBlocks * 6 * 4];
+		m_Indices = new uint32_t[m_NumBlocks * 6 * 6];
 	}
 
 	uint32_t vIndex = 0;
 	uint32_t currentIndex = 0; 
+	for (size_t i = 0; i < m_NumMeshJobs; i++)
+	{
+		const MeshJob& job = m_MeshJobs[i];
+		memcpy(&m_Vertices[vIndex], job.vertices, sizeof(VoxelVertex) * job.numVertices);
+		for (uint32_t j = 0; j < job.numIndices; j++)
+		{
+			m_Indices[currentIndex + j] = job.indices[j] + vIndex;
+		}
+		vIndex += job.numVertices;
+		currentIndex += job.numIndices;
+	}
+	m_MeshStats.buildMicroseconds = meshTimer.GetDeltaTimeMicro();
+
+	m_MeshStats.vertices = vIndex;
+	m_MeshStats.indices = currentIndex;
+	m_MeshStats.mergedFaces = 0;
+	m_MeshStats.mergedQuads = 0;
+	if (s_GreedyMeshing)
+	{
+		MergeFaces(vIndex, currentIndex);
+	}
+	m_MeshStats.uploadedVertices = vIndex;
+	m_MeshStats.uploadedIndices = currentIndex;
+	numVertices = vIndex;
+	numIndices = currentIndex;
+
+	if ((m_NumBlocks * 6 * 4) * sizeof(Themp::VoxelVertex) < vIndex * sizeof(Themp::VoxelVertex))
+	{
+		System::Print("This is wrong.. Very wrong...");
+		assert(false);
+	}
+	if ((m_NumBlocks * 6 * 6) * sizeof(uint32_t) < currentIndex * sizeof(uint32_t))
+	{
+		System::Print("This is wrong.. Very wrong...");
+		assert(false);
+	}
+	return true;
+}
+
+void VoxelObject::UploadMesh(void* context, const VoxelVertex* vertices, uint32_t numVertices, const uint32_t* indices, uint32_t numIndices)
+{
+	VoxelObject* obj = (VoxelObject*)context;
+	Mesh* m = obj->m_Obj3D->m_Meshes[0];
+	const bool uploaded = obj->EditVertexBuffer(vertices, numVertices) && obj->EditIndexBuffer(indices, numIndices);
+	assert(uploaded);
+	m->m_NumIndices = numIndices;
+	m->m_NumVertices = numVertices;
+	m->m_VertexBuffer = obj->m_VertexBuffer.buf;
+	m->m_IndexBuffer = obj->m_IndexBuffer.buf;
+}
 
-	//Z == 0 //For water and Lava animation (vertex displacement)
-	for (int y = camSubTilePosY - subTileRadius; y < camSubTilePosY + subTileRadius; y++)
+void VoxelObject::BuildMeshJob(void* context, int jobIndex)
+{
+	VoxelObject* obj = (VoxelObject*)context;
+	LevelData* level = obj->m_Level;
+	MeshJob& job = obj->m_MeshJobs[jobIndex];
+	if (job.coarse)
 	{
-		const int yTile = y / 3;
-		for (int x = camSubTilePosX - subTileRadius; x < camSubTilePosX + subTileRadius; x++)
+		obj->BuildCoarseChunk(job);
+		return;
+	}
+
+	//worst case every block we go over puts out all its faces, blocks in unexplored tiles only ever do up to z 5
+	size_t blocks = 0;
+	for (int z = 0; z < MAP_SIZE_HEIGHT; z++)
+	{
+		for (int y = job.yStart; y < job.yEnd; y++)
 		{
-			const int xTile = x / 3;
-			assert(x <= 254);
-			assert(y <= 254);
-			assert(x >= 0);
-			assert(y >= 0);
-			if (m_Level->s_Map.m_Tiles[yTile][xTile].visible)
+			for (int x = job.xStart; x < job.xEnd; x++)
 			{
-				if (!m_Level->m_BlockMap[0][y][x].active) continue;
-				DoVoxelBlockVisibleAnimated(y, x,currentIndex, vIndex);
-			}
-			else
-			{
-				DoVoxelBlockInvisible(0, y, x,yTile,xTile, currentIndex, vIndex);
+				if (level->s_Map.m_Tiles[y / 3][x / 3].visible ? level->IsBlockActive(z, y, x) : z + 1 <= 6) blocks++;
 			}
 		}
 	}
-	//Z == 1
-	for (int y = camSubTilePosY - subTileRadius; y < camSubTilePosY + subTileRadius; y++)
+	if (blocks > job.numBlocks)
 	{
-		const int yP = y / 3;
-		for (int x = camSubTilePosX - subTileRadius; x < camSubTilePosX + subTileRadius; x++)
+		delete[] job.vertices;
+		delete[] job.indices;
+		job.numBlocks = blocks;
+		job.vertices = new VoxelVertex[blocks * 6 * 4];
+		job.indices = new uint32_t[blocks * 6 * 6];
+	}
+
+	//the uvs are put together a tile at a time instead of for every block that needs them
+	const int tyStart = job.yStart / 3;
+	const int txStart = job.xStart / 3;
+	const int tilesX = (job.xEnd + 2) / 3 - txStart;
+	job.tileUVs.resize((size_t)(((job.yEnd + 2) / 3 - tyStart) * tilesX));
+	for (int ty = tyStart; ty * 3 < job.yEnd; ty++)
+	{
+		for (int tx = txStart; tx * 3 < job.xEnd; tx++)
 		{
-			const int xP = x / 3;
-			if (m_Level->s_Map.m_Tiles[yP][xP].visible)
-			{
-				if (!m_Level->m_BlockMap[1][y][x].active) continue;
-				DoVoxelBlockVisibleEdge(y, x,yP,xP, currentIndex, vIndex);
-			}
-			else
-			{
-				DoVoxelBlockInvisible(1, y, x,yP,xP, currentIndex, vIndex);
-			}
+			if (level->s_Map.m_Tiles[ty][tx].visible) level->GetTileUVs(ty, tx, job.tileUVs[(ty - tyStart) * tilesX + tx - txStart]);
 		}
 	}
-	for (int z = 2; z < MAP_SIZE_HEIGHT; z++)
+
+	uint32_t vIndex = 0;
+	uint32_t currentIndex = 0;
+	for (int z = 0; z < MAP_SIZE_HEIGHT; z++)
 	{
-		for (int y = camSubTilePosY - subTileRadius; y < camSubTilePosY + subTileRadius; y++)
+		for (int y = job.yStart; y < job.yEnd; y++)
 		{
 			const int yP = y / 3;
-			for (int x = camSubTilePosX - subTileRadius; x < camSubTilePosX + subTileRadius; x++)
+			for (int x = job.xStart; x < job.xEnd; x++)
 			{
 				assert(x <= 254);
 				assert(y <= 254);
@@ -977,40 +1031,390 @@ void VoxelObject::ConstructFromLevel(int camX,int camY)
 				assert(y >= 0);
 
 				const int xP = x / 3;
-				if (m_Level->s_Map.m_Tiles[yP][xP].visible)
+				if (level->s_Map.m_Tiles[yP][xP].visible)
 				{
-					if (!m_Level->m_BlockMap[z][y][x].active) continue;
-					DoVoxelBlockVisible(z, y, x, yP, xP, currentIndex, vIndex);
+					if (!level->IsBlockActive(z, y, x)) continue;
+					const BlockUVs& block = job.tileUVs[(yP - tyStart) * tilesX + xP - txStart].At(z, y, x);
+					if (z == 0) //For water and Lava animation (vertex displacement)
+					{
+						obj->DoVoxelBlockVisibleAnimated(y, x, block, job.vertices, job.indices, currentIndex, vIndex);
+					}
+					else if (z == 1)
+					{
+						obj->DoVoxelBlockVisibleEdge(y, x, yP, xP, block, job.vertices, job.indices, currentIndex, vIndex);
+					}
+					else
+					{
+						obj->DoVoxelBlockVisible(z, y, x, yP, xP, block, job.vertices, job.indices, currentIndex, vIndex);
+					}
 				}
 				else
 				{
-					DoVoxelBlockInvisible(z, y, x,yP,xP, currentIndex, vIndex);
+					obj->DoVoxelBlockInvisible(z, y, x, yP, xP, job.vertices, job.indices, currentIndex, vIndex);
 				}
 			}
 		}
 	}
-	
+	job.numVertices = vIndex;
+	job.numIndices = currentIndex;
+}
 
-	Mesh* m = m_Obj3D->m_Meshes[0];
-	assert(EditVertexBuffer(m_Vertices, vIndex));
-	assert(EditIndexBuffer(m_Indices, currentIndex));
-	m->m_NumIndices = currentIndex;
-	m->m_NumVertices = vIndex;
-	m->m_VertexBuffer = m_VertexBuffer.buf;
-	m->m_IndexBuffer = m_IndexBuffer.buf;
+//faces that got merged get this bit in doAnimate, the shaders tile the texture over them in world space (bit 0 is the water/lava wave)
+static const uint32_t VoxelTiledFace = 2;
+//the two axes a face spans per normal axis, u runs along A and v along B (upside down on the side faces)
+static const int FaceAxisA[3] = { 2, 0, 0 };
+static const int FaceAxisB[3] = { 1, 2, 1 };
 
-	if ((solidBlocks * 6 * 4) * sizeof(Themp::VoxelVertex) < vIndex * sizeof(Themp::VoxelVertex))
+static float GetAxis(const VoxelVertex& v, int axis)
+{
+	return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+}
+static void SetAxis(VoxelVertex& v, int axis, float value)
+{
+	if (axis == 0) v.x = value;
+	else if (axis == 1) v.y = value;
+	else v.z = value;
+}
+//which way the first triangle faces along the normal axis, the block faces that point towards +axis are front facing
+static bool IsFrontFacing(const VoxelVertex& v0, const VoxelVertex& v1, const VoxelVertex& v2, int axis)
+{
+	const XMFLOAT3 e0(v1.x - v0.x, v1.y - v0.y, v1.z - v0.z);
+	const XMFLOAT3 e1(v2.x - v0.x, v2.y - v0.y, v2.z - v0.z);
+	const float cross = axis == 0 ? e0.y * e1.z - e0.z * e1.y : axis == 1 ? e0.z * e1.x - e0.x * e1.z : e0.x * e1.y - e0.y * e1.x;
+	return cross > 0.0f;
+}
+//a quad covering [a0,a1] x [b0,b1] on the plane that the shaders tile atlas cell (cellX, cellY) over, one cell per subtile
+static void WriteTiledQuad(VoxelVertex* vertices, uint32_t* indices, uint32_t vIndex, uint32_t currentIndex, int axis, bool front, float plane, float a0, float a1, float b0, float b1, int cellX, int cellY, float visible)
+{
+	//the uv only tells the shaders which atlas cell to tile, the middle of it so it can't round into the next one
+	VoxelVertex base = { 0, 0, 0, axis == 0 ? 1.0f : 0.0f, axis == 1 ? 1.0f : 0.0f, axis == 2 ? 1.0f : 0.0f, (cellX + 0.5f) / 8.0f, (cellY + 0.5f) / 68.0f, visible, VoxelTiledFace };
+	SetAxis(base, axis, plane);
+	const float cornersA[4] = { a0, a1, a1, a0 };
+	const float cornersB[4] = { b0, b0, b1, b1 };
+	for (int c = 0; c < 4; c++)
 	{
-		System::Print("This is wrong.. Very wrong...");
-		assert(false);
+		VoxelVertex& corner = vertices[vIndex + c];
+		corner = base;
+		SetAxis(corner, FaceAxisA[axis], cornersA[c]);
+		SetAxis(corner, FaceAxisB[axis], cornersB[c]);
 	}
-	if ((solidBlocks * 6 * 6) * sizeof(uint32_t) < currentIndex * sizeof(uint32_t))
+	if (IsFrontFacing(vertices[vIndex], vertices[vIndex + 1], vertices[vIndex + 2], axis) == front)
 	{
-		System::Print("This is wrong.. Very wrong...");
-		assert(false);
+		indices[currentIndex + 0] = vIndex + 0;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 2;
+		indices[currentIndex + 3] = vIndex + 0;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 3;
+	}
+	else
+	{
+		indices[currentIndex + 0] = vIndex + 2;
+		indices[currentIndex + 1] = vIndex + 1;
+		indices[currentIndex + 2] = vIndex + 0;
+		indices[currentIndex + 3] = vIndex + 3;
+		indices[currentIndex + 4] = vIndex + 2;
+		indices[currentIndex + 5] = vIndex + 0;
 	}
 }
 
+//Greedy meshing over what ConstructFromLevel put out.
+//A face can be merged if it's a single block face that's fully visible, not animated and has the plain block uv layout, anything else is kept as it is.
+//Mergeable faces are grouped on (axis, winding, plane, atlas cell), rows of neighbouring faces get joined first and then rows with the same span on top of each other.
+void VoxelObject::MergeFaces(uint32_t& numVertices, uint32_t& numIndices)
+{
+	const uint32_t numQuads = numVertices / 4;
+	m_MergeFaces.clear();
+	m_MergeRuns.clear();
+	uint32_t keptQuads = 0;
+	for (uint32_t q = 0; q < numQuads; q++)
+	{
+		const VoxelVertex* v = &m_Vertices[q * 4];
+		const uint32_t* idx = &m_Indices[q * 6];
+		const int axis = v[0].nx > 0.5f ? 0 : v[0].ny > 0.5f ? 1 : 2;
+		const int axisA = FaceAxisA[axis];
+		const int axisB = FaceAxisB[axis];
+
+		bool mergeable = true;
+		float minA = GetAxis(v[0], axisA), maxA = minA, minB = GetAxis(v[0], axisB), maxB = minB;
+		float minU = v[0].u, minV = v[0].v;
+		for (int i = 0; i < 4; i++)
+		{
+			mergeable &= v[i].visible == 1.0f && v[i].doAnimate == 0 && GetAxis(v[i], axis) == GetAxis(v[0], axis);
+			minA = std::min(minA, GetAxis(v[i], axisA));
+			maxA = std::max(maxA, GetAxis(v[i], axisA));
+			minB = std::min(minB, GetAxis(v[i], axisB));
+			maxB = std::max(maxB, GetAxis(v[i], axisB));
+			minU = std::min(minU, v[i].u);
+			minV = std::min(minV, v[i].v);
+		}
+		mergeable &= maxA - minA == 1.0f && maxB - minB == 1.0f;
+
+		const int cellX = (int)floor(minU * 8.0f + 0.5f);
+		const int cellY = (int)floor(minV * 68.0f + 0.5f);
+		mergeable &= cellX >= 0 && cellX < 8 && cellY >= 0 && cellY < 68;
+		if (mergeable)
+		{
+			//the uvs have to be exactly what tiling the cell over the face would give
+			const float baseU = cellX / 8.0f;
+			const float baseV = cellY / 68.0f;
+			for (int i = 0; i < 4; i++)
+			{
+				const float lu = GetAxis(v[i], axisA) - minA;
+				const float lv = axis == 1 ? GetAxis(v[i], axisB) - minB : maxB - GetAxis(v[i], axisB);
+				mergeable &= fabs(v[i].u - (baseU + lu * pixelSizeX)) < 0.0001f && fabs(v[i].v - (baseV + lv * pixelSizeY)) < 0.0001f;
+			}
+		}
+		if (!mergeable)
+		{
+			//keep it, moved down to fill the gaps the merged faces left behind
+			if (keptQuads != q)
+			{
+				memcpy(&m_Vertices[keptQuads * 4], v, sizeof(VoxelVertex) * 4);
+				for (int i = 0; i < 6; i++)
+				{
+					m_Indices[keptQuads * 6 + i] = idx[i] - q * 4 + keptQuads * 4;
+				}
+			}
+			keptQuads++;
+			continue;
+		}
+
+		const bool front = IsFrontFacing(m_Vertices[idx[0]], m_Vertices[idx[1]], m_Vertices[idx[2]], axis);
+		const uint32_t plane = (uint32_t)((int)floor(GetAxis(v[0], axis)) + 1);
+		const uint32_t key = (axis << 21) | ((uint32_t)front << 20) | (plane << 11) | (cellX << 7) | cellY;
+		const uint64_t a = (uint64_t)(minA + 0.5f);
+		const uint64_t b = (uint64_t)(minB + 0.5f);
+		m_MergeFaces.push_back(((uint64_t)key << 32) | (b << 16) | a);
+	}
+	m_MeshStats.mergedFaces = (uint32_t)m_MergeFaces.size();
+
+	//rows along A
+	std::sort(m_MergeFaces.begin(), m_MergeFaces.end());
+	for (size_t i = 0; i < m_MergeFaces.size(); i++)
+	{
+		const uint32_t key = (uint32_t)(m_MergeFaces[i] >> 32);
+		const int b = (int)((m_MergeFaces[i] >> 16) & 0xFFFF);
+		const int a = (int)(m_MergeFaces[i] & 0xFFFF);
+		if (m_MergeRuns.size() > 0)
+		{
+			FaceRun& last = m_MergeRuns.back();
+			if (last.key == key && last.b0 == b && last.a1 + 1 == a)
+			{
+				last.a1 = a;
+				continue;
+			}
+		}
+		m_MergeRuns.push_back({ key, a, a, b, b });
+	}
+	//rows with the same span stacked along B
+	std::sort(m_MergeRuns.begin(), m_MergeRuns.end(), [](const FaceRun& l, const FaceRun& r)
+	{
+		if (l.key != r.key) return l.key < r.key;
+		if (l.a0 != r.a0) return l.a0 < r.a0;
+		if (l.a1 != r.a1) return l.a1 < r.a1;
+		return l.b0 < r.b0;
+	});
+	size_t numRects = 0;
+	for (size_t i = 0; i < m_MergeRuns.size(); i++)
+	{
+		const FaceRun& run = m_MergeRuns[i];
+		if (numRects > 0)
+		{
+			FaceRun& last = m_MergeRuns[numRects - 1];
+			if (last.key == run.key && last.a0 == run.a0 && last.a1 == run.a1 && last.b1 + 1 == run.b0)
+			{
+				last.b1 = run.b1;
+				continue;
+			}
+		}
+		m_MergeRuns[numRects++] = run;
+	}
+
+	uint32_t vIndex = keptQuads * 4;
+	uint32_t currentIndex = keptQuads * 6;
+	for (size_t i = 0; i < numRects; i++)
+	{
+		const FaceRun& rect = m_MergeRuns[i];
+		const int axis = (rect.key >> 21) & 3;
+		const bool front = ((rect.key >> 20) & 1) != 0;
+		const float plane = (float)((rect.key >> 11) & 0x1FF) - 0.5f;
+		const int cellX = (rect.key >> 7) & 0xF;
+		const int cellY = rect.key & 0x7F;
+
+		WriteTiledQuad(m_Vertices, m_Indices, vIndex, currentIndex, axis, front, plane, rect.a0 - 0.5f, rect.a1 + 0.5f, rect.b0 - 0.5f, rect.b1 + 0.5f, cellX, cellY, 1.0f);
+		currentIndex += 6;
+		vIndex += 4;
+	}
+	m_MeshStats.mergedQuads = (uint32_t)numRects;
+	numVertices = vIndex;
+	numIndices = currentIndex;
+}
+
+//how tall a tile's box is in the coarse mesh, unexplored tiles are blocks up to z 5 like DoVoxelBlockInvisible makes them
+int VoxelObject::GetCoarseHeight(int y, int x) const
+{
+	if (y < 0 || x < 0 || y >= MAP_SIZE_TILES || x >= MAP_SIZE_TILES) return 0;
+	//unexplored tiles are as high as DoVoxelBlockInvisible draws them
+	if (!m_Level->s_Map.m_Tiles[y][x].visible) return 6;
+	//not m_TileSolidHeight, that stops at the raycast height and the full detail mesh draws every layer
+	int height = 0;
+	for (int sy = y * 3; sy < y * 3 + 3; sy++)
+	{
+		for (int sx = x * 3; sx < x * 3 + 3; sx++)
+		{
+			for (int z = MAP_SIZE_HEIGHT - 1; z >= height; z--)
+			{
+				if (m_Level->IsBlockActive(z, sy, sx))
+				{
+					height = z + 1;
+					break;
+				}
+			}
+		}
+	}
+	return height;
+}
+
+float VoxelObject::GetScreenSize(const XMFLOAT4X4& viewProjection, const XMFLOAT3& boxMin, const XMFLOAT3& boxMax)
+{
+	const XMMATRIX vp = XMLoadFloat4x4(&viewProjection);
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	for (int i = 0; i < 8; i++)
+	{
+		const XMVECTOR corner = XMVectorSet((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z, 1.0f);
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector4Transform(corner, vp));
+		if (clip.w <= 0.0f || clip.z < 0.0f) return FLT_MAX;
+		const float x = clip.x / clip.w;
+		const float y = clip.y / clip.w;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+	}
+	//the screen goes from -1 to 1
+	return std::max(maxX - minX, maxY - minY) * 0.5f;
+}
+
+//One box per tile, as high as the tile's highest block, with the top texture most of its subtiles have (tiled by the shaders like merged faces).
+//Sides only go down to the next tile's box, on the border of the chunk they go all the way down so nothing shows through
+//next to a chunk that's built from its blocks. Liquid surfaces are left to the LiquidLayer like always.
+void VoxelObject::BuildCoarseChunk(MeshJob& job)
+{
+	const int tyStart = job.yStart / 3;
+	const int tyEnd = job.yEnd / 3;
+	const int txStart = job.xStart / 3;
+	const int txEnd = job.xEnd / 3;
+	//a top and four sides per tile fit in what a block gets
+	const size_t blocks = (size_t)((tyEnd - tyStart) * (txEnd - txStart));
+	if (blocks > job.numBlocks)
+	{
+		delete[] job.vertices;
+		delete[] job.indices;
+		job.numBlocks = blocks;
+		job.vertices = new VoxelVertex[blocks * 6 * 4];
+		job.indices = new uint32_t[blocks * 6 * 6];
+	}
+
+	static const int SideY[4] = { 0, 0, 1, -1 };
+	static const int SideX[4] = { 1, -1, 0, 0 };
+	uint32_t vIndex = 0;
+	uint32_t currentIndex = 0;
+	for (int ty = tyStart; ty < tyEnd; ty++)
+	{
+		for (int tx = txStart; tx < txEnd; tx++)
+		{
+			const Tile& tile = m_Level->s_Map.m_Tiles[ty][tx];
+			const int height = GetCoarseHeight(ty, tx);
+			if (height == 0) continue;
+
+			int topCellX = 0, topCellY = 0, sideCellX = 0, sideCellY = 0;
+			if (tile.visible)
+			{
+				TileUVs tileUVs;
+				m_Level->GetTileUVs(ty, tx, tileUVs);
+				XMFLOAT2 tops[9];
+				XMFLOAT2 sides[9];
+				int numTops = 0;
+				for (int sy = ty * 3; sy < ty * 3 + 3; sy++)
+				{
+					for (int sx = tx * 3; sx < tx * 3 + 3; sx++)
+					{
+						for (int z = height - 1; z >= 0; z--)
+						{
+							if (!m_Level->IsBlockActive(z, sy, sx)) continue;
+							XMFLOAT2 blockUV[3];
+							uint32_t anim[3];
+							GetBlockUVs(tileUVs.At(z, sy, sx), z, sy, sx, blockUV, anim);
+							tops[numTops] = blockUV[2];
+							sides[numTops] = blockUV[0];
+							numTops++;
+							break;
+						}
+					}
+				}
+				int best = 0, bestCount = 0;
+				for (int i = 0; i < numTops; i++)
+				{
+					int count = 0;
+					for (int j = 0; j < numTops; j++)
+					{
+						if (tops[j].x == tops[i].x && tops[j].y == tops[i].y) count++;
+					}
+					if (count > bestCount)
+					{
+						best = i;
+						bestCount = count;
+					}
+				}
+				if (numTops > 0)
+				{
+					topCellX = (int)tops[best].x;
+					topCellY = (int)tops[best].y;
+					sideCellX = (int)sides[best].x;
+					sideCellY = (int)sides[best].y;
+				}
+			}
+			const float visible = tile.visible ? 1.0f : 0.0f;
+			const float x0 = tx * 3 - 0.5f;
+			const float x1 = tx * 3 + 2.5f;
+			const float z0 = ty * 3 - 0.5f;
+			const float z1 = ty * 3 + 2.5f;
+			const float top = height - 0.5f;
+
+			const int tileType = tile.GetType();
+			if (!tile.visible || (tileType != Type_Water && tileType != Type_Lava))
+			{
+				WriteTiledQuad(job.vertices, job.indices, vIndex, currentIndex, 1, true, top, x0, x1, z0, z1, topCellX, topCellY, visible);
+				vIndex += 4;
+				currentIndex += 6;
+			}
+			for (int side = 0; side < 4; side++)
+			{
+				const int ny = ty + SideY[side];
+				const int nx = tx + SideX[side];
+				const bool onMap = ny >= 0 && nx >= 0 && ny < MAP_SIZE_TILES && nx < MAP_SIZE_TILES;
+				//unexplored tiles only show their sides to explored ones
+				if (!tile.visible && (!onMap || !m_Level->s_Map.m_Tiles[ny][nx].visible)) continue;
+				const bool border = ny < tyStart || ny >= tyEnd || nx < txStart || nx >= txEnd;
+				const float bottom = (border || !tile.visible) ? -0.5f : GetCoarseHeight(ny, nx) - 0.5f;
+				if (bottom >= top) continue;
+
+				const int axis = SideX[side] != 0 ? 0 : 2;
+				const bool front = SideX[side] + SideY[side] > 0;
+				const float plane = axis == 0 ? (front ? x1 : x0) : (front ? z1 : z0);
+				const float a0 = axis == 0 ? z0 : x0;
+				const float a1 = axis == 0 ? z1 : x1;
+				WriteTiledQuad(job.vertices, job.indices, vIndex, currentIndex, axis, front, plane, a0, a1, bottom, top, sideCellX, sideCellY, visible);
+				vIndex += 4;
+				currentIndex += 6;
+			}
+		}
+	}
+	job.numVertices = vIndex;
+	job.numIndices = currentIndex;
+}
 
 bool VoxelObject::CheckWallIsCorner(int x, int y)
 {
@@ -1028,7 +1432,7 @@ bool VoxelObject::CheckWallIsCorner(int x, int y)
 }
 
 
-bool VoxelObject::CreateVertexBuffer(VoxelVertex* vertices, size_t numVertices)
+bool VoxelObject::CreateVertexBuffer(const VoxelVertex* vertices, size_t numVertices)
 {
 	Themp::D3D* d = Themp::System::tSys->m_D3D;
 	D3D11_BUFFER_DESC bd;
@@ -1038,7 +1442,7 @@ bool VoxelObject::CreateVertexBuffer(VoxelVertex* vertices, size_t numVertices)
 
 	//set up for vertices
 	bd.Usage = D3D11_USAGE_DYNAMIC;
-	bd.ByteWidth = sizeof(VoxelVertex) * numVertices;
+	bd.ByteWidth = sizeof(PackedVoxelVertex) * numVertices;
 	bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 
@@ -1050,7 +1454,7 @@ bool VoxelObject::CreateVertexBuffer(VoxelVertex* vertices, size_t numVertices)
 		buf.buf = vertexBuffer;
 		buf.numElements = numVertices;
 		d->m_DevCon->Map(vertexBuffer, NULL, D3D11_MAP_WRITE_DISCARD, NULL, &ms);
-		memcpy(ms.pData, vertices, sizeof(VoxelVertex)*numVertices);
+		VoxelVertexPacking::Pack(vertices, (PackedVoxelVertex*)ms.pData, numVertices);
 		d->m_DevCon->Unmap(vertexBuffer, NULL);
 		m_VertexBuffer = buf;
 		return true;
@@ -1058,7 +1462,7 @@ bool VoxelObject::CreateVertexBuffer(VoxelVertex* vertices, size_t numVertices)
 	System::Print("Could not create vertex buffer!");
 	return false;
 }
-bool VoxelObject::EditVertexBuffer(VoxelVertex* vertices, size_t numVertices)
+bool VoxelObject::EditVertexBuffer(const VoxelVertex* vertices, size_t numVertices)
 {
 	Themp::D3D* d = Themp::System::tSys->m_D3D;
 	Resources::Buffer& buf = m_VertexBuffer;
@@ -1068,7 +1472,7 @@ bool VoxelObject::EditVertexBuffer(VoxelVertex* vertices, size_t numVertices)
 	{
 		if (d->m_DevCon->Map(buf.buf, NULL, D3D11_MAP_WRITE_DISCARD, NULL, &ms) == S_OK)
 		{
-			memcpy(ms.pData, vertices, sizeof(VoxelVertex)*numVertices);
+			VoxelVertexPacking::Pack(vertices, (PackedVoxelVertex*)ms.pData, numVertices);
 			d->m_DevCon->Unmap(buf.buf, NULL);
 			return true;
 		}
@@ -1080,7 +1484,7 @@ bool VoxelObject::EditVertexBuffer(VoxelVertex* vertices, size_t numVertices)
 
 		//set up for vertices
 		bd.Usage = D3D11_USAGE_DYNAMIC;
-		bd.ByteWidth = sizeof(VoxelVertex) * numVertices;
+		bd.ByteWidth = sizeof(PackedVoxelVertex) * numVertices;
 		bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 		bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 
@@ -1090,7 +1494,7 @@ bool VoxelObject::EditVertexBuffer(VoxelVertex* vertices, size_t numVertices)
 		{
 			if (d->m_DevCon->Map(vBuffer, NULL, D3D11_MAP_WRITE_DISCARD, NULL, &ms) == S_OK)
 			{
-				memcpy(ms.pData, vertices, sizeof(VoxelVertex)*numVertices);
+				VoxelVertexPacking::Pack(vertices, (PackedVoxelVertex*)ms.pData, numVertices);
 				d->m_DevCon->Unmap(vBuffer, NULL);
 				buf.buf->Release(); //release old buffer
 				buf.buf = vBuffer;
@@ -1101,7 +1505,7 @@ bool VoxelObject::EditVertexBuffer(VoxelVertex* vertices, size_t numVertices)
 	}
 	return false;
 }
-bool VoxelObject::CreateIndexBuffer(uint32_t* indices, size_t numIndices)
+bool VoxelObject::CreateIndexBuffer(const uint32_t* indices, size_t numIndices)
 {
 	Themp::D3D* d = Themp::System::tSys->m_D3D;
 	HRESULT res;
@@ -1131,7 +1535,7 @@ bool VoxelObject::CreateIndexBuffer(uint32_t* indices, size_t numIndices)
 	System::Print("Could not create index buffer!");
 	return false;
 }
-bool VoxelObject::EditIndexBuffer(uint32_t* indices, size_t numIndices)
+bool VoxelObject::EditIndexBuffer(const uint32_t* indices, size_t numIndices)
 {
 	Themp::D3D* d = Themp::System::tSys->m_D3D;
 	D3D11_MAPPED_SUBRESOURCE ms;
@@ -1185,89 +1589,80 @@ struct GPULight
 	uint32_t lightIndex = 0;
 };
 
-bool VoxelObject::CreateLightBuffer(const std::unordered_map<uint32_t, Light>& lights)
+//Lights are indexed by their LightGrid slot, the vertex shader finds the lights reaching a vertex through the cell it's in
+bool VoxelObject::CreateLightBuffers()
 {
-	Themp::D3D* d = Themp::System::tSys->m_D3D;
-	HRESULT res;
-
-
-	D3D11_BUFFER_DESC bd;
-	D3D11_MAPPED_SUBRESOURCE ms;
-	ZeroMemory(&bd, sizeof(D3D11_BUFFER_DESC));
-	ZeroMemory(&ms, sizeof(D3D11_MAPPED_SUBRESOURCE));
-	//set up for indices
-	bd.Usage = D3D11_USAGE_DYNAMIC;
-	bd.ByteWidth = sizeof(GPULight) * UINT16_MAX;
-	bd.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-	bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	bd.StructureByteStride = sizeof(GPULight);
-	bd.MiscFlags = D3D11_RESOURCE_MISC_FLAG::D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
-	ID3D11Buffer* lightBuffer;
-	Resources::Buffer buf;
-	res = d->m_Device->CreateBuffer(&bd, NULL, &lightBuffer);
-	if (res == S_OK)
+	m_LightBuffer.InitBuf(sizeof(GPULight) * UINT16_MAX, sizeof(GPULight), D3D11_BIND_SHADER_RESOURCE);
+	m_LightBuffer.numElements = UINT16_MAX;
+	m_LightBuffer.InitSRV();
+	m_LightCellBuffer.InitBuf(sizeof(LightGrid::CellRange) * MAP_SIZE_TILES * MAP_SIZE_TILES, sizeof(LightGrid::CellRange), D3D11_BIND_SHADER_RESOURCE);
+	m_LightCellBuffer.numElements = MAP_SIZE_TILES * MAP_SIZE_TILES;
+	m_LightCellBuffer.InitSRV();
+	if (!m_LightBuffer.srv || !m_LightCellBuffer.srv)
 	{
-		buf.buf = lightBuffer;
-		buf.numElements = UINT16_MAX;
-		d->m_DevCon->Map(lightBuffer, NULL, D3D11_MAP_WRITE_DISCARD, NULL, &ms);
-		int index = 0;
-		GPULight* data = static_cast<GPULight*>(ms.pData);
-		for (auto i = lights.begin(); i != lights.end(); i++)
+		System::Print("Could not create light buffer!");
+		return false;
+	}
+	//single block faces are lit per vertex, merged faces per pixel
+	D3D::s_D3D->m_DevCon->VSSetShaderResources(8, 1, &m_LightBuffer.srv);
+	D3D::s_D3D->m_DevCon->PSSetShaderResources(8, 1, &m_LightBuffer.srv);
+	D3D::s_D3D->m_DevCon->VSSetShaderResources(9, 1, &m_LightCellBuffer.srv);
+	D3D::s_D3D->m_DevCon->PSSetShaderResources(9, 1, &m_LightCellBuffer.srv);
+	return true;
+}
+//Only uploads the lights that changed since last time, the cell lists get re-flattened when any light got added, removed or moved to another tile
+void VoxelObject::UploadLights()
+{
+	LightGrid& grid = LevelData::s_LightGrid;
+	ID3D11DeviceContext* devCon = D3D::s_D3D->m_DevCon;
+	if (grid.HasDirtyLights() && m_LightBuffer.buf)
+	{
+		const uint16_t first = grid.GetDirtyMin();
+		const uint16_t last = grid.GetDirtyMax();
+		std::vector<GPULight> data(last - first + 1);
+		for (uint16_t i = first; i <= last && i < grid.GetNumSlots(); i++)
 		{
-			GPULight& dest = data[index];
-			const Light& src = i->second;
-			dest.lightIndex =  src.lightIndex;
+			const Light& src = grid.GetLight(i);
+			GPULight& dest = data[i - first];
+			dest.lightIndex = src.lightIndex;
 			dest.lightIntensity = src.lightIntensity;
 			dest.range = src.range;
 			dest.x = src.x;
 			dest.y = src.y;
 			dest.z = src.z;
-
-			index++;
 		}
-		d->m_DevCon->Unmap(lightBuffer, NULL);
-		m_LightBuffer = buf;
-
-		m_LightBuffer.InitSRV();
-		return true;
+		D3D11_BOX box = { first * (UINT)sizeof(GPULight), 0, 0, (last + 1) * (UINT)sizeof(GPULight), 1, 1 };
+		devCon->UpdateSubresource(m_LightBuffer.buf, 0, &box, data.data(), 0, 0);
+		m_LightUploadStats.lights = last - first + 1;
 	}
-	System::Print("Could not create light buffer!");
-	return false;
-}
-bool VoxelObject::EditLightBuffer(const std::unordered_map<uint32_t, Light>& lights)
-{
-	Themp::D3D* d = Themp::System::tSys->m_D3D;
-	D3D11_MAPPED_SUBRESOURCE ms;
-	ZeroMemory(&ms, sizeof(D3D11_MAPPED_SUBRESOURCE));
-	Resources::Buffer& buf = m_LightBuffer;
-	if (buf.buf) //re-use our buffer
+	else
 	{
-		if (d->m_DevCon->Map(buf.buf, NULL, D3D11_MAP_WRITE_DISCARD, NULL, &ms) == S_OK)
-		{
-			int index = 0;
-			GPULight* data = static_cast<GPULight*>(ms.pData);
-			for (auto i = lights.begin(); i != lights.end(); i++)
-			{
-				GPULight& dest = data[index];
-				const Light& src = i->second;
-				dest.lightIndex = src.lightIndex;
-				dest.lightIntensity = src.lightIntensity;
-				dest.range = src.range;
-				dest.x = src.x;
-				dest.y = src.y;
-				dest.z = src.z;
-
-				index++;
-			}
-			d->m_DevCon->Unmap(buf.buf, NULL);
-			return true;
-		}
+		m_LightUploadStats.lights = 0;
 	}
-	else
+	m_LightUploadStats.cellsRebuilt = false;
+	if (grid.CellsDirty() && m_LightCellBuffer.buf)
 	{
-		return CreateLightBuffer(lights);
+		grid.BuildCellData(m_CellRanges, m_CellIndices);
+		devCon->UpdateSubresource(m_LightCellBuffer.buf, 0, nullptr, m_CellRanges.data(), 0, 0);
+		//StructuredBuffers can't be empty
+		if (m_CellIndices.size() == 0) m_CellIndices.push_back(0);
+		if (m_CellIndices.size() > m_LightIndexBuffer.numElements)
+		{
+			//grow to the next power of two so a few more lights don't recreate it every time
+			size_t capacity = 1024;
+			while (capacity < m_CellIndices.size()) capacity *= 2;
+			CLEAN(m_LightIndexBuffer.srv);
+			CLEAN(m_LightIndexBuffer.buf);
+			m_LightIndexBuffer.InitBuf((int)(sizeof(uint32_t) * capacity), sizeof(uint32_t), D3D11_BIND_SHADER_RESOURCE);
+			m_LightIndexBuffer.numElements = capacity;
+			m_LightIndexBuffer.InitSRV();
+			devCon->VSSetShaderResources(10, 1, &m_LightIndexBuffer.srv);
+			devCon->PSSetShaderResources(10, 1, &m_LightIndexBuffer.srv);
+		}
+		D3D11_BOX box = { 0, 0, 0, (UINT)(sizeof(uint32_t) * m_CellIndices.size()), 1, 1 };
+		devCon->UpdateSubresource(m_LightIndexBuffer.buf, 0, &box, m_CellIndices.data(), 0, 0);
+		m_LightUploadStats.cellsRebuilt = true;
 	}
-	
-	return false;
+	grid.ClearDirty();
 }
 
@@ -2,42 +2,135 @@
 #include <vector>
 #include <d3d11.h>
 #include "ThempTileArrays.h"
+#include "ThempLightGrid.h"
 #include "ThempResources.h"
 namespace Themp
 {
 	class D3D;
 	class Object3D;
 	class LevelData; 
+	class WorkerPool;
 	struct VoxelVertex;
+	struct TileChange;
 	class VoxelObject
 	{
 	public:
+		//where a finished map mesh goes, the map uploads it to its own buffers (UploadMesh), the mesh tests hash it
+		typedef void(*MeshOutputCallback)(void* context, const VoxelVertex* vertices, uint32_t numVertices, const uint32_t* indices, uint32_t numIndices);
+
 		~VoxelObject();
 		VoxelObject(LevelData* level);
+		//doesn't create any D3D resources, every mesh only goes to the output
+		VoxelObject(LevelData* level, MeshOutputCallback output, void* outputContext);
 		void Update(float dt);
-		void DoVoxelBlockVisibleEdge(int y, int x, int yP, int xP, uint32_t & currentIndex, uint32_t & vIndex);
-		void DoVoxelBlockVisibleAnimated(int y, int x, uint32_t & currentIndex, uint32_t & vIndex);
-		void DoVoxelBlockVisible(int z, int y, int x, int yP, int xP, uint32_t & currentIndex, uint32_t & vIndex);
-		void DoVoxelBlockInvisible(int z, int y, int x, int yP, int xP, uint32_t & currentIndex, uint32_t & vIndex);
-		void ConstructFromLevel(int camX, int camY);
+		void DoVoxelBlockVisibleEdge(int y, int x, int yP, int xP, const BlockUVs& block, VoxelVertex* vertices, uint32_t* indices, uint32_t & currentIndex, uint32_t & vIndex);
+		void DoVoxelBlockVisibleAnimated(int y, int x, const BlockUVs& block, VoxelVertex* vertices, uint32_t* indices, uint32_t & currentIndex, uint32_t & vIndex);
+		void DoVoxelBlockVisible(int z, int y, int x, int yP, int xP, const BlockUVs& block, VoxelVertex* vertices, uint32_t* indices, uint32_t & currentIndex, uint32_t & vIndex);
+		void DoVoxelBlockInvisible(int z, int y, int x, int yP, int xP, VoxelVertex* vertices, uint32_t* indices, uint32_t & currentIndex, uint32_t & vIndex);
+		//the side (0, 1) and top (2) uvs and doAnimate a block is drawn with, the block map's own unless the mesher animates them
+		void GetBlockUVs(const BlockUVs& block, int z, int y, int x, XMFLOAT2 uv[3], uint32_t anim[3]) const;
+		//builds and outputs the mesh, only if the map or what's in view changed since the last one
+		void ConstructFromLevel(const XMFLOAT4X4& viewProjection);
+		//the CPU side of ConstructFromLevel, leaves the mesh in m_Vertices/m_Indices, returns false (and leaves them alone) when there's nothing new to build
+		bool BuildMesh(const XMFLOAT4X4& viewProjection, uint32_t& numVertices, uint32_t& numIndices);
+		static void OnTileChanges(void* context, const TileChange* changes, size_t count);
+		static void UploadMesh(void* context, const VoxelVertex* vertices, uint32_t numVertices, const uint32_t* indices, uint32_t numIndices);
+		static void BuildMeshJob(void* context, int jobIndex);
+		void MergeFaces(uint32_t& numVertices, uint32_t& numIndices);
 		bool CheckWallIsCorner(int x, int y);
-		bool CreateVertexBuffer(VoxelVertex * vertices, size_t numVertices);
-		bool EditVertexBuffer(VoxelVertex * vertices, size_t numVertices);
-		bool CreateIndexBuffer(uint32_t * indices, size_t numIndices);
-		bool EditIndexBuffer(uint32_t * indices, size_t numIndices);
-		bool CreateLightBuffer(const std::unordered_map<uint32_t, Light>& lights);
-		bool EditLightBuffer(const std::unordered_map<uint32_t, Light>& lights);
+		bool CreateVertexBuffer(const VoxelVertex * vertices, size_t numVertices);
+		bool EditVertexBuffer(const VoxelVertex * vertices, size_t numVertices);
+		bool CreateIndexBuffer(const uint32_t * indices, size_t numIndices);
+		bool EditIndexBuffer(const uint32_t * indices, size_t numIndices);
+		bool CreateLightBuffers();
+		void UploadLights();
 		Object3D* m_Obj3D = nullptr;
-		float m_AnimationTime = 0;
-		uint8_t m_AnimationIndex = 0;
+
+		//doAnimate bit for faces that flip through texture frames in voxel_vs.hlsl, 5 a second off the frame time in the constant buffer.
+		//The face is built with the first frame, the rest sit next to it in the same row of the atlas.
+		static const uint32_t AnimateFrames = 4;
+		//with AnimateFrames, there's 4 frames instead of 8
+		static const uint32_t AnimateFourFrames = 8;
 
 		size_t m_NumBlocks = 0;
 		VoxelVertex* m_Vertices = nullptr;
-		Light* m_Lights = nullptr;
 		uint32_t* m_Indices = nullptr;
 		Resources::Buffer m_VertexBuffer;
 		Resources::Buffer m_IndexBuffer;
 		Resources::Buffer m_LightBuffer;
+		Resources::Buffer m_LightCellBuffer;
+		Resources::Buffer m_LightIndexBuffer;
+		std::vector<LightGrid::CellRange> m_CellRanges;
+		std::vector<uint32_t> m_CellIndices;
+		struct LightUploadStats
+		{
+			uint32_t lights = 0;
+			bool cellsRebuilt = false;
+		} m_LightUploadStats;
+
+		//merge coplanar faces with the same texture into bigger quads before uploading
+		static bool s_GreedyMeshing;
+		struct MeshStats
+		{
+			uint32_t vertices = 0;
+			uint32_t indices = 0;
+			uint32_t uploadedVertices = 0;
+			uint32_t uploadedIndices = 0;
+			uint32_t mergedFaces = 0;
+			uint32_t mergedQuads = 0;
+			long long buildMicroseconds = 0;
+			uint32_t chunks = 0;
+			uint32_t coarseChunks = 0;
+		} m_MeshStats;
+
+		//a square of tiles that's culled and meshed as one, ConstructFromLevel hands the visible ones out to the worker pool
+		static const int MeshChunkTiles = 4;
+		static const int MeshChunkSubtiles = MeshChunkTiles * 3;
+		static const int NumMeshChunks = (MAP_SIZE_TILES - 1) / MeshChunkTiles;
+		static int s_MeshThreads;
+		struct MeshJob
+		{
+			int yStart = 0, yEnd = 0;
+			int xStart = 0, xEnd = 0;
+			size_t numBlocks = 0;
+			VoxelVertex* vertices = nullptr;
+			uint32_t* indices = nullptr;
+			uint32_t numVertices = 0;
+			uint32_t numIndices = 0;
+			bool coarse = false;
+			//the block uvs of the explored tiles the job covers, put together at the start of every build (LevelData::GetTileUVs)
+			std::vector<TileUVs> tileUVs;
+		};
+		std::vector<MeshJob> m_MeshJobs;
+		size_t m_NumMeshJobs = 0;
+		//what the last mesh was built from: the map (any tile event makes it dirty), the chunks in view and how, and the settings
+		bool m_MeshDirty = true;
+		std::vector<uint16_t> m_BuiltChunks;
+		bool m_BuiltGreedy = false;
+		WorkerPool* m_MeshPool = nullptr;
+
+		//Chunks that only cover a small part of the screen get a box per tile instead of their blocks, see BuildCoarseChunk.
+		//A chunk goes coarse below s_LodScreenSize (how much of the screen it covers) and only comes back a bit above it so it doesn't flip back and forth on the edge.
+		//The boxes go up to the highest block of their tile and down to the floor on the chunk's edge, so a chunk next to a full detail one has no holes (see ThempCoarseLodTests).
+		static bool s_CoarseLod;
+		static float s_LodScreenSize;
+		bool m_ChunkCoarse[NumMeshChunks][NumMeshChunks] = {};
+		//how much of the screen a box covers across its wider side (1 is all of it), anything reaching behind the near plane counts as huge
+		static float GetScreenSize(const XMFLOAT4X4& viewProjection, const XMFLOAT3& boxMin, const XMFLOAT3& boxMax);
+		void BuildCoarseChunk(MeshJob& job);
+		//the top of the highest block on a tile, what a coarse box is built up to
+		int GetCoarseHeight(int y, int x) const;
+		//a row of mergeable faces (inclusive ranges in subtiles), grown into rectangles by MergeFaces
+		struct FaceRun
+		{
+			uint32_t key;
+			int a0, a1, b0, b1;
+		};
+		std::vector<uint64_t> m_MergeFaces;
+		std::vector<FaceRun> m_MergeRuns;
+
+		MeshOutputCallback m_MeshOutput = nullptr;
+		void* m_MeshOutputContext = nullptr;
 
 		//Level to construct this VoxelObject from.
 		LevelData* m_Level = nullptr;
@@ -0,0 +1,45 @@
+#include "ThempVoxelVertexPacking.h"
+#include "../Engine/ThempD3D.h"
+#include "../Engine/ThempMesh.h"
+#include <cassert>
+using namespace Themp;
+
+uint16_t VoxelVertexPacking::Quantize(float value, int scale, int offset)
+{
+	const float scaled = (value + offset) * scale + 0.5f;
+	assert(scaled >= 0.0f && scaled < 65536.0f);
+	return (uint16_t)scaled;
+}
+
+void VoxelVertexPacking::Pack(const VoxelVertex& in, PackedVoxelVertex& out)
+{
+	out.x = Quantize(in.x, PositionScale, PositionOffset);
+	out.y = Quantize(in.y, PositionScale, PositionOffset);
+	out.z = Quantize(in.z, PositionScale, PositionOffset);
+	//block normals only ever point along the positive axes
+	const uint16_t axis = in.nx > 0.5f ? 0 : in.ny > 0.5f ? 1 : 2;
+	out.flags = axis | (in.visible > 0.5f ? VisibleBit : 0) | (uint16_t)((in.doAnimate & AnimateMask) << AnimateShift);
+	out.u = Quantize(in.u, UScale, 0);
+	out.v = Quantize(in.v, VScale, 0);
+}
+void VoxelVertexPacking::Unpack(const PackedVoxelVertex& in, VoxelVertex& out)
+{
+	out.x = (float)in.x / PositionScale - PositionOffset;
+	out.y = (float)in.y / PositionScale - PositionOffset;
+	out.z = (float)in.z / PositionScale - PositionOffset;
+	const uint16_t axis = in.flags & NormalMask;
+	out.nx = axis == 0 ? 1.0f : 0.0f;
+	out.ny = axis == 1 ? 1.0f : 0.0f;
+	out.nz = axis == 2 ? 1.0f : 0.0f;
+	out.u = (float)in.u / UScale;
+	out.v = (float)in.v / VScale;
+	out.visible = (in.flags & VisibleBit) ? 1.0f : 0.0f;
+	out.doAnimate = (in.flags >> AnimateShift) & AnimateMask;
+}
+void VoxelVertexPacking::Pack(const VoxelVertex* in, PackedVoxelVertex* out, size_t numVertices)
+{
+	for (size_t i = 0; i < numVertices; i++)
+	{
+		Pack(in[i], out[i]);
+	}
+}
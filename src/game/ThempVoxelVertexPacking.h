@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+namespace Themp
+{
+	struct VoxelVertex;
+	struct PackedVoxelVertex;
+	//Converts the VoxelVertex the map mesh is built with into the PackedVoxelVertex that goes to the GPU (voxel_vs.hlsl unpacks it again).
+	//Positions are kept in 1/16th of a subtile, shifted by one so the -0.5 edges on the map border still fit,
+	//uvs in half texels of the block atlas (that's all the block faces ever use) and the normal as the axis it's on.
+	class VoxelVertexPacking
+	{
+	public:
+		VoxelVertexPacking() = delete;
+		~VoxelVertexPacking() = delete;
+
+		static const int PositionScale = 16;
+		static const int PositionOffset = 1;
+		static const int UScale = 512;	//256 pixels wide, 2 per texel
+		static const int VScale = 4352; //2176 pixels high, 2 per texel
+
+		//flags: bits 0-1 normal axis, bit 2 visible, bits 3-6 doAnimate
+		static const uint16_t NormalMask = 0x3;
+		static const uint16_t VisibleBit = 0x4;
+		static const int AnimateShift = 3;
+		static const uint16_t AnimateMask = 0xF;
+
+		static void Pack(const VoxelVertex& in, PackedVoxelVertex& out);
+		static void Unpack(const PackedVoxelVertex& in, VoxelVertex& out);
+		//straight into a mapped vertex buffer
+		static void Pack(const VoxelVertex* in, PackedVoxelVertex* out, size_t numVertices);
+	private:
+		static uint16_t Quantize(float value, int scale, int offset);
+	};
+};
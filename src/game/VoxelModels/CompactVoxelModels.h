@@ -0,0 +1,1005 @@
+//Generated by ConvertVoxelModels.py from the model headers in this folder, don't edit by hand, change the models and re-run the script instead
+#pragma once
+#include <cstdint>
+namespace Themp
+{
+	namespace CompactVoxelModels
+	{
+		constexpr int NumModels = 54;
+		constexpr int NumUVSets = 38;
+		constexpr int NumPathTiles = 9;
+
+		//atlas cells for the x side, y side and top
+		constexpr uint8_t UVSets[NumUVSets][6] =
+		{
+			{ 2,9,2,9,2,9 },
+			{ 3,0,3,0,3,0 },
+			{ 6,23,6,23,6,34 },
+			{ 0,0,0,0,0,0 },
+			{ 6,23,6,23,0,0 },
+			{ 6,23,6,23,0,34 },
+			{ 0,0,0,0,0,6 },
+			{ 0,0,0,0,0,26 },
+			{ 0,0,0,0,6,25 },
+			{ 1,14,1,14,6,25 },
+			{ 5,14,5,14,6,25 },
+			{ 4,25,4,25,5,25 },
+			{ 4,25,4,25,0,0 },
+			{ 1,14,1,14,5,27 },
+			{ 2,14,2,14,5,27 },
+			{ 7,27,7,27,5,27 },
+			{ 6,27,6,27,5,27 },
+			{ 1,26,1,26,0,26 },
+			{ 0,0,0,0,3,14 },
+			{ 2,0,2,0,2,0 },
+			{ 0,2,0,2,5,27 },
+			{ 7,1,7,1,5,27 },
+			{ 6,1,6,1,5,27 },
+			{ 1,2,1,2,7,1 },
+			{ 0,0,0,0,7,23 },
+			{ 0,0,0,0,0,24 },
+			{ 0,0,0,0,1,24 },
+			{ 0,0,0,0,2,24 },
+			{ 0,0,0,0,3,24 },
+			{ 0,0,0,0,4,24 },
+			{ 0,0,0,0,5,24 },
+			{ 0,0,0,0,6,24 },
+			{ 0,0,0,0,7,24 },
+			{ 2,0,2,0,3,14 },
+			{ 6,12,6,12,0,26 },
+			{ 1,12,1,12,0,26 },
+			{ 2,12,2,12,0,26 },
+			{ 1,13,1,13,0,13 },
+		};
+
+		//PathFindTile constructor arguments
+		struct PathTile
+		{
+			float cost;
+			uint8_t height;
+			bool walkable;
+		};
+		constexpr PathTile PathTiles[NumPathTiles] =
+		{
+			{ 999999.0f, 6, false },
+			{ 1.0f, 2, true },
+			{ 1.0f, 1, true },
+			{ 1.0f, 4, true },
+			{ 1.0f, 3, true },
+			{ 1.0f, 8, false },
+			{ 99999.0f, 7, false },
+			{ 99999.0f, 7, true },
+			{ 1.0f, 2, false },
+		};
+
+		//a byte of occupancy per subtile column (bit z), a UV set per block and a path tile per subtile, in RenderTile order
+		struct Model
+		{
+			uint8_t occupancy[9];
+			uint8_t uvSet[72];
+			uint8_t pathTile[9];
+			uint16_t activeBlocks;
+		};
+		constexpr Model Models[NumModels] =
+		{
+			//Rock (0)
+			{
+				{ 0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F },
+				{
+					0,0,0,0,0,0,0,0,
+					0,0,0,0,0,0,0,0,
+					0,0,0,0,0,0,0,0,
+					0,0,0,0,0,0,0,0,
+					0,0,0,0,0,0,0,0,
+					0,0,0,0,0,0,0,0,
+					0,0,0,0,0,0,0,0,
+					0,0,0,0,0,0,0,0,
+					0,0,0,0,0,0,0,0,
+				},
+				{ 0,0,0,0,0,0,0,0,0 },
+				54,
+			},
+			//FullBlock (1)
+			{
+				{ 0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F },
+				{
+					1,1,1,1,1,1,1,1,
+					1,1,1,1,1,1,1,1,
+					1,1,1,1,1,1,1,1,
+					1,1,1,1,1,1,1,1,
+					1,1,1,1,1,1,1,1,
+					1,1,1,1,1,1,1,1,
+					1,1,1,1,1,1,1,1,
+					1,1,1,1,1,1,1,1,
+					1,1,1,1,1,1,1,1,
+				},
+				{ 0,0,0,0,0,0,0,0,0 },
+				54,
+			},
+			//GroundBlock (2)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					2,2,3,3,3,3,3,3,
+					2,2,3,3,3,3,3,3,
+					2,2,3,3,3,3,3,3,
+					2,2,3,3,3,3,3,3,
+					4,5,3,3,3,3,3,3,
+					2,2,3,3,3,3,3,3,
+					2,2,3,3,3,3,3,3,
+					2,2,3,3,3,3,3,3,
+					2,2,3,3,3,3,3,3,
+				},
+				{ 1,1,1,1,1,1,1,1,1 },
+				18,
+			},
+			//LiquidBlock (3)
+			{
+				{ 0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01 },
+				{
+					6,6,6,6,6,6,6,6,
+					6,6,6,6,6,6,6,6,
+					6,6,6,6,6,6,6,6,
+					6,6,6,6,6,6,6,6,
+					6,6,6,6,6,6,6,6,
+					6,6,6,6,6,6,6,6,
+					6,6,6,6,6,6,6,6,
+					6,6,6,6,6,6,6,6,
+					6,6,6,6,6,6,6,6,
+				},
+				{ 2,2,2,2,2,2,2,2,2 },
+				9,
+			},
+			//DungeonHeart 0 (4)
+			{
+				{ 0x03,0x03,0x0F,0x03,0x07,0x0F,0x0F,0x0F,0xFF },
+				{
+					7,7,3,3,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+					8,8,9,10,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+					11,11,11,12,12,12,12,12,
+					8,8,9,10,3,3,3,3,
+					8,8,9,10,3,3,3,3,
+					8,8,9,10,3,3,3,3,
+					13,13,13,14,13,14,15,16,
+				},
+				{ 1,1,3,1,4,3,3,3,5 },
+				33,
+			},
+			//DungeonHeart 1 (5)
+			{
+				{ 0x03,0x03,0x03,0x07,0x07,0x07,0x0F,0x0F,0x0F },
+				{
+					17,17,3,3,3,3,3,3,
+					17,17,3,3,3,3,3,3,
+					17,17,3,3,3,3,3,3,
+					17,17,17,3,3,3,3,3,
+					17,17,17,3,3,3,3,3,
+					17,17,17,3,3,3,3,3,
+					17,17,17,17,3,3,3,3,
+					17,17,17,17,3,3,3,3,
+					17,17,17,17,3,3,3,3,
+				},
+				{ 1,1,1,4,4,4,3,3,3 },
+				27,
+			},
+			//DungeonHeart 2 (6)
+			{
+				{ 0x0F,0x03,0x03,0x0F,0x07,0x03,0xFF,0x0F,0x0F },
+				{
+					8,8,9,10,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+					8,8,9,10,3,3,3,3,
+					11,11,11,12,12,12,12,12,
+					7,7,3,3,3,3,3,3,
+					13,13,13,14,13,14,15,16,
+					8,8,9,10,3,3,3,3,
+					8,8,9,10,3,3,3,3,
+				},
+				{ 3,1,1,3,4,1,5,3,3 },
+				33,
+			},
+			//DungeonHeart 3 (7)
+			{
+				{ 0x03,0x07,0x0F,0x03,0x07,0x0F,0x03,0x07,0x0F },
+				{
+					17,17,3,3,3,3,3,3,
+					17,17,17,3,3,3,3,3,
+					17,17,17,17,3,3,3,3,
+					17,17,3,3,3,3,3,3,
+					17,17,17,3,3,3,3,3,
+					17,17,17,17,3,3,3,3,
+					17,17,3,3,3,3,3,3,
+					17,17,17,3,3,3,3,3,
+					17,17,17,17,3,3,3,3,
+				},
+				{ 1,4,3,1,4,3,1,4,3 },
+				27,
+			},
+			//DungeonHeart 4 (8)
+			{
+				{ 0x0F,0x0F,0x0F,0x0F,0x0F,0x0F,0x0F,0x0F,0x0F },
+				{
+					7,7,7,7,3,3,3,3,
+					7,7,7,7,3,3,3,3,
+					7,7,7,7,3,3,3,3,
+					7,7,7,7,3,3,3,3,
+					7,7,7,7,3,3,3,3,
+					7,7,7,7,3,3,3,3,
+					7,7,7,7,3,3,3,3,
+					7,7,7,7,3,3,3,3,
+					7,7,7,7,3,3,3,3,
+				},
+				{ 3,3,3,3,3,3,3,3,3 },
+				36,
+			},
+			//DungeonHeart 5 (9)
+			{
+				{ 0x0F,0x07,0x03,0x0F,0x07,0x03,0x0F,0x07,0x03 },
+				{
+					17,17,17,17,3,3,3,3,
+					17,17,17,3,3,3,3,3,
+					17,17,3,3,3,3,3,3,
+					17,17,17,17,3,3,3,3,
+					17,17,17,3,3,3,3,3,
+					17,17,3,3,3,3,3,3,
+					17,17,17,17,3,3,3,3,
+					17,17,17,3,3,3,3,3,
+					17,17,3,3,3,3,3,3,
+				},
+				{ 3,3,1,3,4,1,3,4,1 },
+				27,
+			},
+			//DungeonHeart 6 (10)
+			{
+				{ 0x0F,0x0F,0xFF,0x03,0x07,0x0F,0x03,0x03,0x0F },
+				{
+					8,8,9,10,3,3,3,3,
+					8,8,9,10,3,3,3,3,
+					13,13,13,14,13,14,15,16,
+					7,7,3,3,3,3,3,3,
+					11,11,11,12,12,12,12,12,
+					8,8,9,10,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+					8,8,9,10,3,3,3,3,
+				},
+				{ 3,3,5,1,4,3,1,1,3 },
+				33,
+			},
+			//DungeonHeart 7 (11)
+			{
+				{ 0x0F,0x0F,0x0F,0x07,0x07,0x07,0x03,0x03,0x03 },
+				{
+					17,17,17,17,3,3,3,3,
+					17,17,17,17,3,3,3,3,
+					17,17,17,17,3,3,3,3,
+					17,17,17,3,3,3,3,3,
+					17,17,17,3,3,3,3,3,
+					17,17,17,3,3,3,3,3,
+					17,17,3,3,3,3,3,3,
+					17,17,3,3,3,3,3,3,
+					17,17,3,3,3,3,3,3,
+				},
+				{ 3,3,3,4,4,4,1,1,1 },
+				27,
+			},
+			//DungeonHeart 8 (12)
+			{
+				{ 0xFF,0x0F,0x0F,0x0F,0x07,0x03,0x0F,0x03,0x03 },
+				{
+					13,13,13,14,13,14,15,16,
+					8,8,9,10,3,3,3,3,
+					8,8,9,10,3,3,3,3,
+					8,8,9,10,3,3,3,3,
+					11,11,11,12,12,12,12,12,
+					7,7,3,3,3,3,3,3,
+					8,8,9,10,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+				},
+				{ 5,3,3,3,4,1,3,1,1 },
+				33,
+			},
+			//DungeonHeart 9 (13)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,3,3,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+					7,7,3,3,3,3,3,3,
+				},
+				{ 1,1,1,1,1,1,1,1,1 },
+				18,
+			},
+			//Portal 0 (14)
+			{
+				{ 0x03,0x03,0x03,0x03,0x07,0x07,0x03,0x07,0xFF },
+				{
+					18,18,3,3,3,3,3,3,
+					18,18,3,3,3,3,3,3,
+					18,18,9,10,3,3,3,3,
+					18,18,3,3,3,3,3,3,
+					19,19,19,12,12,12,12,12,
+					19,19,19,10,3,3,3,3,
+					18,18,9,10,3,3,3,3,
+					19,19,19,10,3,3,3,3,
+					19,19,19,20,21,21,22,23,
+				},
+				{ 1,1,1,1,4,4,1,4,5 },
+				27,
+			},
+			//Portal 1 (15)
+			{
+				{ 0x03,0x03,0x03,0x07,0x07,0x07,0x83,0x83,0x83 },
+				{
+					18,18,3,3,3,3,3,3,
+					18,18,3,3,3,3,3,3,
+					18,18,3,3,3,3,3,3,
+					19,19,19,12,12,12,12,12,
+					19,19,19,12,12,12,12,12,
+					19,19,19,12,12,12,12,12,
+					19,19,3,3,3,3,3,23,
+					19,19,3,3,3,3,3,23,
+					19,19,3,3,3,3,3,23,
+				},
+				{ 1,1,1,4,4,4,1,1,1 },
+				24,
+			},
+			//Portal 2 (16)
+			{
+				{ 0x03,0x03,0x03,0x07,0x07,0x03,0xFF,0x07,0x03 },
+				{
+					18,18,3,3,3,3,3,3,
+					18,18,3,3,3,3,3,3,
+					18,18,9,10,3,3,3,3,
+					19,19,19,12,12,12,12,12,
+					19,19,19,10,3,3,3,3,
+					18,18,3,3,3,3,3,3,
+					19,19,19,20,21,21,22,23,
+					19,19,19,10,3,3,3,3,
+					18,18,9,10,3,3,3,3,
+				},
+				{ 1,1,1,4,4,1,5,4,1 },
+				27,
+			},
+			//Portal 3 (17)
+			{
+				{ 0x03,0x07,0x83,0x03,0x07,0x83,0x03,0x07,0x83 },
+				{
+					18,18,3,3,3,3,3,3,
+					19,19,19,12,12,12,12,12,
+					19,19,19,12,12,12,12,23,
+					18,18,3,3,3,3,3,3,
+					19,19,19,12,12,12,12,12,
+					19,19,19,12,12,12,12,23,
+					18,18,3,3,3,3,3,3,
+					19,19,19,12,12,12,12,12,
+					19,19,19,12,12,12,12,23,
+				},
+				{ 1,4,1,1,4,1,1,4,1 },
+				24,
+			},
+			//Portal 4 (18)
+			{
+				{ 0x81,0x81,0x81,0x81,0x81,0x81,0x81,0x81,0x81 },
+				{
+					3,3,3,3,3,3,3,24,
+					3,3,3,3,3,3,3,25,
+					3,3,3,3,3,3,3,26,
+					3,3,3,3,3,3,3,27,
+					3,3,3,3,3,3,3,28,
+					3,3,3,3,3,3,3,29,
+					3,3,3,3,3,3,3,30,
+					3,3,3,3,3,3,3,31,
+					3,3,3,3,3,3,3,32,
+				},
+				{ 2,2,2,2,2,2,2,2,2 },
+				18,
+			},
+			//Portal 5 (19)
+			{
+				{ 0x83,0x07,0x03,0x83,0x07,0x03,0x83,0x07,0x03 },
+				{
+					19,19,19,12,12,12,12,23,
+					19,19,19,12,12,12,12,12,
+					18,18,3,3,3,3,3,3,
+					19,19,19,12,12,12,12,23,
+					19,19,19,12,12,12,12,12,
+					18,18,3,3,3,3,3,3,
+					19,19,19,12,12,12,12,23,
+					19,19,19,12,12,12,12,12,
+					18,18,3,3,3,3,3,3,
+				},
+				{ 1,4,1,1,4,1,1,4,1 },
+				24,
+			},
+			//Portal 6 (20)
+			{
+				{ 0x03,0x07,0xFF,0x03,0x07,0x07,0x03,0x03,0x03 },
+				{
+					18,18,9,10,3,3,3,3,
+					19,19,19,10,3,3,3,3,
+					19,19,19,20,21,21,22,23,
+					18,18,3,3,3,3,3,3,
+					19,19,19,12,12,12,12,12,
+					19,19,19,10,3,3,3,3,
+					18,18,3,3,3,3,3,3,
+					18,18,3,3,3,3,3,3,
+					18,18,9,10,3,3,3,3,
+				},
+				{ 1,4,5,1,4,4,1,1,1 },
+				27,
+			},
+			//Portal 7 (21)
+			{
+				{ 0x83,0x83,0x83,0x07,0x07,0x07,0x03,0x03,0x03 },
+				{
+					19,19,3,3,3,3,3,23,
+					19,19,3,3,3,3,3,23,
+					19,19,3,3,3,3,3,23,
+					19,19,19,12,12,12,12,12,
+					19,19,19,12,12,12,12,12,
+					19,19,19,12,12,12,12,12,
+					18,18,3,3,3,3,3,3,
+					18,18,3,3,3,3,3,3,
+					18,18,3,3,3,3,3,3,
+				},
+				{ 1,1,1,4,4,4,1,1,1 },
+				24,
+			},
+			//Portal 8 (22)
+			{
+				{ 0xFF,0x07,0x03,0x07,0x07,0x03,0x03,0x03,0x03 },
+				{
+					19,19,19,20,21,21,22,23,
+					19,19,19,19,3,3,3,3,
+					18,18,9,10,3,3,3,3,
+					18,18,19,3,3,3,3,3,
+					19,19,19,12,12,12,12,12,
+					33,33,19,10,3,3,3,3,
+					18,18,3,3,3,3,3,3,
+					18,18,3,3,3,3,3,3,
+					18,18,9,10,3,3,3,3,
+				},
+				{ 5,4,1,4,4,1,1,1,1 },
+				27,
+			},
+			//Portal 9 (23)
+			{
+				{ 0x81,0x81,0x81,0x81,0x81,0x81,0x81,0x81,0x81 },
+				{
+					3,3,3,3,3,3,3,24,
+					3,3,3,3,3,3,3,25,
+					3,3,3,3,3,3,3,26,
+					3,3,3,3,3,3,3,27,
+					3,3,3,3,3,3,3,28,
+					3,3,3,3,3,3,3,29,
+					3,3,3,3,3,3,3,30,
+					3,3,3,3,3,3,3,31,
+					3,3,3,3,3,3,3,32,
+				},
+				{ 2,2,2,2,2,2,2,2,2 },
+				18,
+			},
+			//Library 0 (24)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x7F },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,1,1,1,1,6 },
+				23,
+			},
+			//Library 1 (25)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,1,1,1,1,1 },
+				18,
+			},
+			//Library 2 (26)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x7F,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,1,1,6,1,1 },
+				23,
+			},
+			//Library 3 (27)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,1,1,1,1,1 },
+				18,
+			},
+			//Library 4 (28)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,1,1,1,1,1 },
+				18,
+			},
+			//Library 5 (29)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,1,1,1,1,1 },
+				18,
+			},
+			//Library 6 (30)
+			{
+				{ 0x03,0x03,0x7F,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,6,1,1,1,1,1,1 },
+				23,
+			},
+			//Library 7 (31)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,1,1,1,1,1 },
+				18,
+			},
+			//Library 8 (32)
+			{
+				{ 0x7F,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 6,1,1,1,1,1,1,1,1 },
+				23,
+			},
+			//Library 9 (33)
+			{
+				{ 0x7F,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 6,1,1,1,1,1,1,1,1 },
+				23,
+			},
+			//Barracks 0 (34)
+			{
+				{ 0x03,0x03,0x03,0x03,0x01,0x01,0x03,0x01,0x7F },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,2,2,1,1,6 },
+				20,
+			},
+			//Barracks 1 (35)
+			{
+				{ 0x03,0x03,0x03,0x01,0x01,0x01,0x01,0x01,0x01 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,1,1,1,1,1 },
+				12,
+			},
+			//Barracks 2 (36)
+			{
+				{ 0x03,0x03,0x03,0x01,0x01,0x03,0x7F,0x01,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,2,2,1,6,2,1 },
+				20,
+			},
+			//Barracks 3 (37)
+			{
+				{ 0x03,0x01,0x01,0x03,0x01,0x01,0x03,0x01,0x01 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,2,2,1,2,2,1,2,2 },
+				12,
+			},
+			//Barracks 4 (38)
+			{
+				{ 0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 2,2,2,2,2,2,2,2,2 },
+				9,
+			},
+			//Barracks 5 (39)
+			{
+				{ 0x01,0x01,0x03,0x01,0x01,0x03,0x01,0x01,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 2,2,1,2,2,1,2,2,1 },
+				12,
+			},
+			//Barracks 6 (40)
+			{
+				{ 0x03,0x01,0x7F,0x03,0x01,0x01,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,2,7,1,2,2,1,1,1 },
+				20,
+			},
+			//Barracks 7 (41)
+			{
+				{ 0x01,0x01,0x01,0x01,0x01,0x01,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 2,2,2,2,2,2,1,1,1 },
+				12,
+			},
+			//Barracks 8 (42)
+			{
+				{ 0x7F,0x01,0x03,0x01,0x01,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 7,2,1,2,2,1,1,1,1 },
+				20,
+			},
+			//Barracks 9 (43)
+			{
+				{ 0x7F,0x01,0x03,0x01,0x01,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 7,2,1,2,2,1,1,1,1 },
+				20,
+			},
+			//RoomWithPillars 0 (44)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x7F },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					34,34,34,35,36,35,37,7,
+				},
+				{ 1,1,1,1,1,1,1,1,6 },
+				23,
+			},
+			//RoomWithPillars 1 (45)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,1,1,1,1,1 },
+				18,
+			},
+			//RoomWithPillars 2 (46)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x7F,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					34,34,34,35,36,35,37,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,1,1,6,1,1 },
+				23,
+			},
+			//RoomWithPillars 3 (47)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,1,1,1,1,1 },
+				18,
+			},
+			//RoomWithPillars 4 (48)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,1,1,1,1,1 },
+				18,
+			},
+			//RoomWithPillars 5 (49)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,1,1,1,1,1 },
+				18,
+			},
+			//RoomWithPillars 6 (50)
+			{
+				{ 0x03,0x03,0x7F,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					34,34,34,35,36,35,37,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,6,1,1,1,1,1,1 },
+				23,
+			},
+			//RoomWithPillars 7 (51)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 1,1,1,1,1,1,1,1,1 },
+				18,
+			},
+			//RoomWithPillars 8 (52)
+			{
+				{ 0x7F,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					34,34,34,35,36,35,37,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 6,1,1,1,1,1,1,1,1 },
+				23,
+			},
+			//RoomWithPillars 9 (53)
+			{
+				{ 0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03 },
+				{
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+					7,7,7,7,7,7,7,7,
+				},
+				{ 8,1,1,1,1,1,1,1,1 },
+				18,
+			},
+		};
+	}
+};
@@ -0,0 +1,88 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+
+using namespace Themp;
+using namespace DirectX;
+
+namespace
+{
+	//fills a tile back in the way digging does it in reverse, through an area update
+	void FillTile(LevelData& level, int y, int x)
+	{
+		LevelData::s_Map.m_Tiles[y][x].type = Type_Earth;
+		level.UpdateArea(y - 1, y + 1, x - 1, x + 1);
+	}
+	uint32_t Code(int y, int x)
+	{
+		return LevelData::s_Map.m_Tiles[y][x].areaCode;
+	}
+	//every walkable tile is listed under its own area and nowhere else
+	bool WalkableListsMatch(LevelData& level)
+	{
+		size_t listed = 0;
+		for (auto& area : level.m_AreaWalkableTiles)
+		{
+			for (const XMINT2& p : area.second)
+			{
+				if (Code(p.y, p.x) != area.first) return false;
+			}
+			listed += area.second.size();
+		}
+		size_t walkable = 0;
+		for (int y = 0; y < MAP_SIZE_TILES; y++)
+		{
+			for (int x = 0; x < MAP_SIZE_TILES; x++)
+			{
+				walkable += LevelData::s_Map.m_Tiles[y][x].areaCode != 0 && IsWalkable(LevelData::s_Map.m_Tiles[y][x].GetType());
+			}
+		}
+		return listed == walkable;
+	}
+}
+
+THEMP_TEST(Area_CloseWithoutSplitKeepsCodes)
+{
+	LevelData* level = Test::CreateTestLevel();
+	const uint32_t dungeon = Code(36, 36);
+	const uint32_t cave = Code(15, 15);
+	THEMP_CHECK(dungeon != 0 && Code(42, 60) == dungeon);
+
+	//a corner of the dungeon, everything around it stays connected
+	FillTile(*level, 35, 35);
+	THEMP_CHECK(Code(35, 35) == 0);
+	THEMP_CHECK(Code(36, 36) == dungeon);
+	THEMP_CHECK(Code(48, 48) == dungeon);
+	THEMP_CHECK(Code(42, 60) == dungeon);
+	THEMP_CHECK(Code(15, 15) == cave);
+	THEMP_CHECK(WalkableListsMatch(*level));
+	delete level;
+}
+
+THEMP_TEST(Area_CloseSplitRelabelsSmallerPiece)
+{
+	LevelData* level = Test::CreateTestLevel();
+	const uint32_t dungeon = Code(36, 36);
+	const size_t dungeonTiles = level->m_AreaWalkableTiles[dungeon].size();
+
+	//cut the corridor, the end of it becomes its own area and the dungeon keeps its code
+	FillTile(*level, 42, 56);
+	const uint32_t corridorEnd = Code(42, 60);
+	THEMP_CHECK(Code(36, 36) == dungeon);
+	THEMP_CHECK(Code(42, 55) == dungeon);
+	THEMP_CHECK(corridorEnd != 0 && corridorEnd != dungeon);
+	THEMP_CHECK(Code(42, 57) == corridorEnd && Code(42, 62) == corridorEnd);
+	THEMP_CHECK(level->m_AreaWalkableTiles[corridorEnd].size() == 6);
+	THEMP_CHECK(level->m_AreaWalkableTiles[dungeon].size() == dungeonTiles - 7);
+	THEMP_CHECK(WalkableListsMatch(*level));
+
+	//digging it out again joins them back up, the way DestroyTile does it (minus the sounds)
+	LevelData::s_Map.m_Tiles[42][56].type = Type_Unclaimed_Path;
+	level->OpenTile(42, 56);
+	level->UpdateArea(41, 43, 55, 57);
+	THEMP_CHECK(Code(42, 56) == Code(36, 36));
+	THEMP_CHECK(Code(42, 60) == Code(36, 36));
+	THEMP_CHECK(WalkableListsMatch(*level));
+	delete level;
+}
@@ -0,0 +1,117 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+#include <vector>
+
+using namespace Themp;
+
+namespace
+{
+	const int Claims = 10;
+	//ten imps finishing their claims along the corridor out of the dungeon in the same turn
+	void Claim(LevelData& level, int i)
+	{
+		const int x = 51 + i;
+		LevelData::s_Map.m_Tiles[42][x].type = Type_Claimed_Land;
+		LevelData::s_Map.m_Tiles[42][x].owner = Owner_PlayerRed;
+		level.QueueAreaUpdate(41, 43, x - 1, x + 1);
+	}
+	std::vector<uint8_t> Blocks(const LevelData& level)
+	{
+		std::vector<uint8_t> result((const uint8_t*)level.m_TileModels, (const uint8_t*)level.m_TileModels + sizeof(level.m_TileModels));
+		for (int y = 0; y < MAP_SIZE_TILES; y++)
+		{
+			for (int x = 0; x < MAP_SIZE_TILES; x++)
+			{
+				TileUVs uvs;
+				level.GetTileUVs(y, x, uvs);
+				result.insert(result.end(), (const uint8_t*)uvs.blocks, (const uint8_t*)uvs.blocks + sizeof(uvs.blocks));
+			}
+		}
+		result.insert(result.end(), (const uint8_t*)level.m_BlockOccupancy, (const uint8_t*)level.m_BlockOccupancy + sizeof(level.m_BlockOccupancy));
+		result.insert(result.end(), (const uint8_t*)LevelData::s_Map.m_Tiles, (const uint8_t*)LevelData::s_Map.m_Tiles + sizeof(LevelData::s_Map.m_Tiles));
+		return result;
+	}
+}
+
+//Edits queued in the same turn come out of the flush as one update over the merged area, and leave the map the way updating after every edit does
+THEMP_TEST(AreaUpdates_CoalesceEditsInATurn)
+{
+	LevelData* level = Test::CreateTestLevel();
+	for (int i = 0; i < Claims; i++)
+	{
+		Claim(*level, i);
+	}
+	level->FlushAreaUpdates();
+	const LevelData::AreaUpdateStats stats = level->m_AreaUpdateStats;
+	THEMP_CHECK(stats.queuedLastFlush == Claims);
+	THEMP_CHECK(stats.applied == 1);
+	THEMP_CHECK(stats.tiles == 3 * (Claims + 2));
+	THEMP_CHECK(level->m_QueuedAreaUpdates.size() == 0);
+	const std::vector<uint8_t> coalesced = Blocks(*level);
+	delete level;
+
+	level = Test::CreateTestLevel();
+	for (int i = 0; i < Claims; i++)
+	{
+		Claim(*level, i);
+		level->FlushAreaUpdates();
+		THEMP_CHECK(level->m_AreaUpdateStats.applied == 1);
+		THEMP_CHECK(level->m_AreaUpdateStats.tiles == 9);
+	}
+	THEMP_CHECK(Blocks(*level) == coalesced);
+
+	//rects that don't touch aren't merged into one covering the ground between them
+	LevelData::s_Map.m_Tiles[25][25].type = Type_Unclaimed_Path;
+	level->QueueAreaUpdate(24, 26, 24, 26);
+	LevelData::s_Map.m_Tiles[25][60].type = Type_Unclaimed_Path;
+	level->QueueAreaUpdate(24, 26, 59, 61);
+	level->FlushAreaUpdates();
+	THEMP_CHECK(level->m_AreaUpdateStats.applied == 2);
+	THEMP_CHECK(level->m_AreaUpdateStats.tiles == 18);
+	delete level;
+}
+
+//UpdateArea calls and tiles gone through per turn, every edit updated on its own against one flush a turn
+THEMP_BENCHMARK(AreaUpdates_ClaimsPerTurn)
+{
+	LevelData* level = Test::CreateTestLevel();
+	const int turns = 50;
+	double time[2] = {};
+	uint32_t updates[2] = {}, tiles[2] = {};
+	for (int pass = 0; pass < 2; pass++)
+	{
+		Timer timer;
+		timer.StartTime();
+		for (int turn = 0; turn < turns; turn++)
+		{
+			//claim the corridor and dig it back out again every other turn
+			for (int i = 0; i < Claims; i++)
+			{
+				const int x = 51 + i;
+				LevelData::s_Map.m_Tiles[42][x].type = turn % 2 ? Type_Unclaimed_Path : Type_Claimed_Land;
+				LevelData::s_Map.m_Tiles[42][x].owner = turn % 2 ? Owner_PlayerNone : Owner_PlayerRed;
+				level->QueueAreaUpdate(41, 43, x - 1, x + 1);
+				if (pass == 0)
+				{
+					level->FlushAreaUpdates();
+					updates[pass] += level->m_AreaUpdateStats.applied;
+					tiles[pass] += level->m_AreaUpdateStats.tiles;
+				}
+			}
+			if (pass == 1)
+			{
+				level->FlushAreaUpdates();
+				updates[pass] += level->m_AreaUpdateStats.applied;
+				tiles[pass] += level->m_AreaUpdateStats.tiles;
+			}
+		}
+		time[pass] = timer.GetDeltaTimeMicro() / 1000.0 / turns;
+	}
+	char details[160];
+	snprintf(details, sizeof(details), "%.1f updates over %.1f tiles a turn, updating every edit took %.3f ms for %.1f updates over %.1f tiles",
+		updates[1] / (double)turns, tiles[1] / (double)turns, time[0], updates[0] / (double)turns, tiles[0] / (double)turns);
+	Test::Report("AreaUpdates 10 claims a turn", time[1], details);
+	delete level;
+}
@@ -0,0 +1,106 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+
+using namespace Themp;
+
+namespace
+{
+	//every mask as it is against what it would be worked out from scratch
+	int StaleMasks(const LevelData& level)
+	{
+		int stale = 0;
+		for (int z = 0; z < MAP_SIZE_HEIGHT; z++)
+		{
+			for (int y = 0; y < MAP_SIZE_SUBTILES_RENDER; y++)
+			{
+				for (int x = 0; x < MAP_SIZE_SUBTILES_RENDER; x++)
+				{
+					const uint8_t expected = (uint8_t)((level.IsBlockActive(z, y, x) ? LevelData::Face_Solid : 0) | level.GetExposedFaces(z, y, x));
+					stale += level.m_BlockFaces[z][y][x] != expected;
+				}
+			}
+		}
+		return stale;
+	}
+	//changes a tile and lets the level catch up the way a dig or a claim does
+	void SetTile(LevelData& level, int y, int x, uint16_t type, uint8_t owner)
+	{
+		LevelData::s_Map.m_Tiles[y][x].type = type;
+		LevelData::s_Map.m_Tiles[y][x].owner = owner;
+		level.QueueAreaUpdate(y - 1, y + 1, x - 1, x + 1);
+		level.FlushAreaUpdates();
+	}
+}
+
+//A short session of digging, claiming and filling in, after every step the masks have to be what a full rebuild would make them
+THEMP_TEST(BlockFaces_MatchFullRebuildAfterEdits)
+{
+	LevelData* level = Test::CreateTestLevel();
+	THEMP_CHECK(StaleMasks(*level) == 0);
+
+	//dig out of the dungeon's north wall and on into the earth
+	for (int y = 34; y >= 30; y--)
+	{
+		SetTile(*level, y, 42, Type_Unclaimed_Path, Owner_PlayerNone);
+		THEMP_CHECK(StaleMasks(*level) == 0);
+	}
+	//claim it
+	for (int y = 34; y >= 30; y--)
+	{
+		SetTile(*level, y, 42, Type_Claimed_Land, Owner_PlayerRed);
+		THEMP_CHECK(StaleMasks(*level) == 0);
+	}
+	//reinforce the walls along it and dig through into the water
+	SetTile(*level, 32, 41, Type_Wall0, Owner_PlayerRed);
+	SetTile(*level, 32, 43, Type_Wall0, Owner_PlayerRed);
+	SetTile(*level, 38, 51, Type_Unclaimed_Path, Owner_PlayerNone);
+	THEMP_CHECK(StaleMasks(*level) == 0);
+	//a room in the dungeon and the pillar dug away
+	for (int y = 36; y <= 38; y++)
+	{
+		for (int x = 36; x <= 38; x++)
+		{
+			LevelData::s_Map.m_Tiles[y][x].type = Type_Treasure_Room;
+		}
+	}
+	level->QueueAreaUpdate(35, 39, 35, 39);
+	SetTile(*level, 41, 41, Type_Claimed_Land, Owner_PlayerRed);
+	THEMP_CHECK(StaleMasks(*level) == 0);
+	//and filled back in, next to the rock on the map border too
+	SetTile(*level, 32, 42, Type_Earth, Owner_PlayerNone);
+	SetTile(*level, 1, 1, Type_Unclaimed_Path, Owner_PlayerNone);
+	THEMP_CHECK(StaleMasks(*level) == 0);
+	SetTile(*level, 1, 1, Type_Earth, Owner_PlayerNone);
+	THEMP_CHECK(StaleMasks(*level) == 0);
+	delete level;
+}
+
+//what keeping the masks costs per dug tile, against working every mask out again
+THEMP_BENCHMARK(BlockFaces_MaintenancePerEdit)
+{
+	LevelData* level = Test::CreateTestLevel();
+	const int edits = 200;
+	uint64_t facesRefreshed = 0;
+	Timer timer;
+	timer.StartTime();
+	for (int i = 0; i < edits; i++)
+	{
+		//dig a line of tiles in the earth north of the dungeon, then fill it back in
+		const int y = 22 + (i % 10);
+		const int x = 30 + i / 20;
+		SetTile(*level, y, x, i % 20 < 10 ? Type_Unclaimed_Path : Type_Earth, Owner_PlayerNone);
+		facesRefreshed += level->m_AreaUpdateStats.facesRefreshed;
+	}
+	const double perEdit = timer.GetDeltaTimeMicro() / 1000.0 / edits;
+
+	timer.StartTime();
+	level->UpdateAllBlockFaces();
+	const double fullRebuild = timer.GetDeltaTimeMicro() / 1000.0;
+
+	char details[128];
+	snprintf(details, sizeof(details), "%.0f masks refreshed per edit, every mask over again takes %.3f ms", (double)facesRefreshed / edits, fullRebuild);
+	Test::Report("BlockFaces dig or fill a tile", perEdit, details);
+	delete level;
+}
@@ -0,0 +1,433 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+#include "ThempVoxelObject.h"
+#include "../Engine/ThempD3D.h"
+#include "../Engine/ThempMesh.h"
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <vector>
+#include <cmath>
+
+using namespace Themp;
+using namespace DirectX;
+
+namespace
+{
+	//the highest top face on every tile, -1 for none
+	struct TileTops
+	{
+		std::vector<float> top;
+	};
+	void CollectTops(void* context, const VoxelVertex* vertices, uint32_t numVertices, const uint32_t* indices, uint32_t numIndices)
+	{
+		TileTops* out = (TileTops*)context;
+		out->top.assign(MAP_SIZE_TILES * MAP_SIZE_TILES, -1.0f);
+		for (uint32_t q = 0; q < numVertices / 4; q++)
+		{
+			const VoxelVertex* v = &vertices[q * 4];
+			if (v[0].ny < 0.5f) continue;
+			//a block face is centered on its subtile, a coarse box on the middle subtile of its tile
+			const float x = (v[0].x + v[1].x + v[2].x + v[3].x) * 0.25f;
+			const float z = (v[0].z + v[1].z + v[2].z + v[3].z) * 0.25f;
+			const int tx = (int)floor((x + 0.5f) / 3.0f);
+			const int ty = (int)floor((z + 0.5f) / 3.0f);
+			float& top = out->top[ty * MAP_SIZE_TILES + tx];
+			top = std::max(top, v[0].y);
+		}
+	}
+	XMFLOAT4X4 GetTopView()
+	{
+		const float mapCenter = MAP_SIZE_SUBTILES_RENDER * 0.5f;
+		const XMMATRIX result = XMMatrixLookToLH(XMVectorSet(mapCenter, 50.0f, mapCenter, 1), XMVectorSet(0, -1, 0, 0), XMVectorSet(0, 0, 1, 0))
+			* XMMatrixOrthographicLH((float)MAP_SIZE_SUBTILES_RENDER, (float)MAP_SIZE_SUBTILES_RENDER, 0.1f, 1000.0f);
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, result);
+		return viewProjection;
+	}
+	//The faces of a mesh, bucketed by the subtile column (x, z) they touch so a ray only has to look at the columns it goes through
+	struct Quad
+	{
+		//the axis the face is on, its sign and where on that axis it is
+		int axis;
+		float normal;
+		float plane;
+		float min[3], max[3];
+	};
+	struct MeshQuads
+	{
+		std::vector<Quad> quads;
+		std::vector<std::vector<uint32_t>> columns;
+	};
+	void CollectQuads(void* context, const VoxelVertex* vertices, uint32_t numVertices, const uint32_t* indices, uint32_t numIndices)
+	{
+		MeshQuads* out = (MeshQuads*)context;
+		out->quads.clear();
+		out->columns.assign(MAP_SIZE_SUBTILES_RENDER * MAP_SIZE_SUBTILES_RENDER, std::vector<uint32_t>());
+		for (uint32_t q = 0; q < numVertices / 4; q++)
+		{
+			const VoxelVertex* v = &vertices[q * 4];
+			Quad quad;
+			const float n[3] = { v[0].nx, v[0].ny, v[0].nz };
+			quad.axis = fabsf(n[0]) > 0.5f ? 0 : (fabsf(n[1]) > 0.5f ? 1 : 2);
+			quad.normal = n[quad.axis] > 0 ? 1.0f : -1.0f;
+			for (int a = 0; a < 3; a++)
+			{
+				quad.min[a] = FLT_MAX;
+				quad.max[a] = -FLT_MAX;
+			}
+			for (int i = 0; i < 4; i++)
+			{
+				const float p[3] = { v[i].x, v[i].y, v[i].z };
+				for (int a = 0; a < 3; a++)
+				{
+					quad.min[a] = std::min(quad.min[a], p[a]);
+					quad.max[a] = std::max(quad.max[a], p[a]);
+				}
+			}
+			quad.plane = quad.min[quad.axis];
+			const uint32_t index = (uint32_t)out->quads.size();
+			out->quads.push_back(quad);
+			//faces on a column's edge go in both columns
+			const int x0 = std::max(0, (int)floor(quad.min[0] + 0.5f - 0.01f));
+			const int x1 = std::min(MAP_SIZE_SUBTILES_RENDER - 1, (int)floor(quad.max[0] + 0.5f + 0.01f));
+			const int z0 = std::max(0, (int)floor(quad.min[2] + 0.5f - 0.01f));
+			const int z1 = std::min(MAP_SIZE_SUBTILES_RENDER - 1, (int)floor(quad.max[2] + 0.5f + 0.01f));
+			for (int z = z0; z <= z1; z++)
+			{
+				for (int x = x0; x <= x1; x++)
+				{
+					out->columns[z * MAP_SIZE_SUBTILES_RENDER + x].push_back(index);
+				}
+			}
+		}
+	}
+	//How far a ray goes before it hits the front of a face, FLT_MAX if it leaves the map. hitAxis is the axis of that face.
+	//Walks the columns under the ray (they're a subtile wide, centered on the subtiles like the blocks) and stops at the first column with a hit in it.
+	float CastRay(const MeshQuads& mesh, const float origin[3], const float dir[3], int& hitAxis)
+	{
+		int cell[2] = { (int)floor(origin[0] + 0.5f), (int)floor(origin[2] + 0.5f) };
+		const float d[2] = { dir[0], dir[2] };
+		const float o[2] = { origin[0], origin[2] };
+		float tNext[2], tStep[2];
+		int step[2];
+		for (int a = 0; a < 2; a++)
+		{
+			step[a] = d[a] > 0 ? 1 : -1;
+			tStep[a] = d[a] != 0 ? fabsf(1.0f / d[a]) : FLT_MAX;
+			const float edge = d[a] > 0 ? cell[a] + 0.5f : cell[a] - 0.5f;
+			tNext[a] = d[a] != 0 ? (edge - o[a]) / d[a] : FLT_MAX;
+		}
+		float best = FLT_MAX;
+		while (cell[0] >= 0 && cell[1] >= 0 && cell[0] < MAP_SIZE_SUBTILES_RENDER && cell[1] < MAP_SIZE_SUBTILES_RENDER)
+		{
+			const std::vector<uint32_t>& column = mesh.columns[cell[1] * MAP_SIZE_SUBTILES_RENDER + cell[0]];
+			for (size_t i = 0; i < column.size(); i++)
+			{
+				const Quad& quad = mesh.quads[column[i]];
+				//only the front of a face gets drawn
+				if (dir[quad.axis] * quad.normal >= 0) continue;
+				const float t = (quad.plane - origin[quad.axis]) / dir[quad.axis];
+				if (t <= 0 || t >= best) continue;
+				bool inside = true;
+				for (int a = 0; a < 3 && inside; a++)
+				{
+					if (a == quad.axis) continue;
+					const float p = origin[a] + dir[a] * t;
+					inside = p >= quad.min[a] - 0.001f && p <= quad.max[a] + 0.001f;
+				}
+				if (inside)
+				{
+					best = t;
+					hitAxis = quad.axis;
+				}
+			}
+			const int a = tNext[0] < tNext[1] ? 0 : 1;
+			if (best <= tNext[a]) break;
+			//under the floor and still going down, nothing left to hit
+			if (dir[1] < 0 && origin[1] + dir[1] * tNext[a] < -1.0f) break;
+			cell[a] += step[a];
+			tNext[a] += tStep[a];
+		}
+		return best;
+	}
+	//a perspective camera, the matrix for the mesher and the ray through every pixel of a small screen
+	struct TestCamera
+	{
+		XMFLOAT3 position;
+		XMFLOAT3 forward;
+		XMFLOAT4X4 viewProjection;
+		float right[3], up[3], ahead[3];
+		float tanHalfFov, aspect;
+	};
+	TestCamera MakeCamera(XMFLOAT3 position, XMFLOAT3 forward)
+	{
+		TestCamera camera;
+		camera.position = position;
+		camera.forward = forward;
+		const float fov = XMConvertToRadians(75.0f);
+		camera.aspect = 16.0f / 9.0f;
+		camera.tanHalfFov = tanf(fov * 0.5f);
+		const XMVECTOR f = XMVector3Normalize(XMLoadFloat3(&forward));
+		const XMVECTOR r = XMVector3Normalize(XMVector3Cross(XMVectorSet(0, 1, 0, 0), f));
+		const XMVECTOR u = XMVector3Cross(f, r);
+		XMFLOAT3 ff, rr, uu;
+		XMStoreFloat3(&ff, f);
+		XMStoreFloat3(&rr, r);
+		XMStoreFloat3(&uu, u);
+		const float a[3] = { ff.x, ff.y, ff.z }, b[3] = { rr.x, rr.y, rr.z }, c[3] = { uu.x, uu.y, uu.z };
+		for (int i = 0; i < 3; i++)
+		{
+			camera.ahead[i] = a[i];
+			camera.right[i] = b[i];
+			camera.up[i] = c[i];
+		}
+		const XMMATRIX result = XMMatrixLookToLH(XMVectorSet(position.x, position.y, position.z, 1), XMVectorSet(forward.x, forward.y, forward.z, 0), XMVectorSet(0, 1, 0, 0))
+			* XMMatrixPerspectiveFovLH(fov, camera.aspect, 0.1f, 1000.0f);
+		XMStoreFloat4x4(&camera.viewProjection, result);
+		return camera;
+	}
+	void GetRay(const TestCamera& camera, int px, int py, int width, int height, float origin[3], float dir[3])
+	{
+		//the middle of the pixel, y goes up the screen
+		const float sx = ((px + 0.5f) / width * 2.0f - 1.0f) * camera.tanHalfFov * camera.aspect;
+		const float sy = (1.0f - (py + 0.5f) / height * 2.0f) * camera.tanHalfFov;
+		const float p[3] = { camera.position.x, camera.position.y, camera.position.z };
+		for (int i = 0; i < 3; i++)
+		{
+			origin[i] = p[i];
+			dir[i] = camera.ahead[i] + camera.right[i] * sx + camera.up[i] * sy;
+		}
+	}
+	//the pixels where the mesh with coarse chunks shows something further away than the full detail one, what's behind a crack.
+	//The liquid layer covers the floor under water and lava, a coarse box leaves the top off those like it's done for the blocks
+	int CountCracks(const MeshQuads& blocks, const MeshQuads& mixed, const TestCamera& camera, int width, int height, int& hits)
+	{
+		int cracks = 0;
+		hits = 0;
+		for (int py = 0; py < height; py++)
+		{
+			for (int px = 0; px < width; px++)
+			{
+				float origin[3], dir[3];
+				GetRay(camera, px, py, width, height, origin, dir);
+				int blockAxis = -1, mixedAxis = -1;
+				const float tBlocks = CastRay(blocks, origin, dir, blockAxis);
+				if (tBlocks == FLT_MAX) continue;
+				hits++;
+				const float tMixed = CastRay(mixed, origin, dir, mixedAxis);
+				if (tMixed <= tBlocks + 0.001f) continue;
+				if (blockAxis == 1)
+				{
+					const int tx = (int)floor((origin[0] + dir[0] * tBlocks + 0.5f) / 3.0f);
+					const int ty = (int)floor((origin[2] + dir[2] * tBlocks + 0.5f) / 3.0f);
+					const uint16_t type = LevelData::s_Map.m_Tiles[ty][tx].GetType();
+					if (type == Type_Water || type == Type_Lava) continue;
+				}
+				cracks++;
+			}
+		}
+		return cracks;
+	}
+	int CountCoarse(const VoxelObject& mesher)
+	{
+		int coarse = 0;
+		for (int cy = 0; cy < VoxelObject::NumMeshChunks; cy++)
+		{
+			for (int cx = 0; cx < VoxelObject::NumMeshChunks; cx++)
+			{
+				coarse += mesher.m_ChunkCoarse[cy][cx];
+			}
+		}
+		return coarse;
+	}
+
+	//a pillar of blocks on a claimed tile in the dungeon, up through the layers the raycasts never look at
+	void BuildPillar(LevelData& level, int y, int x)
+	{
+		for (int z = 2; z < MAP_SIZE_HEIGHT; z++)
+		{
+			level.SetBlockActive(z, y * 3 + 1, x * 3 + 1, true);
+		}
+		level.UpdateAllBlockFaces();
+	}
+}
+
+//A coarse box goes up to the highest block on its tile, counting every layer of the map
+THEMP_TEST(CoarseLod_HeightCoversEveryLayer)
+{
+	//on by default, the crack and flicker tests below are what it has to keep passing
+	THEMP_CHECK(VoxelObject::s_CoarseLod);
+	LevelData* level = Test::CreateTestLevel();
+	BuildPillar(*level, 38, 44);
+	{
+		TileTops tops;
+		VoxelObject mesher(level, CollectTops, &tops);
+		int wrong = 0;
+		for (int y = 0; y < MAP_SIZE_TILES; y++)
+		{
+			for (int x = 0; x < MAP_SIZE_TILES; x++)
+			{
+				int expected = 6;
+				if (LevelData::s_Map.m_Tiles[y][x].visible)
+				{
+					expected = 0;
+					for (int z = 0; z < MAP_SIZE_HEIGHT; z++)
+					{
+						for (int s = 0; s < 9; s++)
+						{
+							if (level->IsBlockActive(z, y * 3 + s / 3, x * 3 + s % 3)) expected = z + 1;
+						}
+					}
+				}
+				wrong += mesher.GetCoarseHeight(y, x) != expected;
+			}
+		}
+		THEMP_CHECK(wrong == 0);
+		THEMP_CHECK(mesher.GetCoarseHeight(38, 44) == MAP_SIZE_HEIGHT);
+		THEMP_CHECK(mesher.GetCoarseHeight(-1, 0) == 0 && mesher.GetCoarseHeight(0, MAP_SIZE_TILES) == 0);
+	}
+	delete level;
+}
+
+//Seen from above, every explored tile's coarse box has its top where the tile's highest block face is
+THEMP_TEST(CoarseLod_BoxesReachTheTopBlocks)
+{
+	const bool coarseLod = VoxelObject::s_CoarseLod;
+	const float lodScreenSize = VoxelObject::s_LodScreenSize;
+	LevelData* level = Test::CreateTestLevel();
+	BuildPillar(*level, 38, 44);
+	TileTops blocks, boxes;
+	{
+		VoxelObject mesher(level, CollectTops, &blocks);
+		VoxelObject::s_CoarseLod = false;
+		mesher.ConstructFromLevel(GetTopView());
+		THEMP_CHECK(mesher.m_MeshStats.coarseChunks == 0);
+
+		//every chunk coarse
+		mesher.m_MeshOutputContext = &boxes;
+		VoxelObject::s_CoarseLod = true;
+		VoxelObject::s_LodScreenSize = 2.0f;
+		mesher.ConstructFromLevel(GetTopView());
+		THEMP_CHECK(mesher.m_MeshStats.coarseChunks == mesher.m_MeshStats.chunks);
+	}
+	VoxelObject::s_CoarseLod = coarseLod;
+	VoxelObject::s_LodScreenSize = lodScreenSize;
+
+	int compared = 0, wrong = 0;
+	for (int y = 0; y < MAP_SIZE_TILES - 1; y++)
+	{
+		for (int x = 0; x < MAP_SIZE_TILES - 1; x++)
+		{
+			const Tile& tile = LevelData::s_Map.m_Tiles[y][x];
+			//liquid surfaces are in the liquid layer for both
+			if (!tile.visible || tile.GetType() == Type_Water || tile.GetType() == Type_Lava) continue;
+			compared++;
+			wrong += blocks.top[y * MAP_SIZE_TILES + x] != boxes.top[y * MAP_SIZE_TILES + x];
+		}
+	}
+	THEMP_CHECK(compared > 0);
+	THEMP_CHECK(wrong == 0);
+	THEMP_CHECK(boxes.top[38 * MAP_SIZE_TILES + 44] == MAP_SIZE_HEIGHT - 0.5f);
+	delete level;
+}
+
+//Where a coarse chunk meets one built from its blocks nothing may show through: every pixel sees something at least as close
+//as it would with every chunk at full detail. Two of the benchmark cameras looking across the map, with the far chunks coarse
+THEMP_TEST(CoarseLod_NoCracksAtChunkBorders)
+{
+	const bool coarseLod = VoxelObject::s_CoarseLod;
+	const bool greedy = VoxelObject::s_GreedyMeshing;
+	LevelData* level = Test::CreateTestLevel();
+	BuildPillar(*level, 38, 44);
+	const TestCamera cameras[] =
+	{
+		MakeCamera(XMFLOAT3(230.0f, 10.0f, 230.0f), XMFLOAT3(-0.7f, -0.2f, -0.7f)),
+		MakeCamera(XMFLOAT3(20.0f, 20.0f, 20.0f), XMFLOAT3(0.5f, -0.7f, 0.5f)),
+	};
+	for (int settings = 0; settings < 2; settings++)
+	{
+		VoxelObject::s_GreedyMeshing = settings == 1;
+		for (const TestCamera& camera : cameras)
+		{
+			MeshQuads blocks, mixed;
+			{
+				VoxelObject mesher(level, CollectQuads, &blocks);
+				VoxelObject::s_CoarseLod = false;
+				mesher.ConstructFromLevel(camera.viewProjection);
+				mesher.m_MeshOutputContext = &mixed;
+				VoxelObject::s_CoarseLod = true;
+				mesher.ConstructFromLevel(camera.viewProjection);
+				//both kinds of chunks in view, or there's no border to look at
+				THEMP_CHECK(mesher.m_MeshStats.coarseChunks > 0 && mesher.m_MeshStats.coarseChunks < mesher.m_MeshStats.chunks);
+			}
+			int hits = 0;
+			THEMP_CHECK(CountCracks(blocks, mixed, camera, 320, 180, hits) == 0);
+			THEMP_CHECK(hits > 320 * 180 / 2);
+		}
+	}
+	VoxelObject::s_CoarseLod = coarseLod;
+	VoxelObject::s_GreedyMeshing = greedy;
+	delete level;
+}
+
+//A camera backing away turns chunks coarse and never back, coming closer again turns them back and never coarse,
+//and going back and forth a little on the switching distance doesn't make anything pop in and out
+THEMP_TEST(CoarseLod_TransitionsDontFlicker)
+{
+	const bool coarseLod = VoxelObject::s_CoarseLod;
+	VoxelObject::s_CoarseLod = true;
+	LevelData* level = Test::CreateTestLevel();
+	{
+		MeshQuads mesh;
+		VoxelObject mesher(level, CollectQuads, &mesh);
+		const XMFLOAT3 forward(0.5f, -0.7f, 0.5f);
+		const int steps = 12;
+		int wrongWay = 0, flips = 0;
+		bool before[VoxelObject::NumMeshChunks][VoxelObject::NumMeshChunks];
+		int switchStep = -1;
+		for (int pass = 0; pass < 2; pass++)
+		{
+			for (int i = 0; i < steps; i++)
+			{
+				//out and back in again on the same spots
+				const int s = pass == 0 ? i : steps - 1 - i;
+				const XMFLOAT3 position(60.0f - s * 4.0f * forward.x, 20.0f - s * 4.0f * forward.y, 60.0f - s * 4.0f * forward.z);
+				memcpy(before, mesher.m_ChunkCoarse, sizeof(before));
+				mesher.ConstructFromLevel(MakeCamera(position, forward).viewProjection);
+				for (int cy = 0; cy < VoxelObject::NumMeshChunks; cy++)
+				{
+					for (int cx = 0; cx < VoxelObject::NumMeshChunks; cx++)
+					{
+						const bool now = mesher.m_ChunkCoarse[cy][cx];
+						if (now == before[cy][cx]) continue;
+						flips++;
+						wrongWay += now != (pass == 0);
+						if (pass == 0 && switchStep < 0 && i > 0) switchStep = s;
+					}
+				}
+			}
+		}
+		THEMP_CHECK(flips > 0);
+		THEMP_CHECK(wrongWay == 0);
+		THEMP_CHECK(switchStep > 0);
+
+		//half a subtile back and forth where a chunk just switched, only the first time round may change anything
+		int jitterFlips = 0;
+		for (int i = 0; i < 10; i++)
+		{
+			const float s = switchStep * 4.0f - (i % 2) * 0.5f;
+			const XMFLOAT3 position(60.0f - s * forward.x, 20.0f - s * forward.y, 60.0f - s * forward.z);
+			memcpy(before, mesher.m_ChunkCoarse, sizeof(before));
+			mesher.ConstructFromLevel(MakeCamera(position, forward).viewProjection);
+			if (i >= 2) jitterFlips += memcmp(before, mesher.m_ChunkCoarse, sizeof(before)) != 0;
+		}
+		THEMP_CHECK(jitterFlips == 0);
+		THEMP_CHECK(CountCoarse(mesher) > 0);
+	}
+	VoxelObject::s_CoarseLod = coarseLod;
+	delete level;
+}
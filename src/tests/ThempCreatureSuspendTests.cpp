@@ -0,0 +1,159 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevel.h"
+#include "ThempLevelData.h"
+#include "ThempTimerWheel.h"
+#include "ThempObject3D.h"
+#include "Creature/ThempCreature.h"
+#include "Creature/ThempCreatureTaskManager.h"
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace Themp;
+
+namespace
+{
+	typedef CreatureTaskManager CTM;
+
+	bool IsWaiting(Creature* imp)
+	{
+		const std::vector<Creature*>& waiting = CTM::WaitingImps[imp->m_Owner];
+		return std::find(waiting.begin(), waiting.end(), imp) != waiting.end();
+	}
+	//runs single turns until the creature suspended itself, false if it never did
+	bool RunUntilSuspended(Level* level, Creature* c, int maxTurns)
+	{
+		for (int t = 0; t < maxTurns && !c->m_Suspend.suspended; t++)
+		{
+			Test::RunTurns(level, 1);
+		}
+		return c->m_Suspend.suspended;
+	}
+}
+
+//A suspended creature only wakes on what it waits for, the timer being one of them always
+THEMP_TEST(Creature_SuspendWakesOnItsConditions)
+{
+	Creature::SuspendState state;
+	THEMP_CHECK(!state.Wake(Creature::Wake_Any));
+	THEMP_CHECK(state.Suspend(Creature::Wake_TaskAvailable));
+	THEMP_CHECK(!state.Suspend(Creature::Wake_EnemyInRange));
+	THEMP_CHECK(state.WaitsOn(Creature::Wake_Timer) && state.WaitsOn(Creature::Wake_TaskAvailable) && !state.WaitsOn(Creature::Wake_EnemyInRange));
+	THEMP_CHECK(!state.Wake(Creature::Wake_EnemyInRange));
+	THEMP_CHECK(state.suspended);
+	THEMP_CHECK(state.Wake(Creature::Wake_TaskAvailable));
+	THEMP_CHECK(!state.suspended && !state.WaitsOn(Creature::Wake_Any));
+	THEMP_CHECK(!state.Wake(Creature::Wake_TaskAvailable));
+	THEMP_CHECK(state.Suspend(0));
+	THEMP_CHECK(!state.Wake(Creature::Wake_TaskAvailable));
+	THEMP_CHECK(state.Wake(Creature::Wake_Timer));
+	THEMP_CHECK(state.Suspend(Creature::Wake_EnemyInRange));
+	THEMP_CHECK(state.Wake(Creature::Wake_Any));
+}
+
+//An imp without work sleeps on the task manager's waiting list between searches, its search timer wakes it up to look again
+//and a dig mark wakes it right away, it gets the task on the same turn and goes and digs the tile out
+THEMP_TEST(Creature_IdleImpSleepsBetweenSearches)
+{
+	Level* level = Test::CreateTestWorld();
+	//nothing to do on the map, the claims and walls the dungeon starts with are gone
+	CTM::Clear();
+	srand(6);
+	Creature* imp = Test::AddTestCreature(level, CreatureData::CREATURE_IMP, Owner_PlayerRed, XMINT2(45, 45));
+	const int turns = 20 * 60;
+	int suspendedTurns = 0, waitingWhileSuspended = 0, wakeUps = 0, otherOrders = 0, idleAwake = 0;
+	bool wasSuspended = false;
+	for (int t = 0; t < turns; t++)
+	{
+		Test::RunTurns(level, 1);
+		const bool suspended = imp->m_Suspend.suspended;
+		suspendedTurns += suspended;
+		waitingWhileSuspended += suspended && IsWaiting(imp) && Creature::s_NumSuspended == 1;
+		wakeUps += wasSuspended && !suspended;
+		otherOrders += imp->m_Order.valid && imp->m_Order.orderType != CTM::Order_IdleMovement;
+		idleAwake += !suspended && !imp->m_Order.valid;
+		wasSuspended = suspended;
+	}
+	THEMP_CHECK(otherOrders == 0);
+	//every search waits 20 to 38 turns and ends in a short walk, it's never awake without somewhere to walk to
+	THEMP_CHECK(idleAwake == 0);
+	THEMP_CHECK(suspendedTurns > turns / 3);
+	THEMP_CHECK(waitingWhileSuspended == suspendedTurns);
+	THEMP_CHECK(wakeUps >= turns / 100 && wakeUps <= turns / 20 + 1);
+
+	//marking the pillar's corner wakes it straight away, it asks and gets the task at the end of the next turn
+	THEMP_CHECK(RunUntilSuspended(level, imp, 200));
+	THEMP_CHECK(level->m_LevelData->MarkTile(Owner_PlayerRed, 41, 41));
+	THEMP_CHECK(!imp->m_Suspend.suspended && !IsWaiting(imp) && Creature::s_NumSuspended == 0);
+	THEMP_CHECK(!TimerWheel::IsPending(imp->m_TaskSearchTimer));
+	Test::RunTurns(level, 1);
+	THEMP_CHECK(imp->m_Order.valid && imp->m_Order.orderType == CTM::Order_Mine);
+	THEMP_CHECK(imp->m_Order.targetTilePos.x == 41 && imp->m_Order.targetTilePos.y == 41);
+	THEMP_CHECK(CTM::TaskedImps[Owner_PlayerRed].count(imp) == 1);
+
+	//5 hits of 8 turns each and the walk there
+	int dugOut = -1;
+	for (int t = 0; t < 400 && dugOut < 0; t++)
+	{
+		Test::RunTurns(level, 1);
+		if (LevelData::s_Map.m_Tiles[41][41].GetType() == Type_Unclaimed_Path) dugOut = t;
+	}
+	THEMP_CHECK(dugOut >= 5 * 8);
+	THEMP_CHECK(CTM::MiningTasks[Owner_PlayerRed].size() == 0);
+	//the freshly dug tile is the next thing to claim
+	THEMP_CHECK(CTM::ClaimingTasks[Owner_PlayerRed].count(&LevelData::s_Map.m_Tiles[41][41]) == 1);
+	delete level;
+}
+
+//200 idle imps in the dungeon with 40 heroes in the other cave for them to scan every full update, a minute of game turns with them suspended
+//between searches against every one of them running its full update every turn
+THEMP_BENCHMARK(Creature_200IdleImps)
+{
+	const int numImps = 200;
+	const int turns = 20 * 60;
+	double time[2] = {};
+	uint64_t suspendedTurns[2] = {};
+	for (int pass = 0; pass < 2; pass++)
+	{
+		Level* level = Test::CreateTestWorld();
+		CTM::Clear();
+		srand(7);
+		LevelData* levelData = level->m_LevelData;
+		const int areaCode = LevelData::s_Map.m_Tiles[40][40].areaCode;
+		const int caveAreaCode = LevelData::s_Map.m_Tiles[15][15].areaCode;
+		std::vector<Creature*> imps(numImps);
+		for (int i = 0; i < numImps; i++)
+		{
+			XMINT2 p;
+			levelData->GetRandomWalkableTile(areaCode, p);
+			imps[i] = Test::AddTestCreature(level, CreatureData::CREATURE_IMP, Owner_PlayerRed, p);
+		}
+		for (int i = 0; i < 40; i++)
+		{
+			XMINT2 p;
+			levelData->GetRandomWalkableTile(caveAreaCode, p);
+			Test::AddTestCreature(level, CreatureData::CREATURE_KNIGHT, Owner_PlayerWhite, p);
+		}
+		Timer timer;
+		timer.StartTime();
+		for (int t = 0; t < turns; t++)
+		{
+			//polling, nobody gets to sleep through a turn
+			if (pass == 1)
+			{
+				for (int i = 0; i < numImps; i++) imps[i]->Wake(Creature::Wake_Any);
+			}
+			Test::RunTurns(level, 1);
+			for (int i = 0; i < numImps; i++) suspendedTurns[pass] += imps[i]->m_Suspend.suspended;
+		}
+		time[pass] = timer.GetDeltaTimeMicro() / (double)turns;
+		delete level;
+	}
+	THEMP_CHECK(suspendedTurns[0] > (uint64_t)numImps * turns / 3);
+	char details[192];
+	snprintf(details, sizeof(details), "%.2f us a turn with %.1f imps asleep on average, polling took %.2f us",
+		time[0], suspendedTurns[0] / (double)turns, time[1]);
+	Test::Report("Creature 200 idle imps a turn", time[0] / 1000.0, details);
+}
@@ -0,0 +1,409 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempFieldOfView.h"
+#include "ThempTileArrays.h"
+#include "ThempTestMaps.h"
+#include "ThempLevel.h"
+#include "ThempLevelData.h"
+#include "ThempObject3D.h"
+#include "ThempFunctions.h"
+#include "Creature/ThempCreature.h"
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+using namespace Themp;
+using namespace DirectX;
+
+namespace
+{
+	//a scratch map of solid/open tiles and what the last Compute saw
+	struct Grid
+	{
+		bool solid[MAP_SIZE_TILES][MAP_SIZE_TILES];
+		bool seen[MAP_SIZE_TILES][MAP_SIZE_TILES];
+	};
+	bool IsSolid(void* context, int y, int x)
+	{
+		return static_cast<Grid*>(context)->solid[y][x];
+	}
+	void See(void* context, int y, int x)
+	{
+		static_cast<Grid*>(context)->seen[y][x] = true;
+	}
+	void Look(Grid& grid, XMINT2 from, int radius)
+	{
+		memset(grid.seen, 0, sizeof(grid.seen));
+		FieldOfView::Compute(from, radius, IsSolid, See, &grid);
+	}
+
+	void Reveal(LevelData* ldata, int y, int x, int areaCode)
+	{
+		LevelData::s_Map.m_Tiles[y][x].visible = true;
+		ldata->AddExploredTileNeighboursVisibility(y, x, areaCode);
+		ldata->m_UnexploredTiles.Remove(y, x);
+	}
+	//what CheckVisibility did before, a ray at every unexplored tile in range, revealing the tile if the ray gets there and what it hit if it didn't
+	void OldCheckVisibility(LevelData* ldata, XMINT2 tilePos)
+	{
+		const int range = 7;
+		const int areaCode = LevelData::s_Map.m_Tiles[tilePos.y][tilePos.x].areaCode;
+		std::vector<XMINT2> unexplored;
+		ldata->m_UnexploredTiles.GetInRange(tilePos, range, unexplored);
+		for (size_t i = 0; i < unexplored.size(); i++)
+		{
+			const int x = unexplored[i].x, y = unexplored[i].y;
+			Tile& tile = LevelData::s_Map.m_Tiles[y][x];
+			if (tile.visible)
+			{
+				ldata->m_UnexploredTiles.Remove(y, x);
+				continue;
+			}
+			if (tile.areaCode != areaCode && tile.areaCode != 0) continue;
+			if (tile.owner == Owner_PlayerRed)
+			{
+				Reveal(ldata, y, x, areaCode);
+				continue;
+			}
+			XMFLOAT3 srcPos = LevelData::TileToWorld(tilePos);
+			srcPos.y = 3;
+			const XMFLOAT3 rayDir = Normalize(XMFLOAT3((float)(x * 3 + 1), 3, (float)(y * 3 + 1)) - srcPos);
+			const LevelData::HitData hit = ldata->Raycast(srcPos, rayDir, range * 3);
+			if (!hit.hit) continue;
+			const int tileX = hit.posX / 3, tileY = hit.posZ / 3;
+			Tile& hitTile = LevelData::s_Map.m_Tiles[tileY][tileX];
+			if (tileX == x && tileY == y)
+			{
+				Reveal(ldata, y, x, areaCode);
+				if (!IsMineableForPlayer(hitTile.GetType(), hitTile.owner, Owner_PlayerRed))
+				{
+					hitTile.marked[Owner_PlayerRed] = false;
+				}
+			}
+			else if (!hitTile.visible)
+			{
+				Reveal(ldata, tileY, tileX, areaCode);
+			}
+		}
+	}
+	//what an imp does once it dug a tile out, the earth around it shows up and whatever open tiles are next to it go on the frontier to be looked at
+	void DigOut(LevelData* ldata, int y, int x)
+	{
+		for (int hits = 0; hits < 100 && !ldata->MineTile(y, x); hits++);
+		ldata->FlushAreaUpdates();
+		LevelData::s_Map.m_Tiles[y][x].visible = true;
+		TileNeighbourTiles n = ldata->GetNeighbourTiles(y, x);
+		for (int i = 0; i < 4; i++)
+		{
+			if (IsMineable(n.Axii[i]->GetType()))
+			{
+				n.Axii[i]->visible = true;
+			}
+			else if (!n.Axii[i]->visible)
+			{
+				ldata->AddUnexploredTile(XMINT2(x, y) + AxiiDirections[i]);
+			}
+		}
+	}
+	//the frontier only grows out of dug tiles, so an imp digs into the unexplored end of the corridor, the path to the blue cave and the lava pool,
+	//standing on the dug tile after each one and walking around the dungeon at the end
+	struct ExploreStep
+	{
+		XMINT2 dig;
+		XMINT2 spot;
+	};
+	const ExploreStep ExploreSteps[] =
+	{
+		{ XMINT2(-1, -1), XMINT2(45, 45) },
+		{ XMINT2(63, 42), XMINT2(63, 42) },
+		{ XMINT2(-1, -1), XMINT2(58, 42) },
+		{ XMINT2(31, 15), XMINT2(31, 15) },
+		{ XMINT2(24, 59), XMINT2(24, 59) },
+		{ XMINT2(-1, -1), XMINT2(36, 36) },
+	};
+	const int NumExploreSteps = sizeof(ExploreSteps) / sizeof(ExploreSteps[0]);
+	int CountVisible()
+	{
+		int visible = 0;
+		for (int i = 0; i < MAP_SIZE_TILES * MAP_SIZE_TILES; i++) visible += LevelData::s_Map.m_Tiles[i / MAP_SIZE_TILES][i % MAP_SIZE_TILES].visible;
+		return visible;
+	}
+	struct Exploration
+	{
+		//the visible tiles after every step
+		std::vector<std::vector<bool>> visible;
+		//tiles there's nothing solid on at eye height at the end
+		std::vector<bool> open;
+	};
+	//looks from every spot until nothing new shows up (it'd look again next turn anyway)
+	Exploration Explore(bool oldRaycasts)
+	{
+		Level* level = Test::CreateTestWorld();
+		Creature* imp = Test::AddTestCreature(level, CreatureData::CREATURE_IMP, Owner_PlayerRed, ExploreSteps[0].spot);
+		Exploration result;
+		std::vector<std::vector<bool>>& visible = result.visible;
+		for (int s = 0; s < NumExploreSteps; s++)
+		{
+			const ExploreStep& step = ExploreSteps[s];
+			if (step.dig.x >= 0)
+			{
+				DigOut(level->m_LevelData, step.dig.y, step.dig.x);
+			}
+			const XMFLOAT3 pos = LevelData::TileToWorld(step.spot);
+			imp->m_Renderable->SetPosition(pos.x, 0, pos.z);
+			for (size_t before = SIZE_MAX; before != level->m_LevelData->m_UnexploredTiles.Size();)
+			{
+				before = level->m_LevelData->m_UnexploredTiles.Size();
+				if (oldRaycasts)
+				{
+					OldCheckVisibility(level->m_LevelData, step.spot);
+				}
+				else
+				{
+					imp->CheckVisibility();
+				}
+			}
+			visible.push_back(std::vector<bool>(MAP_SIZE_TILES * MAP_SIZE_TILES));
+			for (int i = 0; i < MAP_SIZE_TILES * MAP_SIZE_TILES; i++)
+			{
+				visible.back()[i] = LevelData::s_Map.m_Tiles[i / MAP_SIZE_TILES][i % MAP_SIZE_TILES].visible;
+			}
+		}
+		for (int i = 0; i < MAP_SIZE_TILES * MAP_SIZE_TILES; i++)
+		{
+			result.open.push_back(!level->m_LevelData->IsBlockActive(3, (i / MAP_SIZE_TILES) * 3 + 1, (i % MAP_SIZE_TILES) * 3 + 1));
+		}
+		delete level;
+		return result;
+	}
+}
+
+THEMP_TEST(FieldOfView_OpenFieldSeesWholeCircle)
+{
+	Grid* grid = new Grid();
+	memset(grid->solid, 0, sizeof(grid->solid));
+	const XMINT2 origin(40, 40);
+	Look(*grid, origin, 7);
+	for (int y = 0; y < MAP_SIZE_TILES; y++)
+	{
+		for (int x = 0; x < MAP_SIZE_TILES; x++)
+		{
+			const int dy = y - origin.y, dx = x - origin.x;
+			THEMP_CHECK(grid->seen[y][x] == (dy * dy + dx * dx <= 49));
+		}
+	}
+	delete grid;
+}
+
+THEMP_TEST(FieldOfView_WallsOcclude)
+{
+	Grid* grid = new Grid();
+	memset(grid->solid, 0, sizeof(grid->solid));
+	const XMINT2 origin(40, 40);
+	//a wall 3 tiles east of the origin, 5 tiles high
+	for (int y = 38; y <= 42; y++)
+	{
+		grid->solid[y][43] = true;
+	}
+	Look(*grid, origin, 7);
+	for (int y = 38; y <= 42; y++)
+	{
+		//the wall itself is seen, what's straight behind it isn't
+		THEMP_CHECK(grid->seen[y][43]);
+	}
+	for (int x = 44; x <= 47; x++)
+	{
+		THEMP_CHECK(!grid->seen[40][x]);
+		THEMP_CHECK(!grid->seen[39][x] && !grid->seen[41][x]);
+	}
+	//the other directions aren't affected
+	THEMP_CHECK(grid->seen[40][33] && grid->seen[47][40] && grid->seen[33][40]);
+
+	//closed in on all sides only the walls around get seen
+	memset(grid->solid, 0, sizeof(grid->solid));
+	for (int y = 39; y <= 41; y++)
+	{
+		for (int x = 39; x <= 41; x++)
+		{
+			grid->solid[y][x] = !(y == 40 && x == 40);
+		}
+	}
+	Look(*grid, origin, 7);
+	int seen = 0;
+	for (int y = 0; y < MAP_SIZE_TILES; y++)
+	{
+		for (int x = 0; x < MAP_SIZE_TILES; x++)
+		{
+			seen += grid->seen[y][x];
+		}
+	}
+	THEMP_CHECK(seen == 9);
+	delete grid;
+}
+
+THEMP_TEST(FieldOfView_Symmetric)
+{
+	//on random maps, if an open tile sees another open tile that one sees it back
+	Grid* grid = new Grid();
+	static bool sees[15][15][15][15];
+	srand(7);
+	const int radius = 7;
+	const XMINT2 corner(30, 30);
+	for (int map = 0; map < 20; map++)
+	{
+		for (int y = 0; y < MAP_SIZE_TILES; y++)
+		{
+			for (int x = 0; x < MAP_SIZE_TILES; x++)
+			{
+				grid->solid[y][x] = rand() % 4 == 0;
+			}
+		}
+		for (int y = 0; y < 15; y++)
+		{
+			for (int x = 0; x < 15; x++)
+			{
+				if (grid->solid[corner.y + y][corner.x + x]) continue;
+				Look(*grid, XMINT2(corner.x + x, corner.y + y), radius);
+				for (int ty = 0; ty < 15; ty++)
+				{
+					for (int tx = 0; tx < 15; tx++)
+					{
+						sees[y][x][ty][tx] = grid->seen[corner.y + ty][corner.x + tx];
+					}
+				}
+			}
+		}
+		int asymmetric = 0;
+		for (int y = 0; y < 15; y++)
+		{
+			for (int x = 0; x < 15; x++)
+			{
+				if (grid->solid[corner.y + y][corner.x + x]) continue;
+				for (int ty = 0; ty < 15; ty++)
+				{
+					for (int tx = 0; tx < 15; tx++)
+					{
+						if (grid->solid[corner.y + ty][corner.x + tx]) continue;
+						asymmetric += sees[y][x][ty][tx] != sees[ty][tx][y][x];
+					}
+				}
+			}
+		}
+		THEMP_CHECK(asymmetric == 0);
+	}
+	delete grid;
+}
+
+//A creature digging and walking around the test map reveals what the old raycasts did, growing out of the unexplored frontier the same way.
+//Where they differ it's the old rays' fault: they only stopped on solid blocks, so an open floor tile never got revealed by one, nor did the walls
+//along it that a ray glanced off a neighbour on the way to, and they looked at a square where the shadowcasting looks at a circle, the old ones see a few tiles further on the diagonals
+THEMP_TEST(FieldOfView_ExploresLikeTheOldRaycasts)
+{
+	const Exploration now = Explore(false);
+	const Exploration old = Explore(true);
+	THEMP_CHECK(now.open == old.open);
+	for (int s = 0; s < NumExploreSteps; s++)
+	{
+		int visible = 0, same = 0, openOnlyNow = 0, besideOpenOnlyNow = 0, otherOnlyNow = 0, cornersOnlyOld = 0, otherOnlyOld = 0;
+		for (int i = 0; i < MAP_SIZE_TILES * MAP_SIZE_TILES; i++)
+		{
+			const int y = i / MAP_SIZE_TILES, x = i % MAP_SIZE_TILES;
+			visible += now.visible[s][i];
+			same += now.visible[s][i] && old.visible[s][i];
+			if (now.visible[s][i] && !old.visible[s][i])
+			{
+				bool besideOpen = false;
+				for (int d = 0; d < 4; d++)
+				{
+					const int n = (y + AxiiDirections[d].y) * MAP_SIZE_TILES + x + AxiiDirections[d].x;
+					besideOpen |= now.open[n] && now.visible[s][n];
+				}
+				openOnlyNow += now.open[i];
+				besideOpenOnlyNow += !now.open[i] && besideOpen;
+				otherOnlyNow += !now.open[i] && !besideOpen;
+			}
+			if (!now.visible[s][i] && old.visible[s][i])
+			{
+				//outside the circle around every spot it's stood on so far
+				bool inCircle = false;
+				for (int k = 0; k <= s; k++)
+				{
+					const int dx = x - ExploreSteps[k].spot.x, dy = y - ExploreSteps[k].spot.y;
+					inCircle |= dx * dx + dy * dy <= 49;
+				}
+				cornersOnlyOld += !inCircle;
+				otherOnlyOld += inCircle;
+			}
+		}
+		System::Print("from %i %i: %i visible, %i the same, only now %i open and %i walls along open ones, %i only the old rays saw in the square's corners",
+			ExploreSteps[s].spot.x, ExploreSteps[s].spot.y, visible, same, openOnlyNow, besideOpenOnlyNow, cornersOnlyOld);
+		THEMP_CHECK(otherOnlyNow == 0);
+		THEMP_CHECK(otherOnlyOld == 0);
+	}
+	//digging into all three revealed something
+	for (int s = 1; s < NumExploreSteps; s++)
+	{
+		int revealed = 0;
+		for (int i = 0; i < MAP_SIZE_TILES * MAP_SIZE_TILES; i++) revealed += now.visible[s][i] && !now.visible[s - 1][i];
+		THEMP_CHECK(revealed > 0 || ExploreSteps[s].dig.x < 0);
+	}
+}
+
+//50 imps spread over the dungeon and the three spots dug into, 20 turns of everyone looking around right after the digging, against the old raycasts
+THEMP_BENCHMARK(FieldOfView_50CreaturesExploring)
+{
+	const int numCreatures = 50;
+	const int turns = 20;
+	const int rounds = 10;
+	//the dungeon and the three dug tiles
+	const XMINT2 starts[4] = { XMINT2(45, 45), XMINT2(63, 42), XMINT2(31, 15), XMINT2(24, 59) };
+	double time[2] = {};
+	int revealed[2] = {};
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int r = 0; r < rounds; r++)
+		{
+			Level* level = Test::CreateTestWorld();
+			LevelData* ldata = level->m_LevelData;
+			const int visibleBefore = CountVisible();
+			for (int s = 0; s < NumExploreSteps; s++)
+			{
+				if (ExploreSteps[s].dig.x >= 0) DigOut(ldata, ExploreSteps[s].dig.y, ExploreSteps[s].dig.x);
+			}
+			srand(37 + r);
+			std::vector<Creature*> imps(numCreatures);
+			std::vector<XMINT2> spots(numCreatures);
+			for (int i = 0; i < numCreatures; i++)
+			{
+				const XMINT2 start = starts[i % 4];
+				const int areaCode = LevelData::s_Map.m_Tiles[start.y][start.x].areaCode;
+				if (!ldata->GetRandomWalkableTileInRange(areaCode, start, 4, spots[i])) spots[i] = start;
+				imps[i] = Test::AddTestCreature(level, CreatureData::CREATURE_IMP, Owner_PlayerRed, spots[i]);
+			}
+			Timer timer;
+			timer.StartTime();
+			for (int t = 0; t < turns; t++)
+			{
+				for (int i = 0; i < numCreatures; i++)
+				{
+					if (pass == 0)
+					{
+						imps[i]->CheckVisibility();
+					}
+					else
+					{
+						OldCheckVisibility(ldata, spots[i]);
+					}
+				}
+			}
+			time[pass] += timer.GetDeltaTimeMicro();
+			revealed[pass] += CountVisible() - visibleBefore;
+			delete level;
+		}
+	}
+	const double perTurn[2] = { time[0] / (rounds * turns), time[1] / (rounds * turns) };
+	char details[192];
+	snprintf(details, sizeof(details), "%.2f us a turn for 50 creatures, %.1f tiles revealed a round, the old raycasts took %.2f us and revealed %.1f",
+		perTurn[0], revealed[0] / (double)rounds, perTurn[1], revealed[1] / (double)rounds);
+	Test::Report("FieldOfView 50 creatures a turn", perTurn[0] / 1000.0, details);
+}
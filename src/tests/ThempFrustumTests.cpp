@@ -0,0 +1,141 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+#include "ThempVoxelObject.h"
+#include "../Engine/ThempFrustum.h"
+#include <DirectXMath.h>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+using namespace Themp;
+using namespace DirectX;
+
+namespace
+{
+	//camera poses over the test map, built the way Camera::Update builds its matrices (LookTo and a perspective or orthographic projection)
+	struct Pose
+	{
+		const char* name;
+		XMFLOAT3 eye;
+		XMFLOAT3 direction;
+		bool orthographic;
+		float zoom;
+	};
+	const Pose Poses[] =
+	{
+		{ "over the dungeon", XMFLOAT3(126.0f, 30.0f, 100.0f), XMFLOAT3(0.0f, -0.8f, 0.6f), false, 1.0f },
+		{ "low, across the map", XMFLOAT3(126.0f, 10.0f, 20.0f), XMFLOAT3(0.0f, -0.15f, 1.0f), false, 1.0f },
+		{ "high, straight down", XMFLOAT3(126.0f, 120.0f, 126.0f), XMFLOAT3(0.0f, -1.0f, 0.01f), false, 1.0f },
+		{ "looking off the map", XMFLOAT3(10.0f, 20.0f, 10.0f), XMFLOAT3(-0.6f, -0.3f, -0.6f), false, 1.0f },
+		{ "orthographic, zoomed in", XMFLOAT3(126.0f, 60.0f, 90.0f), XMFLOAT3(0.0f, -0.8f, 0.6f), true, 40.0f },
+		{ "orthographic, zoomed out", XMFLOAT3(126.0f, 60.0f, 90.0f), XMFLOAT3(0.0f, -0.8f, 0.6f), true, 200.0f },
+	};
+	XMFLOAT4X4 ViewProjection(const Pose& pose)
+	{
+		const XMMATRIX view = XMMatrixLookToLH(XMVectorSet(pose.eye.x, pose.eye.y, pose.eye.z, 1), XMVectorSet(pose.direction.x, pose.direction.y, pose.direction.z, 0), XMVectorSet(0, 1, 0, 0));
+		const XMMATRIX projection = pose.orthographic
+			? XMMatrixOrthographicLH(pose.zoom * 16.0f / 9.0f, pose.zoom, 0.1f, 1000.0f)
+			: XMMatrixPerspectiveFovLH(XMConvertToRadians(75.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+		XMFLOAT4X4 result;
+		XMStoreFloat4x4(&result, view * projection);
+		return result;
+	}
+	float Random(float min, float max)
+	{
+		return min + (max - min) * (rand() / (float)RAND_MAX);
+	}
+	//straight through the matrix into clip space, how far the point is inside the nearest of the six clip planes (negative is outside)
+	float ClipDistance(const XMFLOAT4X4& viewProjection, const XMFLOAT3& point)
+	{
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector4Transform(XMVectorSet(point.x, point.y, point.z, 1), XMLoadFloat4x4(&viewProjection)));
+		float distance = clip.w - fabsf(clip.x);
+		distance = std::min(distance, clip.w - fabsf(clip.y));
+		distance = std::min(distance, clip.z);
+		distance = std::min(distance, clip.w - clip.z);
+		return distance / std::max(fabsf(clip.w), 1.0f);
+	}
+}
+
+//The planes have to agree with transforming the point into clip space, for both kinds of projection
+THEMP_TEST(Frustum_PlanesMatchClipSpace)
+{
+	srand(5);
+	for (const Pose& pose : Poses)
+	{
+		const XMFLOAT4X4 viewProjection = ViewProjection(pose);
+		const Frustum frustum(viewProjection);
+		int mismatches = 0, inside = 0;
+		for (int i = 0; i < 20000; i++)
+		{
+			const XMFLOAT3 point(Random(-200.0f, 450.0f), Random(-100.0f, 200.0f), Random(-200.0f, 450.0f));
+			const float distance = ClipDistance(viewProjection, point);
+			//too close to a plane to tell with floats
+			if (fabs(distance) < 0.001f) continue;
+			inside += distance > 0.0f;
+			mismatches += frustum.ContainsPoint(point) != (distance > 0.0f);
+		}
+		THEMP_CHECK(mismatches == 0);
+		THEMP_CHECK(inside > 0);
+	}
+}
+
+//A box may only be culled when none of it is on screen, and the boxes well inside or well outside have to go the right way
+THEMP_TEST(Frustum_BoxesAreNeverCulledWrongly)
+{
+	srand(6);
+	for (const Pose& pose : Poses)
+	{
+		const XMFLOAT4X4 viewProjection = ViewProjection(pose);
+		const Frustum frustum(viewProjection);
+		int wronglyCulled = 0, culled = 0;
+		for (int i = 0; i < 5000; i++)
+		{
+			const XMFLOAT3 boxMin(Random(-200.0f, 450.0f), Random(-100.0f, 200.0f), Random(-200.0f, 450.0f));
+			const XMFLOAT3 boxMax(boxMin.x + Random(0.5f, 30.0f), boxMin.y + Random(0.5f, 30.0f), boxMin.z + Random(0.5f, 30.0f));
+			if (frustum.IntersectsBox(boxMin, boxMax)) continue;
+			culled++;
+			for (int s = 0; s < 125; s++)
+			{
+				const XMFLOAT3 point(boxMin.x + (boxMax.x - boxMin.x) * (s % 5) / 4.0f, boxMin.y + (boxMax.y - boxMin.y) * (s / 5 % 5) / 4.0f, boxMin.z + (boxMax.z - boxMin.z) * (s / 25) / 4.0f);
+				if (ClipDistance(viewProjection, point) > 0.001f)
+				{
+					wronglyCulled++;
+					break;
+				}
+			}
+		}
+		THEMP_CHECK(wronglyCulled == 0);
+		THEMP_CHECK(culled > 0);
+
+		//a box around the point the camera looks at stays, one behind the camera goes
+		const XMFLOAT3 ahead(pose.eye.x + pose.direction.x * 20.0f, pose.eye.y + pose.direction.y * 20.0f, pose.eye.z + pose.direction.z * 20.0f);
+		const XMFLOAT3 behind(pose.eye.x - pose.direction.x * 20.0f, pose.eye.y - pose.direction.y * 20.0f, pose.eye.z - pose.direction.z * 20.0f);
+		THEMP_CHECK(frustum.IntersectsBox(XMFLOAT3(ahead.x - 1, ahead.y - 1, ahead.z - 1), XMFLOAT3(ahead.x + 1, ahead.y + 1, ahead.z + 1)));
+		THEMP_CHECK(!frustum.IntersectsBox(XMFLOAT3(behind.x - 1, behind.y - 1, behind.z - 1), XMFLOAT3(behind.x + 1, behind.y + 1, behind.z + 1)));
+	}
+}
+
+//how many chunks and vertices the culled map mesh comes to from each pose
+THEMP_BENCHMARK(Frustum_ChunksPerPose)
+{
+	struct Output
+	{
+		uint32_t vertices = 0;
+	};
+	LevelData* level = Test::CreateTestLevel();
+	Output output;
+	{
+		VoxelObject mesher(level, [](void* context, const VoxelVertex*, uint32_t numVertices, const uint32_t*, uint32_t) { ((Output*)context)->vertices = numVertices; }, &output);
+		for (const Pose& pose : Poses)
+		{
+			mesher.ConstructFromLevel(ViewProjection(pose));
+			char details[128];
+			snprintf(details, sizeof(details), "%u of %d chunks (%u coarse), %u vertices", mesher.m_MeshStats.chunks, VoxelObject::NumMeshChunks * VoxelObject::NumMeshChunks, mesher.m_MeshStats.coarseChunks, output.vertices);
+			Test::Report(pose.name, mesher.m_MeshStats.buildMicroseconds / 1000.0, details);
+		}
+	}
+	delete level;
+}
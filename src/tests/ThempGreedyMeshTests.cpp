@@ -0,0 +1,164 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+#include "ThempVoxelObject.h"
+#include "../Engine/ThempD3D.h"
+#include "../Engine/ThempMesh.h"
+#include <DirectXMath.h>
+#include <algorithm>
+#include <tuple>
+#include <vector>
+#include <cmath>
+
+using namespace Themp;
+using namespace DirectX;
+
+namespace
+{
+	//axis, front, plane, a, b, size a, size b, u, v, visible, doAnimate. Positions in 1/16th of a subtile and uvs in half texels, like the packed vertex
+	typedef std::tuple<int, int, int, int, int, int, int, int, int, int, int> UnitFace;
+
+	struct MeshFaces
+	{
+		std::vector<UnitFace> faces;
+		uint32_t quads = 0;
+		uint32_t tiledQuads = 0;
+		uint32_t builds = 0;
+	};
+
+	float GetAxis(const VoxelVertex& v, int axis)
+	{
+		return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+	}
+	int Quantize(float value, float scale)
+	{
+		return (int)floor(value * scale + 0.5f);
+	}
+	//Every quad as the faces it covers, merged quads split back up into the single block faces they replaced.
+	//Quads that couldn't be merged are kept as a whole, they have to come out of both meshes the same.
+	void CollectFaces(void* context, const VoxelVertex* vertices, uint32_t numVertices, const uint32_t* indices, uint32_t numIndices)
+	{
+		static const int axisA[3] = { 2, 0, 0 };
+		static const int axisB[3] = { 1, 2, 1 };
+		MeshFaces* out = (MeshFaces*)context;
+		out->faces.clear();
+		out->quads = numVertices / 4;
+		out->tiledQuads = 0;
+		out->builds++;
+		for (uint32_t q = 0; q < numVertices / 4; q++)
+		{
+			const VoxelVertex* v = &vertices[q * 4];
+			const VoxelVertex& v0 = vertices[indices[q * 6 + 0]];
+			const VoxelVertex& v1 = vertices[indices[q * 6 + 1]];
+			const VoxelVertex& v2 = vertices[indices[q * 6 + 2]];
+			const int axis = v[0].nx > 0.5f ? 0 : v[0].ny > 0.5f ? 1 : 2;
+			const XMFLOAT3 e0(v1.x - v0.x, v1.y - v0.y, v1.z - v0.z);
+			const XMFLOAT3 e1(v2.x - v0.x, v2.y - v0.y, v2.z - v0.z);
+			const float cross = axis == 0 ? e0.y * e1.z - e0.z * e1.y : axis == 1 ? e0.z * e1.x - e0.x * e1.z : e0.x * e1.y - e0.y * e1.x;
+			const int front = cross > 0.0f;
+
+			float minA = GetAxis(v[0], axisA[axis]), maxA = minA, minB = GetAxis(v[0], axisB[axis]), maxB = minB;
+			float minU = v[0].u, minV = v[0].v;
+			for (int i = 1; i < 4; i++)
+			{
+				minA = std::min(minA, GetAxis(v[i], axisA[axis]));
+				maxA = std::max(maxA, GetAxis(v[i], axisA[axis]));
+				minB = std::min(minB, GetAxis(v[i], axisB[axis]));
+				maxB = std::max(maxB, GetAxis(v[i], axisB[axis]));
+				minU = std::min(minU, v[i].u);
+				minV = std::min(minV, v[i].v);
+			}
+			const int plane = Quantize(GetAxis(v[0], axis), 16.0f);
+			if ((v[0].doAnimate & 2) == 0)
+			{
+				out->faces.push_back(UnitFace(axis, front, plane, Quantize(minA, 16.0f), Quantize(minB, 16.0f), Quantize(maxA - minA, 16.0f), Quantize(maxB - minB, 16.0f),
+					Quantize(minU, 512.0f), Quantize(minV, 4352.0f), (int)v[0].visible, (int)v[0].doAnimate));
+				continue;
+			}
+			//a merged face keeps the atlas cell in its uvs, every subtile it covers got the whole cell
+			out->tiledQuads++;
+			const int cellX = (int)floor(minU * 8.0f);
+			const int cellY = (int)floor(minV * 68.0f);
+			for (int a = 0; a < Quantize(maxA - minA, 1.0f); a++)
+			{
+				for (int b = 0; b < Quantize(maxB - minB, 1.0f); b++)
+				{
+					out->faces.push_back(UnitFace(axis, front, plane, Quantize(minA + a, 16.0f), Quantize(minB + b, 16.0f), 16, 16, cellX * 64, cellY * 64, 1, 0));
+				}
+			}
+		}
+		std::sort(out->faces.begin(), out->faces.end());
+	}
+	XMFLOAT4X4 GetTopView()
+	{
+		const float mapCenter = MAP_SIZE_SUBTILES_RENDER * 0.5f;
+		const XMMATRIX result = XMMatrixLookToLH(XMVectorSet(mapCenter, 50.0f, mapCenter, 1), XMVectorSet(0, -1, 0, 0), XMVectorSet(0, 0, 1, 0))
+			* XMMatrixOrthographicLH((float)MAP_SIZE_SUBTILES_RENDER, (float)MAP_SIZE_SUBTILES_RENDER, 0.1f, 1000.0f);
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, result);
+		return viewProjection;
+	}
+}
+
+//Merging has to cover exactly the faces the single block mesh has, with fewer quads (coarse chunks are made of tiled quads too, so they're off)
+THEMP_TEST(GreedyMesh_CoversSameFaces)
+{
+	const bool greedy = VoxelObject::s_GreedyMeshing;
+	const bool coarseLod = VoxelObject::s_CoarseLod;
+	VoxelObject::s_CoarseLod = false;
+	LevelData* level = Test::CreateTestLevel();
+	MeshFaces single, merged;
+
+	{
+		VoxelObject mesher(level, CollectFaces, &single);
+		VoxelObject::s_GreedyMeshing = false;
+		mesher.ConstructFromLevel(GetTopView());
+		mesher.m_MeshOutputContext = &merged;
+		VoxelObject::s_GreedyMeshing = true;
+		mesher.ConstructFromLevel(GetTopView());
+	}
+	VoxelObject::s_GreedyMeshing = greedy;
+	VoxelObject::s_CoarseLod = coarseLod;
+
+	THEMP_CHECK(single.tiledQuads == 0);
+	THEMP_CHECK(merged.tiledQuads > 0);
+	THEMP_CHECK(merged.quads < single.quads);
+	THEMP_CHECK(merged.faces.size() == single.faces.size());
+	THEMP_CHECK(merged.faces == single.faces);
+	delete level;
+}
+
+//The map mesh is only built (and merged) again when the view or a tile changed
+THEMP_TEST(GreedyMesh_RebuildsOnlyOnChange)
+{
+	LevelData* level = Test::CreateTestLevel();
+	MeshFaces faces;
+	{
+		VoxelObject mesher(level, CollectFaces, &faces);
+		mesher.ConstructFromLevel(GetTopView());
+		THEMP_CHECK(faces.builds == 1);
+		const std::vector<UnitFace> before = faces.faces;
+
+		mesher.ConstructFromLevel(GetTopView());
+		THEMP_CHECK(faces.builds == 1);
+
+		//an area update that doesn't change anything isn't worth a rebuild either
+		level->QueueAreaUpdate(35, 37, 35, 37);
+		level->FlushAreaUpdates();
+		mesher.ConstructFromLevel(GetTopView());
+		THEMP_CHECK(faces.builds == 1);
+
+		//fill in a corner of the dungeon
+		LevelData::s_Map.m_Tiles[36][36].type = Type_Earth;
+		level->QueueAreaUpdate(35, 37, 35, 37);
+		level->FlushAreaUpdates();
+		mesher.ConstructFromLevel(GetTopView());
+		THEMP_CHECK(faces.builds == 2);
+		THEMP_CHECK(faces.faces != before);
+
+		mesher.ConstructFromLevel(GetTopView());
+		THEMP_CHECK(faces.builds == 2);
+	}
+	delete level;
+}
@@ -0,0 +1,140 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempLightGrid.h"
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+using namespace Themp;
+
+namespace
+{
+	Light RandomLight()
+	{
+		Light light;
+		light.range = (uint8_t)(3 + rand() % 30);
+		light.lightIntensity = (uint8_t)(rand() % 64);
+		light.x = (uint8_t)(rand() % 255);
+		light.y = (uint8_t)(rand() % 255);
+		light.z = (uint8_t)(rand() % 8);
+		return light;
+	}
+	//the tiles the old AddLightToTiles gave a light (without its 4 lights per tile cap)
+	bool OldReach(const Light& light, int y, int x)
+	{
+		const int lightRange = (int)ceil(ceil((float)light.range / 3.0f) / 2.0f);
+		const int tileX = light.x / 3;
+		const int tileY = light.y / 3;
+		return x >= tileX - lightRange && x < tileX + lightRange && y >= tileY - lightRange && y < tileY + lightRange;
+	}
+	//every cell lists exactly the live lights that reach it
+	bool CellsMatchOldReach(const LightGrid& grid, const std::vector<uint16_t>& slots)
+	{
+		for (int y = 0; y < MAP_SIZE_TILES; y++)
+		{
+			for (int x = 0; x < MAP_SIZE_TILES; x++)
+			{
+				const std::vector<uint16_t>& cell = grid.GetCell(y, x);
+				size_t reaching = 0;
+				for (uint16_t slot : slots)
+				{
+					if (!OldReach(grid.GetLight(slot), y, x)) continue;
+					reaching++;
+					if (std::find(cell.begin(), cell.end(), slot) == cell.end()) return false;
+				}
+				if (cell.size() != reaching) return false;
+			}
+		}
+		return true;
+	}
+}
+
+THEMP_TEST(LightGrid_1000LightsMatchOldReach)
+{
+	srand(3);
+	LightGrid grid;
+	std::vector<uint16_t> slots;
+	for (int i = 0; i < 1000; i++)
+	{
+		slots.push_back(grid.AddLight(RandomLight()));
+	}
+	THEMP_CHECK(grid.GetNumLights() == 1000);
+	THEMP_CHECK(CellsMatchOldReach(grid, slots));
+
+	//move some within their tile and some across the map, remove a few and reuse their slots
+	grid.ClearDirty();
+	for (int i = 0; i < 1000; i += 3)
+	{
+		const Light& light = grid.GetLight(slots[i]);
+		if (i % 2) grid.MoveLight(slots[i], light.x - light.x % 3, light.y - light.y % 3 + 2, light.z);
+		else grid.MoveLight(slots[i], (uint8_t)(rand() % 255), (uint8_t)(rand() % 255), light.z);
+	}
+	THEMP_CHECK(grid.GetDirtyMin() == slots[0] && grid.GetDirtyMax() == slots[999]);
+	for (int i = 0; i < 100; i++)
+	{
+		grid.RemoveLight(slots.back());
+		slots.pop_back();
+	}
+	THEMP_CHECK(CellsMatchOldReach(grid, slots));
+	for (int i = 0; i < 50; i++)
+	{
+		slots.push_back(grid.AddLight(RandomLight()));
+	}
+	THEMP_CHECK(grid.GetNumSlots() == 1000 && grid.GetNumLights() == 950);
+	THEMP_CHECK(CellsMatchOldReach(grid, slots));
+
+	std::vector<LightGrid::CellRange> ranges;
+	std::vector<uint32_t> indices;
+	grid.BuildCellData(ranges, indices);
+	size_t entries = 0;
+	for (int y = 0; y < MAP_SIZE_TILES; y++)
+	{
+		for (int x = 0; x < MAP_SIZE_TILES; x++)
+		{
+			const LightGrid::CellRange& range = ranges[y * MAP_SIZE_TILES + x];
+			THEMP_CHECK(range.offset == entries && range.count == grid.GetCell(y, x).size());
+			entries += range.count;
+		}
+	}
+	THEMP_CHECK(entries == indices.size());
+}
+
+THEMP_BENCHMARK(LightGrid_1000Lights)
+{
+	srand(3);
+	LightGrid grid;
+	std::vector<uint16_t> slots;
+	Timer timer;
+	timer.StartTime();
+	for (int i = 0; i < 1000; i++)
+	{
+		slots.push_back(grid.AddLight(RandomLight()));
+	}
+	const double addTime = timer.GetDeltaTimeMicro() / 1000.0;
+
+	//a tenth of the lights (the creature held ones) move every frame, the cells get flattened for the GPU whenever they changed
+	const int frames = 600;
+	std::vector<LightGrid::CellRange> ranges;
+	std::vector<uint32_t> indices;
+	timer.StartTime();
+	for (int frame = 0; frame < frames; frame++)
+	{
+		for (int i = frame % 10; i < 1000; i += 10)
+		{
+			const Light& light = grid.GetLight(slots[i]);
+			grid.MoveLight(slots[i], (uint8_t)((light.x + 1) % 255), light.y, light.z);
+		}
+		if (grid.CellsDirty())
+		{
+			grid.BuildCellData(ranges, indices);
+		}
+		grid.ClearDirty();
+	}
+	const double frameTime = timer.GetDeltaTimeMicro() / 1000.0;
+
+	char details[128];
+	snprintf(details, sizeof(details), "%u cell entries, at most %u lights in a cell", grid.GetStats().cellEntries, grid.GetStats().mostLightsInCell);
+	Test::Report("LightGrid add 1000 lights", addTime, details);
+	snprintf(details, sizeof(details), "%.3f ms per frame", frameTime / frames);
+	Test::Report("LightGrid move 100 + rebuild cells, 600 frames", frameTime, details);
+}
@@ -0,0 +1,77 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+#include "ThempLiquidLayer.h"
+
+using namespace Themp;
+
+namespace
+{
+	//changes a tile and lets the level catch up the way a dig or a claim does
+	void SetTile(LevelData& level, int y, int x, uint16_t type)
+	{
+		LevelData::s_Map.m_Tiles[y][x].type = type;
+		level.QueueAreaUpdate(y - 1, y + 1, x - 1, x + 1);
+		level.FlushAreaUpdates();
+	}
+}
+
+//The surfaces are only built again for changes on or next to a liquid tile, the animation never rebuilds them
+THEMP_TEST(LiquidLayer_RebuildsOnlyNextToLiquid)
+{
+	LevelData* level = Test::CreateTestLevel();
+	{
+		LiquidLayer liquid(level);
+		liquid.Update();
+		THEMP_CHECK(liquid.m_Stats.rebuilds == 1);
+		//only the explored water pool
+		THEMP_CHECK(liquid.m_Stats.tiles == 4 * 5);
+		THEMP_CHECK(liquid.m_Stats.quads > 0);
+
+		//nothing changed
+		liquid.Update();
+		level->QueueAreaUpdate(35, 40, 51, 57);
+		level->FlushAreaUpdates();
+		liquid.Update();
+		THEMP_CHECK(liquid.m_Stats.rebuilds == 1);
+
+		//dug out far from any liquid, and two tiles away from the water
+		SetTile(*level, 20, 30, Type_Unclaimed_Path);
+		liquid.Update();
+		SetTile(*level, 36, 50, Type_Unclaimed_Path);
+		liquid.Update();
+		THEMP_CHECK(liquid.m_Stats.rebuilds == 1);
+
+		//dug out right next to the water, the shore changes
+		SetTile(*level, 38, 51, Type_Unclaimed_Path);
+		liquid.Update();
+		THEMP_CHECK(liquid.m_Stats.rebuilds == 2);
+		//and diagonally next to it
+		SetTile(*level, 35, 51, Type_Unclaimed_Path);
+		liquid.Update();
+		THEMP_CHECK(liquid.m_Stats.rebuilds == 3);
+
+		//the lava pool gets explored
+		for (int y = 60; y <= 66; y++)
+		{
+			for (int x = 20; x <= 28; x++)
+			{
+				LevelData::s_Map.m_Tiles[y][x].visible = true;
+			}
+		}
+		level->QueueAreaUpdate(59, 67, 19, 29);
+		level->FlushAreaUpdates();
+		liquid.Update();
+		THEMP_CHECK(liquid.m_Stats.rebuilds == 4);
+		THEMP_CHECK(liquid.m_Stats.tiles == 4 * 5 + 7 * 9);
+
+		//a lot of frames go by, the surfaces stay as they are
+		for (int i = 0; i < 100; i++)
+		{
+			liquid.Update();
+		}
+		THEMP_CHECK(liquid.m_Stats.rebuilds == 4);
+	}
+	delete level;
+}
@@ -0,0 +1,325 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+#include "ThempVoxelObject.h"
+#include "ThempVoxelVertexPacking.h"
+#include "ThempLevelScript.h"
+#include "../Engine/ThempD3D.h"
+#include "../Engine/ThempMesh.h"
+#include <DirectXMath.h>
+#include <sstream>
+
+using namespace Themp;
+using namespace DirectX;
+
+namespace
+{
+	struct MeshHash
+	{
+		uint64_t hash = 0;
+		uint32_t vertices = 0;
+		uint32_t indices = 0;
+	};
+	//FNV-1a
+	uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+	//the vertices are hashed packed, that's exactly what the GPU gets to see
+	void HashMesh(void* context, const VoxelVertex* vertices, uint32_t numVertices, const uint32_t* indices, uint32_t numIndices)
+	{
+		MeshHash* out = (MeshHash*)context;
+		uint64_t hash = 14695981039346656037ull;
+		for (uint32_t i = 0; i < numVertices; i++)
+		{
+			PackedVoxelVertex packed;
+			VoxelVertexPacking::Pack(vertices[i], packed);
+			hash = HashBytes(hash, &packed, sizeof(PackedVoxelVertex));
+		}
+		out->hash = HashBytes(hash, indices, sizeof(uint32_t) * numIndices);
+		out->vertices = numVertices;
+		out->indices = numIndices;
+	}
+	//the whole map straight from above, and a close perspective view over the dungeon
+	XMFLOAT4X4 GetView(int view)
+	{
+		const float mapCenter = MAP_SIZE_SUBTILES_RENDER * 0.5f;
+		XMMATRIX result;
+		if (view == 0)
+		{
+			result = XMMatrixLookToLH(XMVectorSet(mapCenter, 50.0f, mapCenter, 1), XMVectorSet(0, -1, 0, 0), XMVectorSet(0, 0, 1, 0))
+				* XMMatrixOrthographicLH((float)MAP_SIZE_SUBTILES_RENDER, (float)MAP_SIZE_SUBTILES_RENDER, 0.1f, 1000.0f);
+		}
+		else
+		{
+			result = XMMatrixLookToLH(XMVectorSet(mapCenter, 20.0f, mapCenter - 30.0f, 1), XMVectorSet(0, -0.7f, 0.7f, 0), XMVectorSet(0, 1, 0, 0))
+				* XMMatrixPerspectiveFovLH(XMConvertToRadians(75.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+		}
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, result);
+		return viewProjection;
+	}
+	//The mesh benchmark's cameras, the same matrices the game camera builds from a few spots that have to stay put for the golden hashes to mean anything
+	const int NumBenchmarkViews = 5;
+	const char* GetBenchmarkView(int view, XMFLOAT4X4& viewProjection)
+	{
+		const float mapCenter = MAP_SIZE_SUBTILES_RENDER * 0.5f;
+		const XMMATRIX perspective = XMMatrixPerspectiveFovLH(XMConvertToRadians(75.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+		XMMATRIX result;
+		const char* name;
+		switch (view)
+		{
+		case 0:
+			name = "whole map, orthographic";
+			result = XMMatrixLookToLH(XMVectorSet(mapCenter, 50.0f, mapCenter, 1), XMVectorSet(0, -1, 0, 0), XMVectorSet(0, 0, 1, 0))
+				* XMMatrixOrthographicLH((float)MAP_SIZE_SUBTILES_RENDER, (float)MAP_SIZE_SUBTILES_RENDER, 0.1f, 1000.0f);
+			break;
+		case 1:
+			name = "high above the middle";
+			result = XMMatrixLookToLH(XMVectorSet(mapCenter, 120.0f, mapCenter, 1), XMVectorSet(0, -1, 0.01f, 0), XMVectorSet(0, 1, 0, 0)) * perspective;
+			break;
+		case 2:
+			name = "close, looking north";
+			result = XMMatrixLookToLH(XMVectorSet(mapCenter, 20.0f, mapCenter - 30.0f, 1), XMVectorSet(0, -0.7f, 0.7f, 0), XMVectorSet(0, 1, 0, 0)) * perspective;
+			break;
+		case 3:
+			name = "close, top left corner";
+			result = XMMatrixLookToLH(XMVectorSet(20.0f, 20.0f, 20.0f, 1), XMVectorSet(0.5f, -0.7f, 0.5f, 0), XMVectorSet(0, 1, 0, 0)) * perspective;
+			break;
+		default:
+			name = "low, bottom right looking across";
+			result = XMMatrixLookToLH(XMVectorSet(230.0f, 10.0f, 230.0f, 1), XMVectorSet(-0.7f, -0.2f, -0.7f, 0), XMVectorSet(0, 1, 0, 0)) * perspective;
+			break;
+		}
+		XMStoreFloat4x4(&viewProjection, result);
+		return name;
+	}
+	//every room the block uvs get picked differently for, built on the red dungeon's claimed floor
+	//the hatchery is an L so its floor has edges, corners and the pillar in the inside corner
+	void BuildRooms(LevelData& level)
+	{
+		const int money = LevelScript::GameValues[Owner_PlayerRed]["MONEY"];
+		LevelScript::GameValues[Owner_PlayerRed]["MONEY"] = 1000000;
+		struct RoomArea { uint16_t type; int minY, maxY, minX, maxX; };
+		const RoomArea rooms[] =
+		{
+			{ Type_Treasure_Room, 36, 38, 36, 38 },
+			{ Type_Hatchery, 36, 39, 44, 48 },
+			{ Type_Hatchery, 40, 40, 44, 45 },
+			{ Type_Lair, 45, 46, 36, 37 },
+			{ Type_Library, 45, 47, 40, 42 },
+			{ Type_Training_Room, 45, 46, 45, 48 },
+			{ Type_Workshop, 36, 38, 40, 41 },
+			{ Type_Prison, 48, 48, 36, 38 },
+		};
+		for (const RoomArea& room : rooms)
+		{
+			for (int y = room.minY; y <= room.maxY; y++)
+			{
+				for (int x = room.minX; x <= room.maxX; x++)
+				{
+					THEMP_CHECK(level.BuildRoom(room.type, Owner_PlayerRed, y, x));
+				}
+			}
+		}
+		level.FlushAreaUpdates();
+		LevelScript::GameValues[Owner_PlayerRed]["MONEY"] = money;
+	}
+	//settings bit 0 is greedy meshing, bit 1 the coarse chunks
+	void SetMeshSettings(int settings)
+	{
+		VoxelObject::s_GreedyMeshing = (settings & 1) != 0;
+		VoxelObject::s_CoarseLod = (settings & 2) != 0;
+	}
+}
+
+//Whatever the block storage looks like, the test map has to keep meshing into exactly the same vertices and indices.
+//The settings are the ones the golden file was made with, not whatever the defaults are now.
+THEMP_TEST(Mesh_TestMapMatchesGolden)
+{
+	const bool greedy = VoxelObject::s_GreedyMeshing;
+	const bool coarseLod = VoxelObject::s_CoarseLod;
+	VoxelObject::s_GreedyMeshing = false;
+	VoxelObject::s_CoarseLod = true;
+	LevelData* level = Test::CreateTestLevel();
+	MeshHash meshHash;
+	std::ostringstream out;
+	{
+		//the mesher unsubscribes from the level when it goes
+		VoxelObject mesher(level, HashMesh, &meshHash);
+		for (int view = 0; view < 2; view++)
+		{
+			mesher.ConstructFromLevel(GetView(view));
+			out << view << " " << std::hex << meshHash.hash << std::dec << " " << meshHash.vertices << " " << meshHash.indices << "\n";
+			THEMP_CHECK(meshHash.vertices > 0);
+		}
+	}
+	VoxelObject::s_GreedyMeshing = greedy;
+	VoxelObject::s_CoarseLod = coarseLod;
+	THEMP_CHECK(Test::MatchGolden("mesh_testmap.txt", out.str()));
+	delete level;
+}
+
+//Every benchmark camera with every mesher setting on the freshly loaded test map, each from a new mesher so the coarse chunks don't remember the view before
+THEMP_TEST(Mesh_BenchmarkViewsMatchGolden)
+{
+	const bool greedy = VoxelObject::s_GreedyMeshing;
+	const bool coarseLod = VoxelObject::s_CoarseLod;
+	LevelData* level = Test::CreateTestLevel();
+	MeshHash meshHash;
+	std::ostringstream out;
+	for (int settings = 0; settings < 4; settings++)
+	{
+		SetMeshSettings(settings);
+		for (int view = 0; view < NumBenchmarkViews; view++)
+		{
+			XMFLOAT4X4 viewProjection;
+			GetBenchmarkView(view, viewProjection);
+			VoxelObject mesher(level, HashMesh, &meshHash);
+			mesher.ConstructFromLevel(viewProjection);
+			out << settings << " " << view << " " << std::hex << meshHash.hash << std::dec << " " << meshHash.vertices << " " << meshHash.indices << " " << mesher.m_MeshStats.coarseChunks << "\n";
+			THEMP_CHECK(meshHash.vertices > 0);
+		}
+	}
+	VoxelObject::s_GreedyMeshing = greedy;
+	VoxelObject::s_CoarseLod = coarseLod;
+	THEMP_CHECK(Test::MatchGolden("mesh_benchmark.txt", out.str()));
+	delete level;
+}
+
+//The rooms pick their floor and wall uvs from their neighbours, they have to keep meshing the same way as well
+THEMP_TEST(Mesh_RoomsMatchGolden)
+{
+	const bool greedy = VoxelObject::s_GreedyMeshing;
+	const bool coarseLod = VoxelObject::s_CoarseLod;
+	LevelData* level = Test::CreateTestLevel();
+	BuildRooms(*level);
+	MeshHash meshHash;
+	std::ostringstream out;
+	for (int settings = 0; settings < 4; settings++)
+	{
+		SetMeshSettings(settings);
+		for (int view = 0; view < 3; view++)
+		{
+			XMFLOAT4X4 viewProjection;
+			GetBenchmarkView(view, viewProjection);
+			VoxelObject mesher(level, HashMesh, &meshHash);
+			mesher.ConstructFromLevel(viewProjection);
+			out << settings << " " << view << " " << std::hex << meshHash.hash << std::dec << " " << meshHash.vertices << " " << meshHash.indices << " " << mesher.m_MeshStats.coarseChunks << "\n";
+			THEMP_CHECK(meshHash.vertices > 0);
+		}
+	}
+	VoxelObject::s_GreedyMeshing = greedy;
+	VoxelObject::s_CoarseLod = coarseLod;
+	THEMP_CHECK(Test::MatchGolden("mesh_rooms.txt", out.str()));
+	delete level;
+}
+
+//The mesh benchmark: how long a full build of the test map takes from every camera, with every mesher setting
+THEMP_BENCHMARK(Mesh_BenchmarkViews)
+{
+	static const char* SettingNames[4] = { "blocks", "greedy", "coarse", "greedy+coarse" };
+	const bool greedy = VoxelObject::s_GreedyMeshing;
+	const bool coarseLod = VoxelObject::s_CoarseLod;
+	LevelData* level = Test::CreateTestLevel();
+	MeshHash meshHash;
+	for (int settings = 0; settings < 4; settings++)
+	{
+		SetMeshSettings(settings);
+		for (int view = 0; view < NumBenchmarkViews; view++)
+		{
+			XMFLOAT4X4 viewProjection;
+			const char* viewName = GetBenchmarkView(view, viewProjection);
+			VoxelObject mesher(level, HashMesh, &meshHash);
+			const int iterations = 10;
+			double total = 0.0;
+			for (int i = 0; i < iterations; i++)
+			{
+				//nothing changes between the builds, so they have to be forced
+				mesher.m_MeshDirty = true;
+				mesher.ConstructFromLevel(viewProjection);
+				total += mesher.m_MeshStats.buildMicroseconds / 1000.0;
+			}
+			char name[96], details[128];
+			snprintf(name, sizeof(name), "Mesh %s, %s", viewName, SettingNames[settings]);
+			snprintf(details, sizeof(details), "%u vertices, %u indices, %u coarse chunks", meshHash.vertices, meshHash.indices, mesher.m_MeshStats.coarseChunks);
+			Test::Report(name, total / iterations, details);
+		}
+	}
+	VoxelObject::s_GreedyMeshing = greedy;
+	VoxelObject::s_CoarseLod = coarseLod;
+	delete level;
+}
+
+//The chunks are meshed on the worker pool and put back together in chunk order, so the mesh can't depend on how many threads did it
+THEMP_TEST(Mesh_SameOnEveryThreadCount)
+{
+	const int threads = VoxelObject::s_MeshThreads;
+	const bool greedy = VoxelObject::s_GreedyMeshing;
+	LevelData* level = Test::CreateTestLevel();
+	MeshHash meshHash;
+	{
+		VoxelObject mesher(level, HashMesh, &meshHash);
+		for (int settings = 0; settings < 4; settings++)
+		{
+			VoxelObject::s_GreedyMeshing = (settings & 1) != 0;
+			const int view = settings >> 1;
+			MeshHash singleThreaded = {};
+			for (int numThreads = 1; numThreads <= 8; numThreads++)
+			{
+				VoxelObject::s_MeshThreads = numThreads;
+				mesher.m_MeshDirty = true;
+				mesher.ConstructFromLevel(GetView(view));
+				if (numThreads == 1)
+				{
+					singleThreaded = meshHash;
+					continue;
+				}
+				THEMP_CHECK(meshHash.hash == singleThreaded.hash);
+				THEMP_CHECK(meshHash.vertices == singleThreaded.vertices && meshHash.indices == singleThreaded.indices);
+			}
+		}
+	}
+	VoxelObject::s_MeshThreads = threads;
+	VoxelObject::s_GreedyMeshing = greedy;
+	delete level;
+}
+
+//how the build time of the close view goes with the number of mesh threads
+THEMP_BENCHMARK(Mesh_ThreadScaling)
+{
+	const int threads = VoxelObject::s_MeshThreads;
+	LevelData* level = Test::CreateTestLevel();
+	MeshHash meshHash;
+	{
+		VoxelObject mesher(level, HashMesh, &meshHash);
+		const int iterations = 20;
+		double singleThreaded = 0.0;
+		for (int numThreads = 1; numThreads <= 8; numThreads *= 2)
+		{
+			VoxelObject::s_MeshThreads = numThreads;
+			double total = 0.0;
+			for (int i = 0; i < iterations; i++)
+			{
+				mesher.m_MeshDirty = true;
+				mesher.ConstructFromLevel(GetView(1));
+				total += mesher.m_MeshStats.buildMicroseconds / 1000.0;
+			}
+			const double milliseconds = total / iterations;
+			if (numThreads == 1) singleThreaded = milliseconds;
+			char name[64], details[128];
+			snprintf(name, sizeof(name), "Mesh close view, %d threads", numThreads);
+			snprintf(details, sizeof(details), "%.2fx, %u vertices", singleThreaded / milliseconds, meshHash.vertices);
+			Test::Report(name, milliseconds, details);
+		}
+	}
+	VoxelObject::s_MeshThreads = threads;
+	delete level;
+}
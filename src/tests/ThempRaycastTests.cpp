@@ -0,0 +1,301 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+#include <cmath>
+#include <cstdlib>
+
+using namespace Themp;
+using namespace DirectX;
+
+//the DDA helpers Raycast uses, from ThempLevelData.cpp
+float intbound(float s, float ds);
+int signum(float x);
+
+namespace
+{
+	//Raycast without the solid height field, a block lookup for every step
+	LevelData::HitData BlockByBlock(const LevelData& level, XMFLOAT3 origin, XMFLOAT3 direction, float range)
+	{
+		int xPos = (int)floor(origin.x);
+		int yPos = (int)floor(origin.y);
+		int zPos = (int)floor(origin.z);
+		const int stepX = signum(direction.x);
+		const int stepY = signum(direction.y);
+		const int stepZ = signum(direction.z);
+		XMFLOAT3 tMax(intbound(origin.x, direction.x), intbound(origin.y, direction.y), intbound(origin.z, direction.z));
+		const XMFLOAT3 tDelta((float)stepX / direction.x, (float)stepY / direction.y, (float)stepZ / direction.z);
+		LevelData::HitData hit = {};
+		//from outside the map it first walks in, range isn't counted for that part
+		while (!(xPos < MAP_SIZE_SUBTILES_RENDER && xPos >= 0 && yPos < 6 && yPos >= 0 && zPos < MAP_SIZE_SUBTILES_RENDER && zPos >= 0))
+		{
+			if (stepX < 0 && xPos < 0) return hit;
+			if (stepY < 0 && yPos < 0) return hit;
+			if (stepZ < 0 && zPos < 0) return hit;
+			if (xPos >= MAP_SIZE_SUBTILES_RENDER && stepX > 0) return hit;
+			if (yPos >= 6 && stepY > 0) return hit;
+			if (zPos >= MAP_SIZE_SUBTILES_RENDER && stepZ > 0) return hit;
+			if (tMax.x < tMax.y)
+			{
+				if (tMax.x < tMax.z) { xPos += stepX; tMax.x += tDelta.x; }
+				else { zPos += stepZ; tMax.z += tDelta.z; }
+			}
+			else
+			{
+				if (tMax.y < tMax.z) { yPos += stepY; tMax.y += tDelta.y; }
+				else { zPos += stepZ; tMax.z += tDelta.z; }
+			}
+		}
+		while (true)
+		{
+			if (xPos < MAP_SIZE_SUBTILES_RENDER && xPos >= 0 && yPos < 6 && yPos >= 0 && zPos < MAP_SIZE_SUBTILES_RENDER && zPos >= 0)
+			{
+				if (level.IsBlockActive(yPos, zPos, xPos) || !LevelData::s_Map.m_Tiles[zPos / 3][xPos / 3].visible)
+				{
+					hit.hit = true;
+					hit.posX = xPos;
+					hit.posY = yPos;
+					hit.posZ = zPos;
+					return hit;
+				}
+			}
+			if (tMax.x < tMax.y)
+			{
+				if (tMax.x < tMax.z) { if (tMax.x > range) break; xPos += stepX; tMax.x += tDelta.x; }
+				else { if (tMax.z > range) break; zPos += stepZ; tMax.z += tDelta.z; }
+			}
+			else
+			{
+				if (tMax.y < tMax.z) { if (tMax.y > range) break; yPos += stepY; tMax.y += tDelta.y; }
+				else { if (tMax.z > range) break; zPos += stepZ; tMax.z += tDelta.z; }
+			}
+		}
+		return hit;
+	}
+	struct TestRay
+	{
+		XMFLOAT3 origin;
+		XMFLOAT3 direction;
+	};
+	float Random(float min, float max)
+	{
+		return min + (max - min) * (rand() / (float)RAND_MAX);
+	}
+	//picking and sight rays: starting inside the map at floor to camera height, mostly flat, some straight down
+	std::vector<TestRay> MakeRays(int count)
+	{
+		std::vector<TestRay> rays(count);
+		for (TestRay& ray : rays)
+		{
+			ray.origin = XMFLOAT3(Random(3.0f, 252.0f), Random(1.0f, 12.0f), Random(3.0f, 252.0f));
+			ray.direction = XMFLOAT3(Random(-1.0f, 1.0f), rand() % 8 == 0 ? -1.0f : Random(-0.6f, 0.3f), Random(-1.0f, 1.0f));
+			if (rand() % 16 == 0) ray.direction.x = 0.0f;
+			const float length = sqrt(ray.direction.x * ray.direction.x + ray.direction.y * ray.direction.y + ray.direction.z * ray.direction.z);
+			ray.direction = XMFLOAT3(ray.direction.x / length, ray.direction.y / length, ray.direction.z / length);
+		}
+		return rays;
+	}
+	//sight rays down the open halls of CreateExploredLevel, where most of the walk is through open air
+	std::vector<TestRay> MakeHallRays(int count)
+	{
+		std::vector<TestRay> rays(count);
+		for (TestRay& ray : rays)
+		{
+			const float hall = (5 + 10 * (rand() % 8)) * 3 + 1.5f;
+			ray.origin = rand() % 2 ? XMFLOAT3(Random(9.0f, 246.0f), Random(1.0f, 5.0f), hall) : XMFLOAT3(hall, Random(1.0f, 5.0f), Random(9.0f, 246.0f));
+			const float along = rand() % 2 ? 1.0f : -1.0f;
+			const float across = Random(-0.03f, 0.03f);
+			ray.direction = ray.origin.z == hall ? XMFLOAT3(along, Random(-0.1f, 0.05f), across) : XMFLOAT3(across, Random(-0.1f, 0.05f), along);
+			const float length = sqrt(ray.direction.x * ray.direction.x + ray.direction.y * ray.direction.y + ray.direction.z * ray.direction.z);
+			ray.direction = XMFLOAT3(ray.direction.x / length, ray.direction.y / length, ray.direction.z / length);
+		}
+		return rays;
+	}
+	//cursor picking rays from a camera looking down on the map at an angle, through every pixel of a 'width' by 'height' screen,
+	//in 2x2 pixel blocks so the rays of a packet are next to each other on screen
+	std::vector<TestRay> MakeScreenRays(int width, int height)
+	{
+		std::vector<TestRay> rays;
+		rays.reserve(width * height);
+		const XMFLOAT3 eye(126.0f, 40.0f, 60.0f);
+		for (int by = 0; by < height; by += 2)
+		{
+			for (int bx = 0; bx < width; bx += 2)
+			{
+				for (int i = 0; i < 4; i++)
+				{
+					const float sx = (bx + i % 2) / (float)width * 2.0f - 1.0f;
+					const float sy = (by + i / 2) / (float)height * 2.0f - 1.0f;
+					XMFLOAT3 direction(sx * 0.9f, -0.8f - sy * 0.4f, 0.6f + sy * 0.3f);
+					const float length = sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+					rays.push_back({ eye, XMFLOAT3(direction.x / length, direction.y / length, direction.z / length) });
+				}
+			}
+		}
+		return rays;
+	}
+	void SplitRays(const std::vector<TestRay>& rays, std::vector<XMFLOAT3>& origins, std::vector<XMFLOAT3>& directions)
+	{
+		origins.resize(rays.size());
+		directions.resize(rays.size());
+		for (size_t i = 0; i < rays.size(); i++)
+		{
+			origins[i] = rays[i].origin;
+			directions[i] = rays[i].direction;
+		}
+	}
+	//the whole map explored, otherwise most rays stop at the first unexplored tile
+	LevelData* CreateExploredLevel()
+	{
+		LevelData* level = Test::CreateTestLevel();
+		for (int y = 0; y < MAP_SIZE_TILES; y++)
+		{
+			for (int x = 0; x < MAP_SIZE_TILES; x++)
+			{
+				LevelData::s_Map.m_Tiles[y][x].visible = true;
+			}
+		}
+		//dig a few open halls so rays have empty columns to cross
+		for (int y = 5; y < 80; y += 10)
+		{
+			for (int x = 3; x < 82; x++)
+			{
+				LevelData::s_Map.m_Tiles[y][x].type = Type_Unclaimed_Path;
+				LevelData::s_Map.m_Tiles[x][y].type = Type_Unclaimed_Path;
+			}
+		}
+		level->UpdateArea(1, 83, 1, 83);
+		return level;
+	}
+}
+
+THEMP_TEST(Raycast_MatchesBlockByBlock)
+{
+	LevelData* level = CreateExploredLevel();
+	srand(11);
+	std::vector<TestRay> rays = MakeRays(20000);
+	const std::vector<TestRay> hallRays = MakeHallRays(20000);
+	rays.insert(rays.end(), hallRays.begin(), hallRays.end());
+	int hits = 0;
+	for (const TestRay& ray : rays)
+	{
+		const LevelData::HitData expected = BlockByBlock(*level, ray.origin, ray.direction, 80.0f);
+		const LevelData::HitData hit = level->Raycast(ray.origin, ray.direction, 80.0f);
+		THEMP_CHECK(hit.hit == expected.hit);
+		if (hit.hit && expected.hit)
+		{
+			THEMP_CHECK(hit.posX == expected.posX && hit.posY == expected.posY && hit.posZ == expected.posZ);
+		}
+		hits += hit.hit;
+	}
+	//make sure both kinds got tested
+	THEMP_CHECK(hits > 2000 && hits < 38000);
+	delete level;
+}
+
+//Batched rays hit exactly what they hit one by one, whether the rays of a packet are close together or all over the place, and for a count that doesn't fill the last packet
+THEMP_TEST(Raycast_BatchMatchesSingleRays)
+{
+	LevelData* level = CreateExploredLevel();
+	srand(39);
+	std::vector<TestRay> rays = MakeRays(10001);
+	const std::vector<TestRay> hallRays = MakeHallRays(10000);
+	const std::vector<TestRay> screenRays = MakeScreenRays(100, 100);
+	rays.insert(rays.end(), hallRays.begin(), hallRays.end());
+	rays.insert(rays.end(), screenRays.begin(), screenRays.end());
+	std::vector<XMFLOAT3> origins, directions;
+	SplitRays(rays, origins, directions);
+	std::vector<LevelData::HitData> hits(rays.size());
+	level->RaycastBatch(origins.data(), directions.data(), rays.size(), 80.0f, hits.data());
+	int different = 0, numHits = 0, screenHits = 0;
+	for (size_t i = 0; i < rays.size(); i++)
+	{
+		const LevelData::HitData expected = level->Raycast(rays[i].origin, rays[i].direction, 80.0f);
+		different += hits[i].hit != expected.hit || hits[i].distance != expected.distance ||
+			hits[i].posX != expected.posX || hits[i].posY != expected.posY || hits[i].posZ != expected.posZ;
+		numHits += hits[i].hit;
+		screenHits += i >= rays.size() - screenRays.size() && hits[i].hit;
+	}
+	THEMP_CHECK(different == 0);
+	THEMP_CHECK(numHits > 2000 && numHits < (int)rays.size() - 2000);
+	//the camera is above the map, its rays walk in from outside first
+	THEMP_CHECK(screenHits > (int)screenRays.size() / 2);
+	delete level;
+}
+
+namespace
+{
+	void TimeRays(LevelData& level, const std::vector<TestRay>& rays, const char* name)
+	{
+		int hits = 0;
+		Timer timer;
+		timer.StartTime();
+		for (const TestRay& ray : rays)
+		{
+			hits += BlockByBlock(level, ray.origin, ray.direction, 80.0f).hit;
+		}
+		const double blockTime = timer.GetDeltaTimeMicro() / 1000.0;
+		timer.StartTime();
+		for (const TestRay& ray : rays)
+		{
+			hits += level.Raycast(ray.origin, ray.direction, 80.0f).hit;
+		}
+		const double skipTime = timer.GetDeltaTimeMicro() / 1000.0;
+		char label[96];
+		char details[64];
+		snprintf(details, sizeof(details), "%d hits", hits / 2);
+		snprintf(label, sizeof(label), "Raycast %s, block by block", name);
+		Test::Report(label, blockTime, details);
+		snprintf(label, sizeof(label), "Raycast %s, with the height field", name);
+		Test::Report(label, skipTime, details);
+	}
+}
+
+THEMP_BENCHMARK(Raycast_100kRays)
+{
+	LevelData* level = CreateExploredLevel();
+	srand(11);
+	TimeRays(*level, MakeRays(100000), "100k random");
+	TimeRays(*level, MakeHallRays(100000), "100k down halls");
+	delete level;
+}
+
+namespace
+{
+	void TimeBatch(LevelData& level, const std::vector<TestRay>& rays, const char* name)
+	{
+		std::vector<XMFLOAT3> origins, directions;
+		SplitRays(rays, origins, directions);
+		std::vector<LevelData::HitData> hits(rays.size());
+		int singleHits = 0, batchHits = 0;
+		Timer timer;
+		timer.StartTime();
+		for (size_t i = 0; i < rays.size(); i++)
+		{
+			hits[i] = level.Raycast(origins[i], directions[i], 80.0f);
+			singleHits += hits[i].hit;
+		}
+		const double singleTime = timer.GetDeltaTimeMicro();
+		timer.StartTime();
+		level.RaycastBatch(origins.data(), directions.data(), rays.size(), 80.0f, hits.data());
+		const double batchTime = timer.GetDeltaTimeMicro();
+		for (size_t i = 0; i < rays.size(); i++) batchHits += hits[i].hit;
+		THEMP_CHECK(singleHits == batchHits);
+		char label[96];
+		char details[128];
+		snprintf(label, sizeof(label), "Raycast batch %s", name);
+		snprintf(details, sizeof(details), "%.2f M rays/s batched, %.2f M rays/s one by one, %d hits", rays.size() / batchTime, rays.size() / singleTime, batchHits);
+		Test::Report(label, batchTime / 1000.0, details);
+	}
+}
+
+//Rays a second through RaycastBatch against Raycast one ray at a time, on the explored test map (there are no campaign maps to load headless)
+THEMP_BENCHMARK(Raycast_BatchRaysPerSecond)
+{
+	LevelData* level = CreateExploredLevel();
+	srand(39);
+	TimeBatch(*level, MakeRays(100000), "100k random");
+	TimeBatch(*level, MakeHallRays(100000), "100k down halls");
+	TimeBatch(*level, MakeScreenRays(400, 250), "100k screen picking");
+	delete level;
+}
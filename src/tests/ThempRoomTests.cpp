@@ -0,0 +1,52 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+#include <cstdlib>
+
+using namespace Themp;
+
+THEMP_TEST(Room_RandomTileWeightedBySize)
+{
+	TileMap* map = Test::CreateTestMap();
+	//two treasure rooms in the red dungeon, 4 and 16 tiles
+	for (int y = 36; y <= 37; y++)
+	{
+		for (int x = 36; x <= 37; x++)
+		{
+			map->m_Tiles[y][x].type = Type_Treasure_Room;
+		}
+	}
+	for (int y = 45; y <= 48; y++)
+	{
+		for (int x = 45; x <= 48; x++)
+		{
+			map->m_Tiles[y][x].type = Type_Treasure_Room;
+		}
+	}
+	LevelData* level = new LevelData(*map);
+	delete map;
+	level->Init();
+	const int small = level->CreateRoomFromArea(Type_Treasure_Room, INT32_MAX, 36, 36);
+	const int big = level->CreateRoomFromArea(Type_Treasure_Room, INT32_MAX, 45, 45);
+	THEMP_CHECK(small != -1 && big != -1);
+	const int areaCode = LevelData::s_Map.m_Tiles[36][36].areaCode;
+	THEMP_CHECK(level->m_Rooms[Owner_PlayerRed][small].tiles.size() == 4);
+	THEMP_CHECK(level->m_Rooms[Owner_PlayerRed][big].tiles.size() == 16);
+
+	srand(1);
+	const int picks = 20000;
+	int inBig = 0;
+	for (int i = 0; i < picks; i++)
+	{
+		const LevelData::Room::RoomTile* tile = level->GetRandomRoomTile(Owner_PlayerRed, Type_Treasure_Room, areaCode);
+		THEMP_CHECK(tile != nullptr);
+		if (tile == nullptr) break;
+		inBig += tile->y >= 45;
+	}
+	//16 of the 20 tiles are in the big room
+	const float share = inBig / (float)picks;
+	THEMP_CHECK(share > 0.77f && share < 0.83f);
+	THEMP_CHECK(level->GetRandomRoomTile(Owner_PlayerRed, Type_Treasure_Room, areaCode + 1000) == nullptr);
+	delete level;
+}
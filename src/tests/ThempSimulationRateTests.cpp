@@ -0,0 +1,220 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempTileArrays.h"
+#include "ThempLevel.h"
+#include "ThempLevelData.h"
+#include "Players/ThempPlayerBase.h"
+#include "Creature/ThempCreature.h"
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdlib>
+
+using namespace Themp;
+using namespace DirectX;
+
+namespace
+{
+	//the game camera's projection from a few spots, eye and look direction in world units (3 per tile)
+	struct View
+	{
+		const char* name;
+		XMFLOAT3 eye;
+		XMFLOAT3 direction;
+	};
+	const View Views[] =
+	{
+		{ "looking down on the heart", XMFLOAT3(126.0f, 30.0f, 110.0f), XMFLOAT3(0.0f, -0.9f, 0.45f) },
+		{ "low, looking north", XMFLOAT3(126.0f, 12.0f, 60.0f), XMFLOAT3(0.0f, -0.5f, 0.85f) },
+		{ "high above the middle", XMFLOAT3(126.0f, 90.0f, 126.0f), XMFLOAT3(0.0f, -1.0f, 0.01f) },
+		{ "close, top left corner", XMFLOAT3(20.0f, 20.0f, 20.0f), XMFLOAT3(0.5f, -0.7f, 0.5f) },
+	};
+	XMFLOAT4X4 ViewProjection(const View& view)
+	{
+		XMFLOAT4X4 result;
+		const XMMATRIX lookTo = XMMatrixLookToLH(XMVectorSet(view.eye.x, view.eye.y, view.eye.z, 1), XMVectorSet(view.direction.x, view.direction.y, view.direction.z, 0), XMVectorSet(0, 1, 0, 0));
+		XMStoreFloat4x4(&result, lookTo * XMMatrixPerspectiveFovLH(XMConvertToRadians(75.0f), 16.0f / 9.0f, 0.1f, 1000.0f));
+		return result;
+	}
+	//what UseReducedRate did before, a 12 tile square around the tile under the camera
+	bool OldReducedRate(const View& view, XMINT2 tilePos)
+	{
+		const XMINT2 focus((int)view.eye.x / 3, (int)view.eye.z / 3);
+		return abs(tilePos.x - focus.x) > 12 || abs(tilePos.y - focus.y) > 12;
+	}
+	//any spot on the tile's floor or walls shows up on screen
+	bool OnScreen(const Frustum& screen, XMINT2 tilePos)
+	{
+		for (int i = 0; i <= 4; i++)
+		{
+			for (int j = 0; j <= 4; j++)
+			{
+				for (int h = 0; h <= MAP_SIZE_HEIGHT; h += 2)
+				{
+					if (screen.ContainsPoint(XMFLOAT3(tilePos.x * 3.0f + i * 0.75f, (float)h, tilePos.y * 3.0f + j * 0.75f))) return true;
+				}
+			}
+		}
+		return false;
+	}
+}
+
+//Every tile the camera shows has to run at full rate, the old square around the camera missed the far half of a tilted view and simulated a lot behind it
+THEMP_TEST(SimulationRate_FrustumAgainstOldSquare)
+{
+	for (size_t v = 0; v < sizeof(Views) / sizeof(Views[0]); v++)
+	{
+		const XMFLOAT4X4 viewProjection = ViewProjection(Views[v]);
+		const Frustum screen(viewProjection);
+		Creature::s_SimulationView.SetFromViewProjection(viewProjection);
+
+		int onScreen = 0, reducedOnScreen = 0, oldReducedOnScreen = 0, fullOffScreen = 0, oldFullOffScreen = 0;
+		for (int y = 0; y < MAP_SIZE_TILES; y++)
+		{
+			for (int x = 0; x < MAP_SIZE_TILES; x++)
+			{
+				const XMINT2 tilePos(x, y);
+				const bool visible = OnScreen(screen, tilePos);
+				const bool reduced = Creature::IsReducedRateTile(tilePos);
+				const bool oldReduced = OldReducedRate(Views[v], tilePos);
+				if (visible)
+				{
+					onScreen++;
+					reducedOnScreen += reduced;
+					oldReducedOnScreen += oldReduced;
+				}
+				else
+				{
+					fullOffScreen += !reduced;
+					oldFullOffScreen += !oldReduced;
+				}
+			}
+		}
+		System::Print("%s: %i tiles on screen, reduced rate on screen: %i (old %i), full rate off screen: %i (old %i)",
+			Views[v].name, onScreen, reducedOnScreen, oldReducedOnScreen, fullOffScreen, oldFullOffScreen);
+		THEMP_CHECK(onScreen > 0);
+		THEMP_CHECK(reducedOnScreen == 0);
+		//the margin keeps a ring of tiles around the view at full rate, but nothing like the whole map
+		THEMP_CHECK(fullOffScreen < MAP_SIZE_TILES * MAP_SIZE_TILES / 4);
+	}
+	//the tilted views see further than 12 tiles, the old square put creatures the player could see on the reduced rate
+	{
+		const Frustum screen(ViewProjection(Views[1]));
+		int oldReducedOnScreen = 0;
+		for (int y = 0; y < MAP_SIZE_TILES; y++)
+		{
+			for (int x = 0; x < MAP_SIZE_TILES; x++)
+			{
+				oldReducedOnScreen += OnScreen(screen, XMINT2(x, y)) && OldReducedRate(Views[1], XMINT2(x, y));
+			}
+		}
+		THEMP_CHECK(oldReducedOnScreen > 0);
+	}
+	Creature::s_SimulationView = Frustum();
+}
+
+namespace
+{
+	//what a run of the simulation left behind, everything the player would notice
+	struct SimulationResult
+	{
+		//the turn every tile showed up on, -1 for never and -2 for the ones visible from the start
+		std::vector<int> revealedOn;
+		std::vector<uint16_t> types;
+		std::vector<uint8_t> owners;
+		std::vector<float> health;
+		std::vector<int> gold;
+		uint32_t reducedRate = 0;
+	};
+	//a few imps with the dungeon's claims and walls to see to and two tiles to dig, one of them down the unexplored end of the corridor,
+	//and a knight of ours fighting one of the heroes in the dungeon
+	SimulationResult RunSeededLevel(const Frustum& view, int turns)
+	{
+		Creature::s_SimulationView = view;
+		Level* level = Test::CreateTestWorld();
+		srand(30);
+		const XMINT2 imps[] = { XMINT2(45, 45), XMINT2(38, 46), XMINT2(47, 37), XMINT2(55, 42) };
+		for (size_t i = 0; i < sizeof(imps) / sizeof(imps[0]); i++)
+		{
+			Test::AddTestCreature(level, CreatureData::CREATURE_IMP, Owner_PlayerRed, imps[i]);
+		}
+		Test::AddTestCreature(level, CreatureData::CREATURE_KNIGHT, Owner_PlayerRed, XMINT2(41, 38));
+		Test::AddTestCreature(level, CreatureData::CREATURE_KNIGHT, Owner_PlayerWhite, XMINT2(38, 38));
+		level->m_LevelData->MarkTile(Owner_PlayerRed, 41, 41);
+		level->m_LevelData->MarkTile(Owner_PlayerRed, 42, 63);
+
+		SimulationResult result;
+		result.revealedOn.assign(MAP_SIZE_TILES * MAP_SIZE_TILES, -1);
+		for (int i = 0; i < MAP_SIZE_TILES * MAP_SIZE_TILES; i++)
+		{
+			if (LevelData::s_Map.m_Tiles[i / MAP_SIZE_TILES][i % MAP_SIZE_TILES].visible) result.revealedOn[i] = -2;
+		}
+		for (int t = 0; t < turns; t++)
+		{
+			Test::RunTurns(level, 1);
+			result.reducedRate += Creature::s_NumReducedRate;
+			for (int i = 0; i < MAP_SIZE_TILES * MAP_SIZE_TILES; i++)
+			{
+				if (result.revealedOn[i] == -1 && LevelData::s_Map.m_Tiles[i / MAP_SIZE_TILES][i % MAP_SIZE_TILES].visible) result.revealedOn[i] = t;
+			}
+		}
+		for (int y = 0; y < MAP_SIZE_TILES; y++)
+		{
+			for (int x = 0; x < MAP_SIZE_TILES; x++)
+			{
+				const Tile& tile = LevelData::s_Map.m_Tiles[y][x];
+				result.types.push_back(tile.GetType());
+				result.owners.push_back(tile.owner);
+			}
+		}
+		const uint8_t players[] = { Owner_PlayerRed, Owner_PlayerWhite };
+		for (int p = 0; p < 2; p++)
+		{
+			const std::vector<Creature*>& creatures = level->m_Players[players[p]]->m_Creatures;
+			for (size_t i = 0; i < creatures.size(); i++)
+			{
+				result.health.push_back(creatures[i]->m_CurrentHealth);
+				result.gold.push_back(creatures[i]->m_CurrentGoldHold);
+			}
+		}
+		delete level;
+		Creature::s_SimulationView = Frustum();
+		return result;
+	}
+}
+
+//Off screen creatures only save on the work nobody sees, the same seeded level run with everything on screen and everything off it
+//reveals the same tiles on the same turns, digs and claims the same ones and the fight ends the same way
+THEMP_TEST(SimulationRate_ReducedRateKeepsGameplay)
+{
+	const int turns = 20 * 45;
+	const SimulationResult full = RunSeededLevel(Frustum(), turns);
+	//a frustum with every plane facing away has nothing inside it
+	Frustum offScreen;
+	for (int i = 0; i < Frustum::NumPlanes; i++) offScreen.m_Planes[i] = XMFLOAT4(0, 0, 0, -1);
+	const SimulationResult reduced = RunSeededLevel(offScreen, turns);
+
+	THEMP_CHECK(full.reducedRate == 0);
+	THEMP_CHECK(reduced.reducedRate > 0);
+
+	int revealed = 0, revealedLater = 0, differentTiles = 0;
+	for (size_t i = 0; i < full.revealedOn.size(); i++)
+	{
+		revealed += full.revealedOn[i] >= 0;
+		revealedLater += full.revealedOn[i] != reduced.revealedOn[i];
+		differentTiles += full.types[i] != reduced.types[i] || full.owners[i] != reduced.owners[i];
+	}
+	System::Print("%i tiles revealed, %i of them on a different turn off screen, %i tiles dug or claimed differently", revealed, revealedLater, differentTiles);
+	THEMP_CHECK(revealed > 0);
+	THEMP_CHECK(revealedLater == 0);
+	THEMP_CHECK(differentTiles == 0);
+	//the corridor's far end got explored and dug into
+	THEMP_CHECK(full.revealedOn[42 * MAP_SIZE_TILES + 62] >= 0);
+	THEMP_CHECK(full.types[42 * MAP_SIZE_TILES + 63] != Type_Earth);
+	THEMP_CHECK(full.health == reduced.health);
+	THEMP_CHECK(full.gold == reduced.gold);
+	//somebody got hurt, nobody starts with anything but the 75 or 300 health of their type
+	bool fought = false;
+	for (size_t i = 0; i < full.health.size(); i++) fought |= full.health[i] != 75.0f && full.health[i] != 300.0f;
+	THEMP_CHECK(fought);
+}
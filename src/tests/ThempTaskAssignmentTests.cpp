@@ -0,0 +1,180 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+#include "Creature/ThempCreatureTaskManager.h"
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+using namespace Themp;
+
+namespace
+{
+	typedef CreatureTaskManager CTM;
+
+	//the task manager only keys its maps with the imps and never looks inside them, so any address will do
+	char ImpIds[256];
+	Creature* FakeImp(int i)
+	{
+		return reinterpret_cast<Creature*>(&ImpIds[i]);
+	}
+	std::vector<CTM::IdleImp> IdleImps(const std::vector<XMINT2>& positions)
+	{
+		std::vector<CTM::IdleImp> imps(positions.size());
+		for (size_t i = 0; i < positions.size(); i++)
+		{
+			imps[i].imp = FakeImp((int)i);
+			imps[i].tilePos = positions[i];
+			imps[i].areaCode = LevelData::s_Map.m_Tiles[positions[i].y][positions[i].x].areaCode;
+		}
+		return imps;
+	}
+	//the categories in the order Update hands them out
+	void AssignAll(uint8_t player, std::vector<CTM::IdleImp>& imps)
+	{
+		CTM::AssignNearestTasks(CTM::Category_SoloMining, player, imps);
+		CTM::AssignNearestTasks(CTM::Category_Mining, player, imps);
+		CTM::AssignNearestTasks(CTM::Category_Claiming, player, imps);
+		CTM::AssignNearestTasks(CTM::Category_Reinforcing, player, imps);
+	}
+	//what every imp did before, asking on its own and taking the first task in the map that still had room, wherever it was
+	float FirstComeClaims(uint8_t player, std::vector<CTM::IdleImp>& imps)
+	{
+		float distance = 0;
+		for (size_t i = 0; i < imps.size(); i++)
+		{
+			for (auto it = CTM::ClaimingTasks[player].begin(); it != CTM::ClaimingTasks[player].end(); it++)
+			{
+				XMINT2 subTile;
+				const int spot = CTM::FindTaskSpot(CTM::Category_Claiming, it->second, player, imps[i].areaCode, subTile);
+				if (spot < 0) continue;
+				imps[i].order = CTM::TakeTaskSpot(CTM::Category_Claiming, it->second, spot, subTile, imps[i].imp, player);
+				imps[i].assigned = true;
+				const int dx = imps[i].tilePos.x - it->second.tilePosition.x;
+				const int dy = imps[i].tilePos.y - it->second.tilePosition.y;
+				distance += sqrtf((float)(dx * dx + dy * dy));
+				break;
+			}
+		}
+		return distance;
+	}
+	void AddClaim(int y, int x)
+	{
+		CTM::AddClaimingTask(Owner_PlayerRed, XMINT2(x, y), &LevelData::s_Map.m_Tiles[y][x]);
+	}
+}
+
+//Closest imp/task pairs go first, a claim takes a single imp and mining comes before claiming and reinforcing
+THEMP_TEST(TaskAssignment_NearestPairsFirst)
+{
+	LevelData* level = Test::CreateTestLevel();
+	CTM::Clear();
+
+	//two claims down the corridor, the imp at the far end takes the close one where asking first would've sent it past the other imp
+	AddClaim(42, 51);
+	AddClaim(42, 60);
+	std::vector<CTM::IdleImp> imps = IdleImps({ XMINT2(55, 42), XMINT2(50, 42), XMINT2(45, 45) });
+	AssignAll(Owner_PlayerRed, imps);
+	THEMP_CHECK(imps[0].assigned && imps[0].order.valid && imps[0].order.orderType == CTM::Order_Claim);
+	THEMP_CHECK(imps[0].order.targetTilePos.x == 60 && imps[0].order.targetTilePos.y == 42);
+	THEMP_CHECK(imps[1].assigned && imps[1].order.targetTilePos.x == 51);
+	THEMP_CHECK(!imps[2].assigned && !imps[2].order.valid);
+	THEMP_CHECK(CTM::ClaimingTasks[Owner_PlayerRed][&LevelData::s_Map.m_Tiles[42][51]].assignedCreatures == 1);
+	THEMP_CHECK(CTM::TaskedImps[Owner_PlayerRed].size() == 2);
+	THEMP_CHECK(CTM::AssignStats.assignedTasks == 2);
+	THEMP_CHECK(fabsf(CTM::AssignStats.totalDistance - 6.0f) < 0.001f);
+
+	//the same imps asking one after the other get the claims in the map's order, 14 tiles when the close one comes first and never less than 6
+	CTM::Clear();
+	AddClaim(42, 51);
+	AddClaim(42, 60);
+	std::vector<XMINT2> mapOrder;
+	for (auto it = CTM::ClaimingTasks[Owner_PlayerRed].begin(); it != CTM::ClaimingTasks[Owner_PlayerRed].end(); it++) mapOrder.push_back(it->second.tilePosition);
+	imps = IdleImps({ XMINT2(55, 42), XMINT2(50, 42), XMINT2(45, 45) });
+	const float firstCome = FirstComeClaims(Owner_PlayerRed, imps);
+	THEMP_CHECK(imps[0].assigned && imps[0].order.targetTilePos.x == mapOrder[0].x);
+	THEMP_CHECK(imps[1].assigned && imps[1].order.targetTilePos.x == mapOrder[1].x);
+	THEMP_CHECK(!imps[2].assigned);
+	THEMP_CHECK(fabsf(firstCome - (mapOrder[0].x == 51 ? 14.0f : 6.0f)) < 0.001f);
+
+	//a corner of the pillar to mine, a claim and a wall to reinforce right next to the imps, mining still comes first
+	CTM::Clear();
+	Tile* pillar = &LevelData::s_Map.m_Tiles[41][41];
+	CTM::AddMiningTask(Owner_PlayerRed, XMINT2(41, 41), pillar);
+	AddClaim(42, 51);
+	CTM::AddReinforcingTask(Owner_PlayerRed, XMINT2(43, 43), &LevelData::s_Map.m_Tiles[43][43]);
+	std::vector<XMINT2> positions;
+	for (int i = 0; i < 10; i++)
+	{
+		positions.push_back(XMINT2(49 - i / 5, 42 + i % 5));
+	}
+	imps = IdleImps(positions);
+	XMINT2 subTile;
+	THEMP_CHECK(CTM::FindTaskSpot(CTM::Category_Mining, CTM::MiningTasks[Owner_PlayerRed][pillar], Owner_PlayerRed, imps[0].areaCode, subTile) >= 0);
+	AssignAll(Owner_PlayerRed, imps);
+	int mining = 0, claiming = 0, reinforcing = 0, idle = 0;
+	for (size_t i = 0; i < imps.size(); i++)
+	{
+		idle += !imps[i].assigned;
+		mining += imps[i].assigned && imps[i].order.orderType == CTM::Order_Mine;
+		claiming += imps[i].assigned && imps[i].order.orderType == CTM::Order_Claim;
+		reinforcing += imps[i].assigned && imps[i].order.orderType == CTM::Order_Reinforce;
+	}
+	THEMP_CHECK(mining == CTM::MiningTasks[Owner_PlayerRed][pillar].assignedCreatures);
+	THEMP_CHECK(mining > 1);
+	THEMP_CHECK(claiming == 1);
+	THEMP_CHECK(reinforcing == CTM::ReinforcingTasks[Owner_PlayerRed][&LevelData::s_Map.m_Tiles[43][43]].assignedCreatures);
+	THEMP_CHECK(idle == (int)imps.size() - mining - claiming - reinforcing);
+	THEMP_CHECK((int)CTM::TaskedImps[Owner_PlayerRed].size() == mining + claiming + reinforcing);
+	CTM::Clear();
+	delete level;
+}
+
+//40 idle imps and 20 claims spread over the dungeon, the time per handed out task and how far the imps walk, against every imp asking on its own
+THEMP_BENCHMARK(TaskAssignment_40ImpsNearestFirst)
+{
+	LevelData* level = Test::CreateTestLevel();
+	CTM::Clear();
+	const int areaCode = LevelData::s_Map.m_Tiles[40][40].areaCode;
+	srand(5);
+	std::vector<XMINT2> positions(40), claims(20);
+	for (size_t i = 0; i < positions.size(); i++) level->GetRandomWalkableTile(areaCode, positions[i]);
+	for (size_t i = 0; i < claims.size(); i++) level->GetRandomWalkableTile(areaCode, claims[i]);
+
+	const int rounds = 200;
+	double time[2] = {};
+	float distance[2] = {};
+	uint32_t assigned[2] = {};
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int r = 0; r < rounds; r++)
+		{
+			CTM::Clear();
+			for (size_t i = 0; i < claims.size(); i++) AddClaim(claims[i].y, claims[i].x);
+			std::vector<CTM::IdleImp> imps = IdleImps(positions);
+			Timer timer;
+			timer.StartTime();
+			if (pass == 0)
+			{
+				AssignAll(Owner_PlayerRed, imps);
+				distance[pass] += CTM::AssignStats.totalDistance;
+			}
+			else
+			{
+				distance[pass] += FirstComeClaims(Owner_PlayerRed, imps);
+			}
+			time[pass] += timer.GetDeltaTimeMicro();
+			for (size_t i = 0; i < imps.size(); i++) assigned[pass] += imps[i].assigned;
+		}
+	}
+	THEMP_CHECK(assigned[0] == assigned[1]);
+	THEMP_CHECK(distance[0] <= distance[1]);
+	const double perTask[2] = { time[0] / assigned[0], time[1] / assigned[1] };
+	char details[160];
+	snprintf(details, sizeof(details), "%.3f us a task, %.2f tiles on average, asking one by one took %.3f us for %.2f tiles",
+		perTask[0], distance[0] / assigned[0], perTask[1], distance[1] / assigned[1]);
+	Test::Report("TaskAssignment 40 imps 20 claims", perTask[0] / 1000.0, details);
+	CTM::Clear();
+	delete level;
+}
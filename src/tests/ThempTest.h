@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdio>
+namespace Themp
+{
+	//Tiny test runner for everything that can run without a window, a GPU or the game files.
+	//Tests and benchmarks register themselves with the macros below, ThempTestMain runs them (benchmarks only with --bench).
+	namespace Test
+	{
+		typedef void(*TestFunction)();
+		struct Entry
+		{
+			const char* name;
+			TestFunction function;
+			bool benchmark;
+		};
+		std::vector<Entry>& Registry();
+		struct Registrar
+		{
+			Registrar(const char* name, TestFunction function, bool benchmark)
+			{
+				Registry().push_back({ name, function, benchmark });
+			}
+		};
+		void Fail(const char* file, int line, const char* expression);
+		//prints a benchmark result line, time is in milliseconds
+		void Report(const char* name, double milliseconds, const char* details = "");
+
+		//--bless, tests comparing against files in the golden folder write them instead
+		extern bool s_Bless;
+		//where the golden files live, relative to the working directory
+		extern std::string s_GoldenDir;
+		//compares with the golden file of that name (or writes it with --bless), a missing golden file is a failure too
+		bool MatchGolden(const char* name, const std::string& contents);
+	};
+};
+
+#define THEMP_TEST(name) static void name(); static Themp::Test::Registrar name##_Registrar(#name, name, false); static void name()
+#define THEMP_BENCHMARK(name) static void name(); static Themp::Test::Registrar name##_Registrar(#name, name, true); static void name()
+#define THEMP_CHECK(x) do { if (!(x)) { Themp::Test::Fail(__FILE__, __LINE__, #x); } } while (0)
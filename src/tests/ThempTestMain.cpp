@@ -0,0 +1,133 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include <cstdarg>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#ifdef _DEBUG
+#include <imgui.h>
+#endif
+
+//ThempSystem.cpp holds the window and the game loop, the tests only need what the game code calls into
+namespace Themp
+{
+	float lerp(float x, float y, float t)
+	{
+		return x * (1.0f - t) + y * t;
+	}
+	float mod(float val, float mod)
+	{
+		return fmod(fmod(val, mod) + mod, mod);
+	}
+	System* System::tSys = nullptr;
+	FILE* System::logFile = nullptr;
+	bool verbose = false;
+
+	namespace Test
+	{
+		bool s_Bless = false;
+		std::string s_GoldenDir = "src/tests/golden/";
+		int s_Failures = 0;
+
+		std::vector<Entry>& Registry()
+		{
+			static std::vector<Entry> entries;
+			return entries;
+		}
+		void Fail(const char* file, int line, const char* expression)
+		{
+			printf("  FAILED %s:%i: %s\n", file, line, expression);
+			s_Failures++;
+		}
+		void Report(const char* name, double milliseconds, const char* details)
+		{
+			printf("  %-40s %10.3f ms %s\n", name, milliseconds, details);
+		}
+		bool MatchGolden(const char* name, const std::string& contents)
+		{
+			const std::string path = s_GoldenDir + name;
+			if (s_Bless)
+			{
+				std::ofstream file(path, std::ios::binary);
+				file << contents;
+				printf("  wrote %s\n", path.c_str());
+				return file.good();
+			}
+			std::ifstream file(path, std::ios::binary);
+			if (!file.is_open())
+			{
+				printf("  missing golden file %s, run with --bless to create it\n", path.c_str());
+				return false;
+			}
+			std::stringstream golden;
+			golden << file.rdbuf();
+			//git may have given the file windows line endings
+			std::string expected = golden.str();
+			expected.erase(std::remove(expected.begin(), expected.end(), '\r'), expected.end());
+			if (expected != contents)
+			{
+				printf("  %s doesn't match, got:\n%s", path.c_str(), contents.c_str());
+				return false;
+			}
+			return true;
+		}
+	};
+};
+void Themp::System::Print(const char* message, ...)
+{
+	if (!verbose) return;
+	va_list args;
+	va_start(args, message);
+	vprintf(message, args);
+	va_end(args);
+	printf("\n");
+}
+void Themp::System::Print(const std::string& message, ...)
+{
+	if (!verbose) return;
+	printf("%s\n", message.c_str());
+}
+
+//ThempTests [--bench] [--bless] [--verbose] [--golden <dir>] [name filter]
+int main(int argc, char** argv)
+{
+	using namespace Themp;
+	bool runBenchmarks = false;
+	const char* filter = nullptr;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--bench") == 0) runBenchmarks = true;
+		else if (strcmp(argv[i], "--bless") == 0) Test::s_Bless = true;
+		else if (strcmp(argv[i], "--verbose") == 0) verbose = true;
+		else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) Test::s_GoldenDir = std::string(argv[++i]) + "/";
+		else filter = argv[i];
+	}
+
+#ifdef _DEBUG
+	//the game code prints its debug windows in debug builds, give it a context to print into that never gets drawn
+	ImGui::CreateContext();
+	ImGuiIO& io = ImGui::GetIO();
+	io.DisplaySize = ImVec2(1280, 720);
+	io.DeltaTime = 1.0f / 60.0f;
+	io.IniFilename = nullptr;
+	unsigned char* fontPixels;
+	int fontWidth, fontHeight;
+	io.Fonts->GetTexDataAsRGBA32(&fontPixels, &fontWidth, &fontHeight);
+#endif
+
+	int ran = 0;
+	int failed = 0;
+	for (const Test::Entry& entry : Test::Registry())
+	{
+		if (entry.benchmark != runBenchmarks) continue;
+		if (filter && !strstr(entry.name, filter)) continue;
+		printf("%s %s\n", entry.benchmark ? "[bench]" : "[test] ", entry.name);
+		const int failuresBefore = Test::s_Failures;
+		entry.function();
+		ran++;
+		if (Test::s_Failures != failuresBefore) failed++;
+	}
+	printf("%i ran, %i failed\n", ran, failed);
+	return failed ? 1 : 0;
+}
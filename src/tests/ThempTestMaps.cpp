@@ -0,0 +1,161 @@
+#include "ThempSystem.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+#include "ThempLevel.h"
+#include "ThempLevelConfig.h"
+#include "Creature/ThempCreature.h"
+#include "Creature/ThempCreatureTaskManager.h"
+#include "Players/ThempPlayerBase.h"
+#ifdef _DEBUG
+#include <imgui.h>
+#endif
+
+using namespace Themp;
+
+namespace
+{
+	void Fill(TileMap& map, int minY, int maxY, int minX, int maxX, uint16_t type, uint8_t owner, bool visible)
+	{
+		for (int y = minY; y <= maxY; y++)
+		{
+			for (int x = minX; x <= maxX; x++)
+			{
+				Tile& tile = map.m_Tiles[y][x];
+				tile.type = type;
+				tile.owner = owner;
+				tile.visible = visible;
+				//building the level gives it the health from the config
+				tile.health = 0;
+			}
+		}
+	}
+	void SetInstance(int instance, uint8_t time, uint8_t actionTime, uint16_t resetTime)
+	{
+		InstanceData& data = LevelConfig::instanceData[instance];
+		data.Time = time;
+		data.ActionTime = actionTime;
+		data.ResetTime = resetTime;
+	}
+	//round numbers in the range of the original configs, an earth tile takes 5 hits and a hit takes 8 turns
+	void SetTestConfig()
+	{
+		LevelConfig::gameSettings[GameSettings::GAME_DEFAULT_IMP_DIG_DAMAGE].Value = 10;
+		LevelConfig::gameSettings[GameSettings::GAME_GOLD_PER_GOLD_BLOCK].Value = 500;
+		LevelConfig::gameSettings[GameSettings::GAME_GOLD_PILE_MAXIMUM].Value = 1000;
+		LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_ROCK].Value = 50;
+		LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_GOLD].Value = 50;
+		LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_PRETTY].Value = 30;
+		LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_FLOOR].Value = 20;
+		LevelConfig::blockHealth[BlockHealth::BLOCK_HEALTH_ROOM].Value = 30;
+		SetInstance(INSTANCE_DIG, 5, 3, 0);
+		SetInstance(INSTANCE_PRETTY_PATH, 4, 2, 0);
+		SetInstance(INSTANCE_REINFORCE, 4, 2, 0);
+		SetInstance(INSTANCE_SWING_WEAPON_FIST, 6, 4, 0);
+		SetInstance(INSTANCE_SWING_WEAPON_SWORD, 8, 4, 0);
+	}
+	CreatureData TestCreatureData(CreatureData::CreatureType type)
+	{
+		CreatureData data = {};
+		data.CreatureNumber = (uint8_t)type;
+		if (type == CreatureData::CREATURE_IMP)
+		{
+			data.Health = 75;
+			data.Strength = 5;
+			data.BaseSpeed = 48;
+			data.VisualRange = 12;
+			data.GoldHold = 200;
+			data.Power[0] = INSTANCE_SWING_WEAPON_FIST;
+		}
+		else
+		{
+			data.Health = 300;
+			data.Strength = 30;
+			data.BaseSpeed = 32;
+			data.VisualRange = 15;
+			data.GoldHold = 300;
+			data.HungerFill = 10;
+			data.Power[0] = INSTANCE_SWING_WEAPON_SWORD;
+		}
+		return data;
+	}
+}
+
+TileMap* Test::CreateTestMap()
+{
+	TileMap* map = new TileMap();
+	Fill(*map, 0, MAP_SIZE_TILES - 1, 0, MAP_SIZE_TILES - 1, Type_Rock, Owner_PlayerNone, false);
+	Fill(*map, 1, MAP_SIZE_TILES - 2, 1, MAP_SIZE_TILES - 2, Type_Earth, Owner_PlayerNone, false);
+
+	//the dungeon, a ring of reinforced wall around claimed land
+	Fill(*map, 34, 50, 34, 50, Type_Wall0, Owner_PlayerRed, true);
+	Fill(*map, 35, 49, 35, 49, Type_Claimed_Land, Owner_PlayerRed, true);
+	map->m_Tiles[34][34].type = Type_Wall3;
+	map->m_Tiles[34][50].type = Type_Wall3;
+	map->m_Tiles[50][34].type = Type_Wall3;
+	map->m_Tiles[50][50].type = Type_Wall3;
+	map->m_Tiles[42][34].type = Type_Wall2;
+	//a pillar of earth and a torch in the middle of it
+	Fill(*map, 41, 43, 41, 43, Type_Earth, Owner_PlayerNone, true);
+	map->m_Tiles[42][42].type = Type_Earth_Torch;
+
+	//a corridor out of the east wall, half of it dug but not claimed yet
+	Fill(*map, 42, 42, 50, 62, Type_Unclaimed_Path, Owner_PlayerNone, true);
+	Fill(*map, 42, 42, 57, 62, Type_Unclaimed_Path, Owner_PlayerNone, false);
+
+	//water and lava pools, one of them next to the dungeon
+	Fill(*map, 36, 39, 52, 56, Type_Water, Owner_PlayerNone, true);
+	Fill(*map, 60, 66, 20, 28, Type_Lava, Owner_PlayerNone, false);
+	Fill(*map, 15, 18, 60, 70, Type_Water, Owner_PlayerNone, false);
+
+	//gold seams and a gem
+	Fill(*map, 30, 31, 40, 48, Type_Gold, Owner_PlayerNone, false);
+	Fill(*map, 52, 58, 44, 45, Type_Gold, Owner_PlayerNone, true);
+	map->m_Tiles[70][70].type = Type_Gem;
+
+	//a second, unexplored cave with an enemy's claimed land and walls
+	Fill(*map, 10, 20, 10, 22, Type_Wall0, Owner_PlayerBlue, false);
+	Fill(*map, 11, 19, 11, 21, Type_Claimed_Land, Owner_PlayerBlue, false);
+	Fill(*map, 15, 15, 22, 30, Type_Unclaimed_Path, Owner_PlayerNone, false);
+	return map;
+}
+
+LevelData* Test::CreateTestLevel()
+{
+	SetTestConfig();
+	TileMap* map = CreateTestMap();
+	LevelData* level = new LevelData(*map);
+	delete map;
+	level->Init();
+	return level;
+}
+
+Level* Test::CreateTestWorld()
+{
+	CreatureTaskManager::Clear();
+	return new Level(CreateTestLevel());
+}
+
+Creature* Test::AddTestCreature(Level* level, CreatureData::CreatureType type, uint8_t owner, XMINT2 tile)
+{
+	Creature* c = new Creature(type, TestCreatureData(type));
+	level->m_Players[owner]->AddCreature(owner, c);
+	c->SetPosition(tile.x * 3 + 1, 2, tile.y * 3 + 1);
+	return c;
+}
+
+void Test::RunTurns(Level* level, int turns)
+{
+	//a hair over a turn, so every frame starts one
+	const float turnDelta = 1.0f / GAME_TURNS_PER_SECOND * 1.0001f;
+	for (int i = 0; i < turns; i++)
+	{
+#ifdef _DEBUG
+		//the creatures print what they're up to
+		ImGui::NewFrame();
+#endif
+		level->UpdateSimulation(turnDelta);
+#ifdef _DEBUG
+		ImGui::EndFrame();
+#endif
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "ThempTileArrays.h"
+#include "Creature/ThempCreatureData.h"
+namespace Themp
+{
+	class LevelData;
+	class Level;
+	class Creature;
+	namespace Test
+	{
+		//An 85x85 map that touches most of the mesher without needing the level files: rock border, earth everywhere else,
+		//a claimed red dungeon in the middle with walls around it, a water pool, a lava pool, gold seams and an unclaimed corridor.
+		//Only the red dungeon is explored. The map is big, so it's handed out on the heap.
+		TileMap* CreateTestMap();
+		//a LevelData made from CreateTestMap that's gone through Init, delete it when done
+		//sets up the few LevelConfig values the map and the creatures need (block health, dig damage, instance times), there's no config file to load them from
+		LevelData* CreateTestLevel();
+		//a headless Level around CreateTestLevel with an empty task manager and no creatures yet, delete it when done (that takes the level data and the creatures with it)
+		Level* CreateTestWorld();
+		//a headless creature with made up stats for its type standing in the middle of the tile, owner has to be one of the level's players
+		Creature* AddTestCreature(Level* level, CreatureData::CreatureType type, uint8_t owner, XMINT2 tile);
+		//runs the level's simulation for the given number of game turns, a single frame each
+		void RunTurns(Level* level, int turns);
+	};
+};
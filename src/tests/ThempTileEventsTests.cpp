@@ -0,0 +1,240 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevel.h"
+#include "ThempLevelData.h"
+#include "ThempTileEvents.h"
+#include "ThempLevelScript.h"
+#include "ThempLevelConfig.h"
+#include "Creature/ThempCreature.h"
+#include "Creature/ThempCreatureTaskManager.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace Themp;
+
+namespace
+{
+	//every batch a subscriber got, with the map as it was when the batch came in
+	struct Recorder
+	{
+		std::vector<std::vector<TileChange>> batches;
+		int wrongFields = 0;
+		int stale = 0;
+		int outOfOrder = 0;
+	};
+	uint8_t Differences(const TileState& a, const TileState& b)
+	{
+		return (a.type != b.type ? TileChange::Field_Type : 0)
+			| (a.owner != b.owner ? TileChange::Field_Owner : 0)
+			| (a.walkableSubTiles != b.walkableSubTiles ? TileChange::Field_Walkable : 0)
+			| (a.visible != b.visible ? TileChange::Field_Visible : 0)
+			| (a.roomID != b.roomID ? TileChange::Field_Room : 0)
+			| (a.marked != b.marked ? TileChange::Field_Marked : 0);
+	}
+	bool SameState(const TileState& a, const TileState& b)
+	{
+		return Differences(a, b) == 0;
+	}
+	void Record(void* context, const TileChange* changes, size_t count)
+	{
+		Recorder* recorder = (Recorder*)context;
+		recorder->batches.push_back(std::vector<TileChange>(changes, changes + count));
+		for (size_t i = 0; i < count; i++)
+		{
+			const TileChange& c = changes[i];
+			recorder->wrongFields += c.fields == 0 || c.fields != Differences(c.before, c.after);
+			recorder->stale += !SameState(c.after, TileEvents::Capture(LevelData::s_Map, c.y, c.x));
+			//one entry per tile, in row order
+			recorder->outOfOrder += i > 0 && c.y * MAP_SIZE_TILES + c.x <= changes[i - 1].y * MAP_SIZE_TILES + changes[i - 1].x;
+		}
+	}
+	void SetTile(LevelData& level, int y, int x, uint16_t type, uint8_t owner)
+	{
+		LevelData::s_Map.m_Tiles[y][x].type = type;
+		LevelData::s_Map.m_Tiles[y][x].owner = owner;
+		level.QueueAreaUpdate(y - 1, y + 1, x - 1, x + 1);
+	}
+	//hits the tile the way an imp does until it comes down
+	void DigOut(LevelData& level, int y, int x)
+	{
+		for (int hits = 0; hits < 100 && !level.MineTile(y, x); hits++);
+	}
+	bool CellHasLight(int y, int x, uint16_t slot)
+	{
+		const std::vector<uint16_t>& cell = LevelData::s_LightGrid.GetCell(y, x);
+		return std::find(cell.begin(), cell.end(), slot) != cell.end();
+	}
+	std::string Describe(const Recorder& recorder)
+	{
+		std::string result;
+		char line[256];
+		for (size_t b = 0; b < recorder.batches.size(); b++)
+		{
+			snprintf(line, sizeof(line), "batch %zu: %zu changes\n", b, recorder.batches[b].size());
+			result += line;
+			for (const TileChange& c : recorder.batches[b])
+			{
+				snprintf(line, sizeof(line), "  %2i %2i fields %02X type %04X %04X owner %u %u walkable %03X %03X visible %i %i room %i %i marked %u %u\n", c.y, c.x, c.fields,
+					c.before.type, c.after.type, c.before.owner, c.after.owner, c.before.walkableSubTiles, c.after.walkableSubTiles,
+					c.before.visible, c.after.visible, c.before.roomID, c.after.roomID, c.before.marked, c.after.marked);
+				result += line;
+			}
+		}
+		return result;
+	}
+}
+
+//A scripted digging session through the same calls the imps and the player's hand make, each flush has to come out as one batch
+//holding only the tiles that really changed, the whole sequence has to match the golden one
+THEMP_TEST(TileEvents_DiggingSessionMatchesGolden)
+{
+	CreatureTaskManager::Clear();
+	LevelData* level = Test::CreateTestLevel();
+	const int money = LevelScript::GameValues[Owner_PlayerRed]["MONEY"];
+	LevelScript::GameValues[Owner_PlayerRed]["MONEY"] = 100000;
+	Recorder recorder;
+	level->m_TileEvents.Subscribe(Record, &recorder);
+	const uint32_t changesBefore = level->m_TileEvents.GetStats().changes;
+
+	//nothing changed, nothing to tell
+	level->QueueAreaUpdate(35, 39, 35, 39);
+	level->FlushAreaUpdates();
+	THEMP_CHECK(recorder.batches.size() == 0);
+
+	//dig out of the dungeon's north wall and on into the earth, a tile per flush
+	for (int y = 34; y >= 30; y--)
+	{
+		DigOut(*level, y, 42);
+		level->FlushAreaUpdates();
+	}
+	THEMP_CHECK(recorder.batches.size() == 5);
+	for (size_t b = 0; b < recorder.batches.size(); b++)
+	{
+		const std::vector<TileChange>& batch = recorder.batches[b];
+		const int dugY = 34 - (int)b;
+		THEMP_CHECK(std::count_if(batch.begin(), batch.end(), [dugY](const TileChange& c) { return c.y == dugY && c.x == 42 && (c.fields & TileChange::Field_Type) && (c.fields & TileChange::Field_Walkable); }) == 1);
+	}
+
+	//claim the whole corridor in one go, that's one batch of the five tiles
+	const size_t beforeClaim = recorder.batches.size();
+	for (int y = 34; y >= 30; y--)
+	{
+		level->ClaimTile(Owner_PlayerRed, y, 42);
+	}
+	level->FlushAreaUpdates();
+	THEMP_CHECK(recorder.batches.size() == beforeClaim + 1);
+	THEMP_CHECK(std::count_if(recorder.batches.back().begin(), recorder.batches.back().end(), [](const TileChange& c) { return c.x == 42 && c.y >= 30 && c.y <= 34 && c.after.type == Type_Claimed_Land && c.after.owner == Owner_PlayerRed; }) == 5);
+
+	//a tile marked and unmarked before the flush didn't change at all
+	const size_t beforeRevert = recorder.batches.size();
+	THEMP_CHECK(level->MarkTile(Owner_PlayerRed, 26, 26));
+	level->UnMarkTile(Owner_PlayerRed, 26, 26);
+	level->FlushAreaUpdates();
+	THEMP_CHECK(recorder.batches.size() == beforeRevert);
+
+	//a room built a tile at a time on the claimed land, all the tiles end up in the same room
+	const size_t beforeRoom = recorder.batches.size();
+	for (int y = 36; y <= 38; y++)
+	{
+		for (int x = 36; x <= 38; x++)
+		{
+			THEMP_CHECK(level->BuildRoom(Type_Treasure_Room, Owner_PlayerRed, y, x));
+		}
+	}
+	level->FlushAreaUpdates();
+	THEMP_CHECK(recorder.batches.size() == beforeRoom + 1);
+	const int32_t roomID = LevelData::s_Map.m_Tiles[36][36].roomID;
+	THEMP_CHECK(std::count_if(recorder.batches.back().begin(), recorder.batches.back().end(), [roomID](const TileChange& c) { return (c.fields & TileChange::Field_Room) && c.after.roomID == roomID; }) == 9);
+
+	//the pillar with the torch dug away from the dungeon's side and claimed
+	DigOut(*level, 42, 41);
+	DigOut(*level, 42, 42);
+	level->FlushAreaUpdates();
+	level->ClaimTile(Owner_PlayerRed, 42, 41);
+	level->ClaimTile(Owner_PlayerRed, 42, 42);
+	level->FlushAreaUpdates();
+	THEMP_CHECK(LevelData::s_Map.m_Tiles[42][42].GetType() == Type_Claimed_Land);
+	//and through into the water
+	DigOut(*level, 35, 51);
+	DigOut(*level, 36, 51);
+	level->FlushAreaUpdates();
+
+	THEMP_CHECK(recorder.wrongFields == 0);
+	THEMP_CHECK(recorder.stale == 0);
+	THEMP_CHECK(recorder.outOfOrder == 0);
+	size_t recorded = 0;
+	for (const std::vector<TileChange>& batch : recorder.batches)
+	{
+		recorded += batch.size();
+	}
+	THEMP_CHECK(level->m_TileEvents.GetStats().changes - changesBefore == recorded);
+	THEMP_CHECK(Test::MatchGolden("tile_events_dig.txt", Describe(recorder)));
+
+	level->m_TileEvents.Unsubscribe(Record, &recorder);
+	LevelScript::GameValues[Owner_PlayerRed]["MONEY"] = money;
+	CreatureTaskManager::Clear();
+	delete level;
+}
+
+//The torch in the pillar keeps a light for as long as it's there, the light subscriber takes it away when it's dug out and brings it back when it's filled in
+THEMP_TEST(TileEvents_TorchLightFollowsTheTile)
+{
+	LevelData* level = Test::CreateTestLevel();
+	const uint16_t torch = level->m_TorchLights[42][42];
+	THEMP_CHECK(torch != LevelData::NoTorchLight);
+	THEMP_CHECK(CellHasLight(42, 42, torch));
+	THEMP_CHECK(level->m_TorchLights[41][41] == LevelData::NoTorchLight);
+	const size_t lights = LevelData::s_LightGrid.GetNumLights();
+
+	//digging the earth next to it leaves it alone
+	SetTile(*level, 41, 42, Type_Claimed_Land, Owner_PlayerRed);
+	level->FlushAreaUpdates();
+	THEMP_CHECK(level->m_TorchLights[42][42] == torch);
+	THEMP_CHECK(LevelData::s_LightGrid.GetNumLights() == lights);
+
+	SetTile(*level, 42, 42, Type_Claimed_Land, Owner_PlayerRed);
+	level->FlushAreaUpdates();
+	THEMP_CHECK(level->m_TorchLights[42][42] == LevelData::NoTorchLight);
+	THEMP_CHECK(!CellHasLight(42, 42, torch));
+	THEMP_CHECK(LevelData::s_LightGrid.GetNumLights() == lights - 1);
+
+	SetTile(*level, 42, 42, Type_Earth_Torch, Owner_PlayerNone);
+	level->FlushAreaUpdates();
+	THEMP_CHECK(level->m_TorchLights[42][42] != LevelData::NoTorchLight);
+	THEMP_CHECK(CellHasLight(42, 42, level->m_TorchLights[42][42]));
+	THEMP_CHECK(LevelData::s_LightGrid.GetNumLights() == lights);
+	delete level;
+}
+
+//Digging a wall only sends the creatures walking along it looking for a new path, one walking across the other end of the dungeon keeps its path
+THEMP_TEST(TileEvents_OnlyCreaturesNearTheChangeRepath)
+{
+	Level* level = Test::CreateTestWorld();
+	Creature* north = Test::AddTestCreature(level, CreatureData::CREATURE_KNIGHT, Owner_PlayerRed, XMINT2(36, 35));
+	Creature* south = Test::AddTestCreature(level, CreatureData::CREATURE_KNIGHT, Owner_PlayerRed, XMINT2(36, 48));
+	north->PathTo(0.0f, XMINT2(48 * 3 + 1, 35 * 3 + 1));
+	south->PathTo(0.0f, XMINT2(48 * 3 + 1, 48 * 3 + 1));
+	THEMP_CHECK(north->m_Path.size() > 0 && south->m_Path.size() > 0);
+	THEMP_CHECK(!north->m_RepathPending && !south->m_RepathPending);
+
+	//the wall right next to the north one's path
+	DigOut(*level->m_LevelData, 34, 40);
+	level->m_LevelData->FlushAreaUpdates();
+	THEMP_CHECK(north->m_RepathPending);
+	THEMP_CHECK(!south->m_RepathPending);
+	const size_t southPath = south->m_Path.size();
+
+	//the next step makes the new path and lowers it, the other one walks on with what it had
+	north->PathTo(0.0f, XMINT2(48 * 3 + 1, 35 * 3 + 1));
+	south->PathTo(0.0f, XMINT2(48 * 3 + 1, 48 * 3 + 1));
+	THEMP_CHECK(!north->m_RepathPending && north->m_Path.size() > 0);
+	THEMP_CHECK(south->m_Path.size() == southPath);
+
+	//a change nowhere near either of them
+	DigOut(*level->m_LevelData, 20, 60);
+	level->m_LevelData->FlushAreaUpdates();
+	THEMP_CHECK(!north->m_RepathPending && !south->m_RepathPending);
+	delete level;
+}
@@ -0,0 +1,177 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+#include <vector>
+#include <cstring>
+
+using namespace Themp;
+
+namespace
+{
+	//every tile's model and the uvs the mesher would get for it
+	std::vector<uint8_t> TileUVBytes(const LevelData& level)
+	{
+		std::vector<uint8_t> result((const uint8_t*)level.m_TileModels, (const uint8_t*)level.m_TileModels + sizeof(level.m_TileModels));
+		for (int y = 0; y < MAP_SIZE_TILES; y++)
+		{
+			for (int x = 0; x < MAP_SIZE_TILES; x++)
+			{
+				TileUVs uvs;
+				level.GetTileUVs(y, x, uvs);
+				result.insert(result.end(), (const uint8_t*)uvs.blocks, (const uint8_t*)uvs.blocks + sizeof(uvs.blocks));
+			}
+		}
+		return result;
+	}
+	//everything UpdateArea builds for the blocks of a tile
+	struct BlockSnapshot
+	{
+		std::vector<uint8_t> blocks;
+		std::vector<uint8_t> occupancy;
+		std::vector<uint8_t> solidHeight;
+		std::vector<uint8_t> faces;
+		std::vector<uint16_t> numBlocks;
+
+		explicit BlockSnapshot(const LevelData& level)
+			: blocks(TileUVBytes(level))
+			, occupancy((const uint8_t*)level.m_BlockOccupancy, (const uint8_t*)level.m_BlockOccupancy + sizeof(level.m_BlockOccupancy))
+			, solidHeight((const uint8_t*)level.m_TileSolidHeight, (const uint8_t*)level.m_TileSolidHeight + sizeof(level.m_TileSolidHeight))
+			, faces((const uint8_t*)level.m_BlockFaces, (const uint8_t*)level.m_BlockFaces + sizeof(level.m_BlockFaces))
+		{
+			for (int y = 0; y < MAP_SIZE_TILES; y++)
+			{
+				for (int x = 0; x < MAP_SIZE_TILES; x++)
+				{
+					numBlocks.push_back(LevelData::s_Map.m_Tiles[y][x].numBlocks);
+				}
+			}
+		}
+		bool operator==(const BlockSnapshot& other) const
+		{
+			return blocks == other.blocks && occupancy == other.occupancy && solidHeight == other.solidHeight && faces == other.faces && numBlocks == other.numBlocks;
+		}
+	};
+	void ForgetRenderKeys(LevelData& level)
+	{
+		for (int y = 0; y < MAP_SIZE_TILES; y++)
+		{
+			for (int x = 0; x < MAP_SIZE_TILES; x++)
+			{
+				level.m_TileRenderKeys[y][x].valid = false;
+			}
+		}
+	}
+	//the blocks as they are have to be what building every tile again gives
+	bool MatchesFullRebuild(LevelData& level)
+	{
+		const BlockSnapshot kept(level);
+		ForgetRenderKeys(level);
+		level.UpdateArea(0, MAP_SIZE_TILES - 1, 0, MAP_SIZE_TILES - 1);
+		return BlockSnapshot(level) == kept;
+	}
+	void SetTile(LevelData& level, int y, int x, uint16_t type, uint8_t owner)
+	{
+		LevelData::s_Map.m_Tiles[y][x].type = type;
+		LevelData::s_Map.m_Tiles[y][x].owner = owner;
+		level.QueueAreaUpdate(y - 1, y + 1, x - 1, x + 1);
+		level.FlushAreaUpdates();
+	}
+}
+
+//Tiles whose render key didn't change skip their rebuild, after a session of edits the blocks still have to be what a full rebuild makes of them
+THEMP_TEST(TileRenderKeys_SkippedTilesMatchFullRebuild)
+{
+	LevelData* level = Test::CreateTestLevel();
+	THEMP_CHECK(MatchesFullRebuild(*level));
+
+	//an update where nothing changed doesn't rebuild anything
+	level->QueueAreaUpdate(35, 39, 35, 39);
+	level->FlushAreaUpdates();
+	THEMP_CHECK(level->m_AreaUpdateStats.tiles == 25);
+	THEMP_CHECK(level->m_AreaUpdateStats.rebuilt == 0);
+
+	//dig out of the north wall into the gold, every tile next to the dug one looks different now
+	for (int y = 34; y >= 30; y--)
+	{
+		SetTile(*level, y, 42, Type_Unclaimed_Path, Owner_PlayerNone);
+		THEMP_CHECK(level->m_AreaUpdateStats.rebuilt > 0);
+		THEMP_CHECK(level->m_AreaUpdateStats.rebuilt <= level->m_AreaUpdateStats.tiles);
+	}
+	THEMP_CHECK(MatchesFullRebuild(*level));
+
+	//claim it, put walls along it and a room and the pillar in the dungeon
+	for (int y = 34; y >= 30; y--)
+	{
+		SetTile(*level, y, 42, Type_Claimed_Land, Owner_PlayerRed);
+	}
+	SetTile(*level, 32, 41, Type_Wall0, Owner_PlayerRed);
+	SetTile(*level, 32, 43, Type_Wall0, Owner_PlayerRed);
+	for (int y = 36; y <= 38; y++)
+	{
+		for (int x = 36; x <= 38; x++)
+		{
+			LevelData::s_Map.m_Tiles[y][x].type = Type_Treasure_Room;
+		}
+	}
+	level->QueueAreaUpdate(35, 39, 35, 39);
+	SetTile(*level, 42, 42, Type_Claimed_Land, Owner_PlayerRed);
+	THEMP_CHECK(MatchesFullRebuild(*level));
+
+	//change the owner only, the key has it so the tile has to be built again
+	SetTile(*level, 30, 42, Type_Claimed_Land, Owner_PlayerBlue);
+	THEMP_CHECK(level->m_AreaUpdateStats.rebuilt > 0);
+	THEMP_CHECK(MatchesFullRebuild(*level));
+
+	//and filled back in
+	SetTile(*level, 31, 42, Type_Earth, Owner_PlayerNone);
+	SetTile(*level, 37, 37, Type_Claimed_Land, Owner_PlayerRed);
+	THEMP_CHECK(MatchesFullRebuild(*level));
+	delete level;
+}
+
+//Building every tile of the map against skipping the ones whose key is still good, and the same for a single dug tile
+THEMP_BENCHMARK(TileRenderKeys_FullMapAndEdits)
+{
+	LevelData* level = Test::CreateTestLevel();
+	const int iterations = 10;
+	Timer timer;
+	timer.StartTime();
+	for (int i = 0; i < iterations; i++)
+	{
+		ForgetRenderKeys(*level);
+		level->UpdateArea(0, MAP_SIZE_TILES - 1, 0, MAP_SIZE_TILES - 1);
+	}
+	const double cold = timer.GetDeltaTimeMicro() / 1000.0 / iterations;
+	timer.StartTime();
+	for (int i = 0; i < iterations; i++)
+	{
+		level->UpdateArea(0, MAP_SIZE_TILES - 1, 0, MAP_SIZE_TILES - 1);
+	}
+	const double warm = timer.GetDeltaTimeMicro() / 1000.0 / iterations;
+	char details[128];
+	snprintf(details, sizeof(details), "every tile built again, %.3f ms with the keys still good", warm);
+	Test::Report("TileRenderKeys full map", cold, details);
+
+	//dig a line of tiles in the earth north of the dungeon and fill it back in, the same edits with and without keys
+	const int edits = 200;
+	double perEdit[2] = {};
+	for (int pass = 0; pass < 2; pass++)
+	{
+		timer.StartTime();
+		for (int i = 0; i < edits; i++)
+		{
+			const int y = 22 + (i % 10);
+			const int x = 30 + i / 20;
+			if (pass == 0)
+			{
+				ForgetRenderKeys(*level);
+			}
+			SetTile(*level, y, x, i % 20 < 10 ? Type_Unclaimed_Path : Type_Earth, Owner_PlayerNone);
+		}
+		perEdit[pass] = timer.GetDeltaTimeMicro() / 1000.0 / edits;
+	}
+	snprintf(details, sizeof(details), "every queued tile built again, %.3f ms only the ones that changed", perEdit[1]);
+	Test::Report("TileRenderKeys dig or fill a tile", perEdit[0], details);
+	delete level;
+}
@@ -0,0 +1,99 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempTileArrays.h"
+#include <array>
+#include <vector>
+
+using namespace Themp;
+
+namespace
+{
+	//Tile the way it was before the subtile arrays moved out into TileDetail
+	struct FatTile
+	{
+		bool visible;
+		uint8_t owner;
+		uint16_t type;
+		uint32_t areaCode;
+		int32_t roomID;
+		uint16_t lightArrayIndex;
+		std::array<std::array<PathFindTile, SUBTILESY>, SUBTILESX> pathSubTiles;
+		std::array<std::array<Entity*, SUBTILESY>, SUBTILESX> placedEntities;
+		uint16_t numBlocks;
+		int32_t health;
+		bool marked[4];
+	};
+	//what a minimap or exploring sweep reads off every tile
+	template<typename T>
+	uint32_t Sweep(const T* tiles)
+	{
+		uint32_t result = 0;
+		for (int i = 0; i < MAP_SIZE_TILES * MAP_SIZE_TILES; i++)
+		{
+			const T& tile = tiles[i];
+			if (!tile.visible) continue;
+			result += (tile.type & 0xFF) + tile.owner * 64 + tile.marked[0] + (uint32_t)tile.areaCode;
+		}
+		return result;
+	}
+}
+
+//A pointer into m_Tiles has to find its own TileDetail, and the hot part has to stay small
+THEMP_TEST(Tile_DetailFollowsTile)
+{
+	THEMP_CHECK(sizeof(Tile) <= 24);
+	TileMap* map = Test::CreateTestMap();
+	int wrong = 0;
+	for (int y = 0; y < MAP_SIZE_TILES; y++)
+	{
+		for (int x = 0; x < MAP_SIZE_TILES; x++)
+		{
+			wrong += &map->GetDetail(&map->m_Tiles[y][x]) != &map->m_TileDetails[y][x];
+		}
+	}
+	THEMP_CHECK(wrong == 0);
+	delete map;
+}
+
+//Sweeping the whole map's hot fields, packed tiles against the old tile with its subtile arrays in it
+THEMP_BENCHMARK(Tile_FullMapSweep)
+{
+	TileMap* map = Test::CreateTestMap();
+	std::vector<FatTile> fatTiles(MAP_SIZE_TILES * MAP_SIZE_TILES);
+	for (int i = 0; i < MAP_SIZE_TILES * MAP_SIZE_TILES; i++)
+	{
+		const Tile& tile = (&map->m_Tiles[0][0])[i];
+		FatTile& fat = fatTiles[i];
+		fat.visible = tile.visible;
+		fat.owner = tile.owner;
+		fat.type = tile.type;
+		fat.areaCode = tile.areaCode;
+		fat.marked[0] = tile.marked[0];
+	}
+
+	//a sweep runs once a frame with everything else going through the cache in between, so it's timed cold
+	std::vector<uint8_t> evict(32 * 1024 * 1024);
+	const int iterations = 200;
+	uint32_t packedResult = 0, fatResult = 0;
+	double packed = 0.0, fat = 0.0;
+	Timer timer;
+	for (int i = 0; i < iterations; i++)
+	{
+		for (size_t b = 0; b < evict.size(); b += 64) evict[b]++;
+		timer.StartTime();
+		packedResult += Sweep(&map->m_Tiles[0][0]);
+		packed += timer.GetDeltaTimeMicro() / 1000.0 / iterations;
+
+		for (size_t b = 0; b < evict.size(); b += 64) evict[b]++;
+		timer.StartTime();
+		fatResult += Sweep(fatTiles.data());
+		fat += timer.GetDeltaTimeMicro() / 1000.0 / iterations;
+	}
+	THEMP_CHECK(packedResult == fatResult);
+
+	char details[128];
+	snprintf(details, sizeof(details), "%zu bytes a tile, %.4f ms with the subtile arrays in it (%zu bytes a tile)", sizeof(Tile), fat, sizeof(FatTile));
+	Test::Report("Tile full map sweep", packed, details);
+	delete map;
+}
@@ -0,0 +1,275 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTimerWheel.h"
+#include "ThempTestMaps.h"
+#include "ThempLevel.h"
+#include "ThempLevelScript.h"
+#include "Creature/ThempCreature.h"
+
+using namespace Themp;
+
+namespace
+{
+	struct FiredLog
+	{
+		std::vector<uint64_t> turns;
+		std::vector<uint32_t> codes;
+	};
+	void LogTimer(void* owner, uint32_t eventCode)
+	{
+		FiredLog* log = static_cast<FiredLog*>(owner);
+		log->turns.push_back(TimerWheel::GetCurrentTurn());
+		log->codes.push_back(eventCode);
+	}
+	void AdvanceTurns(uint64_t turns)
+	{
+		for (uint64_t i = 0; i < turns; i++)
+		{
+			TimerWheel::Advance();
+		}
+	}
+
+	const int StartHunger = 1000000;
+	//a red knight that only ever gets hungry, the hunger level never runs out so it doesn't go looking for food or start losing health
+	Creature* AddHungryKnight(Level* level, uint32_t hungerRate, XMINT2 tile)
+	{
+		Creature* c = Test::AddTestCreature(level, CreatureData::CREATURE_KNIGHT, Owner_PlayerRed, tile);
+		c->m_CreatureData.HungerRate = (uint16_t)hungerRate;
+		c->m_CurrentHungerLevel = StartHunger;
+		return c;
+	}
+};
+
+THEMP_TEST(TimerWheel_FiresOnItsTurn)
+{
+	TimerWheel::Reset();
+	FiredLog log;
+	//one per level of the wheel, plus a few on the boundaries between them
+	const uint32_t delays[] = { 1, 2, 255, 256, 257, 300, 16383, 16384, 20000, 1048576 + 5 };
+	for (uint32_t i = 0; i < sizeof(delays) / sizeof(delays[0]); i++)
+	{
+		TimerWheel::Schedule(delays[i], LogTimer, &log, i);
+	}
+	AdvanceTurns(1048576 + 10);
+	THEMP_CHECK(log.turns.size() == sizeof(delays) / sizeof(delays[0]));
+	for (size_t i = 0; i < log.turns.size(); i++)
+	{
+		THEMP_CHECK(log.turns[i] == delays[log.codes[i]]);
+	}
+	THEMP_CHECK(TimerWheel::GetActiveTimers() == 0);
+}
+
+THEMP_TEST(TimerWheel_CancelAndReschedule)
+{
+	TimerWheel::Reset();
+	FiredLog log;
+	TimerWheel::Handle a = TimerWheel::Schedule(10, LogTimer, &log, 1);
+	TimerWheel::Handle b = TimerWheel::Schedule(10, LogTimer, &log, 2);
+	THEMP_CHECK(TimerWheel::TurnsRemaining(a) == 10);
+	TimerWheel::Cancel(a);
+	THEMP_CHECK(!TimerWheel::IsPending(a));
+	TimerWheel::Reschedule(b, 500, LogTimer, &log, 3);
+	AdvanceTurns(10);
+	THEMP_CHECK(log.turns.empty());
+	THEMP_CHECK(TimerWheel::TurnsRemaining(b) == 490);
+	AdvanceTurns(490);
+	THEMP_CHECK(log.turns.size() == 1 && log.codes[0] == 3 && log.turns[0] == 500);
+	//fired handles are stale, even once their node got reused
+	TimerWheel::Handle c = TimerWheel::Schedule(5);
+	THEMP_CHECK(!TimerWheel::IsPending(b));
+	THEMP_CHECK(TimerWheel::IsPending(c));
+}
+
+//HungerRate is in hundredths of a turn, odd rates have to average out exactly instead of rounding every step up
+THEMP_TEST(Creature_HungerRateIsExact)
+{
+	Level* level = Test::CreateTestWorld();
+	const uint32_t rates[] = { 30, 100, 150, 250, 333, 1000, 1234 };
+	const int numRates = sizeof(rates) / sizeof(rates[0]);
+	std::vector<Creature*> knights;
+	for (int i = 0; i < numRates; i++)
+	{
+		knights.push_back(AddHungryKnight(level, rates[i], XMINT2(36 + i, 46)));
+	}
+	//hunger starts running on their first update and stops on the first one after they got picked up
+	Test::RunTurns(level, 1);
+	const uint64_t startTurn = TimerWheel::GetCurrentTurn();
+	Test::RunTurns(level, 4000);
+	for (int i = 0; i < numRates; i++)
+	{
+		THEMP_CHECK(knights[i]->PickUp());
+	}
+	Test::RunTurns(level, 1);
+	const uint64_t turns = TimerWheel::GetCurrentTurn() - startTurn;
+	for (int i = 0; i < numRates; i++)
+	{
+		THEMP_CHECK(!knights[i]->m_HungerRunning);
+		THEMP_CHECK(StartHunger - knights[i]->m_CurrentHungerLevel == (int)(turns * 100 / rates[i]));
+		THEMP_CHECK(knights[i]->m_HungerProgress == turns * 100 % rates[i]);
+	}
+	delete level;
+}
+
+//being picked up pauses hunger, the turns counted before that aren't lost
+THEMP_TEST(Creature_HungerPauseKeepsProgress)
+{
+	Level* level = Test::CreateTestWorld();
+	Creature* knight = AddHungryKnight(level, 250, XMINT2(45, 45));
+	THEMP_CHECK(knight->PickUp());
+	uint64_t runningTurns = 0;
+	for (int i = 0; i < 300; i++)
+	{
+		//hunger runs from the first update after the drop up to the first one after the pick up
+		knight->Drop(XMINT2(45, 45));
+		const uint64_t run = 1 + (i * 7) % 5;
+		Test::RunTurns(level, (int)run);
+		runningTurns += run;
+		THEMP_CHECK(knight->PickUp());
+		Test::RunTurns(level, 1 + (i * 3) % 4);
+	}
+	THEMP_CHECK(!knight->m_HungerRunning);
+	THEMP_CHECK(StartHunger - knight->m_CurrentHungerLevel == (int)(runningTurns * 100 / 250));
+	THEMP_CHECK(knight->m_HungerProgress == runningTurns * 100 % 250);
+	delete level;
+}
+
+//Script timers aren't counted every turn, an IF on one reads its exact value and the wheel only fires on the values the script's IFs on it flip on
+THEMP_TEST(LevelScript_TimersFireOnTheirThresholds)
+{
+	Level* level = Test::CreateTestWorld();
+	//there's no script file to load, the level deletes it with the rest
+	LevelScript* script = new LevelScript(L"NO_SCRIPT");
+	level->m_LevelScript = script;
+	const char text[] =
+		"SET_TIMER(PLAYER0,TIMER0)\n"
+		"IF(PLAYER0,TIMER0>=100)\n"
+		"	SET_FLAG(PLAYER0,FLAG0,1)\n"
+		"	IF(PLAYER0,TIMER0>250)\n"
+		"		SET_FLAG(PLAYER0,FLAG1,1)\n"
+		"	ENDIF\n"
+		"ENDIF\n";
+	FileData data = {};
+	data.data = (BYTE*)text;
+	data.size = sizeof(text) - 1;
+	script->Parse(data);
+	script->RunInitCommands();
+	std::unordered_map<std::string, int>& values = LevelScript::GameValues[Owner_PlayerRed];
+	THEMP_CHECK(values["TIMER0"] == 0 && values["FLAG0"] == 0 && values["FLAG1"] == 0);
+	THEMP_CHECK(TimerWheel::GetActiveTimers() == 1);
+
+	//without the script reading it the value only moves when the wheel fires, on 100
+	Test::RunTurns(level, 99);
+	THEMP_CHECK(values["TIMER0"] == 0);
+	Test::RunTurns(level, 1);
+	THEMP_CHECK(values["TIMER0"] == 100);
+	Test::RunTurns(level, 50);
+	THEMP_CHECK(values["TIMER0"] == 100);
+	//reading it brings it up to date
+	script->Update(0.0f);
+	THEMP_CHECK(values["TIMER0"] == 150 && values["FLAG0"] == 1 && values["FLAG1"] == 0);
+
+	int flagTurn = -1;
+	for (int t = 151; t <= 300 && flagTurn < 0; t++)
+	{
+		Test::RunTurns(level, 1);
+		script->Update(0.0f);
+		if (values["FLAG1"] == 1) flagTurn = t;
+	}
+	THEMP_CHECK(flagTurn == 251);
+	//nothing on the script watches it anymore
+	THEMP_CHECK(TimerWheel::GetActiveTimers() == 0);
+	//GAME_TURN is only brought up to date when it's read
+	THEMP_CHECK(values["GAME_TURN"] == 0);
+	LevelScript::IfStatement gameTurn;
+	gameTurn.child = nullptr;
+	gameTurn.owner = Owner_PlayerRed;
+	gameTurn.var = "GAME_TURN";
+	gameTurn.eval = LevelScript::IfStatement::Evaluator::BIGGERTHAN;
+	gameTurn.number = 0;
+	THEMP_CHECK(script->EvaluateIfStatement(&gameTurn));
+	THEMP_CHECK(values["GAME_TURN"] == (int)TimerWheel::GetCurrentTurn());
+	delete level;
+}
+
+//2000 creatures with the timers a creature keeps on the wheel (hunger, hunger tick, task search, attack cooldown),
+//against counting every one of them down every frame like before
+THEMP_BENCHMARK(TimerWheel_2000Creatures)
+{
+	const int numCreatures = 2000;
+	const int turns = 20 * 60 * 5;
+	TimerWheel::Reset();
+	//creatures on their own, hunger gets switched on and off like Creature::Update does
+	std::vector<Creature*> hunger(numCreatures);
+	std::vector<TimerWheel::Handle> taskSearch(numCreatures);
+	std::vector<TimerWheel::Handle> cooldown(numCreatures);
+	for (int i = 0; i < numCreatures; i++)
+	{
+		CreatureData data = {};
+		data.Health = 100;
+		data.HungerRate = (uint16_t)(150 + (i % 7) * 100);
+		hunger[i] = new Creature(CreatureData::CREATURE_KNIGHT, data);
+		hunger[i]->m_CurrentHungerLevel = StartHunger;
+		hunger[i]->SetHungerRunning(true);
+	}
+	srand(1);
+	Timer timer;
+	timer.StartTime();
+	for (int turn = 0; turn < turns; turn++)
+	{
+		for (int i = turn % 16; i < numCreatures; i += 16)
+		{
+			//a creature looks for work every 1 to 2 seconds and some get into fights
+			if (!TimerWheel::IsPending(taskSearch[i]))
+			{
+				TimerWheel::Reschedule(taskSearch[i], 20 + rand() % 20);
+			}
+			if (rand() % 8 == 0)
+			{
+				hunger[i]->SetHungerRunning(!hunger[i]->m_HungerRunning);
+				if (!TimerWheel::IsPending(cooldown[i]))
+				{
+					cooldown[i] = TimerWheel::Schedule(10 + rand() % 30);
+				}
+			}
+		}
+		TimerWheel::Advance();
+	}
+	const double wheelTime = timer.GetDeltaTimeMicro() / 1000.0;
+	for (int i = 0; i < numCreatures; i++)
+	{
+		delete hunger[i];
+	}
+
+	//the old way, 3 countdowns per creature every frame at 60 frames per second
+	std::vector<float> hungerTimers(numCreatures, 0.0f), tickTimers(numCreatures, 0.0f), searchTimers(numCreatures, 1.0f);
+	uint32_t steps = 0;
+	const float delta = 1.0f / 60.0f;
+	timer.StartTime();
+	for (int frame = 0; frame < turns * 3; frame++)
+	{
+		for (int i = 0; i < numCreatures; i++)
+		{
+			const float interval = GAME_TURNS_TO_SECOND((150 + (i % 7) * 100) / 100.0f);
+			hungerTimers[i] += delta;
+			if (hungerTimers[i] > interval)
+			{
+				hungerTimers[i] -= interval;
+				tickTimers[i] = 0;
+				steps++;
+			}
+			searchTimers[i] -= delta;
+			if (searchTimers[i] <= 0.0f)
+			{
+				searchTimers[i] = 1.0f + (float)(rand() % 10) / 10.0f;
+			}
+		}
+	}
+	const double pollTime = timer.GetDeltaTimeMicro() / 1000.0;
+
+	char details[128];
+	sprintf(details, "(%i turns, %u fired)", turns, TimerWheel::GetTotalStats().fired);
+	Test::Report("timer wheel", wheelTime, details);
+	sprintf(details, "(%i frames, %u hunger steps)", turns * 3, steps);
+	Test::Report("per frame countdowns", pollTime, details);
+	TimerWheel::Reset();
+}
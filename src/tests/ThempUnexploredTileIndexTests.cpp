@@ -0,0 +1,280 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempUnexploredTileIndex.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+#include "ThempFunctions.h"
+#include <vector>
+#include <cstdlib>
+
+using namespace Themp;
+
+namespace
+{
+	//what GetExploreActivity does: skip (and collect) the tiles that got explored in the mean time, take the rest
+	struct Search
+	{
+		const bool* explored;
+		const uint8_t* areas;
+		uint8_t area;
+		std::vector<XMINT2> stale;
+		int outsideArea;
+	};
+	bool IsUnexplored(void* context, int y, int x)
+	{
+		Search* search = static_cast<Search*>(context);
+		search->outsideArea += (search->areas[y * MAP_SIZE_TILES + x] & search->area) == 0;
+		if (search->explored[y * MAP_SIZE_TILES + x])
+		{
+			search->stale.push_back(XMINT2(x, y));
+			return false;
+		}
+		return true;
+	}
+	bool TakeNothing(void* context, int y, int x)
+	{
+		(*static_cast<int*>(context))++;
+		return false;
+	}
+
+	//what GetExploreActivity asks on the real map, minus the stale tiles
+	struct Reach
+	{
+		LevelData* level;
+		int areaCode;
+	};
+	bool IsReachable(void* context, int y, int x)
+	{
+		Reach* reach = static_cast<Reach*>(context);
+		return !LevelData::s_Map.m_Tiles[y][x].visible && reach->level->HasWalkableNeighbour(y, x, reach->areaCode);
+	}
+	//what the unordered_map did, every unexplored tile on the map goes past the predicate
+	int NearestByWalkingTheMap(LevelData* level, XMINT2 from, int areaCode)
+	{
+		Reach reach = { level, areaCode };
+		int bestDistance = INT32_MAX;
+		for (int y = 0; y < MAP_SIZE_TILES; y++)
+		{
+			for (int x = 0; x < MAP_SIZE_TILES; x++)
+			{
+				if (!level->m_UnexploredTiles.Contains(y, x)) continue;
+				const int distance = (y - from.y) * (y - from.y) + (x - from.x) * (x - from.x);
+				if (distance < bestDistance && IsReachable(&reach, y, x)) bestDistance = distance;
+			}
+		}
+		return bestDistance;
+	}
+	int NearestInArea(LevelData* level, XMINT2 from, int areaCode)
+	{
+		Reach reach = { level, areaCode };
+		XMINT2 found;
+		if (!level->m_UnexploredTiles.FindNearest((uint32_t)areaCode, from, IsReachable, &reach, found)) return INT32_MAX;
+		return (found.y - from.y) * (found.y - from.y) + (found.x - from.x) * (found.x - from.x);
+	}
+	//the frontier every explored open tile of the map gives, the game builds it up the same way while creatures look around
+	void SeedFrontier(LevelData* level)
+	{
+		for (int y = 1; y < MAP_SIZE_TILES - 1; y++)
+		{
+			for (int x = 1; x < MAP_SIZE_TILES - 1; x++)
+			{
+				const Tile& tile = LevelData::s_Map.m_Tiles[y][x];
+				if (tile.visible && IsWalkable(tile.GetType()) && tile.areaCode != 0)
+				{
+					level->AddExploredTileNeighboursVisibility(y, x, tile.areaCode);
+				}
+			}
+		}
+	}
+	//what an imp does with a tile it dug out, everything around it that nobody saw yet goes on the frontier
+	void DigOut(LevelData* level, int y, int x)
+	{
+		for (int hits = 0; hits < 100 && !level->MineTile(y, x); hits++);
+		level->FlushAreaUpdates();
+		LevelData::s_Map.m_Tiles[y][x].visible = true;
+		for (int i = 0; i < 4; i++)
+		{
+			const XMINT2 n = XMINT2(x, y) + AxiiDirections[i];
+			if (!LevelData::s_Map.m_Tiles[n.y][n.x].visible)
+			{
+				level->AddUnexploredTile(n);
+			}
+		}
+	}
+}
+
+THEMP_TEST(UnexploredTileIndex_FindNearestMatchesBruteForce)
+{
+	srand(5);
+	static bool explored[MAP_SIZE_TILES * MAP_SIZE_TILES];
+	//a bit per area the tile is listed under, tiles on the edge of two areas show up in both
+	static uint8_t areas[MAP_SIZE_TILES * MAP_SIZE_TILES];
+	for (int round = 0; round < 50; round++)
+	{
+		UnexploredTileIndex index;
+		std::vector<XMINT2> tiles;
+		const int count = 1 + rand() % 200;
+		for (int i = 0; i < count; i++)
+		{
+			const XMINT2 p(rand() % MAP_SIZE_TILES, rand() % MAP_SIZE_TILES);
+			if (index.Contains(p.y, p.x)) continue;
+			index.Add(p);
+			tiles.push_back(p);
+			explored[p.y * MAP_SIZE_TILES + p.x] = rand() % 3 == 0;
+			uint8_t& tileAreas = areas[p.y * MAP_SIZE_TILES + p.x];
+			tileAreas = (uint8_t)(1 + rand() % 7);
+			for (uint32_t area = 1; area <= 4; area *= 2)
+			{
+				if (tileAreas & area)
+				{
+					//a second listing happens when two neighbours of the tile go into the same area, the search has to see through it
+					index.AddToArea(area, p.y, p.x);
+					if (rand() % 4 == 0) index.AddToArea(area, p.y, p.x);
+				}
+			}
+		}
+		THEMP_CHECK(index.Size() == tiles.size());
+		//areas 2 and 4 got joined in half the rounds
+		const bool merged = round % 2 == 1;
+		if (merged)
+		{
+			index.MergeAreas(4, 2);
+			THEMP_CHECK(index.AreaSize(4) == 0);
+		}
+		const uint8_t area = (uint8_t)(1 << (rand() % 3));
+		const uint8_t areaMask = merged && area != 1 ? 6 : area;
+		const uint32_t searchArea = merged && area == 4 ? 2 : area;
+
+		const XMINT2 from(rand() % MAP_SIZE_TILES, rand() % MAP_SIZE_TILES);
+		int bestDistance = INT32_MAX;
+		for (const XMINT2& p : tiles)
+		{
+			const int distance = (p.y - from.y) * (p.y - from.y) + (p.x - from.x) * (p.x - from.x);
+			if (!explored[p.y * MAP_SIZE_TILES + p.x] && (areas[p.y * MAP_SIZE_TILES + p.x] & areaMask) && distance < bestDistance) bestDistance = distance;
+		}
+
+		Search search = { explored, areas, areaMask };
+		XMINT2 found;
+		const bool any = index.FindNearest(searchArea, from, IsUnexplored, &search, found);
+		THEMP_CHECK(any == (bestDistance != INT32_MAX));
+		if (any)
+		{
+			THEMP_CHECK((found.y - from.y) * (found.y - from.y) + (found.x - from.x) * (found.x - from.x) == bestDistance);
+		}
+		//the predicate never hears about the tiles of the other areas
+		THEMP_CHECK(search.outsideArea == 0);
+
+		//the stale tiles come out after the search, the index stays consistent
+		size_t removed = 0;
+		for (const XMINT2& p : search.stale)
+		{
+			THEMP_CHECK(explored[p.y * MAP_SIZE_TILES + p.x]);
+			removed += index.Contains(p.y, p.x);
+			index.Remove(p.y, p.x);
+		}
+		THEMP_CHECK(index.Size() == tiles.size() - removed);
+		std::vector<XMINT2> left;
+		index.GetInRange(XMINT2(MAP_SIZE_TILES / 2, MAP_SIZE_TILES / 2), MAP_SIZE_TILES, left);
+		THEMP_CHECK(left.size() == index.Size());
+		//a search that takes nothing goes past every tile of the area that's left exactly once, and the list is down to those
+		int calls = 0;
+		THEMP_CHECK(!index.FindNearest(searchArea, from, TakeNothing, &calls, found));
+		size_t remaining = 0;
+		for (const XMINT2& p : tiles)
+		{
+			remaining += index.Contains(p.y, p.x) && (areas[p.y * MAP_SIZE_TILES + p.x] & areaMask) != 0;
+		}
+		THEMP_CHECK(calls == (int)remaining);
+		THEMP_CHECK(index.AreaSize(searchArea) == remaining);
+		for (const XMINT2& p : tiles)
+		{
+			explored[p.y * MAP_SIZE_TILES + p.x] = false;
+		}
+	}
+}
+
+//The frontier lists follow the map: a pocket dug into the earth starts an area of its own, a second one next to it another,
+//and digging out the tile in between joins them with everything on their edges
+THEMP_TEST(UnexploredTileIndex_FrontierFollowsAreas)
+{
+	LevelData* level = Test::CreateTestLevel();
+	SeedFrontier(level);
+	const int dungeonArea = LevelData::s_Map.m_Tiles[40][40].areaCode;
+	THEMP_CHECK(level->m_UnexploredTiles.AreaSize(dungeonArea) > 0);
+	const XMINT2 spots[] = { XMINT2(40, 40), XMINT2(36, 48), XMINT2(55, 42), XMINT2(48, 36) };
+	for (const XMINT2& from : spots)
+	{
+		THEMP_CHECK(NearestInArea(level, from, dungeonArea) == NearestByWalkingTheMap(level, from, dungeonArea));
+	}
+
+	DigOut(level, 25, 25);
+	DigOut(level, 25, 27);
+	const int left = LevelData::s_Map.m_Tiles[25][25].areaCode;
+	const int right = LevelData::s_Map.m_Tiles[25][27].areaCode;
+	THEMP_CHECK(left != 0 && right != 0 && left != right && left != dungeonArea);
+	//nothing in the dungeon leads out there, and the left pocket's closest tile to the right is the one in between the two
+	THEMP_CHECK(NearestInArea(level, XMINT2(36, 36), dungeonArea) == NearestByWalkingTheMap(level, XMINT2(36, 36), dungeonArea));
+	THEMP_CHECK(NearestInArea(level, XMINT2(25, 25), left) == 1);
+	THEMP_CHECK(NearestInArea(level, XMINT2(30, 25), left) == NearestByWalkingTheMap(level, XMINT2(30, 25), left));
+	THEMP_CHECK(NearestInArea(level, XMINT2(30, 25), left) == 4 * 4);
+
+	DigOut(level, 25, 26);
+	const int joined = LevelData::s_Map.m_Tiles[25][26].areaCode;
+	THEMP_CHECK(LevelData::s_Map.m_Tiles[25][25].areaCode == joined && LevelData::s_Map.m_Tiles[25][27].areaCode == joined);
+	const uint32_t gone = joined == left ? right : left;
+	THEMP_CHECK(level->m_UnexploredTiles.AreaSize(gone) == 0);
+	//the tile right of the second pocket is on the edge of the joined area now
+	THEMP_CHECK(NearestInArea(level, XMINT2(30, 25), joined) == 2 * 2);
+	for (int x = 20; x < 32; x += 3)
+	{
+		THEMP_CHECK(NearestInArea(level, XMINT2(x, 22), joined) == NearestByWalkingTheMap(level, XMINT2(x, 22), joined));
+	}
+	delete level;
+}
+
+//An early game map: only the red dungeon and the enemy's cave have been seen, 9 out of 10 tiles are still unexplored.
+//Imps all over the dungeon look for the closest tile to explore, going over their own area's frontier list
+//against walking the map for every unexplored tile like the unordered_map did
+THEMP_BENCHMARK(UnexploredTileIndex_EarlyGameNearest)
+{
+	LevelData* level = Test::CreateTestLevel();
+	for (int y = 10; y <= 20; y++)
+	{
+		for (int x = 10; x <= 22; x++)
+		{
+			LevelData::s_Map.m_Tiles[y][x].visible = true;
+		}
+	}
+	SeedFrontier(level);
+	int visible = 0;
+	for (int i = 0; i < MAP_SIZE_TILES * MAP_SIZE_TILES; i++) visible += LevelData::s_Map.m_Tiles[i / MAP_SIZE_TILES][i % MAP_SIZE_TILES].visible;
+	THEMP_CHECK(visible * 10 < MAP_SIZE_TILES * MAP_SIZE_TILES);
+
+	const int dungeonArea = LevelData::s_Map.m_Tiles[40][40].areaCode;
+	srand(9);
+	std::vector<XMINT2> from(1000);
+	for (size_t i = 0; i < from.size(); i++) level->GetRandomWalkableTile(dungeonArea, from[i]);
+
+	const int rounds = 20;
+	double time[2] = {};
+	int64_t distance[2] = {};
+	for (int pass = 0; pass < 2; pass++)
+	{
+		Timer timer;
+		timer.StartTime();
+		for (int r = 0; r < rounds; r++)
+		{
+			for (size_t i = 0; i < from.size(); i++)
+			{
+				distance[pass] += pass == 0 ? NearestInArea(level, from[i], dungeonArea) : NearestByWalkingTheMap(level, from[i], dungeonArea);
+			}
+		}
+		time[pass] = timer.GetDeltaTimeMicro() / (double)(rounds * from.size());
+	}
+	THEMP_CHECK(distance[0] == distance[1]);
+	char details[192];
+	snprintf(details, sizeof(details), "%.3f us a search over %zu frontier tiles of the dungeon (%zu on the map), walking the map took %.3f us",
+		time[0], level->m_UnexploredTiles.AreaSize(dungeonArea), level->m_UnexploredTiles.Size(), time[1]);
+	Test::Report("UnexploredTileIndex early game nearest", time[0] / 1000.0, details);
+	delete level;
+}
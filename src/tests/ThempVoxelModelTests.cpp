@@ -0,0 +1,93 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTileArrays.h"
+#include "ThempVoxelModels.h"
+#include <vector>
+#include <cstring>
+
+using namespace Themp;
+
+namespace
+{
+	//the models straight from the Block initializers, the way RenderTileMap used to hold them
+	const RenderTile OriginalModels[] =
+	{
+		#include "Rock.h" //0
+		#include "FullBlock.h" //1
+		#include "GroundBlock.h" //2
+		#include "LiquidBlock.h" //3
+		#include "DungeonHeart.h"//4 - 13
+		#include "Portal.h" //14 - 23
+		#include "Library.h"//24 - 33
+		#include "Barracks.h"//34 - 43
+		#include "RoomWithPillars.h"//44 - 53
+	};
+	const int NumOriginalModels = sizeof(OriginalModels) / sizeof(OriginalModels[0]);
+
+	bool SameBlock(const Block& a, const Block& b)
+	{
+		return a.active == b.active && memcmp(a.uv, b.uv, sizeof(a.uv)) == 0;
+	}
+	bool SamePathTile(const PathFindTile& a, const PathFindTile& b)
+	{
+		return a.cost == b.cost && a.height == b.height && a.walkable == b.walkable;
+	}
+}
+
+//Every model expanded from the compact tables has to be the same, block for block and path tile for path tile, as its initializer
+THEMP_TEST(VoxelModels_ExpandMatchesOriginals)
+{
+	THEMP_CHECK(VoxelModels::NumModels == NumOriginalModels);
+	int wrongBlocks = 0, wrongPathTiles = 0, wrongCounts = 0;
+	for (int model = 0; model < NumOriginalModels; model++)
+	{
+		const RenderTile& original = OriginalModels[model];
+		RenderTile expanded;
+		const uint16_t activeBlocks = VoxelModels::Expand(model, expanded);
+		wrongCounts += activeBlocks != original.activeBlocks || VoxelModels::GetActiveBlocks(model) != original.activeBlocks;
+		for (int y = 0; y < SUBTILESY; y++)
+		{
+			for (int x = 0; x < SUBTILESX; x++)
+			{
+				for (int z = 0; z < SUBTILESZ; z++)
+				{
+					wrongBlocks += !SameBlock(expanded.subTile[y][x][z], original.subTile[y][x][z]);
+					wrongBlocks += !SameBlock(VoxelModels::GetBlock(model, y, x, z), original.subTile[y][x][z]);
+				}
+				wrongPathTiles += !SamePathTile(expanded.pathSubTiles[y][x], original.pathSubTiles[y][x]);
+				wrongPathTiles += !SamePathTile(VoxelModels::GetPathTile(model, y, x), original.pathSubTiles[y][x]);
+			}
+		}
+	}
+	THEMP_CHECK(wrongBlocks == 0);
+	THEMP_CHECK(wrongPathTiles == 0);
+	THEMP_CHECK(wrongCounts == 0);
+}
+
+//What CreateFromTile pays per tile, expanding a model against copying a whole RenderTile like it used to
+THEMP_BENCHMARK(VoxelModels_ExpandPerTile)
+{
+	const int iterations = 100000;
+	std::vector<RenderTile> tiles(NumOriginalModels);
+	uint32_t activeBlocks = 0;
+	Timer timer;
+	timer.StartTime();
+	for (int i = 0; i < iterations; i++)
+	{
+		activeBlocks += VoxelModels::Expand(i % NumOriginalModels, tiles[i % NumOriginalModels]);
+	}
+	const double expand = timer.GetDeltaTimeMicro() / (double)iterations;
+	timer.StartTime();
+	for (int i = 0; i < iterations; i++)
+	{
+		memcpy(&tiles[i % NumOriginalModels], &OriginalModels[i % NumOriginalModels], sizeof(RenderTile));
+		activeBlocks -= tiles[i % NumOriginalModels].activeBlocks;
+	}
+	const double copy = timer.GetDeltaTimeMicro() / (double)iterations;
+	THEMP_CHECK(activeBlocks == 0);
+	THEMP_CHECK(memcmp(tiles.data(), OriginalModels, sizeof(OriginalModels)) == 0);
+
+	char details[160];
+	snprintf(details, sizeof(details), "%.3f us per tile, copying a %zu byte RenderTile took %.3f us", expand, sizeof(RenderTile), copy);
+	Test::Report("VoxelModels expand a tile", expand / 1000.0, details);
+}
@@ -0,0 +1,135 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+#include "ThempVoxelObject.h"
+#include "ThempVoxelVertexPacking.h"
+#include "../Engine/ThempD3D.h"
+#include "../Engine/ThempMesh.h"
+#include <DirectXMath.h>
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+using namespace Themp;
+using namespace DirectX;
+
+namespace
+{
+	void CollectVertices(void* context, const VoxelVertex* vertices, uint32_t numVertices, const uint32_t* indices, uint32_t numIndices)
+	{
+		std::vector<VoxelVertex>* out = (std::vector<VoxelVertex>*)context;
+		out->assign(vertices, vertices + numVertices);
+	}
+	//the whole test map from above, single block faces and merged ones, full detail and coarse chunks
+	std::vector<VoxelVertex> MeshTestMap(LevelData* level, bool greedy, bool coarseLod)
+	{
+		const bool oldGreedy = VoxelObject::s_GreedyMeshing;
+		const bool oldCoarseLod = VoxelObject::s_CoarseLod;
+		VoxelObject::s_GreedyMeshing = greedy;
+		VoxelObject::s_CoarseLod = coarseLod;
+
+		const float mapCenter = MAP_SIZE_SUBTILES_RENDER * 0.5f;
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, XMMatrixLookToLH(XMVectorSet(mapCenter, 50.0f, mapCenter, 1), XMVectorSet(0, -1, 0, 0), XMVectorSet(0, 0, 1, 0))
+			* XMMatrixOrthographicLH((float)MAP_SIZE_SUBTILES_RENDER, (float)MAP_SIZE_SUBTILES_RENDER, 0.1f, 1000.0f));
+		std::vector<VoxelVertex> vertices;
+		{
+			VoxelObject mesher(level, CollectVertices, &vertices);
+			mesher.ConstructFromLevel(viewProjection);
+		}
+		VoxelObject::s_GreedyMeshing = oldGreedy;
+		VoxelObject::s_CoarseLod = oldCoarseLod;
+		return vertices;
+	}
+	//Positions, normals and flags have to come back exactly. The mesher adds its uvs up in floats, so those are only on the half texel grid up to float rounding,
+	//they have to come back that close and packing them again has to give the same packed vertex.
+	bool RoundTrips(const VoxelVertex& in)
+	{
+		PackedVoxelVertex packed, repacked;
+		VoxelVertex out;
+		VoxelVertexPacking::Pack(in, packed);
+		VoxelVertexPacking::Unpack(packed, out);
+		VoxelVertexPacking::Pack(out, repacked);
+		return in.x == out.x && in.y == out.y && in.z == out.z && in.nx == out.nx && in.ny == out.ny && in.nz == out.nz
+			&& fabs(in.u - out.u) < 0.000001f && fabs(in.v - out.v) < 0.000001f && in.visible == out.visible && in.doAnimate == out.doAnimate
+			&& memcmp(&packed, &repacked, sizeof(PackedVoxelVertex)) == 0;
+	}
+}
+
+//Everything the mesher puts out has to survive packing, with all four mesher settings
+THEMP_TEST(VoxelVertexPacking_MeshRoundTrips)
+{
+	LevelData* level = Test::CreateTestLevel();
+	for (int settings = 0; settings < 4; settings++)
+	{
+		const std::vector<VoxelVertex> vertices = MeshTestMap(level, (settings & 1) != 0, (settings & 2) != 0);
+		THEMP_CHECK(vertices.size() > 0);
+		size_t mismatches = 0;
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			mismatches += !RoundTrips(vertices[i]);
+		}
+		THEMP_CHECK(mismatches == 0);
+	}
+	delete level;
+}
+
+//The corners of the range: the -0.5 edges on the map border, the top of the map, the first and last half texel of the atlas and every flag
+THEMP_TEST(VoxelVertexPacking_EdgesRoundTrip)
+{
+	const float maxPosition = MAP_SIZE_SUBTILES_RENDER + 0.5f;
+	const float positions[] = { -0.5f, 0.0f, 0.5f, 1.0f / 16.0f, 7.25f, (float)MAP_SIZE_HEIGHT + 0.5f, maxPosition };
+	const float us[] = { 0.0f, 1.0f / 512.0f, 0.125f, 511.0f / 512.0f, 1.0f };
+	const float vs[] = { 0.0f, 1.0f / 4352.0f, 1.0f / 68.0f, 4351.0f / 4352.0f, 1.0f };
+	size_t mismatches = 0;
+	for (float p : positions)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			for (int i = 0; i < 5; i++)
+			{
+				for (uint32_t flags = 0; flags < 32; flags++)
+				{
+					VoxelVertex in;
+					in.x = p;
+					in.y = positions[(i + axis) % 7];
+					in.z = -p + maxPosition - 0.5f;
+					in.nx = axis == 0 ? 1.0f : 0.0f;
+					in.ny = axis == 1 ? 1.0f : 0.0f;
+					in.nz = axis == 2 ? 1.0f : 0.0f;
+					in.u = us[i];
+					in.v = vs[4 - i];
+					in.visible = (flags & 16) ? 0.0f : 1.0f;
+					in.doAnimate = flags & 15;
+					mismatches += !RoundTrips(in);
+				}
+			}
+		}
+	}
+	THEMP_CHECK(mismatches == 0);
+}
+
+//What a full map mesh upload costs before and after packing, and how long the packing itself takes
+THEMP_BENCHMARK(VoxelVertexPacking_Upload)
+{
+	LevelData* level = Test::CreateTestLevel();
+	const std::vector<VoxelVertex> vertices = MeshTestMap(level, false, false);
+	std::vector<PackedVoxelVertex> packed(vertices.size());
+	const int iterations = 100;
+	Timer timer;
+	timer.StartTime();
+	for (int i = 0; i < iterations; i++)
+	{
+		VoxelVertexPacking::Pack(vertices.data(), packed.data(), vertices.size());
+	}
+	const double packTime = timer.GetDeltaTimeMicro() / 1000.0 / iterations;
+
+	const double unpackedKB = sizeof(VoxelVertex) * vertices.size() / 1024.0;
+	const double packedKB = sizeof(PackedVoxelVertex) * vertices.size() / 1024.0;
+	char details[256];
+	snprintf(details, sizeof(details), "%zu vertices, %.0f KB as VoxelVertex, %.0f KB packed (%.1fx less), %.0f MB/s packed",
+		vertices.size(), unpackedKB, packedKB, unpackedKB / packedKB, packedKB / 1024.0 / (packTime / 1000.0));
+	Test::Report("VoxelVertexPacking pack test map mesh", packTime, details);
+	delete level;
+}
@@ -0,0 +1,187 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempTestMaps.h"
+#include "ThempLevelData.h"
+#include <vector>
+#include <cstdlib>
+
+using namespace Themp;
+
+namespace
+{
+	//every list has to hold exactly the walkable tiles of its area, and every tile has to know where it's listed
+	int WrongListings(const LevelData& level)
+	{
+		int wrong = 0;
+		size_t listed = 0;
+		for (const auto& it : level.m_AreaWalkableTiles)
+		{
+			for (size_t i = 0; i < it.second.size(); i++)
+			{
+				const XMINT2& p = it.second[i];
+				wrong += level.m_WalkableTileArea[p.y][p.x] != it.first || level.m_WalkableTileIndex[p.y][p.x] != (int32_t)i;
+			}
+			listed += it.second.size();
+		}
+		size_t walkable = 0;
+		for (int y = 0; y < MAP_SIZE_TILES; y++)
+		{
+			for (int x = 0; x < MAP_SIZE_TILES; x++)
+			{
+				const Tile& tile = LevelData::s_Map.m_Tiles[y][x];
+				const uint32_t area = IsWalkable(tile.GetType()) ? tile.areaCode : 0;
+				wrong += level.m_WalkableTileArea[y][x] != area;
+				walkable += area != 0;
+			}
+		}
+		return wrong + (listed != walkable);
+	}
+	//a tile that opens up joins the areas around it like MineTile does it, closing one is up to the area update
+	void SetTile(LevelData& level, int y, int x, uint16_t type, uint8_t owner)
+	{
+		const bool opens = !IsWalkable(LevelData::s_Map.m_Tiles[y][x].GetType()) && IsWalkable(type);
+		LevelData::s_Map.m_Tiles[y][x].type = type;
+		LevelData::s_Map.m_Tiles[y][x].owner = owner;
+		if (opens)
+		{
+			level.OpenTile(y, x);
+		}
+		level.QueueAreaUpdate(y - 1, y + 1, x - 1, x + 1);
+		level.FlushAreaUpdates();
+	}
+	//what wandering did before the lists: gather the walkable tiles around the creature and pick one
+	bool ScanWalkableTileInRange(int areaCode, XMINT2 center, int range, XMINT2& outTile)
+	{
+		std::vector<XMINT2> walkableTiles;
+		walkableTiles.reserve(4 * 4);
+		const int minY = center.y - range >= range ? center.y - range : range;
+		const int minX = center.x - range >= range ? center.x - range : range;
+		const int maxY = center.y + range < MAP_SIZE_TILES ? center.y + range : MAP_SIZE_TILES - range - 1;
+		const int maxX = center.x + range < MAP_SIZE_TILES ? center.x + range : MAP_SIZE_TILES - range - 1;
+		for (int y = minY; y < maxY; y++)
+		{
+			for (int x = minX; x < maxX; x++)
+			{
+				const Tile& t = LevelData::s_Map.m_Tiles[y][x];
+				if (IsWalkable(t.GetType()) && t.areaCode == areaCode)
+				{
+					walkableTiles.push_back(XMINT2(x, y));
+				}
+			}
+		}
+		if (walkableTiles.size() == 0) return false;
+		outTile = walkableTiles[rand() % walkableTiles.size()];
+		return true;
+	}
+}
+
+//The lists have to follow digging, claiming, filling in and an area getting cut in two
+THEMP_TEST(WalkableTiles_ListsFollowTheMap)
+{
+	LevelData* level = Test::CreateTestLevel();
+	THEMP_CHECK(WrongListings(*level) == 0);
+	const uint32_t dungeon = LevelData::s_Map.m_Tiles[40][40].areaCode;
+	const size_t dungeonTiles = level->m_AreaWalkableTiles[dungeon].size();
+
+	//dig out of the north wall into the earth, the dungeon just grows
+	for (int y = 34; y >= 30; y--)
+	{
+		SetTile(*level, y, 42, Type_Unclaimed_Path, Owner_PlayerNone);
+		THEMP_CHECK(WrongListings(*level) == 0);
+	}
+	THEMP_CHECK(level->m_AreaWalkableTiles[dungeon].size() == dungeonTiles + 5);
+
+	//claim it and dig the pillar away
+	SetTile(*level, 33, 42, Type_Claimed_Land, Owner_PlayerRed);
+	SetTile(*level, 42, 42, Type_Claimed_Land, Owner_PlayerRed);
+	THEMP_CHECK(WrongListings(*level) == 0);
+
+	//fill the corridor back in halfway, the end of it is an area of its own now
+	SetTile(*level, 32, 42, Type_Earth, Owner_PlayerNone);
+	THEMP_CHECK(WrongListings(*level) == 0);
+	THEMP_CHECK(LevelData::s_Map.m_Tiles[30][42].areaCode != dungeon);
+	THEMP_CHECK(level->m_AreaWalkableTiles[LevelData::s_Map.m_Tiles[30][42].areaCode].size() == 2);
+	delete level;
+}
+
+//Random tiles in range come out of the area's list, inside the window and every walkable tile in there about as often as the others
+THEMP_TEST(WalkableTiles_InRangeIsUniform)
+{
+	LevelData* level = Test::CreateTestLevel();
+	const int areaCode = LevelData::s_Map.m_Tiles[40][40].areaCode;
+	const XMINT2 center(42, 38);
+	const int range = 4;
+	int counts[MAP_SIZE_TILES][MAP_SIZE_TILES] = {};
+	int outside = 0;
+	const int picks = 40000;
+	srand(3);
+	for (int i = 0; i < picks; i++)
+	{
+		XMINT2 p;
+		THEMP_CHECK(level->GetRandomWalkableTileInRange(areaCode, center, range, p));
+		outside += p.y < center.y - range || p.y >= center.y + range || p.x < center.x - range || p.x >= center.x + range
+			|| level->m_WalkableTileArea[p.y][p.x] != (uint32_t)areaCode;
+		counts[p.y][p.x]++;
+	}
+	THEMP_CHECK(outside == 0);
+
+	int walkable = 0;
+	for (int y = center.y - range; y < center.y + range; y++)
+	{
+		for (int x = center.x - range; x < center.x + range; x++)
+		{
+			walkable += level->m_WalkableTileArea[y][x] == (uint32_t)areaCode;
+		}
+	}
+	THEMP_CHECK(walkable > 0);
+	const float expected = picks / (float)walkable;
+	int uneven = 0;
+	for (int y = center.y - range; y < center.y + range; y++)
+	{
+		for (int x = center.x - range; x < center.x + range; x++)
+		{
+			if (level->m_WalkableTileArea[y][x] != (uint32_t)areaCode) continue;
+			uneven += counts[y][x] < expected * 0.8f || counts[y][x] > expected * 1.2f;
+		}
+	}
+	THEMP_CHECK(uneven == 0);
+
+	//an area with nothing in the window
+	XMINT2 p;
+	THEMP_CHECK(!level->GetRandomWalkableTileInRange(areaCode, XMINT2(10, 75), range, p));
+	delete level;
+}
+
+//40 creatures wandering around the dungeon, a pick each from the area's list against scanning the window around them
+THEMP_BENCHMARK(WalkableTiles_40CreaturesWandering)
+{
+	LevelData* level = Test::CreateTestLevel();
+	const int areaCode = LevelData::s_Map.m_Tiles[40][40].areaCode;
+	XMINT2 creatures[40];
+	srand(4);
+	for (int i = 0; i < 40; i++)
+	{
+		level->GetRandomWalkableTile(areaCode, creatures[i]);
+	}
+	const int rounds = 2500;
+	double time[2] = {};
+	for (int pass = 0; pass < 2; pass++)
+	{
+		Timer timer;
+		timer.StartTime();
+		for (int r = 0; r < rounds; r++)
+		{
+			for (int i = 0; i < 40; i++)
+			{
+				XMINT2 p;
+				const bool found = pass == 0 ? level->GetRandomWalkableTileInRange(areaCode, creatures[i], 4, p) : ScanWalkableTileInRange(areaCode, creatures[i], 4, p);
+				if (found) creatures[i] = p;
+			}
+		}
+		time[pass] = timer.GetDeltaTimeMicro() / (double)(rounds * 40);
+	}
+	char details[128];
+	snprintf(details, sizeof(details), "%.3f us a pick, scanning the window took %.3f us", time[0], time[1]);
+	Test::Report("WalkableTiles wander pick", time[0] / 1000.0, details);
+	delete level;
+}
@@ -0,0 +1,73 @@
+#include "ThempSystem.h"
+#include "ThempTest.h"
+#include "ThempWorkerPool.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+using namespace Themp;
+
+namespace
+{
+	//what a batch's jobs write to, every batch gets its own so a job that ran for the wrong one shows up
+	struct JobBatch
+	{
+		int id = 0;
+		int numJobs = 0;
+		std::unique_ptr<std::atomic<int>[]> ran;
+	};
+	std::atomic<int> s_RunningBatch;
+	std::atomic<int> s_StrayJobs;
+
+	void CountJob(void* context, int jobIndex)
+	{
+		JobBatch* batch = static_cast<JobBatch*>(context);
+		if (batch->id != s_RunningBatch || jobIndex < 0 || jobIndex >= batch->numJobs)
+		{
+			s_StrayJobs++;
+			return;
+		}
+		batch->ran[jobIndex]++;
+	}
+}
+
+//Batches run back to back with job counts going up and down, every job runs once for its own batch and none of them after Run returned
+THEMP_TEST(WorkerPool_BackToBackBatches)
+{
+	const int jobCounts[] = { 1, 200, 2, 3, 64, 1, 7, 1000, 5, 2, 31, 0, 4 };
+	const int numCounts = sizeof(jobCounts) / sizeof(jobCounts[0]);
+	for (int numThreads = 0; numThreads <= 7; numThreads += 7)
+	{
+		WorkerPool pool(numThreads);
+		const int numBatches = 3000;
+		std::vector<JobBatch> batches(numBatches);
+		s_StrayJobs = 0;
+		int missed = 0;
+		for (int i = 0; i < numBatches; i++)
+		{
+			JobBatch& batch = batches[i];
+			batch.id = i;
+			batch.numJobs = jobCounts[i % numCounts];
+			batch.ran.reset(new std::atomic<int>[batch.numJobs > 0 ? batch.numJobs : 1]);
+			for (int j = 0; j < batch.numJobs; j++) batch.ran[j] = 0;
+			s_RunningBatch = i;
+			pool.Run(CountJob, &batch, batch.numJobs);
+			//anything that ran after this would be for a batch that's already over
+			s_RunningBatch = -1;
+			for (int j = 0; j < batch.numJobs; j++)
+			{
+				missed += batch.ran[j] != 1;
+			}
+		}
+		//check them all again at the end, a late job would have had the time to show up by now
+		for (int i = 0; i < numBatches; i++)
+		{
+			for (int j = 0; j < batches[i].numJobs; j++)
+			{
+				missed += batches[i].ran[j] != 1;
+			}
+		}
+		THEMP_CHECK(missed == 0);
+		THEMP_CHECK(s_StrayJobs == 0);
+	}
+}